@@ -46,6 +46,7 @@
 #include <wicked/bridge.h>
 #include <wicked/vlan.h>
 #include <wicked/fsm.h>
+#include <wicked/snapshot.h>
 
 #include "wicked-client.h"
 #include "appconfig.h"
@@ -278,7 +279,7 @@ __ifstatus_of_device_addrs(ni_netdev_t *dev, unsigned int *st)
 #endif
 
 static unsigned int
-__ifstatus_of_device(ni_netdev_t *dev)
+__ifstatus_of_device(ni_netdev_t *dev, ni_bool_t link_required)
 {
 	unsigned int st = NI_WICKED_ST_OK;
 
@@ -289,8 +290,7 @@ __ifstatus_of_device(ni_netdev_t *dev)
 	if (!ni_string_empty(dev->link.masterdev.name))
 		return NI_WICKED_ST_ENSLAVED;
 
-	if (!ni_ifcheck_device_link_is_up(dev) &&
-	    ni_ifcheck_device_link_required(dev))
+	if (!ni_ifcheck_device_link_is_up(dev) && link_required)
 		return NI_WICKED_ST_IN_PROGRESS;
 
 	__ifstatus_of_device_leases(dev, &st);
@@ -303,7 +303,7 @@ __ifstatus_of_device(ni_netdev_t *dev)
 }
 
 static unsigned int
-ni_ifstatus_of_device(ni_netdev_t *dev, ni_bool_t *mandatory)
+__ni_ifstatus_of_device(ni_netdev_t *dev, ni_bool_t link_required, ni_bool_t *mandatory)
 {
 	if (mandatory) {
 		*mandatory = ni_ifcheck_device_is_persistent(dev);
@@ -315,7 +315,13 @@ ni_ifstatus_of_device(ni_netdev_t *dev, ni_bool_t *mandatory)
 	if (!ni_ifcheck_device_configured(dev))
 		return NI_WICKED_ST_UNCONFIGURED;
 
-	return __ifstatus_of_device(dev);
+	return __ifstatus_of_device(dev, link_required);
+}
+
+static unsigned int
+ni_ifstatus_of_device(ni_netdev_t *dev, ni_bool_t *mandatory)
+{
+	return __ni_ifstatus_of_device(dev, ni_ifcheck_device_link_required(dev), mandatory);
 }
 
 static unsigned int
@@ -641,6 +647,263 @@ ni_ifstatus_show_status(const char *ifname, unsigned int status)
 	if_printf(ifname, "", "%s\n", ni_ifstatus_code_name(status));
 }
 
+/*
+ * Brief status via the server's status summary: it provides all the
+ * status checks need without fetching all interface objects and
+ * building the fsm from them.
+ */
+static ni_netdev_t *
+ni_ifstatus_summary_netdev(const ni_dbus_variant_t *dict, ni_tristate_t *link_required)
+{
+	const ni_dbus_variant_t *var, *entry;
+	ni_addrconf_lease_t *lease;
+	const char *name = NULL;
+	uint32_t index = 0, family, type, u32;
+	ni_client_state_t *cs;
+	ni_netdev_t *dev;
+	dbus_bool_t bv;
+	unsigned int i;
+
+	if (!ni_dbus_dict_get_string(dict, "name", &name) || ni_string_empty(name) ||
+	    !ni_dbus_dict_get_uint32(dict, "index", &index))
+		return NULL;
+
+	dev = ni_netdev_new(name, index);
+	ni_dbus_dict_get_uint32(dict, "status", &dev->link.ifflags);
+	ni_dbus_dict_get_uint32(dict, "oper-state", &dev->link.oper_state);
+	if (ni_dbus_dict_get_uint32(dict, "type", &u32))
+		dev->link.type = u32;
+	if (ni_dbus_dict_get_string(dict, "master", &name))
+		ni_netdev_ref_set_ifname(&dev->link.masterdev, name);
+
+	/* the server's guess, it knows e.g. the bridge ports */
+	*link_required = NI_TRISTATE_DEFAULT;
+	if (ni_dbus_dict_get_bool(dict, "link-required", &bv))
+		ni_tristate_set(link_required, bv);
+
+	if ((var = ni_dbus_dict_get(dict, "client-state"))) {
+		cs = ni_netdev_get_client_state(dev);
+		ni_objectmodel_netif_client_state_control_from_dict(&cs->control, var);
+		ni_objectmodel_netif_client_state_config_from_dict(&cs->config, var);
+	}
+
+	var = ni_dbus_dict_get(dict, "leases");
+	if (!var || !ni_dbus_variant_is_dict_array(var))
+		return dev;
+
+	for (i = 0; i < var->array.len; ++i) {
+		entry = &var->variant_array_value[i];
+
+		if (!ni_dbus_dict_get_uint32(entry, "family", &family) ||
+		    !ni_dbus_dict_get_uint32(entry, "type", &type))
+			continue;
+
+		lease = ni_addrconf_lease_new(type, family);
+		if (ni_dbus_dict_get_uint32(entry, "state", &u32))
+			lease->state = u32;
+		ni_dbus_dict_get_uint32(entry, "flags", &lease->flags);
+		ni_netdev_set_lease(dev, lease);
+	}
+	return dev;
+}
+
+static unsigned int
+ni_ifstatus_of_summary(ni_netdev_t *dev, ni_tristate_t guess, const ni_ifworker_t *w,
+			ni_bool_t check_config, ni_bool_t *mandatory)
+{
+	ni_client_state_t *cs = dev ? dev->client_state : NULL;
+	ni_tristate_t link_required;
+	unsigned int st;
+
+	/* see ni_ifcheck_device_link_required */
+	link_required = guess;
+	if (cs && ni_tristate_is_set(cs->control.require_link))
+		link_required = cs->control.require_link;
+
+	st = __ni_ifstatus_of_device(dev, !ni_tristate_is_disabled(link_required), mandatory);
+
+	/* see ni_ifstatus_of_worker */
+	if (check_config && mandatory) {
+		link_required = guess;
+		if (w && ni_tristate_is_set(w->control.link_required))
+			link_required = w->control.link_required;
+
+		if (!ni_tristate_is_disabled(link_required))
+			*mandatory = TRUE;
+	}
+	return st;
+}
+
+static void
+ni_ifstatus_summary_mark(const char *ifname, unsigned int st, ni_bool_t mandatory,
+			ni_bool_t quiet, ni_uint_array_t *stcodes, ni_uint_array_t *stflags)
+{
+	ni_uint_array_append(stcodes, st);
+	ni_uint_array_append(stflags, mandatory);
+
+	if (!quiet)
+		ni_ifstatus_show_status(ifname, st);
+}
+
+static ni_bool_t
+ni_ifstatus_summary_device(ni_fsm_t *fsm, ni_netdev_t *dev, ni_tristate_t guess,
+			ni_bool_t check_config, ni_bool_t quiet,
+			ni_uint_array_t *stcodes, ni_uint_array_t *stflags)
+{
+	ni_bool_t mandatory = TRUE;
+	ni_ifworker_t *w;
+	unsigned int st;
+
+	/* not ready devices are pending, not workers */
+	if (!ni_netdev_device_is_ready(dev))
+		return FALSE;
+
+	w = ni_fsm_ifworker_by_name(fsm, NI_IFWORKER_TYPE_NETDEV, dev->name);
+	if (check_config)
+		st = ni_ifstatus_of_summary(dev, guess, w, TRUE, &mandatory);
+	else
+		st = ni_ifstatus_of_summary(dev, guess, NULL, FALSE, &mandatory);
+
+	ni_ifstatus_summary_mark(dev->name, st, mandatory, quiet, stcodes, stflags);
+	return TRUE;
+}
+
+/*
+ * The state snapshot published by wickedd provides the same data
+ * as the status summary without any call to the server.
+ */
+static ni_netdev_t *
+ni_ifstatus_snapshot_netdev(const ni_snapshot_t *snap, const ni_snapshot_netdev_t *sd,
+			ni_tristate_t *link_required)
+{
+	const ni_snapshot_lease_t *sl;
+	ni_addrconf_lease_t *lease;
+	ni_client_state_t *cs;
+	ni_netdev_t *dev;
+	unsigned int i;
+
+	dev = ni_netdev_new(sd->name, sd->ifindex);
+	dev->link.ifflags = sd->ifflags;
+	dev->link.oper_state = sd->oper_state;
+	dev->link.type = sd->type;
+	if (sd->master[0])
+		ni_netdev_ref_set_ifname(&dev->link.masterdev, sd->master);
+
+	*link_required = NI_TRISTATE_DEFAULT;
+	if (ni_tristate_is_set(sd->link_required))
+		ni_tristate_set(link_required, ni_tristate_is_enabled(sd->link_required));
+
+	if (sd->has_client_state) {
+		cs = ni_netdev_get_client_state(dev);
+		cs->control.persistent = !!sd->persistent;
+		cs->control.usercontrol = !!sd->usercontrol;
+		cs->control.require_link = NI_TRISTATE_DEFAULT;
+		if (ni_tristate_is_set(sd->require_link))
+			ni_tristate_set(&cs->control.require_link,
+					ni_tristate_is_enabled(sd->require_link));
+		cs->config.uuid = sd->config_uuid;
+		cs->config.owner = sd->config_owner;
+		ni_string_dup(&cs->config.origin, ni_snapshot_string(snap, sd->config_origin));
+	}
+
+	for (i = 0; (sl = ni_snapshot_netdev_lease(snap, sd, i)); ++i) {
+		lease = ni_addrconf_lease_new(sl->type, sl->family);
+		lease->state = sl->state;
+		lease->flags = sl->flags;
+		lease->uuid = sl->uuid;
+		ni_netdev_set_lease(dev, lease);
+	}
+	return dev;
+}
+
+/*
+ * Get the brief status of all devices from the state snapshot or
+ * via getStatusSummary. Both may be unavailable, e.g. to a non-root
+ * user of an older wickedd; the caller falls back to a full refresh.
+ */
+static ni_bool_t
+ni_ifstatus_summary_fetch(const ni_string_array_t *ifnames, ni_snapshot_t **snap,
+			ni_dbus_variant_t *result)
+{
+	ni_dbus_object_t *list_object;
+
+	if ((*snap = ni_snapshot_open(NULL)))
+		return TRUE;
+
+	if (!(list_object = ni_call_get_netif_list_object())) {
+		ni_debug_application("unable to get server's interface list");
+		return FALSE;
+	}
+
+	if (!ni_call_get_status_summary(list_object, ifnames, result)) {
+		ni_dbus_variant_destroy(result);
+		return FALSE;
+	}
+	return TRUE;
+}
+
+static unsigned int
+ni_ifstatus_summary(ni_fsm_t *fsm, const ni_snapshot_t *snap, const ni_dbus_variant_t *result,
+			const ni_string_array_t *ifnames, ni_bool_t check_config,
+			ni_bool_t quiet, ni_uint_array_t *stcodes, ni_uint_array_t *stflags)
+{
+	ni_string_array_t seen = NI_STRING_ARRAY_INIT;
+	const ni_snapshot_netdev_t *sd;
+	const ni_dbus_variant_t *dict;
+	unsigned int i, st, nmarked = 0;
+	ni_bool_t mandatory;
+	ni_tristate_t guess;
+	const char *path;
+	ni_ifworker_t *w;
+	ni_netdev_t *dev;
+
+	if (snap) {
+		for (i = 0; (sd = ni_snapshot_netdev_at(snap, i)); ++i) {
+			if (ifnames->count && ni_string_array_index(ifnames, sd->name) == -1)
+				continue;
+
+			dev = ni_ifstatus_snapshot_netdev(snap, sd, &guess);
+			if (ni_ifstatus_summary_device(fsm, dev, guess, check_config,
+							quiet, stcodes, stflags)) {
+				ni_string_array_append(&seen, dev->name);
+				nmarked++;
+			}
+			ni_netdev_put(dev);
+		}
+	} else {
+		for (i = 0; (dict = ni_dbus_dict_get_entry(result, i, &path)); ++i) {
+			if (!(dev = ni_ifstatus_summary_netdev(dict, &guess)))
+				continue;
+
+			if (ni_ifstatus_summary_device(fsm, dev, guess, check_config,
+							quiet, stcodes, stflags)) {
+				ni_string_array_append(&seen, dev->name);
+				nmarked++;
+			}
+			ni_netdev_put(dev);
+		}
+	}
+
+	/* configured interfaces without a device */
+	for (i = 0; i < fsm->workers.count; ++i) {
+		w = fsm->workers.data[i];
+
+		if (ni_string_array_index(&seen, w->name) != -1)
+			continue;
+		if (ifnames->count && ni_string_array_index(ifnames, w->name) == -1)
+			continue;
+
+		mandatory = TRUE;
+		st = ni_ifstatus_of_summary(NULL, NI_TRISTATE_DEFAULT, w,
+						check_config, &mandatory);
+		ni_ifstatus_summary_mark(w->name, st, mandatory, quiet, stcodes, stflags);
+		nmarked++;
+	}
+
+	ni_string_array_destroy(&seen);
+	return nmarked;
+}
+
 static int
 ni_ifstatus_to_retcode(int status, ni_bool_t mandatory)
 {
@@ -685,6 +948,9 @@ ni_do_ifstatus(int argc, char **argv)
 	ni_bool_t         all = FALSE;
 	ni_bool_t         opt_transient = FALSE;
 	ni_bool_t         check_config;
+	ni_bool_t         summary;
+	ni_dbus_variant_t summary_result = NI_DBUS_VARIANT_INIT;
+	ni_snapshot_t *   summary_snap = NULL;
 	ni_fsm_t *        fsm;
 	unsigned int      i, nmarked;
 
@@ -752,13 +1018,30 @@ ni_do_ifstatus(int argc, char **argv)
 			goto usage;
 	}
 
+	for (c = optind; c < argc; ++c) {
+		char *ifname = argv[c];
+
+		if (ni_string_eq(ifname, "all")) {
+			ni_string_array_destroy(&ifnames);
+			all = TRUE;
+			break;
+		}
+
+		if (ni_string_array_index(&ifnames, ifname) == -1)
+			ni_string_array_append(&ifnames, ifname);
+	}
+
 	if (!ni_fsm_create_client(fsm)) {
 		/* Severe error we always explicitly return */
 		status = NI_WICKED_ST_ERROR;
 		goto cleanup;
 	}
 
-	if (!ni_fsm_refresh_state(fsm)) {
+	/* brief status does not need the full interface objects */
+	summary = opt_verbose <= OPT_BRIEF;
+	if (summary && !ni_ifstatus_summary_fetch(&ifnames, &summary_snap, &summary_result))
+		summary = FALSE;
+	if (!summary && !ni_fsm_refresh_state(fsm)) {
 		/* Severe error we always explicitly return */
 		status = NI_WICKED_ST_ERROR;
 		goto cleanup;
@@ -777,22 +1060,15 @@ ni_do_ifstatus(int argc, char **argv)
 	}
 
 	status = NI_WICKED_ST_OK;
-	for (c = optind; c < argc; ++c) {
-		char *ifname = argv[c];
-
-		if (ni_string_eq(ifname, "all")) {
-			ni_string_array_destroy(&ifnames);
-			all = TRUE;
-			break;
-		}
-
-		if (ni_string_array_index(&ifnames, ifname) == -1)
-			ni_string_array_append(&ifnames, ifname);
-	}
 
 	if (ifnames.count > 1 || all)
 		multiple = TRUE;
 
+	if (summary) {
+		nmarked = ni_ifstatus_summary(fsm, summary_snap, &summary_result,
+				&ifnames, check_config, opt_verbose == OPT_QUIET,
+				&stcodes, &stflags);
+	} else
 	for (i = 0, nmarked = 0; i < fsm->workers.count; ++i) {
 		ni_ifworker_t *w = fsm->workers.data[i];
 		ni_netdev_t *dev = w->device;
@@ -874,6 +1150,9 @@ ni_do_ifstatus(int argc, char **argv)
 	}
 
 cleanup:
+	if (summary_snap)
+		ni_snapshot_close(summary_snap);
+	ni_dbus_variant_destroy(&summary_result);
 	ni_uint_array_destroy(&stcodes);
 	ni_uint_array_destroy(&stflags);
 	ni_string_array_destroy(&ifnames);
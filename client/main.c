@@ -56,6 +56,7 @@
 #include "ifreload.h"
 #include "ifstatus.h"
 #include "arputil.h"
+#include "metrics.h"
 #include "tester.h"
 
 enum {
@@ -148,7 +149,7 @@ main(int argc, char **argv)
 				"  --config filename\n"
 				"        Use alternative configuration file.\n"
 				"  --log-target target\n"
-				"        Set log destination to <stderr|syslog>.\n"
+				"        Set log destination to <stderr|syslog|ring>.\n"
 				"  --log-level level\n"
 				"        Set log level to <error|warning|notice|info|debug>.\n"
 				"  --debug facility\n"
@@ -181,6 +182,7 @@ main(int argc, char **argv)
 				"  xpath       [options] expr ...\n"
 				"  test        [subcommand]\n"
 				"  arp         [options] <ifname> <IP>\n"
+				"  show-metrics [--reset] [service ...]\n"
 				"\n", program);
 			goto done;
 
@@ -319,6 +321,9 @@ main(int argc, char **argv)
 	} else
 	if (!strcmp(cmd, "arp")) {
 		status = ni_do_arp(argc - optind, argv + optind);
+	} else
+	if (!strcmp(cmd, "show-metrics")) {
+		status = ni_do_show_metrics(argc - optind, argv + optind);
 	} else {
 		fprintf(stderr, "Unsupported command %s\n", cmd);
 		goto usage;
@@ -0,0 +1,211 @@
+/*
+ *	wicked client show-metrics action
+ *
+ *	Copyright (C) 2026 SUSE LLC
+ *
+ *	This program is free software; you can redistribute it and/or modify
+ *	it under the terms of the GNU General Public License as published by
+ *	the Free Software Foundation; either version 2 of the License, or
+ *	(at your option) any later version.
+ *
+ *	This program is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU General Public License for more details.
+ *
+ *	You should have received a copy of the GNU General Public License along
+ *	with this program; if not, see <http://www.gnu.org/licenses/> or write
+ *	to the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ *	Boston, MA 02110-1301 USA.
+ *
+ */
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdio.h>
+#include <string.h>
+#include <inttypes.h>
+#include <getopt.h>
+
+#include <wicked/types.h>
+#include <wicked/util.h>
+#include <wicked/logging.h>
+#include <wicked/netinfo.h>
+#include <wicked/objectmodel.h>
+#include <wicked/dbus-errors.h>
+
+#include "metrics.h"
+
+static const struct {
+	const char *	name;
+	const char *	bus_name;
+	const char *	path;
+} ni_show_metrics_services[] = {
+	{ "wickedd",	NI_OBJECTMODEL_DBUS_BUS_NAME,		NI_OBJECTMODEL_OBJECT_PATH	},
+	{ "nanny",	NI_OBJECTMODEL_DBUS_BUS_NAME_NANNY,	NI_OBJECTMODEL_NANNY_PATH	},
+	{ "dhcp4",	NI_OBJECTMODEL_DBUS_BUS_NAME_DHCP4,	NI_OBJECTMODEL_OBJECT_ROOT "/DHCP4" },
+	{ "dhcp6",	NI_OBJECTMODEL_DBUS_BUS_NAME_DHCP6,	NI_OBJECTMODEL_OBJECT_ROOT "/DHCP6" },
+	{ "auto4",	NI_OBJECTMODEL_DBUS_BUS_NAME_AUTO4,	NI_OBJECTMODEL_OBJECT_ROOT "/AUTO4" },
+	{ NULL,		NULL,					NULL				}
+};
+
+static const char *
+ni_show_metrics_usec(char *buf, size_t size, uint64_t usec)
+{
+	if (usec < 10000)
+		snprintf(buf, size, "%uus", (unsigned int)usec);
+	else if (usec < 10000000)
+		snprintf(buf, size, "%ums", (unsigned int)(usec / 1000));
+	else
+		snprintf(buf, size, "%"PRIu64"s", usec / 1000000);
+	return buf;
+}
+
+static void
+ni_show_metrics_print(const char *service, const ni_dbus_variant_t *result)
+{
+	const ni_dbus_variant_t *dict;
+	uint64_t count, sum, max, p50, p90, p99;
+	char b1[32], b2[32], b3[32], b4[32], b5[32];
+	const char *name;
+	unsigned int i;
+
+	printf("%s:\n", service);
+	for (i = 0; (dict = ni_dbus_dict_get_entry(result, i, &name)); ++i) {
+		count = 0;
+		ni_dbus_dict_get_uint64(dict, "count", &count);
+
+		if (!ni_dbus_dict_get_uint64(dict, "sum", &sum)) {
+			printf("  %-26s count %"PRIu64"\n", name, count);
+			continue;
+		}
+
+		max = p50 = p90 = p99 = 0;
+		ni_dbus_dict_get_uint64(dict, "max", &max);
+		ni_dbus_dict_get_uint64(dict, "p50", &p50);
+		ni_dbus_dict_get_uint64(dict, "p90", &p90);
+		ni_dbus_dict_get_uint64(dict, "p99", &p99);
+
+		printf("  %-26s count %-8"PRIu64" avg %-6s p50 %-6s p90 %-6s p99 %-6s max %s\n",
+				name, count,
+				ni_show_metrics_usec(b1, sizeof(b1), count ? sum / count : 0),
+				ni_show_metrics_usec(b2, sizeof(b2), p50),
+				ni_show_metrics_usec(b3, sizeof(b3), p90),
+				ni_show_metrics_usec(b4, sizeof(b4), p99),
+				ni_show_metrics_usec(b5, sizeof(b5), max));
+	}
+}
+
+static int
+ni_show_metrics_service(unsigned int idx, ni_bool_t reset, ni_bool_t quiet)
+{
+	ni_dbus_variant_t result = NI_DBUS_VARIANT_INIT;
+	DBusError error = DBUS_ERROR_INIT;
+	ni_dbus_client_t *client;
+	ni_dbus_object_t *object;
+	int rv = -1;
+
+	if (!(client = ni_create_dbus_client(ni_show_metrics_services[idx].bus_name)))
+		return -1;
+
+	object = ni_dbus_client_object_new(client, &ni_dbus_anonymous_class,
+					ni_show_metrics_services[idx].path,
+					NI_OBJECTMODEL_METRICS_INTERFACE, NULL);
+	if (!object)
+		goto cleanup;
+
+	if (!ni_dbus_object_call_variant(object, NULL, "getMetrics",
+					0, NULL, 1, &result, &error)) {
+		if (!quiet) {
+			ni_dbus_print_error(&error, "%s: unable to get metrics",
+					ni_show_metrics_services[idx].name);
+		}
+		dbus_error_free(&error);
+		goto cleanup;
+	}
+	ni_show_metrics_print(ni_show_metrics_services[idx].name, &result);
+
+	if (reset && !ni_dbus_object_call_variant(object, NULL, "resetMetrics",
+					0, NULL, 0, NULL, &error)) {
+		ni_dbus_print_error(&error, "%s: unable to reset metrics",
+				ni_show_metrics_services[idx].name);
+		dbus_error_free(&error);
+		goto cleanup;
+	}
+	rv = 0;
+
+cleanup:
+	ni_dbus_variant_destroy(&result);
+	if (object)
+		ni_dbus_object_free(object);
+	ni_dbus_client_free(client);
+	return rv;
+}
+
+int
+ni_do_show_metrics(int argc, char **argv)
+{
+	enum { OPT_HELP, OPT_RESET };
+	static struct option options[] = {
+		{ "help",	no_argument,	NULL,	OPT_HELP	},
+		{ "reset",	no_argument,	NULL,	OPT_RESET	},
+		{ NULL,		no_argument,	NULL,	0		}
+	};
+	int c, status = NI_WICKED_RC_USAGE;
+	ni_bool_t opt_reset = FALSE;
+	unsigned int i, shown = 0;
+
+	optind = 1;
+	while ((c = getopt_long(argc, argv, "", options, NULL)) != EOF) {
+		switch (c) {
+		case OPT_RESET:
+			opt_reset = TRUE;
+			break;
+
+		case OPT_HELP:
+			status = NI_WICKED_RC_SUCCESS;
+			/* fall through */
+		default:
+		usage:
+			fprintf(stderr,
+				"wicked %s [options] [service ...]\n"
+				"\n"
+				"Show latency histograms and counters of the wicked services\n"
+				"<wickedd|nanny|dhcp4|dhcp6|auto4>; default are all running ones.\n"
+				"\n"
+				"Supported options:\n"
+				"  --help\n"
+				"      Show this help text.\n"
+				"  --reset\n"
+				"      Reset the metrics after showing them.\n"
+				, argv[0]);
+			return status;
+		}
+	}
+
+	if (optind >= argc) {
+		/* all services, skipping the ones not running */
+		for (i = 0; ni_show_metrics_services[i].name; ++i) {
+			if (ni_show_metrics_service(i, opt_reset, TRUE) == 0)
+				shown++;
+		}
+		return shown ? NI_WICKED_RC_SUCCESS : NI_WICKED_RC_ERROR;
+	}
+
+	status = NI_WICKED_RC_SUCCESS;
+	for (c = optind; c < argc; ++c) {
+		for (i = 0; ni_show_metrics_services[i].name; ++i) {
+			if (ni_string_eq(ni_show_metrics_services[i].name, argv[c]))
+				break;
+		}
+		if (!ni_show_metrics_services[i].name) {
+			fprintf(stderr, "%s: unknown service '%s'\n", argv[0], argv[c]);
+			status = NI_WICKED_RC_USAGE;
+			goto usage;
+		}
+		if (ni_show_metrics_service(i, opt_reset, FALSE) < 0)
+			status = NI_WICKED_RC_ERROR;
+	}
+	return status;
+}
@@ -57,6 +57,8 @@ typedef struct ni_address_array {
 
 #define NI_ADDRESS_ARRAY_INIT	{ .count = 0, .data = NULL }
 
+typedef struct ni_address_index	ni_address_index_t;
+
 extern ni_bool_t	ni_sockaddr_is_ipv4_loopback(const ni_sockaddr_t *);
 extern ni_bool_t	ni_sockaddr_is_ipv4_linklocal(const ni_sockaddr_t *);
 extern ni_bool_t	ni_sockaddr_is_ipv4_broadcast(const ni_sockaddr_t *);
@@ -132,6 +134,14 @@ extern void		ni_address_list_dedup(ni_address_t **);
 extern ni_address_t *	ni_address_list_find(ni_address_t *, const ni_sockaddr_t *);
 extern unsigned int	ni_address_list_count(ni_address_t *list);
 
+extern ni_address_index_t *ni_address_index_new(void);
+extern ni_address_index_t *ni_address_index_build(ni_address_t *);
+extern void		ni_address_index_free(ni_address_index_t *);
+extern unsigned int	ni_address_index_count(const ni_address_index_t *);
+extern ni_address_t *	ni_address_index_find(const ni_address_index_t *, const ni_sockaddr_t *);
+extern ni_bool_t	ni_address_index_insert(ni_address_index_t *, ni_address_t *);
+extern ni_bool_t	ni_address_index_delete(ni_address_index_t *, const ni_address_t *);
+
 extern void		ni_address_array_init(ni_address_array_t *);
 extern void		ni_address_array_destroy(ni_address_array_t *);
 extern ni_bool_t	ni_address_array_append(ni_address_array_t *, ni_address_t *);
@@ -87,6 +87,8 @@ extern void		ni_bridge_free(ni_bridge_t *);
 extern void		ni_bridge_ports_destroy(ni_bridge_t *);
 extern void		ni_bridge_status_destroy(ni_bridge_status_t *);
 extern void		ni_bridge_port_status_destroy(ni_bridge_port_status_t *);
+extern void		ni_bridge_port_status_copy(ni_bridge_port_status_t *,
+						const ni_bridge_port_status_t *);
 extern int		ni_bridge_add_port(ni_bridge_t *, ni_bridge_port_t *);
 extern int		ni_bridge_del_port(ni_bridge_t *, unsigned int);
 extern int		ni_bridge_del_port_ifname(ni_bridge_t *, const char *);
@@ -98,6 +100,9 @@ extern ni_bridge_port_t *ni_bridge_port_by_index(const ni_bridge_t *br, unsigned
 extern ni_bridge_port_t *ni_bridge_port_by_name(const ni_bridge_t *br, const char *ifname);
 extern ni_bridge_port_t *ni_bridge_port_clone(const ni_bridge_port_t *port);
 extern void		ni_bridge_port_free(ni_bridge_port_t *port);
+extern ni_bridge_port_t *ni_bridge_bind_port(ni_bridge_t *, const ni_netdev_ref_t *,
+						const ni_bridge_port_t *);
+extern ni_bool_t	ni_bridge_unbind_port(ni_bridge_t *, const ni_netdev_ref_t *);
 
 
 extern const char *	ni_bridge_port_validate(const ni_bridge_port_t *);
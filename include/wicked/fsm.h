@@ -59,6 +59,12 @@ typedef struct ni_ifworker_array {
 } ni_ifworker_array_t;
 #define NI_IFWORKER_ARRAY_INIT { .count = 0, .data = NULL }
 
+typedef struct ni_fsm_policy_array {
+	unsigned int		count;
+	ni_fsm_policy_t **	data;
+} ni_fsm_policy_array_t;
+#define NI_FSM_POLICY_ARRAY_INIT { .count = 0, .data = NULL }
+
 typedef struct ni_fsm_timer_ctx	ni_fsm_timer_ctx_t;
 typedef void			ni_fsm_timer_fn_t(const ni_timer_t *, ni_fsm_timer_ctx_t *);
 
@@ -141,6 +147,8 @@ struct ni_ifworker {
 				pending		: 1,
 				readonly	: 1;
 
+	unsigned int		scheduled;	/* nanny schedule set membership bits */
+
 	ni_ifworker_control_t	control;
 
 	struct {
@@ -289,6 +297,10 @@ extern ni_fsm_policy_t *	ni_fsm_policy_by_name(const ni_fsm_t *, const char *);
 extern unsigned int		ni_fsm_policy_get_applicable_policies(const ni_fsm_t *, ni_ifworker_t *,
 						const ni_fsm_policy_t **, unsigned int);
 extern ni_bool_t		ni_fsm_exists_applicable_policy(const ni_fsm_t *, ni_fsm_policy_t *, ni_ifworker_t *);
+extern unsigned int		ni_fsm_policy_get_valid_policies(const ni_fsm_t *, ni_fsm_policy_array_t *);
+extern ni_fsm_policy_t *	ni_fsm_policy_array_best_applicable(const ni_fsm_t *,
+						const ni_fsm_policy_array_t *, ni_ifworker_t *);
+extern void			ni_fsm_policy_array_destroy(ni_fsm_policy_array_t *);
 extern xml_node_t *		ni_fsm_policy_transform_document(xml_node_t *, ni_fsm_policy_t * const *, unsigned int);
 extern const char *		ni_fsm_policy_name(const ni_fsm_policy_t *);
 extern const xml_node_t *	ni_fsm_policy_node(const ni_fsm_policy_t *);
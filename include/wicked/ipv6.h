@@ -84,6 +84,11 @@ struct ni_ipv6_ra_info {
 	ni_ipv6_ra_pinfo_t *	pinfo;
 	ni_ipv6_ra_rdnss_t *	rdnss;
 	ni_ipv6_ra_dnssl_t *	dnssl;
+
+	struct {				/* no entry expires before it */
+		struct timeval	acquired;
+		unsigned int	lifetime;
+	} expire;
 };
 
 struct ni_ipv6_devinfo {
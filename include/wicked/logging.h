@@ -11,9 +11,11 @@
 
 #ifdef __GNUC__
 # define __fmtattr	__attribute__ ((format (printf, 1, 2)))
+# define __fmtattr_2	__attribute__ ((format (printf, 2, 3)))
 # define __noreturn	__attribute__ ((noreturn))
 #else
 # define __fmtattr	/* */
+# define __fmtattr_2	/* */
 # define __noreturn	/* */
 #endif
 
@@ -24,6 +26,7 @@ extern void		ni_error(const char *, ...) __fmtattr;
 extern void		ni_error_extra(const char *, ...) __fmtattr;
 extern void		ni_trace(const char *, ...) __fmtattr;
 extern void		ni_fatal(const char *, ...) __fmtattr __noreturn;
+extern void		__ni_trace(unsigned int facility, const char *, ...) __fmtattr_2;
 
 extern int		ni_enable_debug(const char *);
 extern int		ni_debug_set_default(const char *);
@@ -39,6 +42,8 @@ extern unsigned int	ni_log_level_get(void);
 extern ni_bool_t	ni_log_destination(const char *program, const char *destination);
 extern void		ni_log_reopen(void);
 extern void		ni_log_close(void);
+extern void		ni_log_flush(void);
+extern void		ni_log_ring_dump(int fd, unsigned int count);
 
 enum {
 	NI_LOG_ERROR,
@@ -87,7 +92,7 @@ extern unsigned int	ni_log_level;
 #define __ni_debug(level, facility, fmt, args...) \
 	do { \
 		if (ni_debug_guard(level, facility)) \
-			ni_trace(fmt, ##args); \
+			__ni_trace(facility, fmt, ##args); \
 	} while (0)
 
 #define ni_debug_ifconfig(fmt, args...)		__ni_debug(NI_LOG_DEBUG, NI_TRACE_IFCONFIG, fmt, ##args)
@@ -0,0 +1,54 @@
+/*
+ * Built-in latency histograms and counters
+ *
+ * Copyright (C) 2026 SUSE LLC
+ */
+#ifndef __WICKED_METRICS_H__
+#define __WICKED_METRICS_H__
+
+#include <stdint.h>
+#include <sys/time.h>
+#include <wicked/types.h>
+
+typedef enum ni_metric_id {
+	/* latency histograms (usec) */
+	NI_METRIC_SOCKET_DISPATCH,
+	NI_METRIC_TIMER_LAG,
+	NI_METRIC_NETLINK_DUMP,
+	NI_METRIC_NETLINK_EVENT,
+	NI_METRIC_DBUS_METHOD,
+	NI_METRIC_DBUS_CALL,
+	NI_METRIC_FSM_STEP,
+	NI_METRIC_DHCP4_EXCHANGE,
+	NI_METRIC_DHCP6_EXCHANGE,
+
+	/* counters */
+	NI_METRIC_NETLINK_DUMP_INTR,
+	NI_METRIC_DBUS_METHOD_FAILED,
+	NI_METRIC_DBUS_CALL_FAILED,
+
+	NI_METRIC_MAX
+} ni_metric_id_t;
+
+typedef struct ni_metric_stats {
+	uint64_t		count;
+	uint64_t		sum;		/* usec */
+	uint64_t		max;
+	uint64_t		p50;
+	uint64_t		p90;
+	uint64_t		p99;
+} ni_metric_stats_t;
+
+extern const char *		ni_metric_name(ni_metric_id_t);
+extern const char *		ni_metric_description(ni_metric_id_t);
+extern ni_bool_t		ni_metric_is_histogram(ni_metric_id_t);
+
+extern void			ni_metric_count(ni_metric_id_t);
+extern void			ni_metric_record(ni_metric_id_t, uint64_t usec);
+extern void			ni_metric_start(struct timeval *);
+extern void			ni_metric_record_since(ni_metric_id_t, const struct timeval *);
+
+extern ni_bool_t		ni_metric_get_stats(ni_metric_id_t, ni_metric_stats_t *);
+extern void			ni_metrics_reset(void);
+
+#endif /* __WICKED_METRICS_H__ */
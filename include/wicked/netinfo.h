@@ -27,6 +27,7 @@ struct ni_slaveinfo {
 
 	union {
 	    ni_bonding_slave_info_t *	bond;
+	    ni_bridge_port_t *		bridge;
 	};
 };
 
@@ -70,6 +71,7 @@ struct ni_netdev {
 	unsigned int		users;
 
 	ni_address_t *		addrs;
+	ni_address_index_t *	addr_index;
 	ni_route_table_t *	routes;
 
 	/* Network layer */
@@ -141,6 +143,7 @@ extern int		ni_server_enable_route_events(void (*handler)(ni_netconfig_t *, ni_e
 extern int		ni_server_enable_rule_events(void (*handler)(ni_netconfig_t *, ni_event_t, const ni_rule_t *));
 extern int		ni_server_enable_interface_uevents(void);
 extern void		ni_server_disable_interface_uevents(void);
+extern int		ni_server_listen_ethtool_events(void);
 extern void		ni_server_trace_interface_addr_events(ni_netdev_t *, ni_event_t, const ni_address_t *);
 extern void		ni_server_trace_interface_prefix_events(ni_netdev_t *, ni_event_t, const ni_ipv6_ra_pinfo_t *);
 extern void		ni_server_trace_interface_nduseropt_events(ni_netdev_t *, ni_event_t);
@@ -194,6 +197,10 @@ ni_addrconf_lease_t *	ni_netdev_get_lease_by_uuid(ni_netdev_t *, const ni_uuid_t
 ni_addrconf_lease_t *	ni_netdev_get_lease_by_owner(ni_netdev_t *, const char *);
 
 extern ni_address_t *	ni_netdev_get_addresses(ni_netdev_t *, unsigned int af);
+extern ni_address_t *	ni_netdev_address_find(ni_netdev_t *, const ni_sockaddr_t *);
+extern ni_address_t *	ni_netdev_address_new(ni_netdev_t *, int, unsigned int, const ni_sockaddr_t *);
+extern ni_bool_t	ni_netdev_address_remove(ni_netdev_t *, ni_address_t *);
+extern void		ni_netdev_addrs_changed(ni_netdev_t *);
 extern ni_ethernet_t *	ni_netdev_get_ethernet(ni_netdev_t *);
 extern ni_infiniband_t *ni_netdev_get_infiniband(ni_netdev_t *);
 extern ni_bonding_t *	ni_netdev_get_bonding(ni_netdev_t *);
@@ -28,5 +28,14 @@ extern int			ni_resolve_hostnames_timed(int af, unsigned int count, const char *
 
 extern int			ni_resolve_reverse_timed(const ni_sockaddr_t *addr, char **name, unsigned int timeout);
 
+typedef void			ni_resolve_callback_t(int error, const char *name,
+							const ni_sockaddr_t *addr, void *user_data);
+
+extern unsigned int		ni_resolve_hostname_async(const char *hostname, int af, unsigned int timeout,
+							ni_resolve_callback_t *, void *);
+extern unsigned int		ni_resolve_reverse_async(const ni_sockaddr_t *addr, unsigned int timeout,
+							ni_resolve_callback_t *, void *);
+extern void			ni_resolve_async_cancel(unsigned int id);
+
 #endif /* __WICKED_RESOLVER_H__ */
 
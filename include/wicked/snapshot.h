@@ -0,0 +1,134 @@
+/*
+ * Read-only snapshot of the interface state published by wickedd
+ *
+ * Copyright (C) 2026 SUSE LLC
+ */
+#ifndef __WICKED_SNAPSHOT_H__
+#define __WICKED_SNAPSHOT_H__
+
+#include <stdint.h>
+#include <net/if.h>
+#include <wicked/types.h>
+
+/*
+ * The snapshot is a flat file: a header followed by arrays of fixed
+ * size records, referring to each other by index and to the string
+ * table by offset. It is never modified once published; an update
+ * replaces it, so readers can map it and use the records in place.
+ * The fields are in host byte order.
+ */
+#define NI_SNAPSHOT_MAGIC		0x4e49534e	/* "NISN" */
+#define NI_SNAPSHOT_VERSION		1
+#define NI_SNAPSHOT_FILE		"state.snapshot"
+
+typedef struct ni_snapshot		ni_snapshot_t;
+
+typedef struct ni_snapshot_section {
+	uint32_t		offset;
+	uint32_t		count;
+} ni_snapshot_section_t;
+
+typedef struct ni_snapshot_header {
+	uint32_t		magic;
+	uint32_t		version;
+	uint64_t		generation;
+	uint32_t		pid;		/* of the publisher */
+	uint32_t		size;
+
+	ni_snapshot_section_t	netdevs;
+	ni_snapshot_section_t	addrs;
+	ni_snapshot_section_t	routes;
+	ni_snapshot_section_t	leases;
+	ni_snapshot_section_t	strings;
+} ni_snapshot_header_t;
+
+typedef struct ni_snapshot_netdev {
+	char			name[IFNAMSIZ];
+	char			master[IFNAMSIZ];
+	uint32_t		ifindex;
+	uint32_t		type;
+	uint32_t		ifflags;
+	uint32_t		oper_state;
+	uint32_t		mtu;
+	int32_t			link_required;	/* ni_tristate_t guess */
+
+	uint16_t		hwaddr_type;
+	uint16_t		hwaddr_len;
+	unsigned char		hwaddr[NI_MAXHWADDRLEN];
+
+	/* client state, when has_client_state is set */
+	uint32_t		has_client_state;
+	uint32_t		persistent;
+	uint32_t		usercontrol;
+	int32_t			require_link;
+	uint32_t		config_owner;
+	uint32_t		config_origin;	/* string offset */
+	ni_uuid_t		config_uuid;
+
+	uint32_t		addr_first;
+	uint32_t		addr_count;
+	uint32_t		route_first;
+	uint32_t		route_count;
+	uint32_t		lease_first;
+	uint32_t		lease_count;
+} ni_snapshot_netdev_t;
+
+typedef struct ni_snapshot_address {
+	uint32_t		family;
+	uint32_t		prefixlen;
+	uint32_t		flags;
+	int32_t			scope;
+	uint32_t		owner;
+	unsigned char		local[16];
+	unsigned char		peer[16];
+} ni_snapshot_address_t;
+
+typedef struct ni_snapshot_route {
+	uint32_t		family;
+	uint32_t		prefixlen;
+	uint32_t		table;
+	uint32_t		type;
+	uint32_t		scope;
+	uint32_t		protocol;
+	uint32_t		priority;
+	uint32_t		owner;
+	uint32_t		oif;
+	unsigned char		destination[16];
+	unsigned char		gateway[16];
+	unsigned char		pref_src[16];
+} ni_snapshot_route_t;
+
+typedef struct ni_snapshot_lease {
+	uint32_t		family;
+	uint32_t		type;
+	uint32_t		state;
+	uint32_t		flags;
+	ni_uuid_t		uuid;
+} ni_snapshot_lease_t;
+
+/* publisher side */
+extern const char *		ni_snapshot_default_path(void);
+extern void			ni_snapshot_invalidate(void);
+extern int			ni_snapshot_publish(ni_netconfig_t *, const char *);
+extern void			ni_snapshot_unpublish(const char *);
+
+/* reader side */
+extern ni_snapshot_t *		ni_snapshot_open(const char *);
+extern void			ni_snapshot_close(ni_snapshot_t *);
+extern ni_bool_t		ni_snapshot_is_current(const ni_snapshot_t *);
+extern uint64_t			ni_snapshot_generation(const ni_snapshot_t *);
+
+extern unsigned int		ni_snapshot_netdev_count(const ni_snapshot_t *);
+extern const ni_snapshot_netdev_t *ni_snapshot_netdev_at(const ni_snapshot_t *, unsigned int);
+extern const ni_snapshot_netdev_t *ni_snapshot_netdev_by_name(const ni_snapshot_t *, const char *);
+extern const ni_snapshot_netdev_t *ni_snapshot_netdev_by_index(const ni_snapshot_t *, unsigned int);
+
+extern const ni_snapshot_address_t *ni_snapshot_netdev_addr(const ni_snapshot_t *,
+					const ni_snapshot_netdev_t *, unsigned int);
+extern const ni_snapshot_route_t *ni_snapshot_netdev_route(const ni_snapshot_t *,
+					const ni_snapshot_netdev_t *, unsigned int);
+extern const ni_snapshot_lease_t *ni_snapshot_netdev_lease(const ni_snapshot_t *,
+					const ni_snapshot_netdev_t *, unsigned int);
+extern const char *		ni_snapshot_string(const ni_snapshot_t *, uint32_t);
+
+#endif /* __WICKED_SNAPSHOT_H__ */
@@ -9,6 +9,14 @@
 
 #include <wicked/types.h>
 
+/*
+ * Team and ppp devices are created in background by their service;
+ * the callback is called with the device once it appeared or with
+ * NULL when the creation failed.
+ */
+typedef void		ni_system_netdev_create_callback_t(const char *ifname,
+				ni_netdev_t *dev, void *user_data);
+
 extern int		ni_system_interface_link_change(ni_netdev_t *, const ni_netdev_req_t *);
 extern int		ni_system_interface_link_monitor(ni_netdev_t *);
 
@@ -70,8 +78,8 @@ extern int		ni_system_bond_setup(ni_netconfig_t *nc, ni_netdev_t *,
 				const ni_netdev_t *);
 extern int		ni_system_bond_delete(ni_netconfig_t *nc, ni_netdev_t *);
 extern int		ni_system_bond_shutdown(ni_netdev_t *);
-extern int		ni_system_team_create(ni_netconfig_t *nc,
-				const ni_netdev_t *, ni_netdev_t **);
+extern int		ni_system_team_create(ni_netconfig_t *nc, const ni_netdev_t *,
+				ni_system_netdev_create_callback_t *, void *);
 extern int		ni_system_team_setup(ni_netconfig_t *nc, ni_netdev_t *,
 				const ni_netdev_t *);
 extern int		ni_system_team_shutdown(ni_netdev_t *);
@@ -83,8 +91,8 @@ extern int		ni_system_tuntap_delete(ni_netdev_t *);
 extern int		ni_system_tap_create(ni_netconfig_t *, const char *,
 				ni_netdev_t **);
 extern int		ni_system_tap_delete(ni_netdev_t *);
-extern int		ni_system_ppp_create(ni_netconfig_t *nc,
-				const ni_netdev_t *, ni_netdev_t **);
+extern int		ni_system_ppp_create(ni_netconfig_t *nc, const ni_netdev_t *,
+				ni_system_netdev_create_callback_t *, void *);
 extern int		ni_system_ppp_setup(ni_netconfig_t *nc, ni_netdev_t *,
 				const ni_netdev_t *);
 extern int		ni_system_ppp_shutdown(ni_netdev_t *);
@@ -91,6 +91,7 @@ typedef struct ni_process	ni_process_t;
  */
 typedef struct xpath_format xpath_format_t;
 typedef struct xpath_enode xpath_enode_t;
+typedef struct xpath_program xpath_program_t;
 typedef struct xml_document xml_document_t;
 typedef struct xml_node xml_node_t;
 typedef struct xml_location xml_location_t;
@@ -38,14 +38,17 @@ struct ni_variable {
 	char *		value;
 };
 
+typedef struct ni_var_index	ni_var_index_t;
+
 typedef struct ni_var_array ni_var_array_t;
 struct ni_var_array {
 	ni_var_array_t *next;
 	unsigned int	count;
 	ni_var_t *	data;
+	ni_var_index_t *index;
 };
 
-#define NI_VAR_ARRAY_INIT	{ .count = 0, .data = NULL }
+#define NI_VAR_ARRAY_INIT	{ .count = 0, .data = NULL, .index = NULL }
 
 typedef struct ni_stringbuf {
 	size_t			size;
@@ -135,6 +138,10 @@ extern void		ni_var_array_copy(ni_var_array_t *, const ni_var_array_t *);
 extern void		ni_var_array_move(ni_var_array_t *, ni_var_array_t *);
 extern ni_var_t *	ni_var_array_get(const ni_var_array_t *, const char *name);
 extern void		ni_var_array_set(ni_var_array_t *, const char *name, const char *value);
+extern void		ni_var_array_index_enable(ni_var_array_t *);
+extern void		ni_var_array_index_disable(ni_var_array_t *);
+extern unsigned int	ni_var_array_find_prefix(const ni_var_array_t *, const char *prefix,
+				ni_uint_array_t *);
 
 extern int		ni_var_array_get_string(ni_var_array_t *, const char *, char **);
 extern int		ni_var_array_get_uint(ni_var_array_t *, const char *, unsigned int *);
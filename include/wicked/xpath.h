@@ -63,6 +63,12 @@ typedef struct xpath_result {
 extern xpath_enode_t *	xpath_expression_parse(const char *);
 extern void		xpath_expression_free(xpath_enode_t *);
 extern xpath_result_t *	xpath_expression_eval(const xpath_enode_t *, xml_node_t *);
+extern xpath_result_t *	xpath_expression_eval_cached(const char *, xml_node_t *);
+extern void		xpath_expression_cache_flush(void);
+
+extern xpath_program_t *xpath_program_new(const char *);
+extern xpath_result_t *	xpath_program_eval(xpath_program_t *, xml_node_t *);
+extern void		xpath_program_free(xpath_program_t *);
 
 extern xpath_format_t *	xpath_format_parse(const char *);
 extern int		xpath_format_eval(xpath_format_t *, xml_node_t *, ni_string_array_t *);
@@ -58,6 +58,7 @@ ni_objectmodel_nanny_init(ni_nanny_t *mgr)
 	root_object->handle = mgr;
 	root_object->class = &ni_objectmodel_nanny_class;
 	ni_objectmodel_bind_compatible_interfaces(root_object);
+	ni_objectmodel_register_metrics(mgr->server);
 
 	{
 		unsigned int i;
@@ -78,6 +79,10 @@ ni_nanny_new(void)
 	ni_nanny_t *mgr;
 
 	mgr = xcalloc(1, sizeof(*mgr));
+	mgr->recheck.member = 1U << 0;
+	mgr->recheck.queued = 1U << 1;
+	mgr->down.member    = 1U << 2;
+	mgr->down.queued    = 1U << 3;
 	return mgr;
 }
 
@@ -145,30 +150,66 @@ ni_nanny_free(ni_nanny_t *mgr)
  * Both checks happen once per mainloop iteration.
  */
 void
-ni_nanny_schedule_recheck(ni_ifworker_array_t *array, ni_ifworker_t *w)
+ni_nanny_schedule_recheck(ni_nanny_schedule_t *sched, ni_ifworker_t *w)
 {
-	if (ni_ifworker_array_index(array, w) < 0)
-		ni_ifworker_array_append(array, w);
+	w->scheduled |= sched->member;
+	if (!(w->scheduled & sched->queued)) {
+		w->scheduled |= sched->queued;
+		ni_ifworker_array_append(&sched->queue, w);
+	}
 }
 
 void
-ni_nanny_unschedule(ni_ifworker_array_t *array, ni_ifworker_t *w)
+ni_nanny_unschedule(ni_nanny_schedule_t *sched, ni_ifworker_t *w)
+{
+	unsigned int i;
+
+	if (!(w->scheduled & sched->member))
+		return;
+
+	w->scheduled &= ~sched->member;
+	for (i = 0; i < w->children.count; i++)
+		ni_nanny_unschedule(sched, w->children.data[i]);
+}
+
+/*
+ * Drop the unscheduled workers from the queue
+ */
+static void
+ni_nanny_schedule_compact(ni_nanny_schedule_t *sched)
+{
+	unsigned int i, j;
+	ni_ifworker_t *w;
+
+	for (i = j = 0; i < sched->queue.count; ++i) {
+		w = sched->queue.data[i];
+		if (w->scheduled & sched->member) {
+			sched->queue.data[j++] = w;
+		} else {
+			w->scheduled &= ~sched->queued;
+			ni_ifworker_release(w);
+		}
+	}
+	sched->queue.count = j;
+}
+
+static void
+ni_nanny_schedule_clear(ni_nanny_schedule_t *sched)
 {
-	ni_ifworker_array_remove_with_children(array, w);
+	unsigned int i;
+
+	for (i = 0; i < sched->queue.count; ++i)
+		sched->queue.data[i]->scheduled &= ~(sched->member | sched->queued);
+	ni_ifworker_array_destroy(&sched->queue);
 }
 
 /*
  * Check whether a given interface should be reconfigured
  */
-static unsigned int
-ni_nanny_recheck(ni_nanny_t *mgr, ni_ifworker_t *w)
+static int
+ni_nanny_recheck_apply(ni_nanny_t *mgr, ni_ifworker_t *w, ni_managed_policy_t *mpolicy)
 {
-	static const unsigned int MAX_POLICIES = 20;
-	const ni_fsm_policy_t *policies[MAX_POLICIES];
-	const ni_fsm_policy_t *policy;
 	ni_managed_device_t *mdev;
-	ni_managed_policy_t *mpolicy;
-	unsigned int count;
 	ni_bool_t factory_device = FALSE;
 
 	mdev = ni_nanny_get_device(mgr, w);
@@ -191,39 +232,92 @@ ni_nanny_recheck(ni_nanny_t *mgr, ni_ifworker_t *w)
 	 * ni_managed_device_apply_policy() will then check if the policy
 	 * changed. If it did, then we give it another try.
 	 */
-
 	ni_debug_nanny("%s(%s[%u], %s)", __func__, w->name, w->ifindex,
 					mdev ? "managed" : "unmanaged");
-	if ((count = ni_fsm_policy_get_applicable_policies(mgr->fsm, w, policies, MAX_POLICIES)) == 0) {
-		ni_debug_nanny("%s: no applicable policies", w->name);
-		return count;
-	}
-
-	policy = policies[count-1];
-	mpolicy = ni_nanny_get_policy(mgr, policy);
 
 	if (factory_device)
-		count += ni_factory_device_apply_policy(mgr->fsm, w, mpolicy);
+		return ni_factory_device_apply_policy(mgr->fsm, w, mpolicy);
 	else
-		count += ni_managed_device_apply_policy(mdev, mpolicy);
+		return ni_managed_device_apply_policy(mdev, mpolicy);
+}
 
-	return count;
+typedef struct ni_nanny_recheck_entry {
+	unsigned int		index;
+	ni_ifworker_t *		worker;
+	ni_fsm_policy_t *	policy;
+} ni_nanny_recheck_entry_t;
+
+static int
+ni_nanny_recheck_entry_cmp(const void *a, const void *b)
+{
+	const ni_nanny_recheck_entry_t *ea = a;
+	const ni_nanny_recheck_entry_t *eb = b;
+
+	if (ea->policy != eb->policy)
+		return ea->policy < eb->policy ? -1 : 1;
+	return ea->index < eb->index ? -1 : ea->index > eb->index;
 }
 
+/*
+ * Recheck all scheduled workers in one pass: the valid policies are
+ * collected and sorted once, the best applicable policy is selected
+ * per worker and the managed policy resolved once per policy group.
+ */
 unsigned int
 ni_nanny_recheck_do(ni_nanny_t *mgr)
 {
-	unsigned int i, count = 0;
+	ni_fsm_policy_array_t policies = NI_FSM_POLICY_ARRAY_INIT;
+	ni_ifworker_array_t workers = NI_IFWORKER_ARRAY_INIT;
+	ni_nanny_recheck_entry_t *entries = NULL;
+	ni_managed_policy_t *mpolicy = NULL;
+	ni_fsm_policy_t *policy = NULL;
+	unsigned int i, n = 0, count = 0;
 	ni_fsm_t *fsm = mgr->fsm;
 
 	ni_assert(fsm);
-	for (i = 0; i < mgr->recheck.count; ++i) {
-		ni_ifworker_t *w = mgr->recheck.data[i];
+	ni_nanny_schedule_compact(&mgr->recheck);
+
+	/* apply may (un)schedule workers, so work on a snapshot */
+	for (i = 0; i < mgr->recheck.queue.count; ++i) {
+		ni_ifworker_t *w = mgr->recheck.queue.data[i];
 
 		if (!w->dead && !w->pending && !w->kickstarted && !w->done && !w->failed)
-			count += ni_nanny_recheck(mgr, w);
+			ni_ifworker_array_append(&workers, w);
 	}
+	if (!workers.count)
+		return 0;
 
+	if (!ni_fsm_policy_get_valid_policies(fsm, &policies)) {
+		ni_ifworker_array_destroy(&workers);
+		return 0;
+	}
+
+	entries = xcalloc(workers.count, sizeof(entries[0]));
+	for (i = 0; i < workers.count; ++i) {
+		ni_ifworker_t *w = workers.data[i];
+
+		if (!(policy = ni_fsm_policy_array_best_applicable(fsm, &policies, w))) {
+			ni_debug_nanny("%s: no applicable policies", w->name);
+			continue;
+		}
+		entries[n].index = i;
+		entries[n].worker = w;
+		entries[n].policy = policy;
+		n++;
+	}
+	qsort(entries, n, sizeof(entries[0]), ni_nanny_recheck_entry_cmp);
+
+	for (policy = NULL, i = 0; i < n; ++i) {
+		if (entries[i].policy != policy) {
+			policy = entries[i].policy;
+			mpolicy = ni_nanny_get_policy(mgr, policy);
+		}
+		count += 1 + ni_nanny_recheck_apply(mgr, entries[i].worker, mpolicy);
+	}
+
+	free(entries);
+	ni_fsm_policy_array_destroy(&policies);
+	ni_ifworker_array_destroy(&workers);
 	return count;
 }
 
@@ -235,10 +329,13 @@ ni_nanny_down_do(ni_nanny_t *mgr)
 {
 	unsigned int i, count = 0;
 
-	for (i = 0; i < mgr->down.count; ++i) {
-		ni_ifworker_t *w = mgr->down.data[i];
+	for (i = 0; i < mgr->down.queue.count; ++i) {
+		ni_ifworker_t *w = mgr->down.queue.data[i];
 		ni_managed_device_t *mdev;
 
+		if (!(w->scheduled & mgr->down.member))
+			continue;
+
 		if ((mdev = ni_nanny_get_device(mgr, w)) != NULL) {
 			ni_managed_device_down(mdev);
 			count++;
@@ -246,7 +343,7 @@ ni_nanny_down_do(ni_nanny_t *mgr)
 	}
 
 	if (i > 0)
-		ni_ifworker_array_destroy(&mgr->down);
+		ni_nanny_schedule_clear(&mgr->down);
 
 	return count;
 }
@@ -89,6 +89,17 @@ struct ni_nanny_devmatch {
 	 const ni_dbus_class_t *class;	/* if type is NI_NANNY_DEVMATCH_CLASS */
 };
 
+/*
+ * A set of workers scheduled for processing. The membership is tracked
+ * in the ni_ifworker_t scheduled bits, so (un)scheduling is O(1); the
+ * unscheduled workers are dropped from the queue on the next pass.
+ */
+typedef struct ni_nanny_schedule {
+	unsigned int		member;		/* worker is in the set */
+	unsigned int		queued;		/* worker is in the queue */
+	ni_ifworker_array_t	queue;
+} ni_nanny_schedule_t;
+
 struct ni_nanny {
 	ni_dbus_server_t *	server;
 	ni_fsm_t *		fsm;
@@ -97,8 +108,8 @@ struct ni_nanny {
 	ni_managed_policy_t *	policy_list;
 
 	unsigned int		last_policy_seq;
-	ni_ifworker_array_t	recheck;
-	ni_ifworker_array_t	down;
+	ni_nanny_schedule_t	recheck;
+	ni_nanny_schedule_t	down;
 
 	ni_nanny_user_t *	users;
 
@@ -119,8 +130,8 @@ extern void			ni_nanny_start(ni_nanny_t *);
 extern void			ni_nanny_free(ni_nanny_t *);
 extern const char *		ni_nanny_statedir(void);
 extern void			ni_nanny_recheck_policies(ni_nanny_t *, const ni_string_array_t *);
-extern void			ni_nanny_schedule_recheck(ni_ifworker_array_t *, ni_ifworker_t *);
-extern void			ni_nanny_unschedule(ni_ifworker_array_t *, ni_ifworker_t *);
+extern void			ni_nanny_schedule_recheck(ni_nanny_schedule_t *, ni_ifworker_t *);
+extern void			ni_nanny_unschedule(ni_nanny_schedule_t *, ni_ifworker_t *);
 extern unsigned int		ni_nanny_recheck_do(ni_nanny_t *mgr);
 extern unsigned int		ni_nanny_down_do(ni_nanny_t *mgr);
 extern void			ni_nanny_register_device(ni_nanny_t *, ni_ifworker_t *);
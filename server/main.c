@@ -28,8 +28,12 @@
 #include <wicked/objectmodel.h>
 #include <wicked/wireless.h>
 #include <wicked/modem.h>
+#include <wicked/snapshot.h>
 #include "netinfo_priv.h"
 #include "udev-utils.h"
+#include "appconfig.h"
+#include "dbus-server.h"
+#include "systemctl.h"
 #include "auto6.h"
 
 enum {
@@ -122,7 +126,7 @@ main(int argc, char **argv)
 				"  --log-level level\n"
 				"        Set log level to <error|warning|notice|info|debug>.\n"
 				"  --log-target target\n"
-				"        Set log destination to <stderr|syslog>.\n"
+				"        Set log destination to <stderr|syslog|ring>.\n"
 				"  --foreground\n"
 				"        Tell the daemon to not background itself at startup.\n"
 				"  --recover\n"
@@ -231,6 +235,11 @@ run_interface_server(void)
 	dbus_server = ni_objectmodel_create_service();
 	if (!dbus_server)
 		ni_fatal("Cannot create server, giving up.");
+
+	/* queue teamd/pppd unit jobs on our system bus, see sd_booted(3) */
+	if ((!ni_global.config->dbus_type || ni_string_eq(ni_global.config->dbus_type, "system")) &&
+	    ni_isdir("/run/systemd/system"))
+		ni_systemctl_bus_attach(ni_dbus_server_get_connection(dbus_server));
 #ifdef MODEM
 	if (!opt_no_modem_manager) {
 		if (!ni_modem_manager_init(handle_modem_event))
@@ -259,6 +268,10 @@ run_interface_server(void)
 		ni_server_disable_interface_uevents();
 	}
 
+	/* ethtool settings change notifications; link events refresh otherwise */
+	if (ni_server_listen_ethtool_events() < 0)
+		ni_debug_ifconfig("ethtool netlink monitor not available");
+
 	ni_rfkill_open(handle_rfkill_event, NULL);
 
 	/* Listen for other events, such as RESOLVER_UPDATED */
@@ -286,10 +299,15 @@ run_interface_server(void)
 			timeout = ni_timer_next_timeout();
 		} while (ni_dbus_objects_garbage_collect());
 
+		/* state of the events processed so far for read-only clients,
+		 * rebuilt only after it has been invalidated by an event */
+		ni_snapshot_publish(ni_global_state_handle(0), NULL);
+
 		if (ni_socket_wait(timeout) != 0)
 			ni_fatal("ni_socket_wait failed");
 	}
 
+	ni_snapshot_unpublish(NULL);
 	if (opt_recover_state)
 		ni_objectmodel_save_state(opt_state_file);
 
@@ -381,6 +399,9 @@ handle_interface_event(ni_netdev_t *dev, ni_event_t event)
 {
 	const ni_uuid_t *event_uuid = NULL;
 
+	/* e.g. udev ready events not seen as netlink change */
+	ni_snapshot_invalidate();
+
 	if (dbus_server) {
 		ni_dbus_object_t *object;
 
@@ -302,24 +302,25 @@ ni_address_list_append(ni_address_t **list, ni_address_t *ap)
 void
 ni_address_list_dedup(ni_address_t **list)
 {
-	ni_address_t **pos, *ap;
-	ni_address_t **pos2, *ap2;
-
-	for (pos = list; (ap = *pos) != NULL; pos = &ap->next) {
-		for (pos2 = &ap->next; (ap2 = *pos2) != NULL; ) {
-			if (ni_sockaddr_equal(&ap->local_addr, &ap2->local_addr)) {
-				if (ap->prefixlen != ap2->prefixlen
-				 || ap->scope != ap2->scope) {
-					ni_warn("%s(): duplicate address %s with prefix or scope mismatch",
-							__func__, ni_sockaddr_print(&ap->local_addr));
-				}
-				*pos2 = ap2->next;
-				ni_address_free(ap2);
-			} else {
-				pos2 = &ap2->next;
+	ni_address_index_t *index;
+	ni_address_t **pos, *ap, *ap2;
+
+	index = ni_address_index_new();
+	for (pos = list; (ap = *pos) != NULL; ) {
+		if ((ap2 = ni_address_index_find(index, &ap->local_addr)) != NULL) {
+			if (ap->prefixlen != ap2->prefixlen
+			 || ap->scope != ap2->scope) {
+				ni_warn("%s(): duplicate address %s with prefix or scope mismatch",
+						__func__, ni_sockaddr_print(&ap->local_addr));
 			}
+			*pos = ap->next;
+			ni_address_free(ap);
+		} else {
+			ni_address_index_insert(index, ap);
+			pos = &ap->next;
 		}
 	}
+	ni_address_index_free(index);
 }
 
 unsigned int
@@ -371,6 +372,167 @@ ni_address_list_destroy(ni_address_t **list)
 	}
 }
 
+/*
+ * ni_address index, a hash of addresses by local address.
+ * It does not own the addresses; the first address wins on duplicates,
+ * matching ni_address_list_find.
+ */
+#define NI_ADDRESS_INDEX_MIN_SIZE	16
+
+struct ni_address_index {
+	unsigned int		count;
+	unsigned int		size;
+	unsigned int		shadowed;	/* duplicates not indexed */
+	ni_address_t **		slots;
+};
+
+static unsigned int
+__ni_address_index_hash(const ni_sockaddr_t *addr)
+{
+	const unsigned char *data;
+	unsigned int len, i;
+	uint32_t hash = 2166136261U;
+
+	hash = (hash ^ addr->ss_family) * 16777619U;
+	if ((data = __ni_sockaddr_data(addr, &len))) {
+		for (i = 0; i < len; ++i)
+			hash = (hash ^ data[i]) * 16777619U;
+	}
+	return hash;
+}
+
+static unsigned int
+__ni_address_index_slot(const ni_address_index_t *index, const ni_sockaddr_t *addr)
+{
+	unsigned int mask = index->size - 1;
+	unsigned int pos = __ni_address_index_hash(addr) & mask;
+	ni_address_t *ap;
+
+	while ((ap = index->slots[pos]) != NULL) {
+		if (ni_sockaddr_equal(&ap->local_addr, addr))
+			break;
+		pos = (pos + 1) & mask;
+	}
+	return pos;
+}
+
+static void
+__ni_address_index_resize(ni_address_index_t *index, unsigned int size)
+{
+	ni_address_t **slots, **old = index->slots;
+	unsigned int i, osize = index->size;
+
+	slots = xcalloc(size, sizeof(*slots));
+	index->slots = slots;
+	index->size = size;
+	for (i = 0; i < osize; ++i) {
+		if (old[i])
+			slots[__ni_address_index_slot(index, &old[i]->local_addr)] = old[i];
+	}
+	free(old);
+}
+
+ni_address_index_t *
+ni_address_index_new(void)
+{
+	ni_address_index_t *index;
+
+	index = xcalloc(1, sizeof(*index));
+	__ni_address_index_resize(index, NI_ADDRESS_INDEX_MIN_SIZE);
+	return index;
+}
+
+ni_address_index_t *
+ni_address_index_build(ni_address_t *list)
+{
+	ni_address_index_t *index;
+	ni_address_t *ap;
+
+	index = ni_address_index_new();
+	for (ap = list; ap; ap = ap->next)
+		ni_address_index_insert(index, ap);
+	return index;
+}
+
+void
+ni_address_index_free(ni_address_index_t *index)
+{
+	if (index) {
+		free(index->slots);
+		free(index);
+	}
+}
+
+unsigned int
+ni_address_index_count(const ni_address_index_t *index)
+{
+	return index ? index->count : 0;
+}
+
+ni_address_t *
+ni_address_index_find(const ni_address_index_t *index, const ni_sockaddr_t *addr)
+{
+	if (!index || !addr)
+		return NULL;
+
+	return index->slots[__ni_address_index_slot(index, addr)];
+}
+
+ni_bool_t
+ni_address_index_insert(ni_address_index_t *index, ni_address_t *ap)
+{
+	unsigned int pos;
+
+	if (!index || !ap)
+		return FALSE;
+
+	/* keep the load factor below 1/2 */
+	if ((index->count + 1) * 2 > index->size)
+		__ni_address_index_resize(index, index->size * 2);
+
+	pos = __ni_address_index_slot(index, &ap->local_addr);
+	if (index->slots[pos]) {
+		index->shadowed++;
+		return FALSE;
+	}
+
+	index->slots[pos] = ap;
+	index->count++;
+	return TRUE;
+}
+
+/*
+ * Returns FALSE when ap is not indexed or a shadowed duplicate may have
+ * to take its place; the index has to be rebuilt from the list then.
+ */
+ni_bool_t
+ni_address_index_delete(ni_address_index_t *index, const ni_address_t *ap)
+{
+	unsigned int mask, pos, next, home;
+	ni_address_t *cur;
+
+	if (!index || !ap)
+		return FALSE;
+
+	pos = __ni_address_index_slot(index, &ap->local_addr);
+	if (index->slots[pos] != ap)
+		return FALSE;
+
+	/* backward shift deletion keeps the probe chains intact */
+	mask = index->size - 1;
+	index->slots[pos] = NULL;
+	index->count--;
+	for (next = (pos + 1) & mask; (cur = index->slots[next]); next = (next + 1) & mask) {
+		home = __ni_address_index_hash(&cur->local_addr) & mask;
+		if (((next - home) & mask) >= ((next - pos) & mask)) {
+			index->slots[pos] = cur;
+			index->slots[next] = NULL;
+			pos = next;
+		}
+	}
+	return index->shadowed == 0;
+}
+
 void
 ni_address_array_init(ni_address_array_t *array)
 {
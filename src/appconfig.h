@@ -128,6 +128,8 @@ typedef struct ni_config_dhcp6 {
 	unsigned int		num_preferred_servers;
 	ni_server_preference_t	preferred_server[NI_DHCP_SERVER_PREFERENCES_MAX];
 
+	ni_bool_t		shared_socket;	/* global only */
+
 	ni_dhcp_option_decl_t *	custom_options;
 } ni_config_dhcp6_t;
 
@@ -19,7 +19,6 @@
 #include "buffer.h"
 
 static void	ni_arp_socket_recv(ni_socket_t *);
-static int	ni_arp_parse(ni_arp_socket_t *, ni_buffer_t *, ni_arp_packet_t *);
 
 /*
  * Open ARP socket
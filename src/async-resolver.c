@@ -14,13 +14,18 @@
 #include <stdlib.h>
 
 #include <sys/types.h>
-#include <sys/wait.h>
+#include <sys/socket.h>
 #include <sys/time.h>
 #include <unistd.h>
 #include <signal.h>
+#include <pthread.h>
+#include <fcntl.h>
+#include <time.h>
 #include <netdb.h>
 #include <errno.h>
-#include <poll.h>
+
+#include "util_priv.h"
+#include "socket_priv.h"
 
 
 /*
@@ -235,154 +240,614 @@ __ni_resolve_reverse(const ni_sockaddr_t *addr, char **hostname)
 	return ret;
 }
 
+/*
+ * Resolver service: a small pool of worker threads runs the blocking
+ * getaddrinfo/getnameinfo calls. Finished async requests are passed
+ * back to the main loop via a pipe wrapped into a wicked socket and
+ * the callbacks run in the main thread; the result cache is used by
+ * the main thread only.
+ */
+#ifndef NI_RESOLVE_WORKERS_MAX
+#define NI_RESOLVE_WORKERS_MAX		4
+#endif
+/* libc does not tell us the DNS record TTL, use fixed cache lifetimes */
+#ifndef NI_RESOLVE_CACHE_TTL
+#define NI_RESOLVE_CACHE_TTL		60
+#endif
+#ifndef NI_RESOLVE_CACHE_NEG_TTL
+#define NI_RESOLVE_CACHE_NEG_TTL	10
+#endif
+#ifndef NI_RESOLVE_CACHE_MAX
+#define NI_RESOLVE_CACHE_MAX		32
+#endif
+
+typedef enum {
+	NI_RESOLVE_FORWARD,
+	NI_RESOLVE_REVERSE,
+} ni_resolve_kind_t;
+
+typedef enum {
+	NI_RESOLVE_QUEUED,
+	NI_RESOLVE_RUNNING,
+	NI_RESOLVE_DONE,
+} ni_resolve_state_t;
+
+typedef struct ni_resolve_request	ni_resolve_request_t;
+struct ni_resolve_request {
+	/* guarded by the service lock */
+	ni_resolve_request_t *	next;
+	ni_resolve_state_t	state;
+	ni_bool_t		sync;
+	ni_bool_t		abandoned;
+
+	/* owned by the worker while running */
+	ni_resolve_kind_t	kind;
+	int			family;
+	char *			name;
+	ni_sockaddr_t		addr;
+	int			error;
+
+	/* main thread only */
+	ni_resolve_request_t *	async_next;
+	unsigned int		id;
+	ni_bool_t		cached;
+	const ni_timer_t *	timer;
+	ni_resolve_callback_t *	callback;
+	void *			user_data;
+};
+
+typedef struct ni_resolve_cache_entry {
+	ni_resolve_kind_t	kind;
+	int			family;
+	char *			name;
+	ni_sockaddr_t		addr;
+	int			error;
+	struct timeval		expires;
+} ni_resolve_cache_entry_t;
+
+static struct ni_resolve_service {
+	pthread_mutex_t		lock;
+	pthread_cond_t		wakeup;
+	pthread_cond_t		finished;
+	ni_resolve_request_t *	queue;
+	ni_resolve_request_t *	done;
+	unsigned int		workers;
+	unsigned int		idle;
+
+	int			notify[2];
+	ni_socket_t *		sock;
+	ni_resolve_request_t *	async;
+	unsigned int		next_id;
+
+	ni_resolve_cache_entry_t cache[NI_RESOLVE_CACHE_MAX];
+} ni_resolve_service = {
+	.lock		= PTHREAD_MUTEX_INITIALIZER,
+	.wakeup		= PTHREAD_COND_INITIALIZER,
+	.finished	= PTHREAD_COND_INITIALIZER,
+	.notify		= { -1, -1 },
+};
+
+static ni_resolve_request_t *
+ni_resolve_request_new(ni_resolve_kind_t kind, int family, const char *name,
+			const ni_sockaddr_t *addr)
+{
+	ni_resolve_request_t *req;
+
+	req = xcalloc(1, sizeof(*req));
+	req->kind = kind;
+	req->family = family;
+	if (name)
+		req->name = xstrdup(name);
+	if (addr)
+		req->addr = *addr;
+	return req;
+}
+
 static void
-__ni_resolve_reverse_sigchild(int sig)
+ni_resolve_request_free(ni_resolve_request_t *req)
 {
-	(void)sig;
+	free(req->name);
+	free(req);
 }
 
-static int
-__ni_resolve_reverse_exec(const ni_sockaddr_t *addr)
+/*
+ * Runs in a worker thread: no logging and no global state here.
+ */
+static void
+ni_resolve_request_run(ni_resolve_request_t *req)
 {
-	char *hostname = NULL;
+	struct addrinfo hints, *res = NULL;
+	unsigned int alen;
 
-	if (__ni_resolve_reverse(addr, &hostname) == 0) {
-		fputs(hostname, stdout);
-		fflush(stdout);
-		ni_string_free(&hostname);
-		return 0;
+	switch (req->kind) {
+	case NI_RESOLVE_FORWARD:
+		memset(&hints, 0, sizeof(hints));
+		hints.ai_family = req->family;
+		hints.ai_socktype = SOCK_DGRAM;
+		req->error = getaddrinfo(req->name, NULL, &hints, &res);
+		if (req->error == 0 && res) {
+			if ((alen = res->ai_addrlen) > sizeof(req->addr))
+				alen = sizeof(req->addr);
+			memcpy(&req->addr, res->ai_addr, alen);
+		}
+		if (res)
+			freeaddrinfo(res);
+		break;
+
+	case NI_RESOLVE_REVERSE:
+		req->error = __ni_resolve_reverse(&req->addr, &req->name);
+		break;
 	}
-	return 2;
 }
 
-static int
-__ni_resolve_reverse_read(int fd, char **hostname, unsigned int timeout)
+static void *
+ni_resolve_worker(void *arg)
 {
-	char hbuf[NI_MAXHOST+1] = {'\0'};
-	struct pollfd pfd[1] = { { fd, POLLIN, 0 } };
-	struct timeval now, tv;
-	ssize_t len;
-	int rc;
-
-	ni_timer_get_time(&tv);
-	tv.tv_sec += timeout;
-	timeout *= 1000;
-
-	while ((rc = poll(pfd, 1, timeout)) == -1 && errno == EINTR) {
-		ni_timer_get_time(&now);
-		if (timercmp(&tv, &now, <)) {
-			timeout = 0;
+	struct ni_resolve_service *svc = arg;
+	ni_resolve_request_t *req, **pos;
+
+	pthread_mutex_lock(&svc->lock);
+	while (1) {
+		while (!(req = svc->queue)) {
+			svc->idle++;
+			pthread_cond_wait(&svc->wakeup, &svc->lock);
+			svc->idle--;
+		}
+		svc->queue = req->next;
+		req->next = NULL;
+		req->state = NI_RESOLVE_RUNNING;
+		pthread_mutex_unlock(&svc->lock);
+
+		ni_resolve_request_run(req);
+
+		pthread_mutex_lock(&svc->lock);
+		req->state = NI_RESOLVE_DONE;
+		if (req->sync) {
+			if (req->abandoned)
+				ni_resolve_request_free(req);
+			else
+				pthread_cond_broadcast(&svc->finished);
 		} else {
-			struct timeval delta;
-			long delta_ms;
+			for (pos = &svc->done; *pos; pos = &(*pos)->next)
+				;
+			*pos = req;
+			if (write(svc->notify[1], "", 1) < 0) {
+				/* pipe full: main loop is going to wake up anyway */
+			}
+		}
+	}
+	return NULL;
+}
 
-			timersub(&tv, &now, &delta);
-			delta_ms = 1000 * delta.tv_sec + delta.tv_usec / 1000;
-			if (delta_ms < timeout)
-				timeout = delta_ms;
+/*
+ * Queue a request, starting another worker when all are busy.
+ * Called with the service lock held.
+ */
+static ni_bool_t
+ni_resolve_request_queue(struct ni_resolve_service *svc, ni_resolve_request_t *req)
+{
+	ni_resolve_request_t **pos;
+
+	if (!svc->idle && svc->workers < NI_RESOLVE_WORKERS_MAX) {
+		sigset_t all, old;
+		pthread_t tid;
+		int rv;
+
+		/* signals are for the main thread */
+		sigfillset(&all);
+		pthread_sigmask(SIG_SETMASK, &all, &old);
+		rv = pthread_create(&tid, NULL, ni_resolve_worker, svc);
+		pthread_sigmask(SIG_SETMASK, &old, NULL);
+
+		if (rv == 0) {
+			pthread_detach(tid);
+			svc->workers++;
+		} else if (!svc->workers) {
+			ni_error("unable to start resolver worker thread: %s",
+					strerror(rv));
+			return FALSE;
 		}
 	}
-	if (rc == 1 && pfd[0].revents & POLLIN) {
-		len = read(pfd[0].fd, hbuf, sizeof(hbuf) - 1);
-		if (len > 0 && ni_check_domain_name(hbuf, len, 0)) {
-			ni_string_dup(hostname, hbuf);
-			return 0;
+
+	req->state = NI_RESOLVE_QUEUED;
+	for (pos = &svc->queue; *pos; pos = &(*pos)->next)
+		;
+	*pos = req;
+	pthread_cond_signal(&svc->wakeup);
+	return TRUE;
+}
+
+/*
+ * Remove a not yet started request from the queue.
+ * Called with the service lock held.
+ */
+static ni_bool_t
+ni_resolve_request_dequeue(struct ni_resolve_service *svc, ni_resolve_request_t *req)
+{
+	ni_resolve_request_t **pos;
+
+	if (req->state != NI_RESOLVE_QUEUED)
+		return FALSE;
+
+	for (pos = &svc->queue; *pos; pos = &(*pos)->next) {
+		if (*pos == req) {
+			*pos = req->next;
+			req->next = NULL;
+			return TRUE;
 		}
 	}
-	return -1;
+	return FALSE;
 }
 
-int
-__ni_resolve_reverse_reap(pid_t pid)
+/*
+ * Result cache
+ */
+static ni_resolve_cache_entry_t *
+ni_resolve_cache_find(const ni_resolve_request_t *req)
 {
-	int status = -1;
-	int count = 4;
+	struct ni_resolve_service *svc = &ni_resolve_service;
+	ni_resolve_cache_entry_t *ce;
+	struct timeval now;
+	unsigned int i;
 
-	while (count--) {
-		if (waitpid(pid, &status, WNOHANG) == pid) {
-			if (WIFEXITED(status))
-				return WEXITSTATUS(status);
-			else
-				return -1;
-		} else if (count == 2) {
-			kill(pid, SIGHUP);
-		} else if (count == 1) {
-			if (kill(pid, SIGKILL) < 0) {
-				ni_error("Unable to kill reverse resolver");
+	ni_timer_get_time(&now);
+	for (i = 0; i < NI_RESOLVE_CACHE_MAX; ++i) {
+		ce = &svc->cache[i];
+
+		if (!timerisset(&ce->expires) || ce->kind != req->kind)
+			continue;
+
+		if (timercmp(&ce->expires, &now, <)) {
+			ni_string_free(&ce->name);
+			memset(ce, 0, sizeof(*ce));
+			continue;
+		}
+
+		if (req->kind == NI_RESOLVE_FORWARD) {
+			if (ce->family == req->family &&
+			    ni_string_eq_nocase(ce->name, req->name))
+				return ce;
+		} else {
+			if (ni_sockaddr_equal(&ce->addr, &req->addr))
+				return ce;
+		}
+	}
+	return NULL;
+}
+
+static void
+ni_resolve_cache_store(const ni_resolve_request_t *req)
+{
+	struct ni_resolve_service *svc = &ni_resolve_service;
+	ni_resolve_cache_entry_t *ce, *slot = NULL;
+	unsigned int i;
+
+	/* only a (temporary) failure to get an answer is not cached */
+	if (req->error != 0 && req->error != EAI_NONAME)
+		return;
+
+	if (!(slot = ni_resolve_cache_find(req))) {
+		for (i = 0; i < NI_RESOLVE_CACHE_MAX; ++i) {
+			ce = &svc->cache[i];
+			if (!timerisset(&ce->expires)) {
+				slot = ce;
+				break;
 			}
+			if (!slot || timercmp(&ce->expires, &slot->expires, <))
+				slot = ce;
 		}
-		usleep(10000);
 	}
-	ni_error("Unable to reap reverse resolver");
-	return -1;
+
+	ni_string_free(&slot->name);
+	memset(slot, 0, sizeof(*slot));
+	slot->kind = req->kind;
+	slot->family = req->family;
+	slot->addr = req->addr;
+	slot->error = req->error;
+	ni_string_dup(&slot->name, req->name);
+	ni_timer_get_time(&slot->expires);
+	slot->expires.tv_sec += req->error ? NI_RESOLVE_CACHE_NEG_TTL : NI_RESOLVE_CACHE_TTL;
+}
+
+static ni_bool_t
+ni_resolve_cache_lookup(ni_resolve_request_t *req)
+{
+	ni_resolve_cache_entry_t *ce;
+
+	if (!(ce = ni_resolve_cache_find(req)))
+		return FALSE;
+
+	req->cached = TRUE;
+	req->error = ce->error;
+	if (req->kind == NI_RESOLVE_FORWARD)
+		req->addr = ce->addr;
+	else
+		ni_string_dup(&req->name, ce->name);
+	return TRUE;
 }
 
 /*
- * Timed IP address reverse resolve hack (see bnc#861476)
- * Unfortunately getnameinfo does not accept any timeout...
- * Any better ideas how to implement this?
+ * Async request delivery in the main loop
  */
-int
-ni_resolve_reverse_timed(const ni_sockaddr_t *addr, char **hostname, unsigned int timeout)
+static ni_resolve_request_t *
+ni_resolve_async_unlink(unsigned int id)
 {
-	struct sigaction old, new;
-	int fd[2], fds, rc;
-	pid_t pid;
+	struct ni_resolve_service *svc = &ni_resolve_service;
+	ni_resolve_request_t **pos, *req;
+
+	for (pos = &svc->async; (req = *pos); pos = &req->async_next) {
+		if (req->id == id) {
+			*pos = req->async_next;
+			req->async_next = NULL;
+			return req;
+		}
+	}
+	return NULL;
+}
 
-	if (!timeout)
-		return __ni_resolve_reverse(addr, hostname);
+static void
+ni_resolve_async_deliver(ni_resolve_request_t *req)
+{
+	ni_resolve_callback_t *callback = req->callback;
 
-	rc = socketpair(AF_UNIX, SOCK_STREAM, PF_LOCAL, fd);
-	if (rc < 0)
-		return -1;
+	req->callback = NULL;
+	if (callback) {
+		callback(req->error, req->name, req->error ? NULL : &req->addr,
+				req->user_data);
+	}
+}
 
-	new.sa_flags   = 0;
-	new.sa_handler = __ni_resolve_reverse_sigchild;
-	sigemptyset (&new.sa_mask);
-	sigaction (SIGCHLD, &new, &old);
-
-	rc = 2;
-	do {
-		pid = fork();
-	} while (pid == -1 && errno == EAGAIN && --rc);
-
-	rc = -1;
-	switch (pid) {
-	case -1:
-		close(fd[0]);
-		close(fd[1]);
-		break;
+static void
+ni_resolve_async_recv(ni_socket_t *sock)
+{
+	struct ni_resolve_service *svc = &ni_resolve_service;
+	ni_resolve_request_t *done, *req;
+	char buf[64];
+
+	while (read(svc->notify[0], buf, sizeof(buf)) > 0)
+		;
+
+	pthread_mutex_lock(&svc->lock);
+	done = svc->done;
+	svc->done = NULL;
+	pthread_mutex_unlock(&svc->lock);
+
+	while ((req = done)) {
+		done = req->next;
+		req->next = NULL;
+
+		if (!req->cached)
+			ni_resolve_cache_store(req);
+		if (req->callback) {
+			ni_resolve_async_unlink(req->id);
+			if (req->timer)
+				ni_timer_cancel(req->timer);
+			req->timer = NULL;
+			ni_resolve_async_deliver(req);
+		}
+		ni_resolve_request_free(req);
+	}
+}
+
+static void
+ni_resolve_async_timeout(void *user_data, const ni_timer_t *timer)
+{
+	struct ni_resolve_service *svc = &ni_resolve_service;
+	ni_resolve_request_t *req = user_data;
+	ni_bool_t dequeued;
+
+	if (!req || req->timer != timer)
+		return;
+
+	req->timer = NULL;
+	ni_resolve_async_unlink(req->id);
+
+	pthread_mutex_lock(&svc->lock);
+	dequeued = ni_resolve_request_dequeue(svc, req);
+	pthread_mutex_unlock(&svc->lock);
+
+	ni_debug_objectmodel("resolver request %u for %s timed out", req->id,
+			req->kind == NI_RESOLVE_FORWARD ? req->name :
+			ni_sockaddr_print(&req->addr));
+
+	req->error = EAI_AGAIN;
+	ni_resolve_async_deliver(req);
+	if (dequeued)
+		ni_resolve_request_free(req);
+}
+
+static ni_bool_t
+ni_resolve_async_init(struct ni_resolve_service *svc)
+{
+	int flags, i;
+
+	if (svc->sock)
+		return TRUE;
 
-	case 0:
-		close(fd[0]);
-		if (!freopen("/dev/null", "r", stdin) ||
-		    !freopen("/dev/null", "w", stderr)) {
-			close(fd[1]);
-			exit(1);
+	if (pipe(svc->notify) < 0) {
+		ni_error("unable to create resolver notification pipe: %m");
+		return FALSE;
+	}
+	for (i = 0; i < 2; ++i) {
+		flags = fcntl(svc->notify[i], F_GETFL);
+		fcntl(svc->notify[i], F_SETFL, flags | O_NONBLOCK);
+		fcntl(svc->notify[i], F_SETFD, FD_CLOEXEC);
+	}
+
+	if (!(svc->sock = ni_socket_wrap(svc->notify[0], SOCK_STREAM)))
+		goto failure;
+	svc->sock->receive = ni_resolve_async_recv;
+	if (!ni_socket_activate(svc->sock)) {
+		ni_socket_release(svc->sock);
+		svc->sock = NULL;
+		goto failure;
+	}
+	return TRUE;
+
+failure:
+	close(svc->notify[0]);
+	close(svc->notify[1]);
+	svc->notify[0] = svc->notify[1] = -1;
+	return FALSE;
+}
+
+static unsigned int
+ni_resolve_async_submit(ni_resolve_request_t *req, unsigned int timeout,
+			ni_resolve_callback_t *callback, void *user_data)
+{
+	struct ni_resolve_service *svc = &ni_resolve_service;
+	ni_bool_t queued;
+
+	if (!callback || !ni_resolve_async_init(svc)) {
+		ni_resolve_request_free(req);
+		return 0;
+	}
+
+	if (!++svc->next_id)
+		++svc->next_id;
+	req->id = svc->next_id;
+	req->callback = callback;
+	req->user_data = user_data;
+
+	if (ni_resolve_cache_lookup(req)) {
+		/* deliver from the main loop as well */
+		pthread_mutex_lock(&svc->lock);
+		req->state = NI_RESOLVE_DONE;
+		req->next = svc->done;
+		svc->done = req;
+		pthread_mutex_unlock(&svc->lock);
+		if (write(svc->notify[1], "", 1) < 0) {
+			/* pipe full: main loop is going to wake up anyway */
 		}
-		if (dup2(fd[1], fileno(stdout)) < 0) {
-			close(fd[1]);
-			exit(1);
+	} else {
+		pthread_mutex_lock(&svc->lock);
+		queued = ni_resolve_request_queue(svc, req);
+		pthread_mutex_unlock(&svc->lock);
+		if (!queued) {
+			ni_resolve_request_free(req);
+			return 0;
 		}
+		if (timeout)
+			req->timer = ni_timer_register(timeout, ni_resolve_async_timeout, req);
+	}
+
+	req->async_next = svc->async;
+	svc->async = req;
+	return req->id;
+}
+
+/*
+ * Resolve a hostname / reverse resolve an address in the background;
+ * the callback is invoked from the main loop with a getaddrinfo error
+ * code, EAI_AGAIN when the timeout (in msec, 0 to wait) expired.
+ * Returns the request id for ni_resolve_async_cancel() or 0 on error.
+ */
+unsigned int
+ni_resolve_hostname_async(const char *hostname, int af, unsigned int timeout,
+			ni_resolve_callback_t *callback, void *user_data)
+{
+	ni_resolve_request_t *req;
 
-		fds = getdtablesize();
-		for (fd[0] = 3; fd[0] < fds; ++fd[0])
-			close(fd[0]);
+	if (ni_string_empty(hostname))
+		return 0;
 
-		rc = __ni_resolve_reverse_exec(addr);
-		exit(rc);
+	req = ni_resolve_request_new(NI_RESOLVE_FORWARD, af, hostname, NULL);
+	return ni_resolve_async_submit(req, timeout, callback, user_data);
+}
 
-	default:
-		close(fd[1]);
-		rc = __ni_resolve_reverse_read(fd[0], hostname, timeout);
-		close(fd[0]);
-		if (rc < 0)
-			kill(pid, SIGTERM);
+unsigned int
+ni_resolve_reverse_async(const ni_sockaddr_t *addr, unsigned int timeout,
+			ni_resolve_callback_t *callback, void *user_data)
+{
+	ni_resolve_request_t *req;
+
+	if (!addr || !ni_sockaddr_is_specified(addr))
+		return 0;
+
+	req = ni_resolve_request_new(NI_RESOLVE_REVERSE, addr->ss_family, NULL, addr);
+	return ni_resolve_async_submit(req, timeout, callback, user_data);
+}
 
-		__ni_resolve_reverse_reap(pid);
+void
+ni_resolve_async_cancel(unsigned int id)
+{
+	struct ni_resolve_service *svc = &ni_resolve_service;
+	ni_resolve_request_t *req;
+	ni_bool_t dequeued;
+
+	if (!id || !(req = ni_resolve_async_unlink(id)))
+		return;
+
+	if (req->timer)
+		ni_timer_cancel(req->timer);
+	req->timer = NULL;
+	req->callback = NULL;
+
+	pthread_mutex_lock(&svc->lock);
+	dequeued = ni_resolve_request_dequeue(svc, req);
+	pthread_mutex_unlock(&svc->lock);
+
+	/* otherwise freed when the worker passes it back */
+	if (dequeued)
+		ni_resolve_request_free(req);
+}
+
+/*
+ * Timed IP address reverse resolve (see bnc#861476):
+ * getnameinfo does not accept any timeout, so we wait
+ * for a resolver worker and leave it behind on timeout.
+ */
+int
+ni_resolve_reverse_timed(const ni_sockaddr_t *addr, char **hostname, unsigned int timeout)
+{
+	struct ni_resolve_service *svc = &ni_resolve_service;
+	ni_resolve_request_t *req;
+	struct timespec deadline;
+	int rc = -1;
+
+	if (!timeout)
+		return __ni_resolve_reverse(addr, hostname);
+
+	if (!addr || !hostname || !ni_sockaddr_is_specified(addr))
+		return -1;
+
+	req = ni_resolve_request_new(NI_RESOLVE_REVERSE, addr->ss_family, NULL, addr);
+	if (ni_resolve_cache_lookup(req)) {
+		if (req->error == 0 && ni_string_dup(hostname, req->name))
+			rc = 0;
+		ni_resolve_request_free(req);
+		return rc;
 	}
 
-	sigaction (SIGCHLD, &old, &new);
+	clock_gettime(CLOCK_REALTIME, &deadline);
+	deadline.tv_sec += timeout;
+
+	pthread_mutex_lock(&svc->lock);
+	req->sync = TRUE;
+	if (!ni_resolve_request_queue(svc, req)) {
+		pthread_mutex_unlock(&svc->lock);
+		ni_resolve_request_free(req);
+		return -1;
+	}
+	while (req->state != NI_RESOLVE_DONE) {
+		if (pthread_cond_timedwait(&svc->finished, &svc->lock, &deadline) == ETIMEDOUT)
+			break;
+	}
+	if (req->state != NI_RESOLVE_DONE) {
+		if (ni_resolve_request_dequeue(svc, req))
+			ni_resolve_request_free(req);
+		else
+			req->abandoned = TRUE;
+		pthread_mutex_unlock(&svc->lock);
+		return -1;
+	}
+	pthread_mutex_unlock(&svc->lock);
+
+	ni_resolve_cache_store(req);
+	if (req->error == 0 && ni_check_domain_name(req->name, strlen(req->name), 0)) {
+		ni_string_dup(hostname, req->name);
+		rc = 0;
+	}
+	ni_resolve_request_free(req);
 	return rc;
 }
-
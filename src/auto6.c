@@ -25,6 +25,7 @@
 
 #include <sys/time.h>
 #include <ctype.h>
+#include <netinet/icmp6.h>
 
 #include <wicked/logging.h>
 #include <wicked/netinfo.h>
@@ -108,6 +109,7 @@ ni_auto6_new(const ni_netdev_t *dev)
 static void
 ni_auto6_acquire_disarm(ni_auto6_t *auto6)
 {
+	ni_icmpv6_ra_unlisten(auto6->device.index, auto6);
 	if (auto6->acquire.timer) {
 		ni_timer_cancel(auto6->acquire.timer);
 		auto6->acquire.timer = NULL;
@@ -966,6 +968,26 @@ ni_auto6_acquire_run(void *user_data, const ni_timer_t *timer)
 	ni_auto6_acquire_set_timer(auto6, NI_AUTO6_ACQUIRE_TIMEOUT);
 }
 
+/*
+ * A router advertisement arrived on the shared icmpv6 socket while
+ * acquiring: the kernel processes it, we just stop soliciting.
+ */
+static void
+ni_auto6_acquire_on_router_advert(unsigned int ifindex, const struct nd_router_advert *ra,
+				size_t len, const ni_sockaddr_t *from, void *user_data)
+{
+	ni_auto6_t *auto6 = user_data;
+
+	ni_debug_verbose(NI_LOG_DEBUG1, NI_TRACE_IPV6|NI_TRACE_AUTOIP,
+			"%s: ipv6 router advertisement received from %s%s%s",
+			auto6->device.name, ni_sockaddr_print(from),
+			ra->nd_ra_flags_reserved & ND_RA_FLAG_MANAGED ? ", managed" : "",
+			ra->nd_ra_flags_reserved & ND_RA_FLAG_OTHER ? ", other-config" : "");
+
+	auto6->acquire.send_rs = 0;
+	ni_icmpv6_ra_unlisten(ifindex, auto6);
+}
+
 static void
 ni_auto6_acquire_set_timer(ni_auto6_t *auto6, unsigned int delay)
 {
@@ -1011,6 +1033,7 @@ ni_auto6_acquire(ni_netdev_t *dev, const ni_auto6_request_t *req)
 	ni_tristate_set(&auto6->update, req->update);
 	auto6->acquire.deadline = req->defer_timeout;
 	auto6->acquire.send_rs  = NI_AUTO6_ACQUIRE_SEND_RS;
+	ni_icmpv6_ra_listen(auto6->device.index, ni_auto6_acquire_on_router_advert, auto6);
 
 	ni_timer_get_time(&auto6->acquire.start);
 	ni_auto6_acquire_set_timer(auto6, NI_AUTO6_ACQUIRE_DELAY);
@@ -154,6 +154,38 @@ ni_call_device_by_name(ni_dbus_object_t *list_object, const char *name)
 	return result;
 }
 
+/*
+ * Get the status summary records of all or the named interfaces
+ */
+dbus_bool_t
+ni_call_get_status_summary(ni_dbus_object_t *list_object, const ni_string_array_t *names,
+				ni_dbus_variant_t *result)
+{
+	DBusError error = DBUS_ERROR_INIT;
+	ni_dbus_variant_t arg = NI_DBUS_VARIANT_INIT;
+	unsigned int i;
+	dbus_bool_t rv;
+
+	if (!list_object || !result)
+		return FALSE;
+
+	ni_dbus_variant_init_dict(&arg);
+	for (i = 0; names && i < names->count; ++i)
+		ni_dbus_dict_add_string(&arg, "name", names->data[i]);
+
+	rv = ni_dbus_object_call_variant(list_object, NULL, "getStatusSummary",
+						1, &arg, 1, result, &error);
+	if (!rv) {
+		/* e.g. denied by an older policy, the caller falls back */
+		ni_debug_dbus("%s.getStatusSummary() failed: %s",
+				ni_dbus_object_get_path(list_object),
+				error.message ? error.message : error.name);
+		dbus_error_free(&error);
+	}
+	ni_dbus_variant_destroy(&arg);
+	return rv;
+}
+
 /*
  * This works a lot like the serialization code in xml-dbus, except we're not defining a
  * schema for this.
@@ -11,7 +11,11 @@
 #include "config.h"
 #endif
 #include <sys/time.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <sys/file.h>
 #include <stdio.h>
+#include <fcntl.h>
 #include <limits.h>
 #include <errno.h>
 #include <unistd.h>
@@ -25,6 +29,7 @@
 
 #include "client/client_state.h"
 #include "util_priv.h"
+#include "buffer.h"
 
 /*
  * Internal utilities
@@ -427,117 +432,761 @@ ni_client_state_scripts_copy(ni_client_state_scripts_t *dst,
 		dst->node = xml_node_clone(src->node, NULL);
 }
 
-ni_bool_t
-ni_client_state_save(const ni_client_state_t *client_state, unsigned int ifindex)
+/*
+ * Legacy per-ifindex xml state files, read to migrate them
+ * into the state store.
+ */
+static ni_bool_t
+ni_client_state_legacy_load(ni_client_state_t *client_state, unsigned int ifindex)
 {
 	char path[PATH_MAX] = {'\0'};
-	char temp[PATH_MAX] = {'\0'};
+	xml_node_t *xml;
 	xml_node_t *node;
-	FILE *fp = NULL;
-	int fd;
+	FILE *fp;
 
 	ni_client_state_filename(ifindex, path, sizeof(path));
-	snprintf(temp, sizeof(temp), "%s.XXXXXX", path);
+	if (!(fp = fopen(path, "re"))) {
+		if (errno != ENOENT)
+			ni_error("Cannot open state file '%s': %m", path);
+		return FALSE;
+	}
 
-	if ((fd = mkstemp(temp)) < 0) {
-		ni_error("Cannot create %s state temp file", path);
+	if (!(xml = xml_node_scan(fp, path))) {
+		fclose(fp);
+		ni_error("Cannot parse xml from state file '%s", path);
 		return FALSE;
 	}
-	if (!(fp = fdopen(fd, "we"))) {
-		close(fd);
-		ni_error("Cannot create %s state temp file", path);
-		goto failure;
+	fclose(fp);
+
+	node = xml->name ? xml : xml->children;
+	if (!node || !ni_string_eq(node->name, NI_CLIENT_STATE_XML_NODE)) {
+		ni_error("State file '%s' does not contain %s node",
+			path, NI_CLIENT_STATE_XML_NODE);
+		xml_node_free(xml);
+		return FALSE;
 	}
 
-	if (!(node = xml_node_new(NI_CLIENT_STATE_XML_NODE, NULL))) {
-		ni_error("Cannot create %s node for %s", NI_CLIENT_STATE_XML_NODE, path);
-		goto failure;
+	ni_client_state_reset(client_state);
+	if (!ni_client_state_parse_xml(node, client_state)) {
+		ni_error("Cannot parse state from file '%s'", path);
+		xml_node_free(xml);
+		return FALSE;
 	}
 
-	if (!ni_client_state_print_xml(client_state, node)) {
-		ni_error("Cannot format state into xml for %s", path);
-		xml_node_free(node);
-		goto failure;
+	xml_node_free(xml);
+	return TRUE;
+}
+
+static ni_bool_t
+ni_client_state_legacy_drop(unsigned int ifindex)
+{
+	char path[PATH_MAX] = {'\0'};
+
+	ni_client_state_filename(ifindex, path, sizeof(path));
+
+	if (unlink(path) < 0) {
+		if (errno == ENOENT)
+			return TRUE;
+
+		ni_error("Cannot remove state file '%s': %m", path);
+		return FALSE;
 	}
+	return TRUE;
+}
+
+/*
+ * The client state store is a single append-only record log.
+ *
+ * Every save appends a complete record for the ifindex using a single
+ * write(2) on an O_APPEND descriptor, drop and move append tombstones.
+ * The last valid record of an ifindex wins. Readers mmap the file and
+ * walk the fixed record headers without any locking; a torn record at
+ * the tail fails the checksum and terminates the walk, the next writer
+ * truncates it. Writers serialize using flock(2) and compact the log by
+ * rewriting the live records into a temporary file, which is renamed
+ * over the store.
+ */
+#define NI_CLIENT_STATE_STORE_MAGIC	0x5343494eU	/* "NICS" */
+#define NI_CLIENT_STATE_STORE_VERSION	1U
+#define NI_CLIENT_STATE_RECORD_MAGIC	0x4443524eU	/* "NRCD" */
+#define NI_CLIENT_STATE_COMPACT_SIZE	65536U
+
+enum {
+	NI_CLIENT_STATE_RECORD_SAVE	= 1,
+	NI_CLIENT_STATE_RECORD_DROP	= 2,
+};
+
+typedef struct ni_client_state_store_header {
+	uint32_t	magic;
+	uint32_t	version;
+	uint32_t	compacted;	/* store size after last compaction */
+	uint32_t	reserved;
+} ni_client_state_store_header_t;
+
+typedef struct ni_client_state_record {
+	uint32_t	magic;
+	uint32_t	ifindex;
+	uint16_t	type;
+	uint16_t	reserved;
+	uint32_t	length;		/* payload length		*/
+	uint32_t	csum;		/* over header and payload	*/
+} ni_client_state_record_t;
+
+#define NI_CLIENT_STATE_RECORD_ALIGN(len)	(((len) + 3U) & ~3U)
+
+typedef struct ni_client_state_store_map {
+	unsigned char *	base;
+	size_t		size;
+} ni_client_state_store_map_t;
 
-	if (xml_node_print(node, fp) < 0) {
-		ni_error("Cannot write into %s state temp file", path);
-		xml_node_free(node);
-		goto failure;
+static void
+ni_client_state_store_filename(char *path, size_t size)
+{
+	snprintf(path, size, "%s/client-state.db", ni_config_statedir());
+}
+
+static uint32_t
+ni_client_state_record_csum(const ni_client_state_record_t *rec, const void *payload)
+{
+	const unsigned char *ptr;
+	uint32_t csum = 2166136261U;
+	unsigned int i;
+	uint32_t hdr[4];
+
+	hdr[0] = rec->magic;
+	hdr[1] = rec->ifindex;
+	hdr[2] = ((uint32_t)rec->type << 16) | rec->reserved;
+	hdr[3] = rec->length;
+
+	for (ptr = (const unsigned char *)hdr, i = 0; i < sizeof(hdr); ++i) {
+		csum ^= ptr[i];
+		csum *= 16777619U;
 	}
-	xml_node_free(node);
+	for (ptr = payload, i = 0; i < rec->length; ++i) {
+		csum ^= ptr[i];
+		csum *= 16777619U;
+	}
+	return csum;
+}
+
+/*
+ * Return the record at offset or NULL when there is no further
+ * valid record; advances offset to the next record.
+ */
+static const ni_client_state_record_t *
+ni_client_state_store_next(const ni_client_state_store_map_t *map, size_t *offset)
+{
+	const ni_client_state_record_t *rec;
+	size_t len;
+
+	if (*offset + sizeof(*rec) > map->size)
+		return NULL;
+
+	rec = (const ni_client_state_record_t *)(map->base + *offset);
+	if (rec->magic != NI_CLIENT_STATE_RECORD_MAGIC)
+		return NULL;
+
+	len = sizeof(*rec) + NI_CLIENT_STATE_RECORD_ALIGN(rec->length);
+	if (rec->length > map->size || *offset + len > map->size)
+		return NULL;
 
-	if (rename(temp, path) < 0) {
-		ni_error("Cannot move temp file to state file %s", path);
-		goto failure;
+	if (rec->csum != ni_client_state_record_csum(rec, rec + 1))
+		return NULL;
+
+	*offset += len;
+	return rec;
+}
+
+static ni_bool_t
+ni_client_state_store_map(int fd, ni_client_state_store_map_t *map)
+{
+	const ni_client_state_store_header_t *hdr;
+	struct stat st;
+	void *addr;
+
+	memset(map, 0, sizeof(*map));
+	if (fstat(fd, &st) < 0 || (size_t)st.st_size < sizeof(*hdr))
+		return FALSE;
+
+	addr = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	if (addr == MAP_FAILED)
+		return FALSE;
+
+	hdr = addr;
+	if (hdr->magic != NI_CLIENT_STATE_STORE_MAGIC ||
+	    hdr->version != NI_CLIENT_STATE_STORE_VERSION) {
+		munmap(addr, st.st_size);
+		return FALSE;
 	}
 
-	fclose(fp);
+	map->base = addr;
+	map->size = st.st_size;
+	return TRUE;
+}
+
+static void
+ni_client_state_store_unmap(ni_client_state_store_map_t *map)
+{
+	if (map->base)
+		munmap(map->base, map->size);
+	memset(map, 0, sizeof(*map));
+}
+
+/*
+ * Process local index of the last record offset of each ifindex.
+ *
+ * The log is append-only until a compaction replaces it, so the index
+ * stays valid for the inode it was built for and is extended by the
+ * records appended since the last lookup. It keeps the store mapped.
+ */
+#define NI_CLIENT_STATE_INDEX_MIN_SIZE	64
+
+typedef struct ni_client_state_index_slot {
+	unsigned int	ifindex;
+	uint32_t	offset;
+} ni_client_state_index_slot_t;
 
+typedef struct ni_client_state_store_index {
+	dev_t		dev;
+	ino_t		ino;
+	ni_client_state_store_map_t map;
+	size_t		scanned;	/* end of the last indexed record */
+
+	unsigned int	count;
+	unsigned int	size;
+	ni_client_state_index_slot_t *slots;
+} ni_client_state_store_index_t;
+
+static ni_client_state_store_index_t	ni_client_state_store_index;
+
+static unsigned int
+ni_client_state_index_slot(const ni_client_state_store_index_t *index, unsigned int ifindex)
+{
+	unsigned int mask = index->size - 1;
+	unsigned int pos = (ifindex * 2654435761U) & mask;
+
+	while (index->slots[pos].ifindex && index->slots[pos].ifindex != ifindex)
+		pos = (pos + 1) & mask;
+	return pos;
+}
+
+static void
+ni_client_state_index_resize(ni_client_state_store_index_t *index, unsigned int size)
+{
+	ni_client_state_index_slot_t *old = index->slots;
+	unsigned int i, osize = index->size;
+
+	index->slots = xcalloc(size, sizeof(*index->slots));
+	index->size = size;
+	for (i = 0; i < osize; ++i) {
+		if (old[i].ifindex)
+			index->slots[ni_client_state_index_slot(index, old[i].ifindex)] = old[i];
+	}
+	free(old);
+}
+
+static void
+ni_client_state_index_put(ni_client_state_store_index_t *index, unsigned int ifindex, size_t offset)
+{
+	unsigned int pos;
+
+	/* keep the load factor below 1/2 */
+	if ((index->count + 1) * 2 > index->size)
+		ni_client_state_index_resize(index, index->size ?
+				index->size * 2 : NI_CLIENT_STATE_INDEX_MIN_SIZE);
+
+	pos = ni_client_state_index_slot(index, ifindex);
+	if (!index->slots[pos].ifindex) {
+		index->slots[pos].ifindex = ifindex;
+		index->count++;
+	}
+	index->slots[pos].offset = offset;
+}
+
+static void
+ni_client_state_index_reset(ni_client_state_store_index_t *index)
+{
+	ni_client_state_store_unmap(&index->map);
+	free(index->slots);
+	memset(index, 0, sizeof(*index));
+}
+
+/*
+ * Bring the index up to date with the store open at fd.
+ * Returns the index or NULL when the store has no valid header.
+ */
+static ni_client_state_store_index_t *
+ni_client_state_index_update(int fd)
+{
+	ni_client_state_store_index_t *index = &ni_client_state_store_index;
+	const ni_client_state_record_t *rec;
+	size_t offset;
+	struct stat st;
+
+	if (fstat(fd, &st) < 0)
+		return NULL;
+
+	if (index->map.base && (index->dev != st.st_dev || index->ino != st.st_ino ||
+				(size_t)st.st_size < index->scanned))
+		ni_client_state_index_reset(index);
+
+	if (!index->map.base || index->map.size != (size_t)st.st_size) {
+		ni_client_state_store_unmap(&index->map);
+		if (!ni_client_state_store_map(fd, &index->map)) {
+			ni_client_state_index_reset(index);
+			return NULL;
+		}
+		index->dev = st.st_dev;
+		index->ino = st.st_ino;
+		if (!index->scanned)
+			index->scanned = sizeof(ni_client_state_store_header_t);
+	}
+
+	offset = index->scanned;
+	while ((rec = ni_client_state_store_next(&index->map, &offset))) {
+		ni_client_state_index_put(index, rec->ifindex, index->scanned);
+		index->scanned = offset;
+	}
+	return index;
+}
+
+/*
+ * Return the last record of ifindex in the store open at fd; it
+ * is valid until the next lookup.
+ */
+static const ni_client_state_record_t *
+ni_client_state_store_find(int fd, unsigned int ifindex)
+{
+	ni_client_state_store_index_t *index;
+	unsigned int pos;
+
+	if (!ifindex || !(index = ni_client_state_index_update(fd)) || !index->size)
+		return NULL;
+
+	pos = ni_client_state_index_slot(index, ifindex);
+	if (!index->slots[pos].ifindex)
+		return NULL;
+
+	return (const ni_client_state_record_t *)(index->map.base + index->slots[pos].offset);
+}
+
+/*
+ * Replace a store without a valid header by an empty one.
+ * Called with the store lock held.
+ */
+static ni_bool_t
+ni_client_state_store_recreate(const char *path)
+{
+	ni_client_state_store_header_t hdr;
+	char temp[PATH_MAX] = {'\0'};
+	int tfd;
+
+	memset(&hdr, 0, sizeof(hdr));
+	hdr.magic = NI_CLIENT_STATE_STORE_MAGIC;
+	hdr.version = NI_CLIENT_STATE_STORE_VERSION;
+
+	snprintf(temp, sizeof(temp), "%s.XXXXXX", path);
+	if ((tfd = mkstemp(temp)) < 0) {
+		ni_error("Cannot create %s state temp file", path);
+		return FALSE;
+	}
+	if (write(tfd, &hdr, sizeof(hdr)) != sizeof(hdr) || rename(temp, path) < 0) {
+		ni_error("Cannot recreate state store %s: %m", path);
+		unlink(temp);
+		close(tfd);
+		return FALSE;
+	}
+	close(tfd);
 	return TRUE;
+}
 
-failure:
-	if (fp) {
-		fclose(fp);
+/*
+ * Open the store for writing, create it if needed and lock it.
+ * Retries when the store has been replaced by a compaction while
+ * we were waiting for the lock. A store with an invalid header is
+ * recreated, a torn record at the tail left by an interrupted write
+ * is truncated, so the following appends are visible to readers.
+ */
+static int
+ni_client_state_store_open_locked(const char *path)
+{
+	ni_client_state_store_index_t *index;
+	ni_client_state_store_header_t hdr;
+	struct stat fst, pst;
+	int fd;
+
+	do {
+		if ((fd = open(path, O_RDWR|O_APPEND|O_CREAT|O_CLOEXEC, 0600)) < 0) {
+			ni_error("Cannot open state store '%s': %m", path);
+			return -1;
+		}
+		if (flock(fd, LOCK_EX) < 0) {
+			ni_error("Cannot lock state store '%s': %m", path);
+			close(fd);
+			return -1;
+		}
+		if (fstat(fd, &fst) < 0 || stat(path, &pst) < 0 ||
+		    fst.st_ino != pst.st_ino || fst.st_dev != pst.st_dev) {
+			close(fd);
+			continue;
+		}
+
+		if (fst.st_size == 0)
+			break;
+
+		if ((index = ni_client_state_index_update(fd)))
+			break;
+
+		ni_warn("State store '%s' has an invalid header, recreating it", path);
+		if (!ni_client_state_store_recreate(path)) {
+			close(fd);
+			return -1;
+		}
+		close(fd);
+	} while (1);
+
+	if (fst.st_size == 0) {
+		memset(&hdr, 0, sizeof(hdr));
+		hdr.magic = NI_CLIENT_STATE_STORE_MAGIC;
+		hdr.version = NI_CLIENT_STATE_STORE_VERSION;
+		if (write(fd, &hdr, sizeof(hdr)) != sizeof(hdr)) {
+			ni_error("Cannot initialize state store '%s': %m", path);
+			close(fd);
+			return -1;
+		}
+	} else if (index->scanned < (size_t)fst.st_size) {
+		ni_warn("State store '%s' has a torn record at %zu, truncating it",
+				path, index->scanned);
+		if (ftruncate(fd, index->scanned) < 0) {
+			ni_error("Cannot truncate state store '%s': %m", path);
+			close(fd);
+			return -1;
+		}
 	}
-	unlink(temp);
-	return FALSE;
+	return fd;
 }
 
-ni_bool_t
-ni_client_state_load(ni_client_state_t *client_state, unsigned int ifindex)
+static void
+ni_client_state_record_put(ni_buffer_t *buf, unsigned int ifindex,
+			unsigned int type, const void *payload, size_t length)
 {
+	ni_client_state_record_t rec;
+	static const unsigned char pad[4];
+
+	memset(&rec, 0, sizeof(rec));
+	rec.magic = NI_CLIENT_STATE_RECORD_MAGIC;
+	rec.ifindex = ifindex;
+	rec.type = type;
+	rec.length = length;
+	rec.csum = ni_client_state_record_csum(&rec, payload);
+
+	ni_buffer_ensure_tailroom(buf, sizeof(rec) + NI_CLIENT_STATE_RECORD_ALIGN(length));
+	ni_buffer_put(buf, &rec, sizeof(rec));
+	ni_buffer_put(buf, payload, length);
+	ni_buffer_put(buf, pad, NI_CLIENT_STATE_RECORD_ALIGN(length) - length);
+}
+
+static int
+ni_client_state_record_ifindex_cmp(const void *a, const void *b)
+{
+	const ni_client_state_record_t *ra = *(const ni_client_state_record_t **)a;
+	const ni_client_state_record_t *rb = *(const ni_client_state_record_t **)b;
+
+	if (ra->ifindex != rb->ifindex)
+		return ra->ifindex < rb->ifindex ? -1 : 1;
+	/* preserve the log order of records of the same ifindex */
+	return ra < rb ? -1 : ra > rb;
+}
+
+/*
+ * Rewrite the store with the last save record of each ifindex.
+ * Called with the store lock held.
+ */
+static void
+ni_client_state_store_compact(int fd, const char *path)
+{
+	const ni_client_state_record_t *rec, **recs = NULL;
+	ni_client_state_store_map_t map;
+	ni_client_state_store_header_t hdr;
+	char temp[PATH_MAX] = {'\0'};
+	unsigned int count = 0, i;
+	size_t offset;
+	ni_buffer_t buf;
+	int tfd;
+
+	if (!ni_client_state_store_map(fd, &map))
+		return;
+
+	offset = sizeof(hdr);
+	while ((rec = ni_client_state_store_next(&map, &offset))) {
+		if ((count % 64) == 0)
+			recs = xrealloc(recs, (count + 64) * sizeof(*recs));
+		recs[count++] = rec;
+	}
+	qsort(recs, count, sizeof(*recs), ni_client_state_record_ifindex_cmp);
+
+	memset(&hdr, 0, sizeof(hdr));
+	hdr.magic = NI_CLIENT_STATE_STORE_MAGIC;
+	hdr.version = NI_CLIENT_STATE_STORE_VERSION;
+	ni_buffer_init_dynamic(&buf, map.size);
+	ni_buffer_put(&buf, &hdr, sizeof(hdr));
+	for (i = 0; i < count; ++i) {
+		rec = recs[i];
+		if (i + 1 < count && recs[i + 1]->ifindex == rec->ifindex)
+			continue;
+		if (rec->type != NI_CLIENT_STATE_RECORD_SAVE)
+			continue;
+		ni_client_state_record_put(&buf, rec->ifindex, rec->type,
+					rec + 1, rec->length);
+	}
+	free(recs);
+	ni_client_state_store_unmap(&map);
+
+	((ni_client_state_store_header_t *)buf.base)->compacted = ni_buffer_count(&buf);
+
+	snprintf(temp, sizeof(temp), "%s.XXXXXX", path);
+	if ((tfd = mkstemp(temp)) < 0) {
+		ni_error("Cannot create %s state temp file", path);
+		ni_buffer_destroy(&buf);
+		return;
+	}
+	if (write(tfd, ni_buffer_head(&buf), ni_buffer_count(&buf)) != (ssize_t)ni_buffer_count(&buf) ||
+	    rename(temp, path) < 0) {
+		ni_error("Cannot compact state store %s: %m", path);
+		unlink(temp);
+	} else {
+		ni_debug_verbose(NI_LOG_DEBUG3, NI_TRACE_READWRITE,
+			"compacted state store %s to %u bytes",
+			path, ni_buffer_count(&buf));
+	}
+	close(tfd);
+	ni_buffer_destroy(&buf);
+}
+
+/*
+ * Append records to the store, compacting it when it grew too large.
+ */
+static ni_bool_t
+ni_client_state_store_append(ni_buffer_t *records)
+{
+	ni_client_state_store_header_t hdr;
 	char path[PATH_MAX] = {'\0'};
-	xml_node_t *xml;
-	xml_node_t *node;
-	FILE *fp;
+	struct stat st;
+	ssize_t len;
+	int fd;
 
-	if (!client_state)
+	ni_client_state_store_filename(path, sizeof(path));
+	if ((fd = ni_client_state_store_open_locked(path)) < 0)
 		return FALSE;
 
-	ni_client_state_filename(ifindex, path, sizeof(path));
-	if (!(fp = fopen(path, "re"))) {
-		if (errno != ENOENT)
-			ni_error("Cannot open state file '%s': %m", path);
+	len = write(fd, ni_buffer_head(records), ni_buffer_count(records));
+	if (len != (ssize_t)ni_buffer_count(records)) {
+		ni_error("Cannot write into state store %s: %m", path);
+		close(fd);
 		return FALSE;
 	}
 
-	if (!(xml = xml_node_scan(fp, path))) {
-		fclose(fp);
-		ni_error("Cannot parse xml from state file '%s", path);
+	/* compact when the log grew to twice its live size */
+	if (fstat(fd, &st) == 0 && st.st_size > NI_CLIENT_STATE_COMPACT_SIZE &&
+	    pread(fd, &hdr, sizeof(hdr), 0) == sizeof(hdr) &&
+	    (size_t)st.st_size > 2 * (size_t)hdr.compacted)
+		ni_client_state_store_compact(fd, path);
+
+	close(fd);
+	return TRUE;
+}
+
+static ni_bool_t
+ni_client_state_encode(const ni_client_state_t *cs, ni_buffer_t *buf)
+{
+	size_t origin_len;
+	char *scripts = NULL;
+	size_t scripts_len = 0;
+
+	origin_len = ni_string_len(cs->config.origin);
+	if (origin_len > 0xffff)
+		return FALSE;
+
+	if (cs->scripts.node && !(scripts = xml_node_sprint(cs->scripts.node)))
+		return FALSE;
+	scripts_len = ni_string_len(scripts);
+
+	ni_buffer_ensure_tailroom(buf, 32 + origin_len + scripts_len);
+	ni_buffer_putc(buf, cs->control.persistent ? 1 : 0);
+	ni_buffer_putc(buf, cs->control.usercontrol ? 1 : 0);
+	ni_buffer_putc(buf, ni_tristate_is_set(cs->control.require_link) ?
+			(ni_tristate_is_enabled(cs->control.require_link) ? 1 : 0) : 0xff);
+	ni_buffer_putc(buf, 0);
+	ni_buffer_put(buf, cs->config.uuid.octets, sizeof(cs->config.uuid.octets));
+	ni_buffer_put_uint32(buf, cs->config.owner);
+	ni_buffer_put_uint16(buf, origin_len);
+	ni_buffer_put(buf, cs->config.origin, origin_len);
+	ni_buffer_put_uint32(buf, scripts_len);
+	ni_buffer_put(buf, scripts, scripts_len);
+
+	ni_string_free(&scripts);
+	return !buf->overflow;
+}
+
+static ni_bool_t
+ni_client_state_decode(ni_client_state_t *cs, const void *payload, size_t length)
+{
+	uint16_t origin_len;
+	uint32_t scripts_len;
+	xml_document_t *doc;
+	xml_node_t *node;
+	ni_buffer_t buf;
+	int c;
+
+	ni_buffer_init_reader(&buf, (void *)payload, length);
+
+	cs->control.persistent  = ni_buffer_getc(&buf) == 1;
+	cs->control.usercontrol = ni_buffer_getc(&buf) == 1;
+	if ((c = ni_buffer_getc(&buf)) == 0 || c == 1)
+		ni_tristate_set(&cs->control.require_link, c);
+	ni_buffer_getc(&buf);
+
+	if (ni_buffer_get(&buf, cs->config.uuid.octets, sizeof(cs->config.uuid.octets)) < 0 ||
+	    ni_buffer_get_uint32(&buf, &cs->config.owner) < 0 ||
+	    ni_buffer_get_uint16(&buf, &origin_len) < 0 ||
+	    ni_buffer_count(&buf) < origin_len)
 		return FALSE;
+
+	ni_string_set(&cs->config.origin, ni_buffer_head(&buf), origin_len);
+	ni_buffer_pull_head(&buf, origin_len);
+
+	if (ni_buffer_get_uint32(&buf, &scripts_len) < 0 ||
+	    ni_buffer_count(&buf) < scripts_len)
+		return FALSE;
+
+	if (scripts_len) {
+		ni_buffer_t xbuf;
+
+		ni_buffer_init_reader(&xbuf, ni_buffer_head(&buf), scripts_len);
+		if (!(doc = xml_document_from_buffer(&xbuf, NI_CLIENT_STATE_XML_SCRIPTS_NODE)))
+			return FALSE;
+		node = xml_node_get_child(xml_document_root(doc),
+				NI_CLIENT_STATE_XML_SCRIPTS_NODE);
+		if (node)
+			cs->scripts.node = xml_node_clone(node, NULL);
+		xml_document_free(doc);
+		if (!cs->scripts.node)
+			return FALSE;
 	}
-	fclose(fp);
+	return TRUE;
+}
 
-	node = xml->name ? xml : xml->children;
-	if (!node || !ni_string_eq(node->name, NI_CLIENT_STATE_XML_NODE)) {
-		ni_error("State file '%s' does not contain %s node",
-			path, NI_CLIENT_STATE_XML_NODE);
-		xml_node_free(xml);
+ni_bool_t
+ni_client_state_save(const ni_client_state_t *client_state, unsigned int ifindex)
+{
+	ni_buffer_t payload, records;
+	ni_bool_t ret;
+
+	if (!client_state)
+		return FALSE;
+
+	ni_buffer_init_dynamic(&payload, 128);
+	if (!ni_client_state_encode(client_state, &payload)) {
+		ni_error("Cannot encode client state for ifindex %u", ifindex);
+		ni_buffer_destroy(&payload);
 		return FALSE;
 	}
 
-	ni_client_state_reset(client_state);
-	if (!ni_client_state_parse_xml(node, client_state)) {
-		ni_error("Cannot parse state from file '%s'", path);
-		xml_node_free(xml);
+	ni_buffer_init_dynamic(&records, 256);
+	ni_client_state_record_put(&records, ifindex, NI_CLIENT_STATE_RECORD_SAVE,
+			ni_buffer_head(&payload), ni_buffer_count(&payload));
+	ret = ni_client_state_store_append(&records);
+
+	ni_buffer_destroy(&records);
+	ni_buffer_destroy(&payload);
+	return ret;
+}
+
+ni_bool_t
+ni_client_state_load(ni_client_state_t *client_state, unsigned int ifindex)
+{
+	const ni_client_state_record_t *rec = NULL;
+	char path[PATH_MAX] = {'\0'};
+	ni_bool_t ret = FALSE;
+	int fd;
+
+	if (!client_state)
 		return FALSE;
+
+	ni_client_state_store_filename(path, sizeof(path));
+	if ((fd = open(path, O_RDONLY|O_CLOEXEC)) >= 0) {
+		rec = ni_client_state_store_find(fd, ifindex);
+		close(fd);
+	} else if (errno != ENOENT) {
+		ni_error("Cannot open state store '%s': %m", path);
 	}
 
-	xml_node_free(xml);
+	if (rec) {
+		if (rec->type == NI_CLIENT_STATE_RECORD_SAVE) {
+			ni_client_state_reset(client_state);
+			ret = ni_client_state_decode(client_state, rec + 1, rec->length);
+			if (!ret)
+				ni_error("Cannot decode state of ifindex %u from '%s'",
+						ifindex, path);
+		}
+		return ret;
+	}
+
+	/* migrate the state of a legacy xml file into the store */
+	if (!ni_client_state_legacy_load(client_state, ifindex))
+		return FALSE;
+
+	if (ni_client_state_save(client_state, ifindex))
+		ni_client_state_legacy_drop(ifindex);
 	return TRUE;
 }
 
-
 ni_bool_t
 ni_client_state_move(unsigned int ifindex_old, unsigned int ifindex_new)
 {
+	const ni_client_state_record_t *rec = NULL;
 	char path_old[PATH_MAX] = {'\0'};
 	char path_new[PATH_MAX] = {'\0'};
+	char path[PATH_MAX] = {'\0'};
+	ni_buffer_t records;
+	ni_bool_t ret;
+	int fd;
 
 	if (ifindex_old == ifindex_new)
 		return TRUE;
 
+	ni_client_state_store_filename(path, sizeof(path));
+	if ((fd = ni_client_state_store_open_locked(path)) < 0)
+		return FALSE;
+
+	rec = ni_client_state_store_find(fd, ifindex_old);
+
+	if (rec && rec->type == NI_CLIENT_STATE_RECORD_SAVE) {
+		/* both records in one write, so the move is atomic */
+		ni_buffer_init_dynamic(&records, 2 * sizeof(*rec) + rec->length + 4);
+		ni_client_state_record_put(&records, ifindex_new,
+				NI_CLIENT_STATE_RECORD_SAVE, rec + 1, rec->length);
+		ni_client_state_record_put(&records, ifindex_old,
+				NI_CLIENT_STATE_RECORD_DROP, NULL, 0);
+
+		ret = write(fd, ni_buffer_head(&records), ni_buffer_count(&records)) ==
+			(ssize_t)ni_buffer_count(&records);
+		if (!ret)
+			ni_error("Cannot move state %u to %u in %s: %m",
+				ifindex_old, ifindex_new, path);
+		ni_buffer_destroy(&records);
+		close(fd);
+		return ret;
+	}
+	close(fd);
+
+	if (rec) {
+		ni_debug_verbose(NI_LOG_DEBUG3, NI_TRACE_READWRITE,
+			"state %u has been dropped, not moved to %u",
+			ifindex_old, ifindex_new);
+		return TRUE;
+	}
+
 	ni_client_state_filename(ifindex_old, path_old, sizeof(path_old));
 	ni_client_state_filename(ifindex_new, path_new, sizeof(path_new));
 
@@ -556,18 +1205,30 @@ ni_client_state_move(unsigned int ifindex_old, unsigned int ifindex_new)
 ni_bool_t
 ni_client_state_drop(unsigned int ifindex)
 {
+	const ni_client_state_record_t *rec = NULL;
 	char path[PATH_MAX] = {'\0'};
+	ni_buffer_t records;
+	ni_bool_t ret = TRUE;
+	int fd;
 
-	ni_client_state_filename(ifindex, path, sizeof(path));
-
-	if (unlink(path) < 0) {
-		if (errno == ENOENT)
-			return TRUE;
+	ni_client_state_store_filename(path, sizeof(path));
+	if ((fd = open(path, O_RDONLY|O_CLOEXEC)) >= 0) {
+		rec = ni_client_state_store_find(fd, ifindex);
+		if (rec && rec->type != NI_CLIENT_STATE_RECORD_SAVE)
+			rec = NULL;
+		close(fd);
+	}
 
-		ni_error("Cannot remove state file '%s': %m", path);
-		return FALSE;
+	/* don't grow the log with tombstones for unknown interfaces */
+	if (rec) {
+		ni_buffer_init_dynamic(&records, sizeof(*rec));
+		ni_client_state_record_put(&records, ifindex,
+				NI_CLIENT_STATE_RECORD_DROP, NULL, 0);
+		ret = ni_client_state_store_append(&records);
+		ni_buffer_destroy(&records);
 	}
-	return TRUE;
+
+	return ni_client_state_legacy_drop(ifindex) && ret;
 }
 
 ni_bool_t
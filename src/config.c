@@ -932,6 +932,13 @@ ni_config_parse_addrconf_dhcp6_nodes(ni_config_dhcp6_t *dhcp6, xml_node_t *node)
 			ni_config_parse_update_targets(&dhcp6->allow_update, child);
 			dhcp6->allow_update &= ni_config_addrconf_update_mask_dhcp6();
 		} else
+		if (!strcmp(child->name, "shared-socket")) {
+			if (ni_parse_boolean(child->cdata, &dhcp6->shared_socket)) {
+				ni_error("config: invalid <%s>%s</%s> element value",
+					child->name, child->cdata, child->name);
+				return FALSE;
+			}
+		} else
 		if (ni_string_eq(child->name, "define")) {
 			ni_config_parse_dhcp6_definitions(dhcp6, child);
 		}
@@ -13,6 +13,7 @@
 #include <wicked/util.h>
 #include <wicked/logging.h>
 #include <wicked/dbus-errors.h>
+#include <wicked/metrics.h>
 #include "socket_priv.h"
 #include "dbus-connection.h"
 #include "dbus-dict.h"
@@ -310,15 +311,19 @@ ni_dbus_connection_call(ni_dbus_connection_t *connection,
 {
 	DBusPendingCall *pending;
 	DBusMessage *reply;
+	struct timeval start;
 	int msgtype;
 
+	ni_metric_start(&start);
 	if (!dbus_connection_send_with_reply(connection->conn, call, &pending, call_timeout)) {
 		dbus_set_error(error, DBUS_ERROR_FAILED,
 				"unable to send DBus message (errno=%d)", errno);
+		ni_metric_count(NI_METRIC_DBUS_CALL_FAILED);
 		return NULL;
 	}
 
 	dbus_pending_call_block(pending);
+	ni_metric_record_since(NI_METRIC_DBUS_CALL, &start);
 
 	/* This makes sure that any signals we received while waiting for the reply
 	 * do get dispatched. */
@@ -329,6 +334,7 @@ ni_dbus_connection_call(ni_dbus_connection_t *connection,
 
 	if (reply == NULL) {
 		dbus_set_error(error, DBUS_ERROR_FAILED, "dbus: no reply");
+		ni_metric_count(NI_METRIC_DBUS_CALL_FAILED);
 		return NULL;
 	}
 
@@ -338,6 +344,7 @@ ni_dbus_connection_call(ni_dbus_connection_t *connection,
 		return reply;
 	}
 
+	ni_metric_count(NI_METRIC_DBUS_CALL_FAILED);
 	if (msgtype == DBUS_MESSAGE_TYPE_ERROR) {
 		dbus_set_error_from_message(error, reply);
 		ni_debug_dbus("dbus error reply = %s (%s)", error->name, error->message);
@@ -351,6 +358,29 @@ ni_dbus_connection_call(ni_dbus_connection_t *connection,
 	return NULL;
 }
 
+/*
+ * Dispatch the messages already queued, e.g. signals received along
+ * with a method reply, or block until data arrives on the connection
+ * or the timeout (in msec) expires and dispatch it.
+ * Returns FALSE when the connection is gone.
+ */
+ni_bool_t
+ni_dbus_connection_wait(ni_dbus_connection_t *connection, unsigned int timeout)
+{
+	if (!connection->dispatching &&
+	    dbus_connection_get_dispatch_status(connection->conn) == DBUS_DISPATCH_DATA_REMAINS) {
+		__ni_dbus_connection_dispatch(connection);
+		return TRUE;
+	}
+
+	if (!dbus_connection_read_write(connection->conn, timeout))
+		return FALSE;
+
+	if (!connection->dispatching)
+		__ni_dbus_connection_dispatch(connection);
+	return TRUE;
+}
+
 /*
  * Do an asynchronous call across a DBus connection
  */
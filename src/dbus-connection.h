@@ -15,6 +15,7 @@ extern ni_dbus_connection_t *	ni_dbus_connection_open(const char *bus_type, cons
 extern void			ni_dbus_connection_free(ni_dbus_connection_t *);
 extern ni_dbus_message_t *	ni_dbus_connection_call(ni_dbus_connection_t *connection,
 					ni_dbus_message_t *call, unsigned int call_timeout, DBusError *error);
+extern ni_bool_t		ni_dbus_connection_wait(ni_dbus_connection_t *, unsigned int timeout);
 extern int			ni_dbus_connection_call_async(ni_dbus_connection_t *connection,
 					ni_dbus_message_t *call, unsigned int timeout,
 					ni_dbus_async_callback_t *callback, ni_dbus_object_t *proxy);
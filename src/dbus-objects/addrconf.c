@@ -26,6 +26,7 @@
 #include <wicked/dbus-errors.h>
 #include <wicked/dbus-service.h>
 #include <wicked/resolver.h>
+#include <wicked/snapshot.h>
 #include "netinfo_priv.h"	/* for __ni_system_interface_update_lease */
 #include "dbus-common.h"
 #include "model.h"
@@ -299,6 +300,7 @@ ni_objectmodel_addrconf_signal_handler(ni_dbus_connection_t *conn, ni_dbus_messa
 		if (ni_addrconf_flag_bit_is_set(_lease->flags, NI_ADDRCONF_FLAGS_PRIMARY))
 			ni_objectmodel_addrconf_fallback_action(ifp, ifevent, _lease->family, NULL);
 
+		ni_snapshot_invalidate();
 		ni_objectmodel_addrconf_send_event(ifp, ifevent, &uuid);
 		goto done;
 	} else if (!strcmp(signal_name, NI_OBJECTMODEL_LEASE_RELEASED_SIGNAL)) {
@@ -327,7 +329,9 @@ ni_objectmodel_addrconf_signal_handler(ni_dbus_connection_t *conn, ni_dbus_messa
 	 *
 	 * Return code 0 is success, < 0 on error.
 	 */
-	if ((rv = __ni_system_interface_update_lease(ifp, &lease, ifevent)) < 0) {
+	rv = __ni_system_interface_update_lease(ifp, &lease, ifevent);
+	ni_snapshot_invalidate();
+	if (rv < 0) {
 		ni_warn("%s: failed to process %s:%s lease %s%s on signal %s%s%s",
 				ifp->name,
 				ni_addrfamily_type_to_name(forwarder->addrfamily),
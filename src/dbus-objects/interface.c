@@ -25,8 +25,10 @@
 #include <wicked/xml.h>
 #include "netinfo_priv.h"
 #include "dbus-common.h"
+#include "dbus-connection.h"
 #include "xml-schema.h"
 #include "appconfig.h"
+#include "util_priv.h"
 #include "model.h"
 #include "debug.h"
 
@@ -457,10 +459,138 @@ ni_objectmodel_netif_list_get_addresses(ni_dbus_object_t *object, const ni_dbus_
 	return rv;
 }
 
+/*
+ * InterfaceList.getStatusSummary
+ *
+ * Returns a compact status record per interface in a single reply,
+ * so status queries don't need to fetch all objects with all their
+ * properties. The argument dict may contain "name" and/or "index"
+ * entries (repeated) to restrict the result to these interfaces.
+ */
+static dbus_bool_t
+ni_objectmodel_netif_list_status_filter_match(const ni_dbus_variant_t *filter,
+						const ni_netdev_t *dev)
+{
+	const ni_dbus_variant_t *var;
+	const char *key, *name;
+	dbus_bool_t empty = TRUE;
+	unsigned int i;
+	uint32_t index;
+
+	for (i = 0; (var = ni_dbus_dict_get_entry(filter, i, &key)); ++i) {
+		if (ni_string_eq(key, "name") &&
+		    ni_dbus_variant_get_string(var, &name)) {
+			if (ni_string_eq(dev->name, name))
+				return TRUE;
+			empty = FALSE;
+		} else
+		if (ni_string_eq(key, "index") &&
+		    ni_dbus_variant_get_uint32(var, &index)) {
+			if (dev->link.ifindex == index)
+				return TRUE;
+			empty = FALSE;
+		}
+	}
+	return empty;
+}
+
+static dbus_bool_t
+ni_objectmodel_netif_status_to_dict(const ni_netdev_t *dev, ni_dbus_variant_t *dict)
+{
+	const ni_addrconf_lease_t *lease;
+	ni_dbus_variant_t *var, *entry;
+	ni_tristate_t link_required;
+
+	ni_dbus_dict_add_string(dict, "name",  dev->name);
+	ni_dbus_dict_add_uint32(dict, "index", dev->link.ifindex);
+	ni_dbus_dict_add_uint32(dict, "status", dev->link.ifflags);
+	ni_dbus_dict_add_uint32(dict, "type", dev->link.type);
+	ni_dbus_dict_add_uint32(dict, "oper-state", dev->link.oper_state);
+	if (!ni_string_empty(dev->link.masterdev.name))
+		ni_dbus_dict_add_string(dict, "master", dev->link.masterdev.name);
+
+	/* the guess needs e.g. the bridge ports, not in the summary */
+	link_required = ni_netdev_guess_link_required(dev);
+	if (ni_tristate_is_set(link_required))
+		ni_dbus_dict_add_bool(dict, "link-required",
+				ni_tristate_is_enabled(link_required));
+
+	if (dev->client_state) {
+		if (!(var = ni_dbus_dict_add(dict, "client-state")))
+			return FALSE;
+		ni_dbus_variant_init_dict(var);
+		if (!ni_objectmodel_netif_client_state_control_to_dict(&dev->client_state->control, var) ||
+		    !ni_objectmodel_netif_client_state_config_to_dict(&dev->client_state->config, var))
+			return FALSE;
+	}
+
+	if (!dev->leases)
+		return TRUE;
+
+	if (!(var = ni_dbus_dict_add(dict, "leases")))
+		return FALSE;
+	ni_dbus_dict_array_init(var);
+	for (lease = dev->leases; lease; lease = lease->next) {
+		if (!(entry = ni_dbus_dict_array_add(var)))
+			return FALSE;
+		ni_dbus_dict_add_uint32(entry, "family", lease->family);
+		ni_dbus_dict_add_uint32(entry, "type",   lease->type);
+		ni_dbus_dict_add_uint32(entry, "state",  lease->state);
+		ni_dbus_dict_add_uint32(entry, "flags",  lease->flags);
+	}
+	return TRUE;
+}
+
+static dbus_bool_t
+ni_objectmodel_netif_list_get_status_summary(ni_dbus_object_t *object, const ni_dbus_method_t *method,
+			unsigned int argc, const ni_dbus_variant_t *argv,
+			ni_dbus_message_t *reply, DBusError *error)
+{
+	ni_dbus_variant_t result = NI_DBUS_VARIANT_INIT;
+	ni_netconfig_t *nc = ni_global_state_handle(0);
+	ni_dbus_variant_t *dict;
+	ni_netdev_t *dev;
+	const char *path;
+	dbus_bool_t rv;
+
+	if (!reply || !argv || argc != 1 || !ni_dbus_variant_is_dict(&argv[0])) {
+		dbus_set_error(error, DBUS_ERROR_INVALID_ARGS,
+				"%s.%s: invalid filter argument dict",
+				object->path, method->name);
+		return FALSE;
+	}
+
+	ni_dbus_variant_init_dict(&result);
+	for (dev = nc ? ni_netconfig_devlist(nc) : NULL; dev; dev = dev->next) {
+		path = ni_objectmodel_netif_full_path(dev);
+		if (ni_string_empty(path))
+			continue;
+
+		if (!ni_objectmodel_netif_list_status_filter_match(&argv[0], dev))
+			continue;
+
+		if (!(dict = ni_dbus_dict_add(&result, path)))
+			break;
+		ni_dbus_variant_init_dict(dict);
+		if (!ni_objectmodel_netif_status_to_dict(dev, dict)) {
+			ni_dbus_variant_destroy(&result);
+			dbus_set_error(error, DBUS_ERROR_FAILED,
+				"%s.%s: unable to encode status of %s",
+				object->path, method->name, dev->name);
+			return FALSE;
+		}
+	}
+
+	rv = ni_dbus_message_serialize_variants(reply, 1, &result, error);
+	ni_dbus_variant_destroy(&result);
+	return rv;
+}
+
 static ni_dbus_method_t		ni_objectmodel_netif_list_methods[] = {
 	{ "deviceByName",	"s",		ni_objectmodel_netif_list_device_by_name },
 	{ "identifyDevice",	"sa{sv}",	ni_objectmodel_netif_list_identify_device },
 	{ "getAddresses",	"a{sv}",	ni_objectmodel_netif_list_get_addresses },
+	{ "getStatusSummary",	"a{sv}",	ni_objectmodel_netif_list_get_status_summary },
 	{ NULL }
 };
 
@@ -646,6 +776,67 @@ ni_objectmodel_netif_factory_result(ni_dbus_server_t *server, ni_dbus_message_t
 	return rv;
 }
 
+/*
+ * Factories of devices created in background, e.g. by teamd, defer
+ * their reply: the factory call is passed as callback data to the
+ * ni_system_*_create function and replied to once the device has
+ * appeared or its creation failed.
+ */
+struct ni_objectmodel_netif_factory_call {
+	ni_dbus_connection_t *	connection;
+	ni_dbus_server_t *	server;
+	ni_dbus_message_t *	call;
+	ni_iftype_t		iftype;
+};
+
+ni_objectmodel_netif_factory_call_t *
+ni_objectmodel_netif_factory_call_new(ni_dbus_connection_t *connection,
+				ni_dbus_object_t *factory_object, ni_dbus_message_t *call,
+				ni_iftype_t iftype)
+{
+	ni_objectmodel_netif_factory_call_t *fcall;
+
+	fcall = xcalloc(1, sizeof(*fcall));
+	fcall->connection = connection;
+	fcall->server = ni_dbus_object_get_server(factory_object);
+	fcall->call = dbus_message_ref(call);
+	fcall->iftype = iftype;
+	return fcall;
+}
+
+void
+ni_objectmodel_netif_factory_call_free(ni_objectmodel_netif_factory_call_t *fcall)
+{
+	if (fcall->call)
+		dbus_message_unref(fcall->call);
+	free(fcall);
+}
+
+void
+ni_objectmodel_netif_factory_call_done(const char *ifname, ni_netdev_t *dev, void *user_data)
+{
+	ni_objectmodel_netif_factory_call_t *fcall = user_data;
+	DBusError error = DBUS_ERROR_INIT;
+	ni_dbus_message_t *reply;
+
+	reply = dbus_message_new_method_return(fcall->call);
+	if (!dev) {
+		dbus_set_error(&error, DBUS_ERROR_FAILED, "Unable to create %s interface '%s'",
+				ni_linktype_type_to_name(fcall->iftype), ifname);
+	} else
+	if (ni_objectmodel_netif_factory_result(fcall->server, reply, dev, NULL, &error)) {
+		if (ni_dbus_connection_send_message(fcall->connection, reply) < 0)
+			ni_error("unable to send reply (out of memory)");
+	}
+
+	if (dbus_error_is_set(&error))
+		ni_dbus_connection_send_error(fcall->connection, fcall->call, &error);
+
+	dbus_message_unref(reply);
+	dbus_error_free(&error);
+	ni_objectmodel_netif_factory_call_free(fcall);
+}
+
 /*
  * Build a dummy dbus object encapsulating a network interface,
  * and add the appropriate dbus services
@@ -1420,6 +1611,7 @@ __ni_objectmodel_netif_set_addresses(ni_dbus_object_t *object,
 {
 	ni_netdev_t *ifp = ni_dbus_object_get_handle(object);
 
+	ni_netdev_addrs_changed(ifp);
 	return __ni_objectmodel_set_address_list(&ifp->addrs, argument, error);
 }
 
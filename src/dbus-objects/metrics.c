@@ -0,0 +1,100 @@
+/*
+ * DBus encapsulation of the built-in metrics
+ *
+ * Copyright (C) 2026 SUSE LLC
+ */
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <wicked/netinfo.h>
+#include <wicked/logging.h>
+#include <wicked/metrics.h>
+#include <wicked/dbus-errors.h>
+#include <wicked/dbus-service.h>
+#include <wicked/objectmodel.h>
+#include "model.h"
+#include "debug.h"
+
+/*
+ * Metrics.getMetrics() returns a dict of all metrics
+ */
+static dbus_bool_t
+ni_objectmodel_metrics_get(ni_dbus_object_t *object, const ni_dbus_method_t *method,
+			unsigned int argc, const ni_dbus_variant_t *argv,
+			ni_dbus_message_t *reply, DBusError *error)
+{
+	ni_dbus_variant_t result = NI_DBUS_VARIANT_INIT;
+	ni_metric_stats_t stats;
+	ni_dbus_variant_t *dict;
+	unsigned int id;
+	dbus_bool_t rv;
+
+	if (argc != 0)
+		return ni_dbus_error_invalid_args(error, object->path, method->name);
+
+	ni_dbus_variant_init_dict(&result);
+	for (id = 0; id < NI_METRIC_MAX; ++id) {
+		if (!ni_metric_get_stats(id, &stats))
+			continue;
+
+		if (!(dict = ni_dbus_dict_add(&result, ni_metric_name(id))))
+			break;
+
+		ni_dbus_variant_init_dict(dict);
+		ni_dbus_dict_add_uint64(dict, "count", stats.count);
+		if (!ni_metric_is_histogram(id))
+			continue;
+
+		ni_dbus_dict_add_uint64(dict, "sum", stats.sum);
+		ni_dbus_dict_add_uint64(dict, "max", stats.max);
+		ni_dbus_dict_add_uint64(dict, "p50", stats.p50);
+		ni_dbus_dict_add_uint64(dict, "p90", stats.p90);
+		ni_dbus_dict_add_uint64(dict, "p99", stats.p99);
+	}
+
+	rv = ni_dbus_message_serialize_variants(reply, 1, &result, error);
+	ni_dbus_variant_destroy(&result);
+	return rv;
+}
+
+/*
+ * Metrics.resetMetrics()
+ */
+static dbus_bool_t
+ni_objectmodel_metrics_reset(ni_dbus_object_t *object, const ni_dbus_method_t *method,
+			unsigned int argc, const ni_dbus_variant_t *argv,
+			ni_dbus_message_t *reply, DBusError *error)
+{
+	if (argc != 0)
+		return ni_dbus_error_invalid_args(error, object->path, method->name);
+
+	ni_metrics_reset();
+	return TRUE;
+}
+
+static ni_dbus_method_t		ni_objectmodel_metrics_methods[] = {
+	{ "getMetrics",		"",		ni_objectmodel_metrics_get },
+	{ "resetMetrics",	"",		ni_objectmodel_metrics_reset },
+	{ NULL }
+};
+
+static ni_dbus_service_t	ni_objectmodel_metrics_service = {
+	.name		= NI_OBJECTMODEL_METRICS_INTERFACE,
+	.methods	= ni_objectmodel_metrics_methods,
+};
+
+/*
+ * Register the metrics interface with the root object of a server
+ */
+dbus_bool_t
+ni_objectmodel_register_metrics(ni_dbus_server_t *server)
+{
+	ni_dbus_object_t *root;
+
+	if (!server || !(root = ni_dbus_server_get_root_object(server)))
+		return FALSE;
+
+	ni_dbus_object_register_service(root, &ni_objectmodel_metrics_service);
+	return TRUE;
+}
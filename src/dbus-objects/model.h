@@ -79,6 +79,7 @@ __ni_objectmodel_get_property_ulong(const void *handle, unsigned long *member_of
 	return ni_dbus_variant_set_ulong(result, *__pointer(handle, member_offset));
 }
 
+typedef struct ni_objectmodel_netif_factory_call ni_objectmodel_netif_factory_call_t;
 
 extern ni_dbus_server_t *	__ni_objectmodel_server;
 extern ni_xs_scope_t *		__ni_objectmodel_schema;
@@ -125,6 +126,13 @@ extern ni_netdev_t *		ni_objectmodel_get_netif_argument(const ni_dbus_variant_t
 extern dbus_bool_t		ni_objectmodel_netif_factory_result(ni_dbus_server_t *, ni_dbus_message_t *,
 						ni_netdev_t *, const ni_dbus_class_t *,
 						DBusError *);
+extern ni_objectmodel_netif_factory_call_t *
+				ni_objectmodel_netif_factory_call_new(ni_dbus_connection_t *,
+						ni_dbus_object_t *, ni_dbus_message_t *,
+						ni_iftype_t);
+extern void			ni_objectmodel_netif_factory_call_free(ni_objectmodel_netif_factory_call_t *);
+extern void			ni_objectmodel_netif_factory_call_done(const char *, ni_netdev_t *,
+						void *);
 extern const char *		ni_objectmodel_netif_path(const ni_netdev_t *);
 extern const char *		ni_objectmodel_netif_full_path(const ni_netdev_t *);
 extern const char *		ni_objectmodel_interface_full_path(const ni_netdev_t *);
@@ -32,45 +32,53 @@
 #include <wicked/dbus-errors.h>
 #include <wicked/dbus-service.h>
 #include "dbus-common.h"
+#include "dbus-connection.h"
 #include "dbus-objects/misc.h"
 #include "appconfig.h"
 #include "model.h"
 #include "debug.h"
 
 static ni_netdev_t *		ni_objectmodel_ppp_device_arg(const ni_dbus_variant_t *);
-static ni_netdev_t *		ni_objectmodel_ppp_device_create(ni_netdev_t *, const char *, DBusError *);
+static dbus_bool_t		ni_objectmodel_ppp_device_create(ni_netdev_t *, const char *,
+					ni_objectmodel_netif_factory_call_t *, DBusError *);
 
 /*
- * Create a new ppp interface
+ * Create a new ppp interface; pppd creates it in background, so
+ * the reply is deferred until the device appeared.
  */
 static dbus_bool_t
-ni_objectmodel_ppp_device_new(ni_dbus_object_t *factory_object, const ni_dbus_method_t *method,
-			unsigned int argc, const ni_dbus_variant_t *argv,
-			ni_dbus_message_t *reply, DBusError *error)
+ni_objectmodel_ppp_device_new(ni_dbus_connection_t *connection, ni_dbus_object_t *factory_object,
+			const ni_dbus_method_t *method, ni_dbus_message_t *call)
 {
-	ni_dbus_server_t *server = ni_dbus_object_get_server(factory_object);
-	ni_netdev_t *dev, *cfg;
+	ni_dbus_variant_t argv[2];
+	DBusError error = DBUS_ERROR_INIT;
+	ni_objectmodel_netif_factory_call_t *fcall;
 	const char *ifname = NULL;
+	ni_netdev_t *cfg;
+	int argc;
+
+	memset(argv, 0, sizeof(argv));
+	argc = ni_dbus_message_get_args_variants(call, argv, 2);
+
+	if (argc != 2 || !ni_dbus_variant_get_string(&argv[0], &ifname) ||
+	    !(cfg = ni_objectmodel_ppp_device_arg(&argv[1]))) {
+		ni_dbus_error_invalid_args(&error, factory_object->path, method->name);
+	} else {
+		fcall = ni_objectmodel_netif_factory_call_new(connection, factory_object,
+				call, NI_IFTYPE_PPP);
+		if (!ni_objectmodel_ppp_device_create(cfg, ifname, fcall, &error))
+			ni_objectmodel_netif_factory_call_free(fcall);
+		ni_netdev_put(cfg);
+	}
 
-	if (argc != 2)
-		goto error;
-
-	if (!ni_dbus_variant_get_string(&argv[0], &ifname))
-		goto error;
-
-	if (!(cfg = ni_objectmodel_ppp_device_arg(&argv[1])))
-		goto error;
-
-	dev = ni_objectmodel_ppp_device_create(cfg, ifname, error);
-	ni_netdev_put(cfg);
-
-	if (dev)
-		return ni_objectmodel_netif_factory_result(server, reply, dev, NULL, error);
-	else
-		return FALSE;
+	/* errors are replied to here, the result when the device appeared */
+	if (dbus_error_is_set(&error))
+		ni_dbus_connection_send_error(connection, call, &error);
 
-error:
-	return ni_dbus_error_invalid_args(error, factory_object->path, method->name);
+	while (argc-- > 0)
+		ni_dbus_variant_destroy(&argv[argc]);
+	dbus_error_free(&error);
+	return TRUE;
 }
 
 static ni_netdev_t *
@@ -79,34 +87,26 @@ ni_objectmodel_ppp_device_arg(const ni_dbus_variant_t *dict)
 	return ni_objectmodel_get_netif_argument(dict, NI_IFTYPE_PPP, &ni_objectmodel_ppp_service);
 }
 
-static ni_netdev_t *
-ni_objectmodel_ppp_device_create(ni_netdev_t *cfg, const char *ifname, DBusError *error)
+static dbus_bool_t
+ni_objectmodel_ppp_device_create(ni_netdev_t *cfg, const char *ifname,
+			ni_objectmodel_netif_factory_call_t *fcall, DBusError *error)
 {
 	ni_netconfig_t *nc = ni_global_state_handle(0);
-	ni_netdev_t *dev = NULL;
-	int rv;
 
 	ni_netdev_get_ppp(cfg);
 	if (ifname == NULL && !(ifname = ni_netdev_make_name(nc, "ppp", 0))) {
 		dbus_set_error(error, DBUS_ERROR_FAILED,
 				"Unable to create ppp interface - too many interfaces");
-		return NULL;
+		return FALSE;
 	}
 	ni_string_dup(&cfg->name, ifname);
 
-	if ((rv = ni_system_ppp_create(nc, cfg, &dev)) < 0) {
+	if (ni_system_ppp_create(nc, cfg, ni_objectmodel_netif_factory_call_done, fcall) < 0) {
 		dbus_set_error(error, DBUS_ERROR_FAILED, "Unable to create ppp interface '%s'",
 				cfg->name);
-		return NULL;
-	}
-
-	if (dev && dev->link.type != NI_IFTYPE_PPP) {
-		dbus_set_error(error, DBUS_ERROR_FAILED,
-			"Unable to create ppp interface: new interface is of type %s",
-			ni_linktype_type_to_name(dev->link.type));
-		return NULL;
+		return FALSE;
 	}
-	return dev;
+	return TRUE;
 }
 
 /*
@@ -656,7 +656,7 @@ static ni_dbus_method_t		ni_objectmodel_ppp_device_methods[] = {
 };
 
 static ni_dbus_method_t		ni_objectmodel_ppp_factory_methods[] = {
-	{ "newDevice",		"sa{sv}",	ni_objectmodel_ppp_device_new },
+	{ "newDevice",		"sa{sv}",	.async_handler = ni_objectmodel_ppp_device_new },
 	{ NULL }
 };
 
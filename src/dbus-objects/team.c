@@ -35,13 +35,15 @@
 #include <wicked/dbus-errors.h>
 #include <wicked/dbus-service.h>
 #include "dbus-common.h"
+#include "dbus-connection.h"
 #include "model.h"
 #include "debug.h"
 #include "appconfig.h"
 
 
 static ni_netdev_t *	__ni_objectmodel_team_device_arg(const ni_dbus_variant_t *);
-static ni_netdev_t *	__ni_objectmodel_team_newlink(ni_netdev_t *, const char *, DBusError *);
+static dbus_bool_t	__ni_objectmodel_team_newlink(ni_netdev_t *, const char *,
+					ni_objectmodel_netif_factory_call_t *, DBusError *);
 
 /*
  * Return an interface handle containing all bridge-specific information provided
@@ -65,37 +67,52 @@ ni_objectmodel_team_report_disabled(DBusError *error)
 }
 
 /*
- * Create a new team interface
+ * Create a new team interface; teamd creates it in background, so
+ * the reply is deferred until the device appeared.
  */
 static dbus_bool_t
-ni_objectmodel_new_team(ni_dbus_object_t *factory_object, const ni_dbus_method_t *method,
-			unsigned int argc, const ni_dbus_variant_t *argv,
-			ni_dbus_message_t *reply, DBusError *error)
+ni_objectmodel_new_team(ni_dbus_connection_t *connection, ni_dbus_object_t *factory_object,
+			const ni_dbus_method_t *method, ni_dbus_message_t *call)
 {
-	ni_dbus_server_t *server = ni_dbus_object_get_server(factory_object);
-	ni_netdev_t *ifp;
+	ni_dbus_variant_t argv[2];
+	DBusError error = DBUS_ERROR_INIT;
+	ni_objectmodel_netif_factory_call_t *fcall;
 	const char *ifname = NULL;
+	ni_netdev_t *ifp;
+	int argc;
+
+	memset(argv, 0, sizeof(argv));
+	argc = ni_dbus_message_get_args_variants(call, argv, 2);
+
+	if (!ni_objectmodel_team_report_disabled(&error)) {
+		/* error set */
+	} else
+	if (argc != 2 || !ni_dbus_variant_get_string(&argv[0], &ifname)
+	 || !(ifp = __ni_objectmodel_team_device_arg(&argv[1]))) {
+		ni_dbus_error_invalid_args(&error, factory_object->path, method->name);
+	} else {
+		fcall = ni_objectmodel_netif_factory_call_new(connection, factory_object,
+				call, NI_IFTYPE_TEAM);
+		if (!__ni_objectmodel_team_newlink(ifp, ifname, fcall, &error))
+			ni_objectmodel_netif_factory_call_free(fcall);
+	}
 
-	if (!ni_objectmodel_team_report_disabled(error))
-		return FALSE;
-
-	ni_assert(argc == 2);
-	if (!ni_dbus_variant_get_string(&argv[0], &ifname)
-	 || !(ifp = __ni_objectmodel_team_device_arg(&argv[1])))
-		return ni_dbus_error_invalid_args(error, factory_object->path, method->name);
+	/* errors are replied to here, the result when the device appeared */
+	if (dbus_error_is_set(&error))
+		ni_dbus_connection_send_error(connection, call, &error);
 
-	if (!(ifp = __ni_objectmodel_team_newlink(ifp, ifname, error)))
-		return FALSE;
-
-	return ni_objectmodel_netif_factory_result(server, reply, ifp, NULL, error);
+	while (argc-- > 0)
+		ni_dbus_variant_destroy(&argv[argc]);
+	dbus_error_free(&error);
+	return TRUE;
 }
 
-static ni_netdev_t *
-__ni_objectmodel_team_newlink(ni_netdev_t *cfg_ifp, const char *ifname, DBusError *error)
+static dbus_bool_t
+__ni_objectmodel_team_newlink(ni_netdev_t *cfg_ifp, const char *ifname,
+			ni_objectmodel_netif_factory_call_t *fcall, DBusError *error)
 {
 	ni_netconfig_t *nc = ni_global_state_handle(0);
-	ni_netdev_t *new_ifp = NULL;
-	int rv;
+	dbus_bool_t rv = FALSE;
 
 	ni_netdev_get_team(cfg_ifp);
 	if (ifname == NULL && !(ifname = ni_netdev_make_name(nc, "team", 0))) {
@@ -117,36 +134,17 @@ __ni_objectmodel_team_newlink(ni_netdev_t *cfg_ifp, const char *ifname, DBusErro
 		}
 	}
 
-	if ((rv = ni_system_team_create(nc, cfg_ifp, &new_ifp)) < 0) {
+	if (ni_system_team_create(nc, cfg_ifp, ni_objectmodel_netif_factory_call_done, fcall) < 0) {
 		dbus_set_error(error, DBUS_ERROR_FAILED,
 				"Unable to create team interface '%s'", cfg_ifp->name);
-		new_ifp = NULL;
 		goto out;
-#if 0
-		if (rv != -NI_ERROR_DEVICE_EXISTS
-		 && (ifname != NULL && strcmp(ifname, new_ifp->name))) {
-			dbus_set_error(error,
-					DBUS_ERROR_FAILED,
-					"Unable to create team interface: %s",
-					ni_strerror(rv));
-			goto out;
-		}
-		ni_debug_dbus("Bonding interface exists (and name matches)");
-#endif
-	}
-
-	if (new_ifp->link.type != NI_IFTYPE_TEAM) {
-		dbus_set_error(error,
-				DBUS_ERROR_FAILED,
-				"Unable to create team interface: new interface is of type %s",
-				ni_linktype_type_to_name(new_ifp->link.type));
-		new_ifp = NULL;
 	}
+	rv = TRUE;
 
 out:
 	if (cfg_ifp)
 		ni_netdev_put(cfg_ifp);
-	return new_ifp;
+	return rv;
 }
 
 /*
@@ -904,7 +902,7 @@ static ni_dbus_method_t		ni_objectmodel_team_methods[] = {
 };
 
 static ni_dbus_method_t		ni_objectmodel_team_factory_methods[] = {
-	{ "newDevice",		"sa{sv}",			ni_objectmodel_new_team },
+	{ "newDevice",		"sa{sv}",			.async_handler = ni_objectmodel_new_team },
 	{ NULL }
 };
 
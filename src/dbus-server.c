@@ -11,6 +11,8 @@
 #include <wicked/logging.h>
 #include <wicked/dbus-service.h>
 #include <wicked/dbus-errors.h>
+#include <wicked/metrics.h>
+#include <wicked/snapshot.h>
 #include "dbus-server.h"
 #include "dbus-object.h"
 #include "dbus-dict.h"
@@ -82,6 +84,15 @@ ni_dbus_server_free(ni_dbus_server_t *server)
 	free(server);
 }
 
+/*
+ * Retrieve the server's bus connection
+ */
+ni_dbus_connection_t *
+ni_dbus_server_get_connection(const ni_dbus_server_t *server)
+{
+	return server->connection;
+}
+
 /*
  * Retrieve the server's root object
  */
@@ -157,6 +168,8 @@ ni_dbus_server_send_signal(ni_dbus_server_t *server, ni_dbus_object_t *object,
 	if (ni_dbus_connection_send_message(server->connection, msg) < 0)
 		goto out;
 
+	/* signals announce state changes */
+	ni_snapshot_invalidate();
 	rv = TRUE;
 
 out:
@@ -577,6 +590,9 @@ __ni_dbus_object_message(DBusConnection *conn, DBusMessage *call, void *user_dat
 	const ni_dbus_service_t *svc;
 	ni_dbus_server_t *server;
 	dbus_bool_t rv = FALSE;
+	struct timeval start;
+
+	ni_metric_start(&start);
 
 	/* Clean out deceased objects */
 	ni_dbus_objects_garbage_collect();
@@ -674,12 +690,14 @@ __ni_dbus_object_message(DBusConnection *conn, DBusMessage *call, void *user_dat
 
 			/* Beware, object may be gone after this! */
 			object = NULL;
+			ni_snapshot_invalidate();
 
 			while (argc--)
 				ni_dbus_variant_destroy(&argv[argc]);
 		} else
 		if (method->async_handler) {
 			rv = method->async_handler(server->connection, object, method, call);
+			ni_snapshot_invalidate();
 		} else {
 			dbus_set_error(&error, DBUS_ERROR_FAILED, "No server side handler for method");
 			rv = FALSE;
@@ -693,6 +711,7 @@ error_reply:
 		if (!dbus_error_is_set(&error))
 			dbus_set_error(&error, DBUS_ERROR_FAILED, "Unexpected error in method call");
 		reply = dbus_message_new_error(call, error.name, error.message);
+		ni_metric_count(NI_METRIC_DBUS_METHOD_FAILED);
 	}
 
 	/* send reply */
@@ -703,6 +722,7 @@ error_reply:
 	if (reply)
 		dbus_message_unref(reply);
 
+	ni_metric_record_since(NI_METRIC_DBUS_METHOD, &start);
 	return DBUS_HANDLER_RESULT_HANDLED;
 
 
@@ -1766,20 +1766,13 @@ int
 ni_dbus_xml_expand_element_reference(xml_node_t *doc_node, const char *expr_string,
 			xml_node_t **ret_nodes, unsigned int max_nodes)
 {
-	xpath_enode_t *expression;
 	xpath_result_t *result;
 	unsigned int i, nret;
 
 	if (xml_node_is_empty(doc_node))
 		return 0;
 
-	expression = xpath_expression_parse(expr_string);
-	if (expression == NULL)
-		return -NI_ERROR_DOCUMENT_ERROR;
-
-	result = xpath_expression_eval(expression, doc_node);
-	xpath_expression_free(expression);
-
+	result = xpath_expression_eval_cached(expr_string, doc_node);
 	if (result == NULL)
 		return -NI_ERROR_DOCUMENT_ERROR;
 
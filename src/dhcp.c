@@ -1815,6 +1815,366 @@ failure:
 	return FALSE;
 }
 
+static void
+ni_dhcp_decode_list_rollback(ni_string_array_t *list, unsigned int count)
+{
+	while (list->count > count)
+		ni_string_array_remove_index(list, list->count - 1);
+}
+
+/*
+ * Appends the decoded addresses of the family to the list; on failure,
+ * the list is restored to the count it had when called.
+ */
+int
+ni_dhcp_decode_address_list(ni_buffer_t *bp, ni_string_array_t *list, int family)
+{
+	unsigned int alen = ni_af_address_length(family);
+	unsigned int count = list->count;
+	ni_sockaddr_t addr;
+
+	if (!alen || ni_buffer_count(bp) % alen) {
+		bp->underflow = 1;
+		return -1;
+	}
+
+	while (ni_buffer_count(bp) && !bp->underflow) {
+		memset(&addr, 0, sizeof(addr));
+		addr.ss_family = family;
+		if (ni_buffer_get(bp, family == AF_INET ? (void *)&addr.sin.sin_addr :
+					(void *)&addr.six.sin6_addr, alen) < 0)
+			goto failure;
+
+		ni_string_array_append(list, ni_sockaddr_print(&addr));
+	}
+
+	if (bp->underflow)
+		goto failure;
+
+	return 0;
+
+failure:
+	ni_dhcp_decode_list_rollback(list, count);
+	return -1;
+}
+
+/*
+ * Decode an RFC3397 DNS search order option, appending the names
+ * to the list (restored to the initial count on failure).
+ */
+int
+ni_dhcp_decode_name_list(ni_buffer_t *optbuf, ni_string_array_t *list, const char *what)
+{
+	ni_stringbuf_t namebuf = NI_STRINGBUF_INIT_DYNAMIC;
+	unsigned char *base = ni_buffer_head(optbuf);
+	unsigned int base_offset = optbuf->head;
+	unsigned int count = list->count;
+	size_t len;
+
+	while (ni_buffer_count(optbuf) && !optbuf->underflow) {
+		ni_buffer_t *bp = optbuf;
+		ni_buffer_t jumpbuf;
+
+		while (1) {
+			unsigned int pos = bp->head - base_offset;
+			unsigned int pointer;
+			char label[64];
+			int length;
+
+			if ((length = ni_buffer_getc(bp)) == EOF) {
+				bp->underflow = 1;
+				goto failure; /* unexpected EOF */
+			}
+
+			if (length == 0)
+				break;	/* end of this name */
+
+			switch (length & 0xC0) {
+			case 0:
+				/* Plain name component */
+				if (ni_buffer_get(bp, label, length) < 0)
+					goto failure;
+
+				label[length] = '\0';
+				if (!ni_stringbuf_empty(&namebuf))
+					ni_stringbuf_putc(&namebuf, '.');
+				ni_stringbuf_puts(&namebuf, label);
+				break;
+
+			case 0xC0:
+				/* Pointer */
+				pointer = (length & 0x3F) << 8;
+				if ((length = ni_buffer_getc(bp)) == EOF) {
+					bp->underflow = 1;
+					goto failure;
+				}
+
+				pointer |= length;
+				if (pointer >= pos)
+					goto failure;
+
+				ni_buffer_init_reader(&jumpbuf, base, pos);
+				jumpbuf.head = pointer;
+				bp = &jumpbuf;
+				break;
+
+			default:
+				goto failure;
+			}
+
+		}
+
+		if (!ni_stringbuf_empty(&namebuf)) {
+
+			len = ni_string_len(namebuf.string);
+			if (ni_check_domain_name(namebuf.string, len, 0)) {
+				ni_string_array_append(list, namebuf.string);
+			} else {
+				ni_warn("Discarded suspect %s: '%s'", what,
+					ni_print_suspect(namebuf.string, len));
+			}
+		}
+		ni_stringbuf_destroy(&namebuf);
+	}
+
+	return 0;
+
+failure:
+	ni_stringbuf_destroy(&namebuf);
+	ni_dhcp_decode_list_rollback(list, count);
+	return -1;
+}
+
+/*
+ * Table driven option codec
+ */
+ni_bool_t
+ni_dhcp_option_codec_check(const ni_dhcp_option_codec_t *codec, unsigned int len)
+{
+	if (!codec || len < codec->minlen || len > codec->maxlen)
+		return FALSE;
+	if (codec->unit && (len % codec->unit))
+		return FALSE;
+	return TRUE;
+}
+
+static int
+ni_dhcp_option_codec_get_string(const ni_dhcp_option_codec_t *codec, const char *what,
+				ni_buffer_t *bp, char **str)
+{
+	unsigned int len = ni_buffer_count(bp);
+	ni_bool_t valid;
+
+	if (!len) {
+		bp->underflow = 1;
+		return -1;
+	}
+
+	*str = xmalloc(len + 1);
+	if (ni_buffer_get(bp, *str, len) < 0) {
+		ni_string_free(str);
+		return -1;
+	}
+	(*str)[len] = '\0';
+
+	switch (codec->type) {
+	case NI_DHCP_CODEC_DOMAIN:
+		valid = ni_check_domain_name(*str, len, 0);
+		break;
+	case NI_DHCP_CODEC_PATHNAME:
+		valid = ni_check_pathname(*str, len);
+		break;
+	default:
+		valid = ni_check_printable(*str, len);
+		break;
+	}
+	if (!valid) {
+		ni_warn("Discarded suspect %s: '%s'", what, ni_print_suspect(*str, len));
+		ni_string_free(str);
+		return -1;
+	}
+	return 0;
+}
+
+/*
+ * Decodes the option data into the codec field of the parse context.
+ * Lists are appended to, other fields replaced; data of options without
+ * a field is decoded and discarded. Returns 0 when the option has been
+ * consumed (also when invalid data has been discarded), 1 when the codec
+ * has no decoder and -1 on allocation failure.
+ */
+int
+ni_dhcp_option_codec_decode(const ni_dhcp_option_codec_t *codec, const char *name,
+				ni_buffer_t *bp, void *ctx)
+{
+	ni_string_array_t temp = NI_STRING_ARRAY_INIT;
+	ni_string_array_t *list;
+	const char *what;
+	unsigned int i, count;
+	void *dest = NULL;
+	char *str = NULL;
+	uint32_t u32;
+	uint16_t u16;
+	struct in_addr in;
+
+	if (!codec || codec->type == NI_DHCP_CODEC_NONE)
+		return 1;
+
+	if (codec->field && !(dest = codec->field(ctx))) {
+		ni_error("Cannot allocate memory for %s: %m", name);
+		return -1;
+	}
+	what = codec->what ? codec->what : name;
+
+	switch (codec->type) {
+	case NI_DHCP_CODEC_UINT16:
+		if (ni_buffer_get(bp, &u16, sizeof(u16)) < 0)
+			goto invalid;
+		u16 = ntohs(u16);
+		ni_debug_dhcp("%s: %u", name, (unsigned int)u16);
+		if (dest)
+			*(uint16_t *)dest = u16;
+		return 0;
+
+	case NI_DHCP_CODEC_UINT32:
+		if (ni_buffer_get(bp, &u32, sizeof(u32)) < 0)
+			goto invalid;
+		u32 = ntohl(u32);
+		ni_debug_dhcp("%s: %u", name, u32);
+		if (dest)
+			*(uint32_t *)dest = u32;
+		return 0;
+
+	case NI_DHCP_CODEC_IPV4:
+		if (ni_buffer_get(bp, &in, sizeof(in)) < 0)
+			goto invalid;
+		if (dest)
+			*(struct in_addr *)dest = in;
+		return 0;
+
+	case NI_DHCP_CODEC_ADDR_LIST:
+	case NI_DHCP_CODEC_NAME_LIST:
+		list = dest ? dest : &temp;
+		count = list->count;
+		if ((codec->type == NI_DHCP_CODEC_ADDR_LIST ?
+			ni_dhcp_decode_address_list(bp, list,
+				codec->unit == 16 ? AF_INET6 : AF_INET) :
+			ni_dhcp_decode_name_list(bp, list, what)) < 0) {
+			ni_debug_dhcp("Cannot parse option %s", name);
+		}
+		for (i = count; i < list->count; ++i)
+			ni_debug_dhcp("%s: %s", name, list->data[i]);
+		ni_string_array_destroy(&temp);
+		return 0;
+
+	case NI_DHCP_CODEC_DOMAIN:
+	case NI_DHCP_CODEC_PRINTABLE:
+	case NI_DHCP_CODEC_PATHNAME:
+		if (ni_dhcp_option_codec_get_string(codec, what, bp, &str) < 0)
+			goto invalid;
+
+		ni_debug_dhcp("%s: %s", name, str);
+		if (dest) {
+			ni_string_free((char **)dest);
+			*(char **)dest = str;
+		} else {
+			ni_string_free(&str);
+		}
+		return 0;
+
+	default:
+		return 1;
+	}
+
+invalid:
+	ni_debug_dhcp("Cannot parse option %s", name);
+	return 0;
+}
+
+/*
+ * Encodes the option data from a value of the codec field type,
+ * a string is passed itself. Fails and leaves the buffer unchanged
+ * when the value is invalid or violates the length constraints.
+ */
+int
+ni_dhcp_option_codec_encode(const ni_dhcp_option_codec_t *codec, ni_buffer_t *bp,
+				const void *value)
+{
+	const ni_string_array_t *list;
+	unsigned int tail, i;
+	ni_sockaddr_t addr;
+	const char *str;
+	uint32_t u32;
+	uint16_t u16;
+	size_t len;
+
+	if (!codec || !value || !bp)
+		return -1;
+
+	tail = bp->tail;
+	switch (codec->type) {
+	case NI_DHCP_CODEC_UINT16:
+		u16 = htons(*(const uint16_t *)value);
+		ni_buffer_put(bp, &u16, sizeof(u16));
+		break;
+
+	case NI_DHCP_CODEC_UINT32:
+		u32 = htonl(*(const uint32_t *)value);
+		ni_buffer_put(bp, &u32, sizeof(u32));
+		break;
+
+	case NI_DHCP_CODEC_IPV4:
+		ni_buffer_put(bp, value, sizeof(struct in_addr));
+		break;
+
+	case NI_DHCP_CODEC_ADDR_LIST:
+		list = value;
+		for (i = 0; i < list->count; ++i) {
+			int family = codec->unit == 16 ? AF_INET6 : AF_INET;
+
+			if (ni_sockaddr_parse(&addr, list->data[i], family) < 0)
+				goto failure;
+			ni_buffer_put(bp, family == AF_INET ? (void *)&addr.sin.sin_addr :
+					(void *)&addr.six.sin6_addr,
+					ni_af_address_length(family));
+		}
+		break;
+
+	case NI_DHCP_CODEC_NAME_LIST:
+		list = value;
+		for (i = 0; i < list->count; ++i) {
+			if (!ni_dhcp_domain_encode(bp, list->data[i], FALSE))
+				goto failure;
+			if (bp->tail > tail && bp->base[bp->tail - 1] != 0)
+				ni_buffer_putc(bp, 0);
+		}
+		break;
+
+	case NI_DHCP_CODEC_DOMAIN:
+	case NI_DHCP_CODEC_PRINTABLE:
+	case NI_DHCP_CODEC_PATHNAME:
+		str = value;
+		len = ni_string_len(str);
+		if (codec->type == NI_DHCP_CODEC_DOMAIN ? !ni_check_domain_name(str, len, 0) :
+		    codec->type == NI_DHCP_CODEC_PATHNAME ? !ni_check_pathname(str, len) :
+		    !ni_check_printable(str, len))
+			goto failure;
+		ni_buffer_put(bp, str, len);
+		break;
+
+	default:
+		return -1;
+	}
+
+	if (bp->overflow || !ni_dhcp_option_codec_check(codec, bp->tail - tail))
+		goto failure;
+	return 0;
+
+failure:
+	bp->tail = tail;
+	return -1;
+}
+
 /*
  * DHCP fqdn option utilities
  */
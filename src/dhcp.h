@@ -142,4 +142,41 @@ extern ni_var_array_t *			ni_dhcp_option_to_vars(const ni_dhcp_option_t *, const
 extern ni_bool_t			ni_dhcp_domain_encode(ni_buffer_t *, const char *, ni_bool_t);
 extern ni_bool_t			ni_dhcp_domain_decode(ni_buffer_t *, char **);
 
+extern int				ni_dhcp_decode_address_list(ni_buffer_t *, ni_string_array_t *, int);
+extern int				ni_dhcp_decode_name_list(ni_buffer_t *, ni_string_array_t *, const char *);
+
+
+/*
+ * Table driven option codec: the length constraints of a known option
+ * and the type and destination of the options mapped directly into a
+ * (protocol specific) parse context or encoded from a value.
+ * An option without a codec table entry has a zero maxlen.
+ */
+typedef enum {
+	NI_DHCP_CODEC_NONE = 0,		/* decoded by the protocol	*/
+	NI_DHCP_CODEC_UINT16,		/* uint16_t			*/
+	NI_DHCP_CODEC_UINT32,		/* uint32_t			*/
+	NI_DHCP_CODEC_IPV4,		/* struct in_addr		*/
+	NI_DHCP_CODEC_ADDR_LIST,	/* ni_string_array_t, unit 4/16	*/
+	NI_DHCP_CODEC_NAME_LIST,	/* ni_string_array_t, rfc1035	*/
+	NI_DHCP_CODEC_DOMAIN,		/* char *, domain name		*/
+	NI_DHCP_CODEC_PRINTABLE,	/* char *, printable string	*/
+	NI_DHCP_CODEC_PATHNAME,		/* char *, pathname or url	*/
+} ni_dhcp_codec_type_t;
+
+typedef struct ni_dhcp_option_codec {
+	ni_dhcp_codec_type_t		type;
+	uint16_t			minlen;
+	uint16_t			maxlen;
+	uint16_t			unit;	/* length is a multiple of	*/
+	const char *			what;	/* name used in warnings	*/
+	void *				(*field)(void *);
+} ni_dhcp_option_codec_t;
+
+extern ni_bool_t			ni_dhcp_option_codec_check(const ni_dhcp_option_codec_t *, unsigned int);
+extern int				ni_dhcp_option_codec_decode(const ni_dhcp_option_codec_t *, const char *,
+								ni_buffer_t *, void *);
+extern int				ni_dhcp_option_codec_encode(const ni_dhcp_option_codec_t *,
+								ni_buffer_t *, const void *);
+
 #endif /* WICKED_DHCP_H */
@@ -19,6 +19,7 @@
 #include <wicked/netinfo.h>
 #include <wicked/logging.h>
 #include <wicked/xml.h>
+#include <wicked/metrics.h>
 #include "netinfo_priv.h"
 #include "appconfig.h"
 
@@ -1001,4 +1002,5 @@ ni_dhcp4_new_xid(ni_dhcp4_device_t *cur)
 	} while (!xid);
 
 	cur->dhcp4.xid = xid;
+	ni_metric_start(&cur->dhcp4.started);
 }
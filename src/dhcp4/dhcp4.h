@@ -70,6 +70,7 @@ typedef struct ni_dhcp4_device {
 
 	struct {
 	    uint32_t		xid;
+	    struct timeval	started;	/* when the xid was created */
 	    unsigned int	nak_backoff;	/* backoff timer when we get NAKs */
 	    unsigned int	accept_any_offer : 1;
 	} dhcp4;
@@ -20,6 +20,7 @@
 #include <wicked/netinfo.h>
 #include <wicked/logging.h>
 #include <wicked/route.h>
+#include <wicked/metrics.h>
 #include <netlink/netlink.h>
 #include "netinfo_priv.h"
 #include "buffer.h"
@@ -70,6 +71,17 @@ ni_dhcp4_fsm_init_device(ni_dhcp4_device_t *dev)
 	}
 }
 
+/*
+ * Record the exchange latency once per xid, when the final
+ * reply (ACK or NAK) is accepted.
+ */
+static void
+ni_dhcp4_fsm_exchange_done(ni_dhcp4_device_t *dev)
+{
+	ni_metric_record_since(NI_METRIC_DHCP4_EXCHANGE, &dev->dhcp4.started);
+	timerclear(&dev->dhcp4.started);
+}
+
 int
 ni_dhcp4_fsm_process_dhcp4_packet(ni_dhcp4_device_t *dev, ni_buffer_t *msgbuf, ni_sockaddr_t *from)
 {
@@ -159,7 +171,6 @@ ni_dhcp4_fsm_process_dhcp4_packet(ni_dhcp4_device_t *dev, ni_buffer_t *msgbuf, n
 			dev->ifname, ni_dhcp4_message_name(msg_code), message->xid,
 			ni_dhcp4_fsm_state_name(dev->fsm.state),
 			sender ? " sender " : "", sender ? sender : "");
-
 	if (lease->dhcp4.client_id.len) {
 		ni_debug_verbose(NI_LOG_DEBUG1, NI_TRACE_DHCP,
 				"%s: and matching client id %s", dev->ifname,
@@ -286,6 +297,7 @@ ni_dhcp4_fsm_process_dhcp4_packet(ni_dhcp4_device_t *dev, ni_buffer_t *msgbuf, n
 		case NI_DHCP4_STATE_RENEWING:
 		case NI_DHCP4_STATE_REBINDING:
 		case NI_DHCP4_STATE_REBOOT:
+			ni_dhcp4_fsm_exchange_done(dev);
 			ni_dhcp4_process_ack(dev, lease);
 			lease = NULL;
 			break;
@@ -312,6 +324,7 @@ ni_dhcp4_fsm_process_dhcp4_packet(ni_dhcp4_device_t *dev, ni_buffer_t *msgbuf, n
 		case NI_DHCP4_STATE_REBINDING:
 		case NI_DHCP4_STATE_REBOOT:
 		case __NI_DHCP4_STATE_MAX:
+			ni_dhcp4_fsm_exchange_done(dev);
 			ni_dhcp4_process_nak(dev);
 		}
 		break;
@@ -46,6 +46,7 @@
 #include "socket_priv.h"
 
 static void	ni_dhcp4_socket_recv(ni_socket_t *);
+static const ni_dhcp_option_codec_t *	ni_dhcp4_option_codec(unsigned int);
 
 /*
  * Open a DHCP4 socket for send and receive
@@ -168,19 +169,6 @@ ni_dhcp4_option_put16(ni_buffer_t *bp, int code, uint16_t value)
 	ni_dhcp4_option_put(bp, code, &value, 2);
 }
 
-static inline void
-ni_dhcp4_option_put32(ni_buffer_t *bp, int code, uint32_t value)
-{
-	value = htonl(value);
-	ni_dhcp4_option_put(bp, code, &value, 4);
-}
-
-static inline void
-ni_dhcp4_option_put_ipv4(ni_buffer_t *bp, int code, struct in_addr addr)
-{
-	ni_dhcp4_option_put(bp, code, &addr, 4);
-}
-
 static inline void
 ni_dhcp4_option_puts(ni_buffer_t *bp, int code, const char *string)
 {
@@ -205,6 +193,27 @@ ni_dhcp4_option_end(ni_buffer_t *bp, unsigned int pos)
 	}
 }
 
+/*
+ * Put an option encoded from a value by the option codec table
+ */
+static int
+ni_dhcp4_option_encode(ni_buffer_t *bp, unsigned int code, const void *value)
+{
+	unsigned int pos;
+
+	pos = ni_dhcp4_option_begin(bp, code);
+	/* the codec allows longer, concatenated list options */
+	if (ni_dhcp_option_codec_encode(ni_dhcp4_option_codec(code), bp, value) < 0 ||
+	    bp->tail - pos > 255) {
+		ni_debug_dhcp("Discarded invalid %s option value",
+				ni_dhcp4_option_name(code));
+		bp->tail = pos - 2;
+		return -1;
+	}
+	ni_dhcp4_option_end(bp, pos);
+	return 0;
+}
+
 static int
 ni_dhcp4_option_next(ni_buffer_t *bp, ni_buffer_t *optbuf)
 {
@@ -214,11 +223,11 @@ ni_dhcp4_option_next(ni_buffer_t *bp, ni_buffer_t *optbuf)
 		return -1;
 	if (bp->head == bp->tail)
 		return DHCP4_END;
-	if (bp->tail - bp->head < 2)
-		goto underflow;
 
 	code = bp->base[bp->head++];
 	if (code != DHCP4_PAD && code != DHCP4_END) {
+		if (bp->tail == bp->head)
+			goto underflow;
 		count = bp->base[bp->head++];
 		if (bp->tail - bp->head < count)
 			goto underflow;
@@ -259,12 +268,6 @@ ni_dhcp4_option_get_sockaddr(ni_buffer_t *bp, ni_sockaddr_t *addr)
 	return ni_buffer_get(bp, &sin->sin_addr, 4);
 }
 
-static int
-ni_dhcp4_option_get_ipv4(ni_buffer_t *bp, struct in_addr *addr)
-{
-	return ni_buffer_get(bp, addr, 4);
-}
-
 static int
 ni_dhcp4_option_get16(ni_buffer_t *bp, uint16_t *var)
 {
@@ -274,15 +277,6 @@ ni_dhcp4_option_get16(ni_buffer_t *bp, uint16_t *var)
 	return 0;
 }
 
-static int
-ni_dhcp4_option_get32(ni_buffer_t *bp, uint32_t *var)
-{
-	if (ni_buffer_get(bp, var, 4) < 0)
-		return -1;
-	*var = ntohl(*var);
-	return 0;
-}
-
 static int
 ni_dhcp4_option_get_string(ni_buffer_t *bp, char **var, unsigned int *lenp)
 {
@@ -431,7 +425,7 @@ __ni_dhcp4_build_msg_put_our_hostname(const ni_dhcp4_device_t *dev, ni_buffer_t
 		}
 
 		if ((len = ni_string_len(hname))) {
-			ni_dhcp4_option_puts(msgbuf, DHCP4_HOSTNAME, hname);
+			ni_dhcp4_option_encode(msgbuf, DHCP4_HOSTNAME, hname);
 			ni_debug_verbose(NI_LOG_DEBUG1, NI_TRACE_DHCP,
 					"%s: using hostname: %s", dev->ifname, hname);
 		} else
@@ -628,7 +622,7 @@ __ni_dhcp4_build_msg_put_server_id(const ni_dhcp4_device_t *dev,
 		return -1;
 	}
 
-	ni_dhcp4_option_put_ipv4(msgbuf, DHCP4_SERVERIDENTIFIER, lease->dhcp4.server_id);
+	ni_dhcp4_option_encode(msgbuf, DHCP4_SERVERIDENTIFIER, &lease->dhcp4.server_id);
 	ni_debug_verbose(NI_LOG_DEBUG1, NI_TRACE_DHCP,
 			"%s: using server-id: %s", dev->ifname,
 			ni_sockaddr_print(&addr));
@@ -732,7 +726,7 @@ __ni_dhcp4_build_msg_discover(const ni_dhcp4_device_t *dev,
 	 */
 	ni_sockaddr_set_ipv4(&addr, lease->dhcp4.address, 0);
 	if (ni_sockaddr_is_ipv4_specified(&addr)) {
-		ni_dhcp4_option_put_ipv4(msgbuf, DHCP4_ADDRESS, lease->dhcp4.address);
+		ni_dhcp4_option_encode(msgbuf, DHCP4_ADDRESS, &lease->dhcp4.address);
 		ni_debug_verbose(NI_LOG_DEBUG1, NI_TRACE_DHCP,
 				"%s: using ip-address hint: %s",
 				dev->ifname, ni_sockaddr_print(&addr));
@@ -744,8 +738,8 @@ __ni_dhcp4_build_msg_discover(const ni_dhcp4_device_t *dev,
 	ni_dhcp4_option_put16(msgbuf, DHCP4_MAXMESSAGESIZE, dev->system.mtu);
 
 	if (lease->dhcp4.lease_time != 0) {
-		ni_dhcp4_option_put32(msgbuf, DHCP4_LEASETIME,
-					lease->dhcp4.lease_time);
+		ni_dhcp4_option_encode(msgbuf, DHCP4_LEASETIME,
+					&lease->dhcp4.lease_time);
 	}
 
 	if (options->user_class.class_id.count) {
@@ -754,7 +748,7 @@ __ni_dhcp4_build_msg_discover(const ni_dhcp4_device_t *dev,
 	}
 
 	if (options->classid && options->classid[0]) {
-		ni_dhcp4_option_puts(msgbuf, DHCP4_CLASSID, options->classid);
+		ni_dhcp4_option_encode(msgbuf, DHCP4_CLASSID, options->classid);
 	}
 
 	if (__ni_dhcp4_build_msg_put_our_hostname(dev, msgbuf, &options->fqdn, options->hostname) < 0)
@@ -793,7 +787,7 @@ __ni_dhcp4_build_msg_decline(const ni_dhcp4_device_t *dev,
 	if (__ni_dhcp4_build_msg_put_server_id(dev, lease, msg_code, msgbuf) <  0)
 		return -1;
 
-	ni_dhcp4_option_put_ipv4(msgbuf, DHCP4_ADDRESS, lease->dhcp4.address);
+	ni_dhcp4_option_encode(msgbuf, DHCP4_ADDRESS, &lease->dhcp4.address);
 	ni_debug_verbose(NI_LOG_DEBUG1, NI_TRACE_DHCP,
 			"%s: using decline ip-address: %s",
 			dev->ifname, ni_sockaddr_print(&addr));
@@ -878,7 +872,7 @@ __ni_dhcp4_build_msg_inform(const ni_dhcp4_device_t *dev,
 	}
 
 	if (options->classid && options->classid[0]) {
-		ni_dhcp4_option_puts(msgbuf, DHCP4_CLASSID, options->classid);
+		ni_dhcp4_option_encode(msgbuf, DHCP4_CLASSID, options->classid);
 	}
 
 	return 0;
@@ -915,7 +909,7 @@ __ni_dhcp4_build_msg_request_offer(const ni_dhcp4_device_t *dev,
 	if (__ni_dhcp4_build_msg_put_server_id(dev, lease, msg_code, msgbuf) <  0)
 		return -1;
 
-	ni_dhcp4_option_put_ipv4(msgbuf, DHCP4_ADDRESS, lease->dhcp4.address);
+	ni_dhcp4_option_encode(msgbuf, DHCP4_ADDRESS, &lease->dhcp4.address);
 	ni_debug_verbose(NI_LOG_DEBUG1, NI_TRACE_DHCP,
 			"%s: using offered ip-address: %s",
 			dev->ifname, ni_sockaddr_print(&addr));
@@ -934,8 +928,8 @@ __ni_dhcp4_build_msg_request_offer(const ni_dhcp4_device_t *dev,
 	ni_dhcp4_option_put16(msgbuf, DHCP4_MAXMESSAGESIZE, dev->system.mtu);
 
 	if (lease->dhcp4.lease_time != 0) {
-		ni_dhcp4_option_put32(msgbuf, DHCP4_LEASETIME,
-					lease->dhcp4.lease_time);
+		ni_dhcp4_option_encode(msgbuf, DHCP4_LEASETIME,
+					&lease->dhcp4.lease_time);
 	}
 
 	if (options->user_class.class_id.count) {
@@ -944,7 +938,7 @@ __ni_dhcp4_build_msg_request_offer(const ni_dhcp4_device_t *dev,
 	}
 
 	if (options->classid && options->classid[0]) {
-		ni_dhcp4_option_puts(msgbuf, DHCP4_CLASSID, options->classid);
+		ni_dhcp4_option_encode(msgbuf, DHCP4_CLASSID, options->classid);
 	}
 
 	return 0;
@@ -998,8 +992,8 @@ __ni_dhcp4_build_msg_request_renew(const ni_dhcp4_device_t *dev,
 
 #if 0
 	if (lease->dhcp4.lease_time != 0) {
-		ni_dhcp4_option_put32(msgbuf, DHCP4_LEASETIME,
-					lease->dhcp4.lease_time);
+		ni_dhcp4_option_encode(msgbuf, DHCP4_LEASETIME,
+					&lease->dhcp4.lease_time);
 	}
 #endif
 
@@ -1009,7 +1003,7 @@ __ni_dhcp4_build_msg_request_renew(const ni_dhcp4_device_t *dev,
 	}
 
 	if (options->classid && options->classid[0]) {
-		ni_dhcp4_option_puts(msgbuf, DHCP4_CLASSID, options->classid);
+		ni_dhcp4_option_encode(msgbuf, DHCP4_CLASSID, options->classid);
 	}
 
 	return 0;
@@ -1063,8 +1057,8 @@ __ni_dhcp4_build_msg_request_rebind(const ni_dhcp4_device_t *dev,
 
 #if 0
 	if (lease->dhcp4.lease_time != 0) {
-		ni_dhcp4_option_put32(msgbuf, DHCP4_LEASETIME,
-					lease->dhcp4.lease_time);
+		ni_dhcp4_option_encode(msgbuf, DHCP4_LEASETIME,
+					&lease->dhcp4.lease_time);
 	}
 #endif
 
@@ -1074,7 +1068,7 @@ __ni_dhcp4_build_msg_request_rebind(const ni_dhcp4_device_t *dev,
 	}
 
 	if (options->classid && options->classid[0]) {
-		ni_dhcp4_option_puts(msgbuf, DHCP4_CLASSID, options->classid);
+		ni_dhcp4_option_encode(msgbuf, DHCP4_CLASSID, options->classid);
 	}
 
 	return 0;
@@ -1108,7 +1102,7 @@ __ni_dhcp4_build_msg_request_reboot(const ni_dhcp4_device_t *dev,
 	if (__ni_dhcp4_build_msg_put_client_id(dev, msg_code, message, msgbuf) <  0)
 		return -1;
 
-	ni_dhcp4_option_put_ipv4(msgbuf, DHCP4_ADDRESS, lease->dhcp4.address);
+	ni_dhcp4_option_encode(msgbuf, DHCP4_ADDRESS, &lease->dhcp4.address);
 	ni_debug_verbose(NI_LOG_DEBUG1, NI_TRACE_DHCP,
 			"%s: using reused ip-address: %s",
 			dev->ifname, ni_sockaddr_print(&addr));
@@ -1128,8 +1122,8 @@ __ni_dhcp4_build_msg_request_reboot(const ni_dhcp4_device_t *dev,
 
 #if 0
 	if (lease->dhcp4.lease_time != 0) {
-		ni_dhcp4_option_put32(msgbuf, DHCP4_LEASETIME,
-					lease->dhcp4.lease_time);
+		ni_dhcp4_option_encode(msgbuf, DHCP4_LEASETIME,
+					&lease->dhcp4.lease_time);
 	}
 #endif
 
@@ -1139,7 +1133,7 @@ __ni_dhcp4_build_msg_request_reboot(const ni_dhcp4_device_t *dev,
 	}
 
 	if (options->classid && options->classid[0]) {
-		ni_dhcp4_option_puts(msgbuf, DHCP4_CLASSID, options->classid);
+		ni_dhcp4_option_encode(msgbuf, DHCP4_CLASSID, options->classid);
 	}
 
 	return 0;
@@ -1251,93 +1245,6 @@ failed:
 	return -1;
 }
 
-/*
- * Decode an RFC3397 DNS search order option.
- */
-static int
-ni_dhcp4_decode_dnssearch(ni_buffer_t *optbuf, ni_string_array_t *list, const char *what)
-{
-	ni_stringbuf_t namebuf = NI_STRINGBUF_INIT_DYNAMIC;
-	unsigned char *base = ni_buffer_head(optbuf);
-	unsigned int base_offset = optbuf->head;
-	size_t len;
-
-	ni_string_array_destroy(list);
-
-	while (ni_buffer_count(optbuf) && !optbuf->underflow) {
-		ni_buffer_t *bp = optbuf;
-		ni_buffer_t jumpbuf;
-
-		while (1) {
-			unsigned int pos = bp->head - base_offset;
-			unsigned int pointer;
-			char label[64];
-			int length;
-
-			if ((length = ni_buffer_getc(bp)) == EOF) {
-				bp->underflow = 1;
-				goto failure; /* unexpected EOF */
-			}
-
-			if (length == 0)
-				break;	/* end of this name */
-
-			switch (length & 0xC0) {
-			case 0:
-				/* Plain name component */
-				if (ni_buffer_get(bp, label, length) < 0)
-					goto failure;
-
-				label[length] = '\0';
-				if (!ni_stringbuf_empty(&namebuf))
-					ni_stringbuf_putc(&namebuf, '.');
-				ni_stringbuf_puts(&namebuf, label);
-				break;
-
-			case 0xC0:
-				/* Pointer */
-				pointer = (length & 0x3F) << 8;
-				if ((length = ni_buffer_getc(bp)) == EOF) {
-					bp->underflow = 1;
-					goto failure;
-				}
-
-				pointer |= length;
-				if (pointer >= pos)
-					goto failure;
-
-				ni_buffer_init_reader(&jumpbuf, base, pos);
-				jumpbuf.head = pointer;
-				bp = &jumpbuf;
-				break;
-
-			default:
-				goto failure;
-			}
-
-		}
-
-		if (!ni_stringbuf_empty(&namebuf)) {
-
-			len = ni_string_len(namebuf.string);
-			if (ni_check_domain_name(namebuf.string, len, 0)) {
-				ni_string_array_append(list, namebuf.string);
-			} else {
-				ni_warn("Discarded suspect %s: '%s'", what,
-					ni_print_suspect(namebuf.string, len));
-			}
-		}
-		ni_stringbuf_destroy(&namebuf);
-	}
-
-	return 0;
-
-failure:
-	ni_stringbuf_destroy(&namebuf);
-	ni_string_array_destroy(list);
-	return -1;
-}
-
 /*
  * Decode a CIDR list option.
  */
@@ -1379,28 +1286,6 @@ ni_dhcp4_decode_csr(ni_buffer_t *bp, ni_route_array_t *routes)
 	return 0;
 }
 
-static int
-ni_dhcp4_decode_address_list(ni_buffer_t *bp, ni_string_array_t *list)
-{
-	if (ni_buffer_count(bp) % 4) {
-		bp->underflow = 1;
-		return -1;
-	}
-
-	while (ni_buffer_count(bp) && !bp->underflow) {
-		struct in_addr addr;
-
-		if (ni_dhcp4_option_get_ipv4(bp, &addr) < 0)
-			return -1;
-		ni_string_array_append(list, inet_ntoa(addr));
-	}
-
-	if (bp->underflow)
-		return -1;
-
-	return 0;
-}
-
 static int
 ni_dhcp4_decode_sipservers(ni_buffer_t *bp, ni_string_array_t *list)
 {
@@ -1413,10 +1298,10 @@ ni_dhcp4_decode_sipservers(ni_buffer_t *bp, ni_string_array_t *list)
 		return -1;
 
 	case 0:
-		return ni_dhcp4_decode_dnssearch(bp, list, "sip-server name");
+		return ni_dhcp_decode_name_list(bp, list, "sip-server name");
 
 	case 1:
-		return ni_dhcp4_decode_address_list(bp, list);
+		return ni_dhcp_decode_address_list(bp, list, AF_INET);
 
 	default:
 		ni_error("unknown sip encoding %d", encoding);
@@ -1670,28 +1555,6 @@ ni_dhcp4_option_get_fqdn(ni_buffer_t *bp, char **hostname, ni_dhcp_fqdn_t *fqdn)
 	return 0;
 }
 
-static int
-ni_dhcp4_option_get_pathname(ni_buffer_t *bp, char **var, const char *what)
-{
-	unsigned int len;
-	char *tmp = NULL;
-
-	if (ni_dhcp4_option_get_string(bp, &tmp, &len) < 0)
-		return -1;
-
-	if (!ni_check_pathname(tmp, len)) {
-		ni_warn("Discarded suspect %s: '%s'", what,
-			ni_print_suspect(tmp, len));
-		free(tmp);
-		return -1;
-	}
-
-	if (*var)
-		free(*var);
-	*var = tmp;
-	return 0;
-}
-
 static int
 ni_dhcp4_option_get_printable(ni_buffer_t *bp, char **var, const char *what)
 {
@@ -1800,6 +1663,136 @@ ni_dhcp4_apply_routes(ni_addrconf_lease_t *lease, ni_route_array_t *routes)
 	ni_route_array_destroy(&temp);
 }
 
+/*
+ * DHCP4 response parse context: the lease and the option values,
+ * which are applied to the lease after all options are parsed.
+ */
+typedef struct ni_dhcp4_parse_ctx {
+	ni_addrconf_lease_t *	lease;
+
+	ni_string_array_t	dns_servers;
+	ni_string_array_t	dns_search;
+	ni_string_array_t	nis_servers;
+	char *			nisdomain;
+} ni_dhcp4_parse_ctx_t;
+
+#define NI_DHCP4_PARSE_CTX_FIELD(name, member)				\
+static void *								\
+ni_dhcp4_parse_ctx_##name(void *ctx)					\
+{									\
+	return &((ni_dhcp4_parse_ctx_t *)ctx)->member;			\
+}
+
+NI_DHCP4_PARSE_CTX_FIELD(address,		lease->dhcp4.address)
+NI_DHCP4_PARSE_CTX_FIELD(netmask,		lease->dhcp4.netmask)
+NI_DHCP4_PARSE_CTX_FIELD(broadcast,		lease->dhcp4.broadcast)
+NI_DHCP4_PARSE_CTX_FIELD(server_id,		lease->dhcp4.server_id)
+NI_DHCP4_PARSE_CTX_FIELD(lease_time,		lease->dhcp4.lease_time)
+NI_DHCP4_PARSE_CTX_FIELD(renewal_time,		lease->dhcp4.renewal_time)
+NI_DHCP4_PARSE_CTX_FIELD(rebind_time,		lease->dhcp4.rebind_time)
+NI_DHCP4_PARSE_CTX_FIELD(message,		lease->dhcp4.message)
+NI_DHCP4_PARSE_CTX_FIELD(root_path,		lease->dhcp4.root_path)
+NI_DHCP4_PARSE_CTX_FIELD(netbios_scope,		lease->netbios_scope)
+NI_DHCP4_PARSE_CTX_FIELD(ntp_servers,		lease->ntp_servers)
+NI_DHCP4_PARSE_CTX_FIELD(lpr_servers,		lease->lpr_servers)
+NI_DHCP4_PARSE_CTX_FIELD(log_servers,		lease->log_servers)
+NI_DHCP4_PARSE_CTX_FIELD(netbios_name_servers,	lease->netbios_name_servers)
+NI_DHCP4_PARSE_CTX_FIELD(netbios_dd_servers,	lease->netbios_dd_servers)
+NI_DHCP4_PARSE_CTX_FIELD(nds_servers,		lease->nds_servers)
+NI_DHCP4_PARSE_CTX_FIELD(nds_tree,		lease->nds_tree)
+NI_DHCP4_PARSE_CTX_FIELD(posix_tz_string,	lease->posix_tz_string)
+NI_DHCP4_PARSE_CTX_FIELD(posix_tz_dbname,	lease->posix_tz_dbname)
+NI_DHCP4_PARSE_CTX_FIELD(dns_servers,		dns_servers)
+NI_DHCP4_PARSE_CTX_FIELD(dns_search,		dns_search)
+NI_DHCP4_PARSE_CTX_FIELD(nis_servers,		nis_servers)
+NI_DHCP4_PARSE_CTX_FIELD(nisdomain,		nisdomain)
+
+#undef NI_DHCP4_PARSE_CTX_FIELD
+
+/*
+ * Option codec table: length constraints of the known options and the
+ * type used by the common codec to encode them and to decode options
+ * with a parse context field and without an explicit parse case.
+ * The maximum length of list options exceeds 255 octets, as the
+ * parser concatenates split options (RFC 3396).
+ */
+#define NI_DHCP4_CODEC_MAXLEN		0xffff
+
+static const ni_dhcp_option_codec_t	ni_dhcp4_option_codecs[DHCP4_END] = {
+	[DHCP4_NETMASK]		= { NI_DHCP_CODEC_IPV4,       4,   4, 0,
+				    NULL, ni_dhcp4_parse_ctx_netmask },
+	[DHCP4_ROUTERS]		= { NI_DHCP_CODEC_NONE,       4, NI_DHCP4_CODEC_MAXLEN, 4 },
+	[DHCP4_DNSSERVER]	= { NI_DHCP_CODEC_ADDR_LIST,  4, NI_DHCP4_CODEC_MAXLEN, 4,
+				    NULL, ni_dhcp4_parse_ctx_dns_servers },
+	[DHCP4_LOGSERVER]	= { NI_DHCP_CODEC_ADDR_LIST,  4, NI_DHCP4_CODEC_MAXLEN, 4,
+				    NULL, ni_dhcp4_parse_ctx_log_servers },
+	[DHCP4_LPRSERVER]	= { NI_DHCP_CODEC_ADDR_LIST,  4, NI_DHCP4_CODEC_MAXLEN, 4,
+				    NULL, ni_dhcp4_parse_ctx_lpr_servers },
+	[DHCP4_HOSTNAME]	= { NI_DHCP_CODEC_DOMAIN,     1, 255, 0, "hostname" },
+	[DHCP4_DNSDOMAIN]	= { NI_DHCP_CODEC_NONE,       1, NI_DHCP4_CODEC_MAXLEN, 0 },
+	[DHCP4_ROOTPATH]	= { NI_DHCP_CODEC_PATHNAME,   1, NI_DHCP4_CODEC_MAXLEN, 0,
+				    "root-path", ni_dhcp4_parse_ctx_root_path },
+	[DHCP4_MTU]		= { NI_DHCP_CODEC_NONE,       2,   2, 0 },
+	[DHCP4_BROADCAST]	= { NI_DHCP_CODEC_IPV4,       4,   4, 0,
+				    NULL, ni_dhcp4_parse_ctx_broadcast },
+	[DHCP4_STATICROUTE]	= { NI_DHCP_CODEC_NONE,       8, NI_DHCP4_CODEC_MAXLEN, 8 },
+	[DHCP4_NISDOMAIN]	= { NI_DHCP_CODEC_DOMAIN,     1, NI_DHCP4_CODEC_MAXLEN, 0,
+				    "nis-domain", ni_dhcp4_parse_ctx_nisdomain },
+	[DHCP4_NISSERVER]	= { NI_DHCP_CODEC_ADDR_LIST,  4, NI_DHCP4_CODEC_MAXLEN, 4,
+				    NULL, ni_dhcp4_parse_ctx_nis_servers },
+	[DHCP4_NTPSERVER]	= { NI_DHCP_CODEC_ADDR_LIST,  4, NI_DHCP4_CODEC_MAXLEN, 4,
+				    NULL, ni_dhcp4_parse_ctx_ntp_servers },
+	[DHCP4_NETBIOSNAMESERVER]={ NI_DHCP_CODEC_ADDR_LIST,  4, NI_DHCP4_CODEC_MAXLEN, 4,
+				    NULL, ni_dhcp4_parse_ctx_netbios_name_servers },
+	[DHCP4_NETBIOSDDSERVER]	= { NI_DHCP_CODEC_ADDR_LIST,  4, NI_DHCP4_CODEC_MAXLEN, 4,
+				    NULL, ni_dhcp4_parse_ctx_netbios_dd_servers },
+	[DHCP4_NETBIOSNODETYPE]	= { NI_DHCP_CODEC_NONE,       1,   1, 0 },
+	[DHCP4_NETBIOSSCOPE]	= { NI_DHCP_CODEC_DOMAIN,     1, NI_DHCP4_CODEC_MAXLEN, 0,
+				    "netbios-scope", ni_dhcp4_parse_ctx_netbios_scope },
+	[DHCP4_ADDRESS]		= { NI_DHCP_CODEC_IPV4,       4,   4, 0,
+				    NULL, ni_dhcp4_parse_ctx_address },
+	[DHCP4_LEASETIME]	= { NI_DHCP_CODEC_UINT32,     4,   4, 0,
+				    NULL, ni_dhcp4_parse_ctx_lease_time },
+	[DHCP4_SERVERIDENTIFIER]= { NI_DHCP_CODEC_IPV4,       4,   4, 0,
+				    NULL, ni_dhcp4_parse_ctx_server_id },
+	[DHCP4_MESSAGE]		= { NI_DHCP_CODEC_PRINTABLE,  1, NI_DHCP4_CODEC_MAXLEN, 0,
+				    "dhcp4-message", ni_dhcp4_parse_ctx_message },
+	[DHCP4_MAXMESSAGESIZE]	= { NI_DHCP_CODEC_UINT16,     2,   2, 0 },
+	[DHCP4_RENEWALTIME]	= { NI_DHCP_CODEC_UINT32,     4,   4, 0,
+				    NULL, ni_dhcp4_parse_ctx_renewal_time },
+	[DHCP4_REBINDTIME]	= { NI_DHCP_CODEC_UINT32,     4,   4, 0,
+				    NULL, ni_dhcp4_parse_ctx_rebind_time },
+	[DHCP4_CLASSID]		= { NI_DHCP_CODEC_PRINTABLE,  1, 255, 0, "vendor-class" },
+	[DHCP4_CLIENTID]	= { NI_DHCP_CODEC_NONE,       1, NI_DHCP4_CODEC_MAXLEN, 0 },
+	[DHCP4_FQDN]		= { NI_DHCP_CODEC_NONE,       3, NI_DHCP4_CODEC_MAXLEN, 0 },
+	[DHCP4_NDS_SERVER]	= { NI_DHCP_CODEC_ADDR_LIST,  4, NI_DHCP4_CODEC_MAXLEN, 4,
+				    NULL, ni_dhcp4_parse_ctx_nds_servers },
+	[DHCP4_NDS_TREE]	= { NI_DHCP_CODEC_PRINTABLE,  1, NI_DHCP4_CODEC_MAXLEN, 0,
+				    "nds-tree", ni_dhcp4_parse_ctx_nds_tree },
+	[DHCP4_NDS_CTX]		= { NI_DHCP_CODEC_NONE,       1, NI_DHCP4_CODEC_MAXLEN, 0 },
+	[DHCP4_POSIX_TZ_STRING]	= { NI_DHCP_CODEC_PRINTABLE,  1, NI_DHCP4_CODEC_MAXLEN, 0,
+				    "posix-tz-string", ni_dhcp4_parse_ctx_posix_tz_string },
+	[DHCP4_POSIX_TZ_DBNAME]	= { NI_DHCP_CODEC_PRINTABLE,  1, NI_DHCP4_CODEC_MAXLEN, 0,
+				    "posix-tz-dbname", ni_dhcp4_parse_ctx_posix_tz_dbname },
+	[DHCP4_DNSSEARCH]	= { NI_DHCP_CODEC_NAME_LIST,  1, NI_DHCP4_CODEC_MAXLEN, 0,
+				    "dns-search domain", ni_dhcp4_parse_ctx_dns_search },
+	[DHCP4_SIPSERVER]	= { NI_DHCP_CODEC_NONE,       1, NI_DHCP4_CODEC_MAXLEN, 0 },
+	[DHCP4_CSR]		= { NI_DHCP_CODEC_NONE,       5, NI_DHCP4_CODEC_MAXLEN, 0 },
+	[DHCP4_MSCSR]		= { NI_DHCP_CODEC_NONE,       5, NI_DHCP4_CODEC_MAXLEN, 0 },
+};
+
+static const ni_dhcp_option_codec_t *
+ni_dhcp4_option_codec(unsigned int option)
+{
+	const ni_dhcp_option_codec_t *codec;
+
+	if (option >= DHCP4_END)
+		return NULL;
+
+	codec = &ni_dhcp4_option_codecs[option];
+	return codec->maxlen ? codec : NULL;
+}
+
 /*
  * Parse a DHCP4 response.
  */
@@ -1807,16 +1800,14 @@ int
 ni_dhcp4_parse_response(const ni_dhcp4_config_t *config, const ni_dhcp4_message_t *message,
 			ni_buffer_t *options, ni_addrconf_lease_t **leasep)
 {
+	const ni_dhcp_option_codec_t *codec;
 	ni_buffer_t overload_buf;
 	ni_addrconf_lease_t *lease;
+	ni_dhcp4_parse_ctx_t ctx;
 	ni_route_array_t default_routes = NI_ROUTE_ARRAY_INIT;
 	ni_route_array_t static_routes = NI_ROUTE_ARRAY_INIT;
 	ni_route_array_t classless_routes = NI_ROUTE_ARRAY_INIT;
-	ni_string_array_t dns_servers = NI_STRING_ARRAY_INIT;
-	ni_string_array_t dns_search = NI_STRING_ARRAY_INIT;
 	ni_string_array_t dns_domain = NI_STRING_ARRAY_INIT;
-	ni_string_array_t nis_servers = NI_STRING_ARRAY_INIT;
-	char *nisdomain = NULL;
 	char *tmp = NULL;
 	int opt_overload = 0;
 	int msg_type = -1;
@@ -1826,6 +1817,8 @@ ni_dhcp4_parse_response(const ni_dhcp4_config_t *config, const ni_dhcp4_message_
 	ni_dhcp_option_t *opts = NULL, *opt;
 
 	lease = ni_addrconf_lease_new(NI_ADDRCONF_DHCP, AF_INET);
+	memset(&ctx, 0, sizeof(ctx));
+	ctx.lease = lease;
 
 	lease->state = NI_ADDRCONF_STATE_GRANTED;
 	lease->type = NI_ADDRCONF_DHCP;
@@ -1918,31 +1911,25 @@ parse_more:
 		int option = opt->code;
 
 		ni_buffer_init_reader(&buf, opt->data, opt->len);
+
+		codec = ni_dhcp4_option_codec(option);
+		if (codec && !ni_dhcp_option_codec_check(codec, opt->len)) {
+			ni_debug_dhcp("discarded DHCP4 option %s (%u): invalid %u byte data length",
+					ni_dhcp4_option_name(option), option, opt->len);
+			ni_dhcp_option_free(opt);
+			continue;
+		}
+		if (codec && codec->field) {
+			ni_dhcp_option_codec_decode(codec, ni_dhcp4_option_name(option),
+							&buf, &ctx);
+			ni_dhcp_option_free(opt);
+			continue;
+		}
+
 		switch (option) {
-		case DHCP4_ADDRESS:
-			ni_dhcp4_option_get_ipv4(&buf, &lease->dhcp4.address);
-			break;
-		case DHCP4_NETMASK:
-			ni_dhcp4_option_get_ipv4(&buf, &lease->dhcp4.netmask);
-			break;
-		case DHCP4_BROADCAST:
-			ni_dhcp4_option_get_ipv4(&buf, &lease->dhcp4.broadcast);
-			break;
-		case DHCP4_SERVERIDENTIFIER:
-			ni_dhcp4_option_get_ipv4(&buf, &lease->dhcp4.server_id);
-			break;
 		case DHCP4_CLIENTID:
 			ni_dhcp4_option_get_opaque(&buf, &lease->dhcp4.client_id);
 			break;
-		case DHCP4_LEASETIME:
-			ni_dhcp4_option_get32(&buf, &lease->dhcp4.lease_time);
-			break;
-		case DHCP4_RENEWALTIME:
-			ni_dhcp4_option_get32(&buf, &lease->dhcp4.renewal_time);
-			break;
-		case DHCP4_REBINDTIME:
-			ni_dhcp4_option_get32(&buf, &lease->dhcp4.rebind_time);
-			break;
 		case DHCP4_MTU:
 			ni_dhcp4_option_get16(&buf, &lease->dhcp4.mtu);
 			/* Minimum legal mtu is 68 accoridng to
@@ -1967,62 +1954,14 @@ parse_more:
 			ni_dhcp4_option_get_domain_list(&buf, &dns_domain,
 							"dns-domain");
 			break;
-		case DHCP4_MESSAGE:
-			ni_dhcp4_option_get_printable(&buf, &lease->dhcp4.message,
-							"dhcp4-message");
-			break;
-		case DHCP4_ROOTPATH:
-			ni_dhcp4_option_get_pathname(&buf, &lease->dhcp4.root_path,
-							"root-path");
-			break;
-		case DHCP4_NISDOMAIN:
-			ni_dhcp4_option_get_domain(&buf, &nisdomain,
-							"nis-domain");
-			break;
 		case DHCP4_NETBIOSNODETYPE:
 			ni_dhcp4_option_get_netbios_type(&buf, &lease->netbios_type);
 			break;
-		case DHCP4_NETBIOSSCOPE:
-			ni_dhcp4_option_get_domain(&buf, &lease->netbios_scope,
-							"netbios-scope");
-			break;
-		case DHCP4_DNSSERVER:
-			ni_dhcp4_decode_address_list(&buf, &dns_servers);
-			break;
-		case DHCP4_NTPSERVER:
-			ni_dhcp4_decode_address_list(&buf, &lease->ntp_servers);
-			break;
-		case DHCP4_NISSERVER:
-			ni_dhcp4_decode_address_list(&buf, &nis_servers);
-			break;
-		case DHCP4_LPRSERVER:
-			ni_dhcp4_decode_address_list(&buf, &lease->lpr_servers);
-			break;
-		case DHCP4_LOGSERVER:
-			ni_dhcp4_decode_address_list(&buf, &lease->log_servers);
-			break;
-		case DHCP4_NETBIOSNAMESERVER:
-			ni_dhcp4_decode_address_list(&buf, &lease->netbios_name_servers);
-			break;
-		case DHCP4_NETBIOSDDSERVER:
-			ni_dhcp4_decode_address_list(&buf, &lease->netbios_dd_servers);
-			break;
-		case DHCP4_DNSSEARCH:
-			ni_dhcp4_decode_dnssearch(&buf, &dns_search, "dns-search domain");
-			break;
-
-		case DHCP4_NDS_SERVER:
-			ni_dhcp4_decode_address_list(&buf, &lease->nds_servers);
-			break;
 		case DHCP4_NDS_CTX:
 			if (!ni_dhcp4_option_get_printable(&buf, &tmp, "nds-context"))
 				ni_string_array_append(&lease->nds_context, tmp);
 			ni_string_free(&tmp);
 			break;
-		case DHCP4_NDS_TREE:
-			ni_dhcp4_option_get_printable(&buf, &lease->nds_tree,
-							"nds-tree");
-			break;
 
 		case DHCP4_CSR:
 		case DHCP4_MSCSR:
@@ -2044,16 +1983,6 @@ parse_more:
 			ni_dhcp4_decode_routers(&buf, &default_routes);
 			break;
 
-		case DHCP4_POSIX_TZ_STRING:
-			ni_dhcp4_option_get_printable(&buf, &lease->posix_tz_string,
-							"posix-tz-string");
-			break;
-
-		case DHCP4_POSIX_TZ_DBNAME:
-			ni_dhcp4_option_get_printable(&buf, &lease->posix_tz_dbname,
-							"posix-tz-dbname");
-			break;
-
 		default:
 			ni_debug_dhcp("adding unparsed DHCP4 option %s code %u len %u",
 					ni_dhcp4_option_name(option), option, opt->len);
@@ -2169,30 +2098,30 @@ parse_more:
 		ni_route_array_destroy(&default_routes);
 	}
 
-	if (dns_servers.count || dns_search.count || dns_domain.count) {
+	if (ctx.dns_servers.count || ctx.dns_search.count || dns_domain.count) {
 		ni_resolver_info_t *resolver = ni_resolver_info_new();
 
 		if (dns_domain.count)
 			ni_string_dup(&resolver->default_domain, dns_domain.data[0]);
 
-		if (dns_search.count)
-			ni_string_array_move(&resolver->dns_search, &dns_search);
+		if (ctx.dns_search.count)
+			ni_string_array_move(&resolver->dns_search, &ctx.dns_search);
 		else
 			ni_string_array_move(&resolver->dns_search, &dns_domain);
 
-		ni_string_array_move(&resolver->dns_servers, &dns_servers);
+		ni_string_array_move(&resolver->dns_servers, &ctx.dns_servers);
 		lease->resolver = resolver;
 	}
-	if (nisdomain != NULL) {
+	if (ctx.nisdomain != NULL) {
 		ni_nis_info_t *nis = ni_nis_info_new();
 
-		nis->domainname = nisdomain;
-		nisdomain = NULL;
+		nis->domainname = ctx.nisdomain;
+		ctx.nisdomain = NULL;
 
-		if (nis_servers.count == 0)
+		if (ctx.nis_servers.count == 0)
 			nis->default_binding = NI_NISCONF_BROADCAST;
 		else
-			ni_string_array_move(&nis->default_servers, &nis_servers);
+			ni_string_array_move(&nis->default_servers, &ctx.nis_servers);
 		lease->nis = nis;
 	}
 
@@ -2203,11 +2132,11 @@ done:
 	ni_route_array_destroy(&default_routes);
 	ni_route_array_destroy(&static_routes);
 	ni_route_array_destroy(&classless_routes);
-	ni_string_array_destroy(&dns_servers);
-	ni_string_array_destroy(&dns_search);
+	ni_string_array_destroy(&ctx.dns_servers);
+	ni_string_array_destroy(&ctx.dns_search);
 	ni_string_array_destroy(&dns_domain);
-	ni_string_array_destroy(&nis_servers);
-	ni_string_free(&nisdomain);
+	ni_string_array_destroy(&ctx.nis_servers);
+	ni_string_free(&ctx.nisdomain);
 	ni_dhcp_option_list_destroy(&opts);
 
 	return msg_type;
@@ -159,6 +159,11 @@ ni_dhcp6_device_close(ni_dhcp6_device_t *dev)
 {
 	ni_dhcp6_mcast_socket_close(dev);
 
+	if (dev->retrans.timer) {
+		ni_timer_cancel(dev->retrans.timer);
+		dev->retrans.timer = NULL;
+	}
+
 	if (dev->fsm.timer) {
 		ni_warn("%s: timer active while close, disarming", dev->ifname);
 		ni_timer_cancel(dev->fsm.timer);
@@ -646,6 +651,38 @@ ni_dhcp6_device_transmit_arm_delay(ni_dhcp6_device_t *dev)
 	return TRUE;
 }
 
+static void
+ni_dhcp6_device_retransmit_timeout(void *user_data, const ni_timer_t *timer)
+{
+	ni_dhcp6_device_t *dev = user_data;
+
+	if (dev->retrans.timer != timer) {
+		ni_warn("%s: bad retransmit timer handle", __func__);
+		return;
+	}
+	dev->retrans.timer = NULL;
+
+	ni_dhcp6_device_retransmit(dev);
+}
+
+/*
+ * Retransmissions are driven by the central timer list instead
+ * of socket timeout hooks evaluated in every poll loop iteration.
+ */
+static void
+ni_dhcp6_device_retransmit_timer_arm(ni_dhcp6_device_t *dev)
+{
+	unsigned long msec = dev->retrans.params.timeout;
+
+	if (dev->retrans.timer) {
+		if (ni_timer_rearm(dev->retrans.timer, msec))
+			return;
+		dev->retrans.timer = NULL;
+	}
+	dev->retrans.timer = ni_timer_register(msec,
+				ni_dhcp6_device_retransmit_timeout, dev);
+}
+
 static void
 ni_dhcp6_device_retransmit_arm(ni_dhcp6_device_t *dev)
 {
@@ -711,6 +748,8 @@ ni_dhcp6_device_retransmit_arm(ni_dhcp6_device_t *dev)
 		dev->retrans.params.timeout = ni_timeout_arm_msec(&dev->retrans.deadline,
 								  &dev->retrans.params);
 	}
+	ni_dhcp6_device_retransmit_timer_arm(dev);
+
 	if (dev->retrans.duration) {
 		/*
 		 * rfc3315#section-14
@@ -738,6 +777,9 @@ ni_dhcp6_device_retransmit_disarm(ni_dhcp6_device_t *dev)
 				dev->ifname, ni_dhcp6_print_timeval(&now));
 	}
 
+	if (dev->retrans.timer)
+		ni_timer_cancel(dev->retrans.timer);
+
 	dev->dhcp6.xid = 0;
 	memset(&dev->retrans, 0, sizeof(dev->retrans));
 }
@@ -773,6 +815,7 @@ ni_dhcp6_device_retransmit_advance(ni_dhcp6_device_t *dev)
 		dev->retrans.params.timeout = ni_timeout_arm_msec(
 				&dev->retrans.deadline,
 				&dev->retrans.params);
+		ni_dhcp6_device_retransmit_timer_arm(dev);
 
 		ni_debug_dhcp("%s: increased retransmission timeout from %u to %u [%d .. %d]: %s",
 				dev->ifname, old_timeout,
@@ -1284,7 +1327,8 @@ ni_dhcp6_device_transmit(ni_dhcp6_device_t *dev)
 		return rv;
 	}
 
-	rv = ni_dhcp6_socket_send(dev->mcast.sock, &dev->message, &dev->mcast.dest);
+	rv = ni_dhcp6_socket_send(dev->mcast.sock, &dev->message, &dev->mcast.dest,
+			dev->mcast.shared ? &dev->link : NULL);
 	if (rv <= 0 || (size_t)rv != cnt) {
 		/* Hmm... advance retrans.count here? Use stop? */
 
@@ -183,6 +183,7 @@ struct ni_dhcp6_device {
 	struct {
 	    ni_socket_t *	sock;		/* multicast socket		*/
 	    ni_sockaddr_t	dest;		/* relays & servers multicast	*/
+	    ni_bool_t		shared;		/* sock is the shared socket	*/
 	} mcast;
 
 	struct timeval		start_time;	/* when we started managing     */
@@ -204,6 +205,7 @@ struct ni_dhcp6_device {
 	    unsigned int	duration;	/* max duration in msec             */
 	    struct timeval	deadline;	/* next delay/timeout deadline      */
 	    ni_timeout_param_t	params;		/* timeout parameters               */
+	    const ni_timer_t *	timer;		/* retransmission timer             */
 	} retrans;
 
 	unsigned int		failed : 1,
@@ -211,6 +213,7 @@ struct ni_dhcp6_device {
 
 	struct {
 	    uint32_t		xid;
+	    struct timeval	started;	/* when the xid was created	*/
 	} dhcp6;
 	ni_buffer_t		message;
 
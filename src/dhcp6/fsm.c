@@ -29,6 +29,7 @@
 
 #include <wicked/logging.h>
 #include <wicked/resolver.h>
+#include <wicked/metrics.h>
 
 #include "dhcp6/dhcp6.h"
 #include "dhcp6/device.h"
@@ -1197,6 +1198,11 @@ ni_dhcp6_fsm_process_client_message(ni_dhcp6_device_t *dev, unsigned int msg_typ
 	break;
 	}
 
+	if (rv == 0) {
+		/* record the exchange once, when a reply is accepted */
+		ni_metric_record_since(NI_METRIC_DHCP6_EXCHANGE, &dev->dhcp6.started);
+		timerclear(&dev->dhcp6.started);
+	} else
 	if (rv > 0) {
 		if (err_xid != msg_xid) {
 			err_xid = msg_xid;
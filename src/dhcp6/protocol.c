@@ -41,6 +41,7 @@
 #include <wicked/addrconf.h>
 #include <wicked/resolver.h>
 #include <wicked/ipv6.h>
+#include <wicked/metrics.h>
 #if 0
 #include <wicked/route.h>
 #include <wicked/nis.h>
@@ -53,6 +54,7 @@
 #include "dhcp6/fsm.h"
 #include "dhcp.h"
 #include "socket_priv.h"
+#include "appconfig.h"
 #include "netinfo_priv.h"
 #include "buffer.h"
 #include "debug.h"
@@ -79,11 +81,10 @@ static void	ni_dhcp6_socket_recv		(ni_socket_t *);
 static int	ni_dhcp6_process_packet		(ni_dhcp6_device_t *dev, ni_buffer_t *msgbuf,
 						 const struct in6_addr *sender);
 
-static int	ni_dhcp6_socket_get_timeout	(const ni_socket_t *sock, struct timeval *tv);
-static void	ni_dhcp6_socket_check_timeout	(ni_socket_t *sock, const struct timeval *now);
 
 static int	ni_dhcp6_option_next(ni_buffer_t *options, ni_buffer_t *optbuf);
 static int	ni_dhcp6_option_get_duid(ni_buffer_t *bp, ni_opaque_t *duid);
+static const ni_dhcp_option_codec_t *	ni_dhcp6_option_codec(unsigned int option);
 
 static int	__ni_dhcp6_parse_client_options(ni_dhcp6_device_t *dev, ni_buffer_t *buffer,
 						ni_addrconf_lease_t *lease, ni_bool_t request);
@@ -162,6 +163,108 @@ __ni_dhcp6_mcast_socket_open(const struct ni_dhcp6_link *link, const char *ifnam
 	return fd;
 }
 
+/*
+ * Optional socket shared by all devices, bound to the wildcard address.
+ * Packets are dispatched to the devices by their incoming ifindex and
+ * sent using an explicit IPV6_PKTINFO source and interface.
+ */
+static ni_socket_t *	ni_dhcp6_shared_sock;
+static unsigned int	ni_dhcp6_shared_users;
+
+static int
+__ni_dhcp6_shared_socket_open(void)
+{
+	ni_sockaddr_t saddr;
+	int fd, on;
+
+	if ((fd = socket (PF_INET6, SOCK_DGRAM, IPPROTO_UDP)) == -1) {
+		ni_error("Cannot open shared socket(INET6, DGRAM, UDP): %m");
+		return -1;
+	}
+
+	on = 1;
+	if (setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on)) == -1)
+		ni_error("Cannot set shared setsockopt(SO_REUSEADDR): %m");
+#if defined(SO_REUSEPORT)
+	if (setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &on, sizeof(on)) == -1)
+		ni_error("Cannot set shared setsockopt(SO_REUSEPORT): %m");
+#endif
+	if (setsockopt(fd, IPPROTO_IPV6, IPV6_RECVPKTINFO, &on, sizeof(on)) != 0)
+		ni_error("Cannot set shared setsockopt(IPV6_RECVPKTINFO): %m");
+
+	if (fcntl(fd, F_SETFD, FD_CLOEXEC) == -1)
+		ni_error("Cannot set shared fcntl(SETDF, CLOEXEC): %m");
+
+	ni_sockaddr_set_ipv6(&saddr, in6addr_any, NI_DHCP6_CLIENT_PORT);
+	if (bind(fd, &saddr.sa, sizeof(saddr.six)) == -1) {
+		ni_error("Cannot bind shared socket to (%s): %m",
+				ni_sockaddr_print(&saddr));
+		close(fd);
+		return -1;
+	}
+
+	ni_debug_dhcp("bound shared DHCPv6 socket to [%s]:%u",
+		ni_sockaddr_print(&saddr), ntohs(saddr.six.sin6_port));
+
+	return fd;
+}
+
+static ni_socket_t *
+ni_dhcp6_shared_socket_get(void)
+{
+	ni_socket_t *sock = ni_dhcp6_shared_sock;
+	int fd;
+
+	if (sock && (!sock->active || sock->error)) {
+		/* broken; current users drop their reference on reopen */
+		ni_dhcp6_shared_sock = NULL;
+		ni_dhcp6_shared_users = 0;
+		ni_socket_close(sock);
+		sock = NULL;
+	}
+
+	if (!sock) {
+		if ((fd = __ni_dhcp6_shared_socket_open()) == -1)
+			return NULL;
+
+		if (!(sock = ni_socket_wrap(fd, SOCK_DGRAM))) {
+			ni_error("Unable to prepare shared DHCPv6 socket");
+			close(fd);
+			return NULL;
+		}
+		sock->user_data = NULL;
+		sock->receive = ni_dhcp6_socket_recv;
+		ni_buffer_init_dynamic(&sock->rbuf, NI_DHCP6_RBUF_SIZE);
+		ni_socket_activate(sock);
+
+		ni_dhcp6_shared_sock = sock;
+	}
+
+	ni_dhcp6_shared_users++;
+	return ni_socket_hold(sock);
+}
+
+static void
+ni_dhcp6_shared_socket_put(ni_socket_t *sock)
+{
+	if (sock == ni_dhcp6_shared_sock && ni_dhcp6_shared_users) {
+		if (--ni_dhcp6_shared_users == 0) {
+			ni_dhcp6_shared_sock = NULL;
+			ni_socket_close(sock);
+		}
+	}
+	ni_socket_release(sock);
+}
+
+static ni_bool_t
+ni_dhcp6_shared_socket_enabled(void)
+{
+	const ni_config_dhcp6_t *conf;
+
+	conf = ni_config_dhcp6_find_device(NULL);
+	return conf ? conf->shared_socket : FALSE;
+}
+
 /*
  * Open a DHCP6 socket for send and receive
  */
@@ -203,6 +306,13 @@ ni_dhcp6_mcast_socket_open(ni_dhcp6_device_t *dev)
 	dev->mcast.dest.six.sin6_port = htons(NI_DHCP6_SERVER_PORT);
 	dev->mcast.dest.six.sin6_scope_id = dev->link.ifindex;
 
+	if (ni_dhcp6_shared_socket_enabled()) {
+		if (!(dev->mcast.sock = ni_dhcp6_shared_socket_get()))
+			return -1;
+		dev->mcast.shared = TRUE;
+		return 0;
+	}
+
 	/* open the socket an bind to the link-local address */
 	if ((fd = __ni_dhcp6_mcast_socket_open(&dev->link, dev->ifname)) == -1)
 		return -1;
@@ -211,8 +321,6 @@ ni_dhcp6_mcast_socket_open(ni_dhcp6_device_t *dev)
 	if ((dev->mcast.sock = ni_socket_wrap(fd, SOCK_DGRAM)) != NULL) {
 		dev->mcast.sock->user_data = dev;
 		dev->mcast.sock->receive = ni_dhcp6_socket_recv;
-		dev->mcast.sock->get_timeout = ni_dhcp6_socket_get_timeout;
-		dev->mcast.sock->check_timeout = ni_dhcp6_socket_check_timeout;
 
 		/* See rfc2460#section-5, Packet Size Issues. Allocate max buffer */
 		ni_buffer_init_dynamic(&dev->mcast.sock->rbuf, NI_DHCP6_RBUF_SIZE);
@@ -230,15 +338,26 @@ ni_dhcp6_mcast_socket_open(ni_dhcp6_device_t *dev)
 void
 ni_dhcp6_mcast_socket_close(ni_dhcp6_device_t *dev)
 {
-	if (dev->mcast.sock)
-		ni_socket_close(dev->mcast.sock);
+	if (dev->mcast.sock) {
+		if (dev->mcast.shared)
+			ni_dhcp6_shared_socket_put(dev->mcast.sock);
+		else
+			ni_socket_close(dev->mcast.sock);
+	}
 	dev->mcast.sock = NULL;
+	dev->mcast.shared = FALSE;
 	memset(&dev->mcast.dest, 0, sizeof(dev->mcast.dest));
 }
 
 ssize_t
-ni_dhcp6_socket_send(ni_socket_t *sock, const ni_buffer_t *mesg, const ni_sockaddr_t *dest)
+ni_dhcp6_socket_send(ni_socket_t *sock, const ni_buffer_t *mesg, const ni_sockaddr_t *dest,
+			const struct ni_dhcp6_link *link)
 {
+	unsigned char cbuf[CMSG_SPACE(sizeof(struct in6_pktinfo))];
+	struct in6_pktinfo *pinfo;
+	struct cmsghdr *cm;
+	struct msghdr msg;
+	struct iovec iov;
 	int flags = 0;
 	size_t cnt;
 
@@ -261,8 +380,32 @@ ni_dhcp6_socket_send(ni_socket_t *sock, const ni_buffer_t *mesg, const ni_sockad
 	    ni_sockaddr_is_ipv6_linklocal(dest))
 		flags |= MSG_DONTROUTE;
 
-	return sendto(sock->__fd, ni_buffer_head(mesg), cnt,
-			flags, &dest->sa, sizeof(dest->six));
+	if (!link)
+		return sendto(sock->__fd, ni_buffer_head(mesg), cnt,
+				flags, &dest->sa, sizeof(dest->six));
+
+	/* unbound (shared) socket: select link-local source and interface */
+	memset(&cbuf, 0, sizeof(cbuf));
+	iov.iov_base = (void *)ni_buffer_head(mesg);
+	iov.iov_len = cnt;
+
+	memset(&msg, 0, sizeof(msg));
+	msg.msg_name = (void *)&dest->six;
+	msg.msg_namelen = sizeof(dest->six);
+	msg.msg_iov = &iov;
+	msg.msg_iovlen = 1;
+	msg.msg_control = cbuf;
+	msg.msg_controllen = sizeof(cbuf);
+
+	cm = CMSG_FIRSTHDR(&msg);
+	cm->cmsg_level = IPPROTO_IPV6;
+	cm->cmsg_type = IPV6_PKTINFO;
+	cm->cmsg_len = CMSG_LEN(sizeof(struct in6_pktinfo));
+	pinfo = (struct in6_pktinfo *)CMSG_DATA(cm);
+	pinfo->ipi6_addr = link->addr.six.sin6_addr;
+	pinfo->ipi6_ifindex = link->ifindex;
+
+	return sendmsg(sock->__fd, &msg, flags);
 }
 
 
@@ -285,6 +428,7 @@ ni_dhcp6_socket_recv(ni_socket_t *sock)
 	ni_stringbuf_t hexbuf = NI_STRINGBUF_INIT_DYNAMIC;
 #endif
 	ni_dhcp6_device_t * dev = sock->user_data;
+	const char *ifname = dev ? dev->ifname : "dhcp6";
 	ni_buffer_t * rbuf = &sock->rbuf;
 	unsigned char cbuf[CMSG_SPACE(sizeof(struct in6_pktinfo))];
 	ni_sockaddr_t saddr;
@@ -312,13 +456,13 @@ ni_dhcp6_socket_recv(ni_socket_t *sock)
 	if(bytes < 0) {
 		if (errno != EINTR && errno != EAGAIN && errno != EWOULDBLOCK) {
 			ni_error("%s: recvmsg error on socket %d: %m",
-				dev->ifname, sock->__fd);
+				ifname, sock->__fd);
 			ni_socket_deactivate(sock);
 		}
 		return;
 	} else if (bytes == 0) {
 		ni_error("%s: recvmsg didn't returned any data on socket %d",
-			dev->ifname, sock->__fd);
+			ifname, sock->__fd);
 		return;
 	}
 
@@ -332,9 +476,18 @@ ni_dhcp6_socket_recv(ni_socket_t *sock)
 
 	if (pinfo == NULL) {
 		ni_error("%s: discarding packet without packet info on socket %d",
-			dev->ifname, sock->__fd);
+			ifname, sock->__fd);
 		return;
 	}
+	if (dev == NULL) {
+		/* shared socket: dispatch by incoming interface index */
+		dev = ni_dhcp6_device_by_index(pinfo->ipi6_ifindex);
+		if (!dev || dev->mcast.sock != sock) {
+			ni_debug_dhcp("%s: discarding packet for unmanaged interface index %u",
+				ifname, pinfo->ipi6_ifindex);
+			return;
+		}
+	}
 	if(dev->link.ifindex != pinfo->ipi6_ifindex) {
 		ni_error("%s: discarding packet with interface index %u instead %u",
 			dev->ifname, pinfo->ipi6_ifindex, dev->link.ifindex);
@@ -438,55 +591,6 @@ ni_dhcp6_address_print(const struct in6_addr *ipv6)
 	return ni_sockaddr_print(&addr);
 }
 
-static int
-ni_dhcp6_socket_get_timeout(const ni_socket_t *sock, struct timeval *tv)
-{
-	ni_dhcp6_device_t * dev = sock->user_data;
-	if( !(dev = sock->user_data)) {
-		ni_error("check_timeout: socket without capture object?!");
-		return -1;
-	}
-
-	timerclear(tv);
-	if (timerisset(&dev->retrans.deadline)) {
-		*tv = dev->retrans.deadline;
-#if 0
-		ni_trace("%s: get socket timeout for socket [fd=%d]: %s",
-				dev->ifname, sock->__fd, ni_dhcp6_print_timeval(tv));
-	} else {
-		ni_trace("%s: get socket timeout for socket [fd=%d]: unset",
-				dev->ifname, sock->__fd);
-#endif
-	}
-	return timerisset(tv) ? 0 : -1;
-}
-
-static void
-ni_dhcp6_socket_check_timeout(ni_socket_t *sock, const struct timeval *now)
-{
-	ni_dhcp6_device_t * dev;
-	struct tm;
-
-	if (!(dev = sock->user_data)) {
-		ni_error("check_timeout: socket without device object?!");
-		return;
-	}
-
-	if (timerisset(&dev->retrans.deadline) && timercmp(&dev->retrans.deadline, now, <)) {
-#if 0
-		ni_trace("%s: check socket timeout for socket [fd=%d]: %s",
-				dev->ifname, sock->__fd,
-				ni_dhcp6_print_timeval(&dev->retrans.deadline));
-#endif
-		ni_dhcp6_device_retransmit(dev);
-#if 0
-	} else {
-		ni_trace("%s: check socket timeout for socket [fd=%d]: unset",
-				dev->ifname, sock->__fd);
-#endif
-	}
-}
-
 /*
  * Inline functions for setting/retrieving options from a buffer
  */
@@ -518,6 +622,7 @@ ni_dhcp6_option_put8(ni_buffer_t *bp, int code, uint8_t value)
 }
 #endif
 
+#if 0
 static inline int
 ni_dhcp6_option_put16(ni_buffer_t *bp, int code, uint16_t value)
 {
@@ -525,7 +630,6 @@ ni_dhcp6_option_put16(ni_buffer_t *bp, int code, uint16_t value)
 	return ni_dhcp6_option_put(bp, code, &value, 2);
 }
 
-#if 0
 static inline int
 ni_dhcp6_option_put32(ni_buffer_t *bp, int code, uint32_t value)
 {
@@ -552,6 +656,33 @@ ni_dhcp6_option_puts(ni_buffer_t *bp, int code, const char *string)
 }
 #endif
 
+/*
+ * Put an option encoded from a value by the option codec table
+ */
+static int
+ni_dhcp6_option_encode(ni_buffer_t *bp, unsigned int code, const void *value)
+{
+	ni_dhcp6_option_header_t opt = {
+		.code = htons(code),
+		.len = 0,
+	};
+	unsigned int pos = bp->tail;
+
+	if (ni_buffer_put(bp, &opt, sizeof(opt)) < 0)
+		return -1;
+
+	if (ni_dhcp_option_codec_encode(ni_dhcp6_option_codec(code), bp, value) < 0) {
+		ni_debug_dhcp("Discarded invalid %s option value",
+				ni_dhcp6_option_name(code));
+		bp->tail = pos;
+		return -1;
+	}
+
+	opt.len = htons(bp->tail - pos - sizeof(opt));
+	memcpy(bp->base + pos, &opt, sizeof(opt));
+	return 0;
+}
+
 static int
 ni_dhcp6_option_put_status(ni_buffer_t *bp, ni_dhcp6_status_t *status)
 {
@@ -1042,110 +1173,6 @@ ni_dhcp6_option_get_fqdn(ni_buffer_t *bp, ni_dhcp_fqdn_t *fqdn, char **hostname)
 	return 0;
 }
 
-static int
-ni_dhcp6_decode_address_list(ni_buffer_t *bp, ni_string_array_t *list)
-{
-	while (ni_buffer_count(bp) && !bp->underflow) {
-		ni_sockaddr_t addr;
-
-		if (ni_dhcp6_option_get_sockaddr(bp, &addr, AF_INET6) < 0)
-			return -1;
-
-		ni_string_array_append(list, ni_sockaddr_print(&addr));
-	}
-
-	if (bp->underflow)
-		return -1;
-
-	return 0;
-}
-
-/*
- * FIXME: See http://tools.ietf.org/html/rfc3315#section-8
- *        Move to src/dhcputils.c ?
- *
- * Decode an RFC3397 DNS search order option.
- */
-static int
-ni_dhcp6_decode_dnssearch(ni_buffer_t *optbuf, ni_string_array_t *list, const char *what)
-{
-	ni_stringbuf_t namebuf = NI_STRINGBUF_INIT_DYNAMIC;
-	unsigned char *base = ni_buffer_head(optbuf);
-	unsigned int base_offset = optbuf->head;
-	size_t len;
-
-	ni_string_array_destroy(list);
-
-	while (ni_buffer_count(optbuf) && !optbuf->underflow) {
-		ni_buffer_t *bp = optbuf;
-		ni_buffer_t jumpbuf;
-
-		while (1) {
-			unsigned int pos = bp->head - base_offset;
-			unsigned int pointer;
-			char label[64];
-			int length;
-
-			if ((length = ni_buffer_getc(bp)) < 0)
-				goto failure; /* unexpected EOF */
-
-			if (length == 0)
-				break;	/* end of this name */
-
-			switch (length & 0xC0) {
-			case 0:
-				/* Plain name component */
-				if (ni_buffer_get(bp, label, length) < 0)
-					goto failure;
-
-				label[length] = '\0';
-				if (!ni_stringbuf_empty(&namebuf))
-					ni_stringbuf_putc(&namebuf, '.');
-				ni_stringbuf_puts(&namebuf, label);
-				break;
-
-			case 0xC0:
-				/* Pointer */
-				pointer = (length & 0x3F) << 8;
-				if ((length = ni_buffer_getc(bp)) < 0)
-					goto failure;
-
-				pointer |= length;
-				if (pointer >= pos)
-					goto failure;
-
-				ni_buffer_init_reader(&jumpbuf, base, pos);
-				jumpbuf.head = pointer;
-				bp = &jumpbuf;
-				break;
-
-			default:
-				goto failure;
-			}
-
-		}
-
-		if (!ni_stringbuf_empty(&namebuf)) {
-
-			len = ni_string_len(namebuf.string);
-			if (ni_check_domain_name(namebuf.string, len, 0)) {
-				ni_string_array_append(list, namebuf.string);
-			} else {
-				ni_warn("Discarded suspect %s: '%s'", what,
-					ni_print_suspect(namebuf.string, len));
-			}
-		}
-		ni_stringbuf_destroy(&namebuf);
-	}
-
-	return 0;
-
-failure:
-	ni_stringbuf_destroy(&namebuf);
-	ni_string_array_destroy(list);
-	return -1;
-}
-
 /*
  * Option request array
  */
@@ -1745,8 +1772,8 @@ ni_dhcp6_build_message(ni_dhcp6_device_t *dev,
 
 	/* The elapsed time since transaction begin */
 	elapsed_time = ni_dhcp6_device_uptime(dev, 0xffff);
-	if (ni_dhcp6_option_put16(msg_buf, NI_DHCP6_OPTION_ELAPSED_TIME,
-					elapsed_time) < 0)
+	if (ni_dhcp6_option_encode(msg_buf, NI_DHCP6_OPTION_ELAPSED_TIME,
+					&elapsed_time) < 0)
 		goto cleanup;
 
 	/* Identify yourself */
@@ -1874,6 +1901,7 @@ ni_dhcp6_init_message(ni_dhcp6_device_t *dev, unsigned int msg_code, const ni_ad
 	do {
 		dev->dhcp6.xid = random() & NI_DHCP6_XID_MASK;
 	} while (dev->dhcp6.xid == 0);
+	ni_metric_start(&dev->dhcp6.started);
 
 	ni_debug_dhcp("%s: building %s with xid 0x%x", dev->ifname,
 		ni_dhcp6_message_name(msg_code), dev->dhcp6.xid);
@@ -2660,15 +2688,112 @@ __copy_ia_na_to_lease_addrs(const ni_dhcp6_device_t *dev, ni_addrconf_lease_t *l
 	return count;
 }
 
+/*
+ * Option codec table: length constraints of the known options and the
+ * type used by the common codec to encode them and to decode options
+ * without an explicit case in the parse switch into the lease fields.
+ */
+static void *
+ni_dhcp6_lease_dns_servers(void *lease)
+{
+	ni_addrconf_lease_t *l = lease;
+
+	if (!l->resolver && !(l->resolver = ni_resolver_info_new()))
+		return NULL;
+	return &l->resolver->dns_servers;
+}
+
+static void *
+ni_dhcp6_lease_dns_search(void *lease)
+{
+	ni_addrconf_lease_t *l = lease;
+
+	if (!l->resolver && !(l->resolver = ni_resolver_info_new()))
+		return NULL;
+	return &l->resolver->dns_search;
+}
+
+static void *
+ni_dhcp6_lease_sip_servers(void *lease)
+{
+	return &((ni_addrconf_lease_t *)lease)->sip_servers;
+}
+
+static void *
+ni_dhcp6_lease_ntp_servers(void *lease)
+{
+	return &((ni_addrconf_lease_t *)lease)->ntp_servers;
+}
+
+static void *
+ni_dhcp6_lease_posix_tz_string(void *lease)
+{
+	return &((ni_addrconf_lease_t *)lease)->posix_tz_string;
+}
+
+static void *
+ni_dhcp6_lease_posix_tz_dbname(void *lease)
+{
+	return &((ni_addrconf_lease_t *)lease)->posix_tz_dbname;
+}
+
+static void *
+ni_dhcp6_lease_boot_url(void *lease)
+{
+	return &((ni_addrconf_lease_t *)lease)->dhcp6.boot_url;
+}
+
+#define NI_DHCP6_CODEC_MAXLEN		0xffff
+
+static const ni_dhcp_option_codec_t	ni_dhcp6_option_codecs[__NI_DHCP6_OPTION_MAX] = {
+	[NI_DHCP6_OPTION_CLIENTID]	= { NI_DHCP_CODEC_NONE,       2, 130, 0 },
+	[NI_DHCP6_OPTION_SERVERID]	= { NI_DHCP_CODEC_NONE,       2, 130, 0 },
+	[NI_DHCP6_OPTION_PREFERENCE]	= { NI_DHCP_CODEC_NONE,       1,   1, 0 },
+	[NI_DHCP6_OPTION_ELAPSED_TIME]	= { NI_DHCP_CODEC_UINT16,     2,   2, 0 },
+	[NI_DHCP6_OPTION_UNICAST]	= { NI_DHCP_CODEC_NONE,      16,  16, 0 },
+	[NI_DHCP6_OPTION_STATUS_CODE]	= { NI_DHCP_CODEC_NONE,       2, NI_DHCP6_CODEC_MAXLEN, 0 },
+
+	[NI_DHCP6_OPTION_DNS_SERVERS]	= { NI_DHCP_CODEC_ADDR_LIST, 16, NI_DHCP6_CODEC_MAXLEN, 16,
+					    NULL, ni_dhcp6_lease_dns_servers },
+	[NI_DHCP6_OPTION_DNS_DOMAINS]	= { NI_DHCP_CODEC_NAME_LIST,  1, NI_DHCP6_CODEC_MAXLEN, 0,
+					    "dns-search domain", ni_dhcp6_lease_dns_search },
+	[NI_DHCP6_OPTION_SIP_SERVER_A]	= { NI_DHCP_CODEC_ADDR_LIST, 16, NI_DHCP6_CODEC_MAXLEN, 16,
+					    NULL, ni_dhcp6_lease_sip_servers },
+	[NI_DHCP6_OPTION_SIP_SERVER_D]	= { NI_DHCP_CODEC_NAME_LIST,  1, NI_DHCP6_CODEC_MAXLEN, 0,
+					    "sip-server name", ni_dhcp6_lease_sip_servers },
+	[NI_DHCP6_OPTION_SNTP_SERVERS]	= { NI_DHCP_CODEC_ADDR_LIST, 16, NI_DHCP6_CODEC_MAXLEN, 16,
+					    NULL, ni_dhcp6_lease_ntp_servers },
+	/* not requested: NIS does not support IPv6, decoded for the log only */
+	[NI_DHCP6_OPTION_NIS_SERVERS]	= { NI_DHCP_CODEC_ADDR_LIST, 16, NI_DHCP6_CODEC_MAXLEN, 16 },
+	[NI_DHCP6_OPTION_NIS_DOMAIN_NAME]={ NI_DHCP_CODEC_NAME_LIST,  1, NI_DHCP6_CODEC_MAXLEN, 0,
+					    "nis domain" },
+
+	[NI_DHCP6_OPTION_POSIX_TZ_STRING]={ NI_DHCP_CODEC_PRINTABLE,  1, NI_DHCP6_CODEC_MAXLEN, 0,
+					    NULL, ni_dhcp6_lease_posix_tz_string },
+	[NI_DHCP6_OPTION_POSIX_TZ_DBNAME]={ NI_DHCP_CODEC_PATHNAME,   1, NI_DHCP6_CODEC_MAXLEN, 0,
+					    NULL, ni_dhcp6_lease_posix_tz_dbname },
+	[NI_DHCP6_OPTION_BOOTFILE_URL]	= { NI_DHCP_CODEC_PATHNAME,   1, NI_DHCP6_CODEC_MAXLEN, 0,
+					    NULL, ni_dhcp6_lease_boot_url },
+};
+
+static const ni_dhcp_option_codec_t *
+ni_dhcp6_option_codec(unsigned int option)
+{
+	const ni_dhcp_option_codec_t *codec;
+
+	if (option >= __NI_DHCP6_OPTION_MAX)
+		return NULL;
+
+	codec = &ni_dhcp6_option_codecs[option];
+	return codec->maxlen ? codec : NULL;
+}
+
 static int
 __ni_dhcp6_parse_client_options(ni_dhcp6_device_t *dev, ni_buffer_t *buffer, ni_addrconf_lease_t *lease, ni_bool_t request)
 {
 	ni_stringbuf_t hexbuf = NI_STRINGBUF_INIT_DYNAMIC;
-	ni_string_array_t temp = NI_STRING_ARRAY_INIT;
-	ni_string_array_t nis_servers = NI_STRING_ARRAY_INIT;
-	ni_string_array_t nis_domains = NI_STRING_ARRAY_INIT;
+	const ni_dhcp_option_codec_t *codec;
 	ni_dhcp_option_t *opt;
-	char *str = NULL;
 	struct timeval elapsed;
 	unsigned int i;
 
@@ -2684,6 +2809,16 @@ __ni_dhcp6_parse_client_options(ni_dhcp6_device_t *dev, ni_buffer_t *buffer, ni_
 		if (option == 0)
 			break;
 
+		codec = ni_dhcp6_option_codec(option);
+		if (codec && !ni_dhcp_option_codec_check(codec, ni_buffer_count(&optbuf))) {
+			ni_trace("%s: dhcp6 option %s: invalid %u byte data length: %s",
+				dev->ifname, ni_dhcp6_option_name(option),
+				ni_buffer_count(&optbuf),
+				__ni_dhcp6_hexdump(&hexbuf, &optbuf));
+			ni_stringbuf_destroy(&hexbuf);
+			continue;
+		}
+
 		switch(option) {
 		case NI_DHCP6_OPTION_CLIENTID:
 			if (ni_dhcp6_option_get_duid(&optbuf, &lease->dhcp6.client_id) == 0) {
@@ -2760,148 +2895,11 @@ __ni_dhcp6_parse_client_options(ni_dhcp6_device_t *dev, ni_buffer_t *buffer, ni_
 			ni_dhcp6_option_parse_ia_pd(&optbuf, &lease->dhcp6.ia_list,
 							lease->time_acquired);
 		break;
-		case NI_DHCP6_OPTION_DNS_SERVERS:
-			if (lease->resolver == NULL) {
-				if ((lease->resolver = ni_resolver_info_new()) == NULL) {
-					ni_error("Cannot allocate memory for resolver info: %m");
-					option = 0;
-					goto failure;
-				}
-			}
-
-			if (ni_dhcp6_decode_address_list(&optbuf, &temp) == 0) {
-				for (i = 0; i < temp.count; ++i) {
-					ni_debug_dhcp("%s: %s",	ni_dhcp6_option_name(option),
-							temp.data[i]);
-					ni_string_array_append(&lease->resolver->dns_servers,
-							temp.data[i]);
-				}
-			}
-			ni_string_array_destroy(&temp);
-		break;
-		case NI_DHCP6_OPTION_DNS_DOMAINS:
-			if (lease->resolver == NULL) {
-				if ((lease->resolver = ni_resolver_info_new()) == NULL) {
-					ni_error("Cannot allocate memory for resolver info: %m");
-					option = 0;
-					goto failure;
-				}
-			}
-
-			if (ni_dhcp6_decode_dnssearch(&optbuf, &temp, "dns-search domain") == 0) {
-				for (i = 0; i < temp.count; ++i) {
-					ni_debug_dhcp("%s: %s", ni_dhcp6_option_name(option),
-							temp.data[i]);
-					ni_string_array_append(&lease->resolver->dns_search,
-							temp.data[i]);
-				}
-			}
-			ni_string_array_destroy(&temp);
-		break;
 		case NI_DHCP6_OPTION_FQDN:
 			if (ni_dhcp6_option_get_fqdn(&optbuf, &lease->fqdn, &lease->hostname) == 0) {
 				ni_debug_dhcp("%s: %s", ni_dhcp6_option_name(option), lease->hostname);
 			}
 		break;
-		case NI_DHCP6_OPTION_SIP_SERVER_A:
-			if (ni_dhcp6_decode_address_list(&optbuf, &temp) == 0) {
-				for (i = 0; i < temp.count; ++i) {
-					ni_debug_dhcp("%s: %s", ni_dhcp6_option_name(option),
-							temp.data[i]);
-					ni_string_array_append(&lease->sip_servers,
-							temp.data[i]);
-				}
-			}
-			ni_string_array_destroy(&temp);
-		break;
-		case NI_DHCP6_OPTION_SIP_SERVER_D:
-			if (ni_dhcp6_decode_dnssearch(&optbuf, &temp, "sip-server name") == 0) {
-				for (i = 0; i < temp.count; ++i) {
-					ni_debug_dhcp("%s: %s", ni_dhcp6_option_name(option),
-							temp.data[i]);
-					ni_string_array_append(&lease->sip_servers,
-							temp.data[i]);
-				}
-			}
-			ni_string_array_destroy(&temp);
-		break;
-		case NI_DHCP6_OPTION_SNTP_SERVERS:
-			if (ni_dhcp6_decode_address_list(&optbuf, &temp) == 0) {
-				for (i = 0; i < temp.count; ++i) {
-					ni_debug_dhcp("%s: %s", ni_dhcp6_option_name(option),
-							temp.data[i]);
-					ni_string_array_append(&lease->ntp_servers,
-							temp.data[i]);
-				}
-			}
-			ni_string_array_destroy(&temp);
-		break;
-		case NI_DHCP6_OPTION_NIS_SERVERS:
-			if (ni_dhcp6_decode_address_list(&optbuf, &temp) == 0) {
-				for (i = 0; i < temp.count; ++i) {
-					ni_debug_dhcp("%s: %s", ni_dhcp6_option_name(option),
-							temp.data[i]);
-					/* TODO
-					ni_string_array_append(&nis_servers, temp.data[i]);
-					*/
-				}
-			}
-			ni_string_array_destroy(&temp);
-		break;
-		case NI_DHCP6_OPTION_NIS_DOMAIN_NAME:
-			if (ni_dhcp6_decode_dnssearch(&optbuf, &temp, "nis domain") == 0) {
-				for (i = 0; i < temp.count; ++i) {
-					ni_debug_dhcp("%s: %s", ni_dhcp6_option_name(option),
-							temp.data[i]);
-					/* TODO:
-					ni_string_array_append(&nis_domains, temp.data[i]);
-					*/
-				}
-			}
-			ni_string_array_destroy(&temp);
-		break;
-		case NI_DHCP6_OPTION_POSIX_TZ_STRING:
-			if (ni_dhcp6_option_gets(&optbuf, &str) == 0) {
-				size_t len = ni_string_len(str);
-				if (ni_check_printable(str, len)) {
-					ni_string_dup(&lease->posix_tz_string, str);
-					ni_debug_dhcp("%s: %s", ni_dhcp6_option_name(option), str);
-				} else {
-					ni_warn("Discarded suspect %s: '%s'",
-							ni_dhcp6_option_name(option),
-							ni_print_suspect(str, len));
-				}
-				ni_string_free(&str);
-			}
-		break;
-		case NI_DHCP6_OPTION_POSIX_TZ_DBNAME:
-			if (ni_dhcp6_option_gets(&optbuf, &str) == 0) {
-				size_t len = ni_string_len(str);
-				if (ni_check_pathname(str, len)) {
-					ni_string_dup(&lease->posix_tz_dbname, str);
-					ni_debug_dhcp("%s: %s", ni_dhcp6_option_name(option), str);
-				} else {
-					ni_warn("Discarded suspect %s: '%s'",
-							ni_dhcp6_option_name(option),
-							ni_print_suspect(str, len));
-				}
-				ni_string_free(&str);
-			}
-		break;
-		case NI_DHCP6_OPTION_BOOTFILE_URL:
-			if (ni_dhcp6_option_gets(&optbuf, &str) == 0) {
-				size_t len = ni_string_len(str);
-				if (ni_check_pathname(str, len)) {
-					ni_string_dup(&lease->dhcp6.boot_url, str);
-					ni_debug_dhcp("%s: %s", ni_dhcp6_option_name(option), str);
-				} else {
-					ni_warn("Discarded suspect %s: '%s'",
-							ni_dhcp6_option_name(option),
-							ni_print_suspect(str, len));
-				}
-				ni_string_free(&str);
-			}
-		break;
 		case NI_DHCP6_OPTION_BOOTFILE_PARAM:
 			if (ni_dhcp6_option_get_printable_array(&optbuf,
 						&lease->dhcp6.boot_params,
@@ -2947,6 +2945,13 @@ __ni_dhcp6_parse_client_options(ni_dhcp6_device_t *dev, ni_buffer_t *buffer, ni_
 		break;
 
 		default:
+			if (codec && codec->type != NI_DHCP_CODEC_NONE) {
+				if (ni_dhcp_option_codec_decode(codec,
+						ni_dhcp6_option_name(option),
+						&optbuf, lease) < 0)
+					goto failure;
+				break;
+			}
 #ifdef	NI_DHCP6_HEXDUMP_LEVEL
 			__ni_dhcp6_hexdump(&hexbuf, &optbuf);
 			ni_debug_verbose(NI_DHCP6_HEXDUMP_LEVEL, NI_TRACE_DHCP,
@@ -2985,20 +2990,12 @@ __ni_dhcp6_parse_client_options(ni_dhcp6_device_t *dev, ni_buffer_t *buffer, ni_
 		}
 	}
 
-	if (nis_domains.count) {
-		/* TODO */
-	}
-
 	/* FIXME: too early here -- do it after parsing depending on the state? */
 	__copy_ia_na_to_lease_addrs(dev, lease);
 
-	ni_string_array_destroy(&nis_servers);
-	ni_string_array_destroy(&nis_domains);
 	return 0;
 
 failure:
-	ni_string_array_destroy(&nis_servers);
-	ni_string_array_destroy(&nis_domains);
 	return -1;
 }
 
@@ -3223,6 +3220,8 @@ ni_dhcp6_jitter_rebase(unsigned int msec, int lower, int upper)
 ni_bool_t
 ni_dhcp6_set_message_timing(ni_dhcp6_device_t *dev, unsigned int msg_type)
 {
+	if (dev->retrans.timer)
+		ni_timer_cancel(dev->retrans.timer);
 	memset(&dev->retrans, 0, sizeof(dev->retrans));
 
 	if (msg_type < __NI_DHCP6_MSG_TYPE_MAX) {
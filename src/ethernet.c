@@ -6,15 +6,23 @@
 #ifdef HAVE_CONFIG_H
 #include "config.h"
 #endif
+#include <stddef.h>
 #include <net/if_arp.h>
 #include <linux/ethtool.h>
 #include <errno.h>
+#include <netlink/msg.h>
+#include <netlink/attr.h>
+#include <linux/genetlink.h>
+#ifdef HAVE_LINUX_ETHTOOL_NETLINK_H
+#include <linux/ethtool_netlink.h>
+#endif
 
 #include <wicked/util.h>
 #include <wicked/ethernet.h>
 #include "netinfo_priv.h"
 #include "util_priv.h"
 #include "kernel.h"
+#include "ethtool-netlink.h"
 
 #define ALL_ADVERTISED_MODES			\
 	(ADVERTISED_10baseT_Half |		\
@@ -1090,16 +1098,619 @@ ni_ethtool_set_ring(const char *ifname, ni_ethtool_ring_t *ring)
 	return 0;
 }
 
+#ifdef HAVE_LINUX_ETHTOOL_NETLINK_H
+/*
+ * ethtool netlink backend: one request per settings group.
+ * Return -1 when the caller should use the ioctl interface.
+ */
+typedef struct ni_ethtool_nl_uint_map {
+	unsigned int		attr;
+	unsigned int		type;	/* NLA_U8 or NLA_U32 */
+	size_t			offset;
+	const char *		name;
+	unsigned int		max_attr;
+} ni_ethtool_nl_uint_map_t;
+
+#define NI_ETHTOOL_NL_UINT(a, t, s, f, n, m)	{ a, t, offsetof(s, f), n, m }
+#define NI_ETHTOOL_NL_UINT_MAXATTR		((unsigned int)ETHTOOL_A_COALESCE_MAX > (unsigned int)ETHTOOL_A_RINGS_MAX ? \
+						 (unsigned int)ETHTOOL_A_COALESCE_MAX : (unsigned int)ETHTOOL_A_RINGS_MAX)
+
+static const ni_ethtool_nl_uint_map_t	ni_ethtool_nl_ring_map[] = {
+	NI_ETHTOOL_NL_UINT(ETHTOOL_A_RINGS_TX, NLA_U32, ni_ethtool_ring_t,
+			tx, "tx", ETHTOOL_A_RINGS_TX_MAX),
+	NI_ETHTOOL_NL_UINT(ETHTOOL_A_RINGS_RX, NLA_U32, ni_ethtool_ring_t,
+			rx, "rx", ETHTOOL_A_RINGS_RX_MAX),
+	NI_ETHTOOL_NL_UINT(ETHTOOL_A_RINGS_RX_JUMBO, NLA_U32, ni_ethtool_ring_t,
+			rx_jumbo, "rx-jumbo", ETHTOOL_A_RINGS_RX_JUMBO_MAX),
+	NI_ETHTOOL_NL_UINT(ETHTOOL_A_RINGS_RX_MINI, NLA_U32, ni_ethtool_ring_t,
+			rx_mini, "rx-mini", ETHTOOL_A_RINGS_RX_MINI_MAX),
+	{ 0 }
+};
+
+#define NI_ETHTOOL_NL_COALESCE(a, t, f)	\
+	NI_ETHTOOL_NL_UINT(ETHTOOL_A_COALESCE_##a, t, ni_ethtool_coalesce_t, f, #f, 0)
+
+static const ni_ethtool_nl_uint_map_t	ni_ethtool_nl_coalesce_map[] = {
+	NI_ETHTOOL_NL_COALESCE(USE_ADAPTIVE_TX,		NLA_U8,  adaptive_tx),
+	NI_ETHTOOL_NL_COALESCE(USE_ADAPTIVE_RX,		NLA_U8,  adaptive_rx),
+	NI_ETHTOOL_NL_COALESCE(PKT_RATE_LOW,		NLA_U32, pkt_rate_low),
+	NI_ETHTOOL_NL_COALESCE(PKT_RATE_HIGH,		NLA_U32, pkt_rate_high),
+	NI_ETHTOOL_NL_COALESCE(RATE_SAMPLE_INTERVAL,	NLA_U32, sample_interval),
+	NI_ETHTOOL_NL_COALESCE(STATS_BLOCK_USECS,	NLA_U32, stats_block_usecs),
+	NI_ETHTOOL_NL_COALESCE(RX_USECS,		NLA_U32, rx_usecs),
+	NI_ETHTOOL_NL_COALESCE(RX_USECS_IRQ,		NLA_U32, rx_usecs_irq),
+	NI_ETHTOOL_NL_COALESCE(RX_USECS_LOW,		NLA_U32, rx_usecs_low),
+	NI_ETHTOOL_NL_COALESCE(RX_USECS_HIGH,		NLA_U32, rx_usecs_high),
+	NI_ETHTOOL_NL_COALESCE(RX_MAX_FRAMES,		NLA_U32, rx_frames),
+	NI_ETHTOOL_NL_COALESCE(RX_MAX_FRAMES_IRQ,	NLA_U32, rx_frames_irq),
+	NI_ETHTOOL_NL_COALESCE(RX_MAX_FRAMES_LOW,	NLA_U32, rx_frames_low),
+	NI_ETHTOOL_NL_COALESCE(RX_MAX_FRAMES_HIGH,	NLA_U32, rx_frames_high),
+	NI_ETHTOOL_NL_COALESCE(TX_USECS,		NLA_U32, tx_usecs),
+	NI_ETHTOOL_NL_COALESCE(TX_USECS_IRQ,		NLA_U32, tx_usecs_irq),
+	NI_ETHTOOL_NL_COALESCE(TX_USECS_LOW,		NLA_U32, tx_usecs_low),
+	NI_ETHTOOL_NL_COALESCE(TX_USECS_HIGH,		NLA_U32, tx_usecs_high),
+	NI_ETHTOOL_NL_COALESCE(TX_MAX_FRAMES,		NLA_U32, tx_frames),
+	NI_ETHTOOL_NL_COALESCE(TX_MAX_FRAMES_IRQ,	NLA_U32, tx_frames_irq),
+	NI_ETHTOOL_NL_COALESCE(TX_MAX_FRAMES_LOW,	NLA_U32, tx_frames_low),
+	NI_ETHTOOL_NL_COALESCE(TX_MAX_FRAMES_HIGH,	NLA_U32, tx_frames_high),
+	{ 0 }
+};
+
+/*
+ * Legacy offload settings are aggregates of netdev features
+ */
+static const struct ni_ethtool_nl_feature_map {
+	const char *		name;
+	size_t			offset;
+} ni_ethtool_nl_feature_map[] = {
+	{ "rx-checksum",			offsetof(ni_ethtool_offload_t, rx_csum)		},
+	{ "tx-checksum-ipv4",			offsetof(ni_ethtool_offload_t, tx_csum)		},
+	{ "tx-checksum-ip-generic",		offsetof(ni_ethtool_offload_t, tx_csum)		},
+	{ "tx-checksum-ipv6",			offsetof(ni_ethtool_offload_t, tx_csum)		},
+	{ "tx-scatter-gather",			offsetof(ni_ethtool_offload_t, scatter_gather)	},
+	{ "tx-tcp-segmentation",		offsetof(ni_ethtool_offload_t, tso)		},
+	{ "tx-tcp-ecn-segmentation",		offsetof(ni_ethtool_offload_t, tso)		},
+	{ "tx-tcp-mangleid-segmentation",	offsetof(ni_ethtool_offload_t, tso)		},
+	{ "tx-tcp6-segmentation",		offsetof(ni_ethtool_offload_t, tso)		},
+	{ "tx-udp-fragmentation",		offsetof(ni_ethtool_offload_t, ufo)		},
+	{ "tx-generic-segmentation",		offsetof(ni_ethtool_offload_t, gso)		},
+	{ "rx-gro",				offsetof(ni_ethtool_offload_t, gro)		},
+	{ "rx-lro",				offsetof(ni_ethtool_offload_t, lro)		},
+	{ NULL,					0						}
+};
+
+static int
+ni_ethtool_nl_get(const char *ifname, unsigned int cmd, unsigned int reply,
+		unsigned int flags, struct nlattr **tb, int maxattr,
+		struct ni_nlmsg_list *list)
+{
+	struct nl_msg *msg;
+	int ret;
+
+	ni_nlmsg_list_init(list);
+	if (!(msg = ni_ethtool_nl_msg_new(cmd, NI_ETHTOOL_NL_HEADER_ATTR, ifname, flags)))
+		return -1;
+
+	ret = ni_ethtool_nl_call(msg, list);
+	nlmsg_free(msg);
+
+	if (ret < 0) {
+		ni_debug_verbose(NI_LOG_DEBUG2, NI_TRACE_IFCONFIG,
+				"%s: ethtool netlink request %u failed: %s",
+				ifname, cmd, nl_geterror(ret));
+		ni_nlmsg_list_destroy(list);
+		return -1;
+	}
+
+	if (!list->head || ni_ethtool_nl_parse(&list->head->h, reply, tb, maxattr) < 0) {
+		ni_nlmsg_list_destroy(list);
+		return -1;
+	}
+	return 0;
+}
+
+static int
+ni_ethtool_nl_set(const char *ifname, struct nl_msg *msg, const char *what)
+{
+	int ret;
+
+	ret = ni_ethtool_nl_call(msg, NULL);
+	nlmsg_free(msg);
+
+	if (ret < 0) {
+		ni_warn("%s: failed to set ethtool.%s options: %s",
+				ifname, what, nl_geterror(ret));
+		return -1;
+	}
+	ni_debug_verbose(NI_LOG_DEBUG1, NI_TRACE_IFCONFIG,
+			"%s: applied ethtool.%s options", ifname, what);
+	return 0;
+}
+
+/*
+ * First word of a compact bitset value or mask
+ */
+static ni_bool_t
+ni_ethtool_nl_bitset_word(struct nlattr *bitset, unsigned int type, uint32_t *word)
+{
+	struct nlattr *tb[ETHTOOL_A_BITSET_MAX + 1];
+
+	if (!bitset || nla_parse_nested(tb, ETHTOOL_A_BITSET_MAX, bitset, NULL) < 0)
+		return FALSE;
+
+	if (!tb[type] || nla_len(tb[type]) < (int)sizeof(*word))
+		return FALSE;
+
+	memcpy(word, nla_data(tb[type]), sizeof(*word));
+	return TRUE;
+}
+
+static unsigned int
+ni_ethtool_nl_get_uint(struct nlattr *nla, unsigned int type)
+{
+	return type == NLA_U8 ? nla_get_u8(nla) : nla_get_u32(nla);
+}
+
+static void
+ni_ethtool_nl_get_uint_map(const ni_ethtool_nl_uint_map_t *map, struct nlattr **tb, void *data)
+{
+	for ( ; map->name; ++map) {
+		unsigned int *field = (unsigned int *)((char *)data + map->offset);
+
+		if (!tb[map->attr])
+			continue;
+
+		if (map->type == NLA_U8)
+			ni_tristate_set((ni_tristate_t *)field, nla_get_u8(tb[map->attr]));
+		else
+			*field = nla_get_u32(tb[map->attr]);
+	}
+}
+
+/*
+ * Put all changed and valid parameters into a single SET request
+ */
+static unsigned int
+ni_ethtool_nl_put_uint_map(const char *ifname, const char *what, struct nl_msg *msg,
+		const ni_ethtool_nl_uint_map_t *map, struct nlattr **tb, const void *data)
+{
+	unsigned int count = 0;
+
+	for ( ; map->name; ++map) {
+		unsigned int want = *(const unsigned int *)((const char *)data + map->offset);
+		unsigned int curr, max;
+
+		if (!tb[map->attr])
+			continue;
+
+		curr = ni_ethtool_nl_get_uint(tb[map->attr], map->type);
+		if (map->max_attr)
+			max = tb[map->max_attr] ? nla_get_u32(tb[map->max_attr]) : 0;
+		else if (map->type == NLA_U8)
+			max = NI_TRISTATE_ENABLE;
+		else
+			max = NI_ETHTOOL_COALESCE_DEFAULT;
+
+		if (!ni_ethtool_validate_uint_param(&curr, want, max, what, map->name, ifname))
+			continue;
+
+		if (map->type == NLA_U8)
+			nla_put_u8(msg, map->attr, curr);
+		else
+			nla_put_u32(msg, map->attr, curr);
+		count++;
+	}
+	return count;
+}
+
+static int
+ni_ethtool_nl_get_link(const char *ifname, ni_ethernet_t *ether)
+{
+	struct nlattr *tb[ETHTOOL_A_LINKMODES_MAX + 1];
+	struct nlattr *ti[ETHTOOL_A_LINKINFO_MAX + 1];
+	struct ni_nlmsg_list list;
+	unsigned int speed;
+	int mapped;
+
+	if (ni_ethtool_nl_get(ifname, ETHTOOL_MSG_LINKMODES_GET, ETHTOOL_MSG_LINKMODES_GET_REPLY,
+			ETHTOOL_FLAG_COMPACT_BITSETS, tb, ETHTOOL_A_LINKMODES_MAX, &list) < 0)
+		return -1;
+
+	if (tb[ETHTOOL_A_LINKMODES_SPEED]) {
+		speed = nla_get_u32(tb[ETHTOOL_A_LINKMODES_SPEED]);
+		mapped = __ni_ethtool_to_wicked(__ni_ethtool_speed_map, speed);
+		ether->link_speed = mapped >= 0 ? (unsigned int)mapped : speed;
+	}
+	if (tb[ETHTOOL_A_LINKMODES_DUPLEX]) {
+		mapped = __ni_ethtool_to_wicked(__ni_ethtool_duplex_map,
+					nla_get_u8(tb[ETHTOOL_A_LINKMODES_DUPLEX]));
+		if (mapped >= 0)
+			ether->duplex = mapped;
+	}
+	if (tb[ETHTOOL_A_LINKMODES_AUTONEG]) {
+		ether->autoneg_enable = nla_get_u8(tb[ETHTOOL_A_LINKMODES_AUTONEG]) ?
+					NI_TRISTATE_ENABLE : NI_TRISTATE_DISABLE;
+	}
+	ni_nlmsg_list_destroy(&list);
+
+	if (ni_ethtool_nl_get(ifname, ETHTOOL_MSG_LINKINFO_GET, ETHTOOL_MSG_LINKINFO_GET_REPLY,
+			0, ti, ETHTOOL_A_LINKINFO_MAX, &list) == 0) {
+		if (ti[ETHTOOL_A_LINKINFO_PORT]) {
+			mapped = __ni_ethtool_to_wicked(__ni_ethtool_port_map,
+						nla_get_u8(ti[ETHTOOL_A_LINKINFO_PORT]));
+			if (mapped >= 0)
+				ether->port_type = mapped;
+		}
+		ni_nlmsg_list_destroy(&list);
+	}
+	return 0;
+}
+
+static int
+ni_ethtool_nl_get_wol(const char *ifname, ni_ethernet_wol_t *wol)
+{
+	struct nlattr *tb[ETHTOOL_A_WOL_MAX + 1];
+	struct ni_nlmsg_list list;
+	uint32_t value = 0, mask = 0;
+
+	if (ni_ethtool_nl_get(ifname, ETHTOOL_MSG_WOL_GET, ETHTOOL_MSG_WOL_GET_REPLY,
+			ETHTOOL_FLAG_COMPACT_BITSETS, tb, ETHTOOL_A_WOL_MAX, &list) < 0)
+		return -1;
+
+	ni_ethtool_nl_bitset_word(tb[ETHTOOL_A_WOL_MODES], ETHTOOL_A_BITSET_VALUE, &value);
+	ni_ethtool_nl_bitset_word(tb[ETHTOOL_A_WOL_MODES], ETHTOOL_A_BITSET_MASK, &mask);
+
+	wol->support = __ni_ethtool_to_wicked_bits(__ni_ethtool_wol_map, mask);
+	wol->options = __ni_ethtool_to_wicked_bits(__ni_ethtool_wol_map, value);
+	wol->sopass.len = 0;
+
+	if ((wol->options & (1<<NI_ETHERNET_WOL_SECUREON)) && tb[ETHTOOL_A_WOL_SOPASS] &&
+	    nla_len(tb[ETHTOOL_A_WOL_SOPASS]) == SOPASS_MAX && NI_MAXHWADDRLEN > SOPASS_MAX) {
+		wol->sopass.type = ARPHRD_ETHER;
+		wol->sopass.len = SOPASS_MAX;
+		memcpy(&wol->sopass.data, nla_data(tb[ETHTOOL_A_WOL_SOPASS]), SOPASS_MAX);
+	}
+
+	ni_nlmsg_list_destroy(&list);
+	return 0;
+}
+
+static int
+ni_ethtool_nl_get_offload(const char *ifname, ni_ethtool_offload_t *offload)
+{
+	struct nlattr *tb[ETHTOOL_A_FEATURES_MAX + 1];
+	struct nlattr *bs[ETHTOOL_A_BITSET_MAX + 1];
+	struct nlattr *bit[ETHTOOL_A_BITSET_BIT_MAX + 1];
+	const struct ni_ethtool_nl_feature_map *map;
+	struct ni_nlmsg_list list;
+	struct nlattr *pos;
+	ni_bool_t nomask;
+	const char *name;
+	int rem;
+
+	/* non-compact bitsets carry the feature names */
+	if (ni_ethtool_nl_get(ifname, ETHTOOL_MSG_FEATURES_GET, ETHTOOL_MSG_FEATURES_GET_REPLY,
+			0, tb, ETHTOOL_A_FEATURES_MAX, &list) < 0)
+		return -1;
+
+	if (!tb[ETHTOOL_A_FEATURES_ACTIVE] ||
+	    nla_parse_nested(bs, ETHTOOL_A_BITSET_MAX, tb[ETHTOOL_A_FEATURES_ACTIVE], NULL) < 0 ||
+	    !bs[ETHTOOL_A_BITSET_BITS]) {
+		ni_nlmsg_list_destroy(&list);
+		return -1;
+	}
+
+	for (map = ni_ethtool_nl_feature_map; map->name; ++map)
+		*(ni_tristate_t *)((char *)offload + map->offset) = NI_TRISTATE_DISABLE;
+
+	nomask = bs[ETHTOOL_A_BITSET_NOMASK] != NULL;
+	nla_for_each_nested(pos, bs[ETHTOOL_A_BITSET_BITS], rem) {
+		if (nla_parse_nested(bit, ETHTOOL_A_BITSET_BIT_MAX, pos, NULL) < 0 ||
+		    !bit[ETHTOOL_A_BITSET_BIT_NAME])
+			continue;
+		if (!nomask && !bit[ETHTOOL_A_BITSET_BIT_VALUE])
+			continue;
+
+		name = nla_get_string(bit[ETHTOOL_A_BITSET_BIT_NAME]);
+		for (map = ni_ethtool_nl_feature_map; map->name; ++map) {
+			if (ni_string_eq(map->name, name))
+				*(ni_tristate_t *)((char *)offload + map->offset) = NI_TRISTATE_ENABLE;
+		}
+	}
+
+	ni_nlmsg_list_destroy(&list);
+	return 0;
+}
+
+static int
+ni_ethtool_nl_get_eee(const char *ifname, ni_ethtool_eee_t *eee)
+{
+	struct nlattr *tb[ETHTOOL_A_EEE_MAX + 1];
+	struct ni_nlmsg_list list;
+	uint32_t word;
+
+	if (ni_ethtool_nl_get(ifname, ETHTOOL_MSG_EEE_GET, ETHTOOL_MSG_EEE_GET_REPLY,
+			ETHTOOL_FLAG_COMPACT_BITSETS, tb, ETHTOOL_A_EEE_MAX, &list) < 0)
+		return -1;
+
+	if (tb[ETHTOOL_A_EEE_ENABLED])
+		eee->status.enabled = nla_get_u8(tb[ETHTOOL_A_EEE_ENABLED]);
+	if (tb[ETHTOOL_A_EEE_ACTIVE])
+		eee->status.active = nla_get_u8(tb[ETHTOOL_A_EEE_ACTIVE]);
+
+	if (ni_ethtool_nl_bitset_word(tb[ETHTOOL_A_EEE_MODES_OURS], ETHTOOL_A_BITSET_MASK, &word))
+		eee->speed.supported = word;
+	if (ni_ethtool_nl_bitset_word(tb[ETHTOOL_A_EEE_MODES_OURS], ETHTOOL_A_BITSET_VALUE, &word))
+		eee->speed.advertised = word;
+	if (ni_ethtool_nl_bitset_word(tb[ETHTOOL_A_EEE_MODES_PEER], ETHTOOL_A_BITSET_VALUE, &word))
+		eee->speed.lp_advertised = word;
+
+	if (tb[ETHTOOL_A_EEE_TX_LPI_ENABLED])
+		eee->tx_lpi.enabled = nla_get_u8(tb[ETHTOOL_A_EEE_TX_LPI_ENABLED]);
+	if (tb[ETHTOOL_A_EEE_TX_LPI_TIMER])
+		eee->tx_lpi.timer = nla_get_u32(tb[ETHTOOL_A_EEE_TX_LPI_TIMER]);
+
+	ni_nlmsg_list_destroy(&list);
+	return 0;
+}
+
+static int
+ni_ethtool_nl_get_ring(const char *ifname, ni_ethtool_ring_t *ring)
+{
+	struct nlattr *tb[ETHTOOL_A_RINGS_MAX + 1];
+	struct ni_nlmsg_list list;
+
+	if (ring->supported == NI_TRISTATE_DISABLE)
+		return 0;
+
+	if (ni_ethtool_nl_get(ifname, ETHTOOL_MSG_RINGS_GET, ETHTOOL_MSG_RINGS_GET_REPLY,
+			0, tb, ETHTOOL_A_RINGS_MAX, &list) < 0)
+		return -1;
+
+	ni_ethtool_nl_get_uint_map(ni_ethtool_nl_ring_map, tb, ring);
+	ni_nlmsg_list_destroy(&list);
+	return 0;
+}
+
+static int
+ni_ethtool_nl_get_coalesce(const char *ifname, ni_ethtool_coalesce_t *coalesce)
+{
+	struct nlattr *tb[ETHTOOL_A_COALESCE_MAX + 1];
+	struct ni_nlmsg_list list;
+
+	if (coalesce->supported == NI_TRISTATE_DISABLE)
+		return 0;
+
+	if (ni_ethtool_nl_get(ifname, ETHTOOL_MSG_COALESCE_GET, ETHTOOL_MSG_COALESCE_GET_REPLY,
+			0, tb, ETHTOOL_A_COALESCE_MAX, &list) < 0)
+		return -1;
+
+	ni_ethtool_nl_get_uint_map(ni_ethtool_nl_coalesce_map, tb, coalesce);
+	ni_nlmsg_list_destroy(&list);
+	return 0;
+}
+
+static int
+ni_ethtool_nl_set_uint_map(const char *ifname, const char *what,
+		unsigned int get_cmd, unsigned int get_reply, unsigned int set_cmd,
+		int maxattr, const ni_ethtool_nl_uint_map_t *map, const void *data)
+{
+	struct nlattr *tb[NI_ETHTOOL_NL_UINT_MAXATTR + 1];
+	struct ni_nlmsg_list list;
+	struct nl_msg *msg;
+	unsigned int count;
+
+	if (ni_ethtool_nl_get(ifname, get_cmd, get_reply, 0, tb, maxattr, &list) < 0)
+		return -1;
+
+	if (!(msg = ni_ethtool_nl_msg_new(set_cmd, NI_ETHTOOL_NL_HEADER_ATTR, ifname, 0))) {
+		ni_nlmsg_list_destroy(&list);
+		return -1;
+	}
+
+	count = ni_ethtool_nl_put_uint_map(ifname, what, msg, map, tb, data);
+	ni_nlmsg_list_destroy(&list);
+
+	if (!count) {
+		nlmsg_free(msg);
+		return 0;
+	}
+	return ni_ethtool_nl_set(ifname, msg, what);
+}
+
+static int
+ni_ethtool_nl_set_ring(const char *ifname, const ni_ethtool_ring_t *ring)
+{
+	if (ring->supported == NI_TRISTATE_DISABLE)
+		return 0;
+
+	return ni_ethtool_nl_set_uint_map(ifname, "ring",
+			ETHTOOL_MSG_RINGS_GET, ETHTOOL_MSG_RINGS_GET_REPLY,
+			ETHTOOL_MSG_RINGS_SET, ETHTOOL_A_RINGS_MAX,
+			ni_ethtool_nl_ring_map, ring);
+}
+
+static int
+ni_ethtool_nl_set_coalesce(const char *ifname, const ni_ethtool_coalesce_t *coalesce)
+{
+	if (coalesce->supported == NI_TRISTATE_DISABLE)
+		return 0;
+
+	return ni_ethtool_nl_set_uint_map(ifname, "coalesce",
+			ETHTOOL_MSG_COALESCE_GET, ETHTOOL_MSG_COALESCE_GET_REPLY,
+			ETHTOOL_MSG_COALESCE_SET, ETHTOOL_A_COALESCE_MAX,
+			ni_ethtool_nl_coalesce_map, coalesce);
+}
+
+static int
+ni_ethtool_nl_set_eee(const char *ifname, const ni_ethtool_eee_t *eee)
+{
+	unsigned int count = 0;
+	struct nlattr *modes;
+	struct nl_msg *msg;
+
+	if (eee->supported == NI_TRISTATE_DISABLE)
+		return 0;
+
+	if (!(msg = ni_ethtool_nl_msg_new(ETHTOOL_MSG_EEE_SET, ETHTOOL_A_EEE_HEADER,
+					ifname, ETHTOOL_FLAG_COMPACT_BITSETS)))
+		return -1;
+
+	if (eee->status.enabled != NI_TRISTATE_DEFAULT) {
+		nla_put_u8(msg, ETHTOOL_A_EEE_ENABLED, eee->status.enabled == NI_TRISTATE_ENABLE);
+		count++;
+	}
+	if (eee->tx_lpi.enabled != NI_TRISTATE_DEFAULT) {
+		nla_put_u8(msg, ETHTOOL_A_EEE_TX_LPI_ENABLED, eee->tx_lpi.enabled == NI_TRISTATE_ENABLE);
+		count++;
+	}
+	if (eee->tx_lpi.timer != NI_ETHTOOL_EEE_DEFAULT) {
+		nla_put_u32(msg, ETHTOOL_A_EEE_TX_LPI_TIMER, eee->tx_lpi.timer);
+		count++;
+	}
+
+	/* the legacy advertise mask covers the first 32 link modes */
+	if (eee->speed.advertised != NI_ETHTOOL_EEE_DEFAULT &&
+	    (modes = nla_nest_start(msg, ETHTOOL_A_EEE_MODES_OURS))) {
+		uint32_t value = eee->speed.advertised;
+		uint32_t mask = -1U;
+
+		nla_put_u32(msg, ETHTOOL_A_BITSET_SIZE, 32);
+		nla_put(msg, ETHTOOL_A_BITSET_VALUE, sizeof(value), &value);
+		nla_put(msg, ETHTOOL_A_BITSET_MASK, sizeof(mask), &mask);
+		nla_nest_end(msg, modes);
+		count++;
+	}
+
+	if (!count) {
+		nlmsg_free(msg);
+		return 0;
+	}
+	return ni_ethtool_nl_set(ifname, msg, "eee");
+}
+
+/*
+ * Advertise all supported link modes, as the ioctl variant does
+ */
+static ni_bool_t
+ni_ethtool_nl_put_supported_modes(const char *ifname, struct nl_msg *msg)
+{
+	struct nlattr *tb[ETHTOOL_A_LINKMODES_MAX + 1];
+	struct nlattr *bs[ETHTOOL_A_BITSET_MAX + 1];
+	struct ni_nlmsg_list list;
+	struct nlattr *modes;
+	ni_bool_t ret = FALSE;
+
+	if (ni_ethtool_nl_get(ifname, ETHTOOL_MSG_LINKMODES_GET, ETHTOOL_MSG_LINKMODES_GET_REPLY,
+			ETHTOOL_FLAG_COMPACT_BITSETS, tb, ETHTOOL_A_LINKMODES_MAX, &list) < 0)
+		return FALSE;
+
+	if (tb[ETHTOOL_A_LINKMODES_OURS] &&
+	    nla_parse_nested(bs, ETHTOOL_A_BITSET_MAX, tb[ETHTOOL_A_LINKMODES_OURS], NULL) >= 0 &&
+	    bs[ETHTOOL_A_BITSET_SIZE] && bs[ETHTOOL_A_BITSET_MASK] &&
+	    (modes = nla_nest_start(msg, ETHTOOL_A_LINKMODES_OURS))) {
+		struct nlattr *mask = bs[ETHTOOL_A_BITSET_MASK];
+
+		nla_put_u32(msg, ETHTOOL_A_BITSET_SIZE, nla_get_u32(bs[ETHTOOL_A_BITSET_SIZE]));
+		nla_put(msg, ETHTOOL_A_BITSET_VALUE, nla_len(mask), nla_data(mask));
+		nla_put(msg, ETHTOOL_A_BITSET_MASK, nla_len(mask), nla_data(mask));
+		nla_nest_end(msg, modes);
+		ret = TRUE;
+	}
+
+	ni_nlmsg_list_destroy(&list);
+	return ret;
+}
+
+static int
+ni_ethtool_nl_set_link(const char *ifname, const ni_ethernet_t *ether)
+{
+	struct nl_msg *msg;
+	unsigned int count = 0;
+	int mapped, ret = 0;
+
+	if (ether->port_type != NI_ETHERNET_PORT_DEFAULT &&
+	    (mapped = __ni_wicked_to_ethtool(__ni_ethtool_port_map, ether->port_type)) >= 0) {
+		if (!(msg = ni_ethtool_nl_msg_new(ETHTOOL_MSG_LINKINFO_SET,
+					ETHTOOL_A_LINKINFO_HEADER, ifname, 0)))
+			return -1;
+		nla_put_u8(msg, ETHTOOL_A_LINKINFO_PORT, mapped);
+		if (ni_ethtool_nl_set(ifname, msg, "port") < 0)
+			ret = -1;
+	}
+
+	if (!(msg = ni_ethtool_nl_msg_new(ETHTOOL_MSG_LINKMODES_SET,
+				ETHTOOL_A_LINKMODES_HEADER, ifname, 0)))
+		return -1;
+
+	/*
+	 * With autoneg on and speed or duplex given, the kernel
+	 * restricts the advertised modes to the matching ones.
+	 */
+	if (ether->link_speed) {
+		mapped = __ni_wicked_to_ethtool(__ni_ethtool_speed_map, ether->link_speed);
+		nla_put_u32(msg, ETHTOOL_A_LINKMODES_SPEED,
+				mapped < 0 ? ether->link_speed : (unsigned int)mapped);
+		count++;
+	}
+	if (ether->duplex != NI_ETHERNET_DUPLEX_DEFAULT &&
+	    (mapped = __ni_wicked_to_ethtool(__ni_ethtool_duplex_map, ether->duplex)) >= 0) {
+		nla_put_u8(msg, ETHTOOL_A_LINKMODES_DUPLEX, mapped);
+		count++;
+	}
+	if (ether->autoneg_enable != NI_TRISTATE_DEFAULT) {
+		nla_put_u8(msg, ETHTOOL_A_LINKMODES_AUTONEG,
+				ether->autoneg_enable == NI_TRISTATE_ENABLE);
+		count++;
+
+		/* without speed and duplex, (re)advertise everything */
+		if (ether->autoneg_enable == NI_TRISTATE_ENABLE && count == 1 &&
+		    !ni_ethtool_nl_put_supported_modes(ifname, msg)) {
+			nlmsg_free(msg);
+			return -1;
+		}
+	}
+
+	if (!count) {
+		nlmsg_free(msg);
+		return ret;
+	}
+	if (ni_ethtool_nl_set(ifname, msg, "link") < 0)
+		return -1;
+	return ret;
+}
+
+#else /* HAVE_LINUX_ETHTOOL_NETLINK_H */
+
+#define ni_ethtool_nl_get_link(ifname, ether)		(-1)
+#define ni_ethtool_nl_get_wol(ifname, wol)		(-1)
+#define ni_ethtool_nl_get_offload(ifname, offload)	(-1)
+#define ni_ethtool_nl_get_eee(ifname, eee)		(-1)
+#define ni_ethtool_nl_get_ring(ifname, ring)		(-1)
+#define ni_ethtool_nl_get_coalesce(ifname, coalesce)	(-1)
+#define ni_ethtool_nl_set_link(ifname, ether)		(-1)
+#define ni_ethtool_nl_set_eee(ifname, eee)		(-1)
+#define ni_ethtool_nl_set_ring(ifname, ring)		(-1)
+#define ni_ethtool_nl_set_coalesce(ifname, coalesce)	(-1)
+
+#endif /* HAVE_LINUX_ETHTOOL_NETLINK_H */
+
 void
 __ni_system_ethernet_get(const char *ifname, ni_ethernet_t *ether)
 {
-	__ni_ethtool_get_wol(ifname, &ether->wol);
-	__ni_ethtool_get_offload(ifname, &ether->offload);
+	if (ni_ethtool_nl_get_wol(ifname, &ether->wol) < 0)
+		__ni_ethtool_get_wol(ifname, &ether->wol);
+	if (ni_ethtool_nl_get_offload(ifname, &ether->offload) < 0)
+		__ni_ethtool_get_offload(ifname, &ether->offload);
 	__ni_ethtool_get_permanent_address(ifname, &ether->permanent_address);
-	__ni_ethtool_get_gset(ifname, ether);
-	ni_ethtool_get_eee(ifname, &ether->eee);
-	ni_ethtool_get_ring(ifname, &ether->ring);
-	ni_ethtool_get_coalesce(ifname, &ether->coalesce);
+	if (ni_ethtool_nl_get_link(ifname, ether) < 0)
+		__ni_ethtool_get_gset(ifname, ether);
+	if (ni_ethtool_nl_get_eee(ifname, &ether->eee) < 0)
+		ni_ethtool_get_eee(ifname, &ether->eee);
+	if (ni_ethtool_nl_get_ring(ifname, &ether->ring) < 0)
+		ni_ethtool_get_ring(ifname, &ether->ring);
+	if (ni_ethtool_nl_get_coalesce(ifname, &ether->coalesce) < 0)
+		ni_ethtool_get_coalesce(ifname, &ether->coalesce);
 }
 
 /*
@@ -1290,8 +1901,12 @@ __ni_system_ethernet_set(const char *ifname, ni_ethernet_t *ether)
 {
 	__ni_ethtool_set_wol(ifname, &ether->wol);
 	__ni_ethtool_set_offload(ifname, &ether->offload);
-	__ni_ethtool_set_sset(ifname, ether);
-	ni_ethtool_set_eee(ifname, &ether->eee);
-	ni_ethtool_set_ring(ifname, &ether->ring);
-	ni_ethtool_set_coalesce(ifname, &ether->coalesce);
+	if (ni_ethtool_nl_set_link(ifname, ether) < 0)
+		__ni_ethtool_set_sset(ifname, ether);
+	if (ni_ethtool_nl_set_eee(ifname, &ether->eee) < 0)
+		ni_ethtool_set_eee(ifname, &ether->eee);
+	if (ni_ethtool_nl_set_ring(ifname, &ether->ring) < 0)
+		ni_ethtool_set_ring(ifname, &ether->ring);
+	if (ni_ethtool_nl_set_coalesce(ifname, &ether->coalesce) < 0)
+		ni_ethtool_set_coalesce(ifname, &ether->coalesce);
 }
@@ -0,0 +1,387 @@
+/*
+ * Ethtool generic netlink (ETHTOOL_GENL) interface
+ *
+ * Settings are queried and applied with one ETHTOOL_MSG_*_GET/SET
+ * message per settings group instead of one ioctl per option, and
+ * the "monitor" multicast group notifies us about changes.
+ * Kernels without ethtool netlink fall back to the ioctl interface.
+ *
+ * Copyright (C) 2026 SUSE LLC
+ */
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <errno.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <netlink/msg.h>
+#include <netlink/attr.h>
+#include <linux/genetlink.h>
+#ifdef HAVE_LINUX_ETHTOOL_NETLINK_H
+#include <linux/ethtool_netlink.h>
+#endif
+
+#include <wicked/netinfo.h>
+#include <wicked/logging.h>
+#include <wicked/socket.h>
+
+#include "netinfo_priv.h"
+#include "socket_priv.h"
+#include "kernel.h"
+#include "ethtool-netlink.h"
+
+#ifdef HAVE_LINUX_ETHTOOL_NETLINK_H
+
+static struct ni_ethtool_nl {
+	ni_bool_t		probed;
+	int			family;
+	unsigned int		monitor_group;
+
+	ni_netlink_t *		nl;
+	ni_socket_t *		monitor;
+	struct nl_sock *	monitor_sock;
+} ni_ethtool_nl;
+
+static struct nl_msg *
+ni_ethtool_nl_genlmsg_new(int family, unsigned int cmd, unsigned int version)
+{
+	struct genlmsghdr *gh;
+	struct nl_msg *msg;
+
+	if (!(msg = nlmsg_alloc()))
+		return NULL;
+
+	if (!nlmsg_put(msg, NL_AUTO_PORT, NL_AUTO_SEQ, family, GENL_HDRLEN, NLM_F_REQUEST)) {
+		nlmsg_free(msg);
+		return NULL;
+	}
+
+	gh = nlmsg_data(nlmsg_hdr(msg));
+	gh->cmd = cmd;
+	gh->version = version;
+	gh->reserved = 0;
+	return msg;
+}
+
+static void
+ni_ethtool_nl_probe_groups(struct nlattr *groups)
+{
+	struct nlattr *gtb[CTRL_ATTR_MCAST_GRP_MAX + 1];
+	struct nlattr *grp;
+	int rem;
+
+	nla_for_each_nested(grp, groups, rem) {
+		if (nla_parse_nested(gtb, CTRL_ATTR_MCAST_GRP_MAX, grp, NULL) < 0)
+			continue;
+		if (!gtb[CTRL_ATTR_MCAST_GRP_NAME] || !gtb[CTRL_ATTR_MCAST_GRP_ID])
+			continue;
+
+		if (ni_string_eq(nla_get_string(gtb[CTRL_ATTR_MCAST_GRP_NAME]),
+					ETHTOOL_MCGRP_MONITOR_NAME))
+			ni_ethtool_nl.monitor_group = nla_get_u32(gtb[CTRL_ATTR_MCAST_GRP_ID]);
+	}
+}
+
+/*
+ * Resolve the ethtool genl family (once)
+ */
+static ni_bool_t
+ni_ethtool_nl_probe(void)
+{
+	struct ni_ethtool_nl *state = &ni_ethtool_nl;
+	struct nlattr *tb[CTRL_ATTR_MAX + 1];
+	struct ni_nlmsg_list list;
+	struct nl_msg *msg;
+	int ret;
+
+	if (state->probed)
+		return state->family > 0;
+	state->probed = TRUE;
+
+	if (!(state->nl = __ni_netlink_open(NETLINK_GENERIC)))
+		return FALSE;
+
+	if (!(msg = ni_ethtool_nl_genlmsg_new(GENL_ID_CTRL, CTRL_CMD_GETFAMILY, 1)) ||
+	    nla_put_string(msg, CTRL_ATTR_FAMILY_NAME, ETHTOOL_GENL_NAME) < 0) {
+		if (msg)
+			nlmsg_free(msg);
+		goto failure;
+	}
+
+	ni_nlmsg_list_init(&list);
+	ret = ni_nl_talk_handle(state->nl, msg, &list);
+	nlmsg_free(msg);
+
+	if (ret < 0 || !list.head ||
+	    nlmsg_parse(&list.head->h, GENL_HDRLEN, tb, CTRL_ATTR_MAX, NULL) < 0 ||
+	    !tb[CTRL_ATTR_FAMILY_ID]) {
+		ni_debug_ifconfig("ethtool netlink interface not available");
+		ni_nlmsg_list_destroy(&list);
+		goto failure;
+	}
+
+	state->family = nla_get_u16(tb[CTRL_ATTR_FAMILY_ID]);
+	if (tb[CTRL_ATTR_MCAST_GROUPS])
+		ni_ethtool_nl_probe_groups(tb[CTRL_ATTR_MCAST_GROUPS]);
+	ni_nlmsg_list_destroy(&list);
+
+	ni_debug_ifconfig("ethtool netlink family %d, monitor group %u",
+			state->family, state->monitor_group);
+	return TRUE;
+
+failure:
+	__ni_netlink_close(state->nl);
+	state->nl = NULL;
+	return FALSE;
+}
+
+ni_bool_t
+ni_ethtool_nl_available(void)
+{
+	return ni_ethtool_nl_probe();
+}
+
+/*
+ * Create an ethtool request for a device by name
+ */
+struct nl_msg *
+ni_ethtool_nl_msg_new(unsigned int cmd, unsigned int hdr_attr, const char *ifname,
+			unsigned int flags)
+{
+	struct nlattr *hdr;
+	struct nl_msg *msg;
+
+	if (ni_string_empty(ifname) || !ni_ethtool_nl_probe())
+		return NULL;
+
+	if (!(msg = ni_ethtool_nl_genlmsg_new(ni_ethtool_nl.family, cmd, ETHTOOL_GENL_VERSION)))
+		return NULL;
+
+	if (!(hdr = nla_nest_start(msg, hdr_attr)) ||
+	    nla_put_string(msg, ETHTOOL_A_HEADER_DEV_NAME, ifname) < 0 ||
+	    (flags && nla_put_u32(msg, ETHTOOL_A_HEADER_FLAGS, flags) < 0)) {
+		nlmsg_free(msg);
+		return NULL;
+	}
+	nla_nest_end(msg, hdr);
+
+	return msg;
+}
+
+/*
+ * Send a request and store the reply (if any) in the list
+ */
+int
+ni_ethtool_nl_call(struct nl_msg *msg, struct ni_nlmsg_list *list)
+{
+	int ret;
+
+	if (!msg || !ni_ethtool_nl_probe())
+		return -1;
+
+	if ((ret = ni_nl_talk_handle(ni_ethtool_nl.nl, msg, list)) < 0)
+		return ret;
+	return 0;
+}
+
+int
+ni_ethtool_nl_parse(struct nlmsghdr *h, unsigned int cmd, struct nlattr **tb, int maxattr)
+{
+	struct genlmsghdr *gh;
+
+	if (!h || h->nlmsg_type != ni_ethtool_nl.family || !nlmsg_valid_hdr(h, GENL_HDRLEN))
+		return -1;
+
+	gh = nlmsg_data(h);
+	if (gh->cmd != cmd)
+		return -1;
+
+	return nlmsg_parse(h, GENL_HDRLEN, tb, maxattr, NULL);
+}
+
+/*
+ * Monitor multicast group processing
+ */
+static int
+ni_ethtool_nl_monitor_process(struct nl_msg *msg, void *user_data)
+{
+	struct nlattr *tb[ETHTOOL_A_HEADER_MAX + 1];
+	struct nlmsghdr *h = nlmsg_hdr(msg);
+	struct genlmsghdr *gh;
+	struct nlattr *hdr;
+	ni_netconfig_t *nc;
+	ni_netdev_t *dev;
+
+	if (h->nlmsg_type != ni_ethtool_nl.family || !nlmsg_valid_hdr(h, GENL_HDRLEN))
+		return NL_SKIP;
+
+	gh = nlmsg_data(h);
+	switch (gh->cmd) {
+	case ETHTOOL_MSG_LINKINFO_NTF:
+	case ETHTOOL_MSG_LINKMODES_NTF:
+	case ETHTOOL_MSG_WOL_NTF:
+	case ETHTOOL_MSG_FEATURES_NTF:
+	case ETHTOOL_MSG_RINGS_NTF:
+	case ETHTOOL_MSG_COALESCE_NTF:
+	case ETHTOOL_MSG_EEE_NTF:
+		break;
+	default:
+		return NL_SKIP;
+	}
+
+	if (!(hdr = nlmsg_find_attr(h, GENL_HDRLEN, NI_ETHTOOL_NL_HEADER_ATTR)) ||
+	    nla_parse_nested(tb, ETHTOOL_A_HEADER_MAX, hdr, NULL) < 0 ||
+	    !tb[ETHTOOL_A_HEADER_DEV_INDEX])
+		return NL_SKIP;
+
+	if (!(nc = ni_global_state_handle(0)))
+		return NL_SKIP;
+
+	dev = ni_netdev_by_index(nc, nla_get_u32(tb[ETHTOOL_A_HEADER_DEV_INDEX]));
+	if (!dev || dev->link.type != NI_IFTYPE_ETHERNET)
+		return NL_SKIP;
+
+	ni_debug_events("%s: ethtool notification %u, refreshing ethernet settings",
+			dev->name, gh->cmd);
+	__ni_system_ethernet_refresh(dev);
+	return NL_OK;
+}
+
+static void
+ni_ethtool_nl_monitor_receive(ni_socket_t *sock)
+{
+	struct nl_sock *nlsock = ni_ethtool_nl.monitor_sock;
+	int ret;
+
+	if (!nlsock)
+		return;
+
+	do {
+		ret = nl_recvmsgs_default(nlsock);
+	} while (ret == NLE_SUCCESS || ret == -NLE_INTR);
+
+	if (ret != -NLE_AGAIN) {
+		/* we lost notifications; refresh on link events again */
+		ni_error("ethtool netlink event receive error: %s", nl_geterror(ret));
+		ni_socket_close(sock);
+	}
+}
+
+static void
+ni_ethtool_nl_monitor_close(ni_socket_t *sock)
+{
+	if (ni_ethtool_nl.monitor_sock) {
+		nl_socket_free(ni_ethtool_nl.monitor_sock);
+		ni_ethtool_nl.monitor_sock = NULL;
+	}
+	if (ni_ethtool_nl.monitor == sock)
+		ni_ethtool_nl.monitor = NULL;
+}
+
+static void
+ni_ethtool_nl_monitor_error(ni_socket_t *sock)
+{
+	ni_error("poll error on ethtool netlink event socket: %m");
+	ni_socket_close(sock);
+}
+
+/*
+ * Listen to the ethtool monitor group and refresh the ethernet
+ * settings of a device on notifications instead of on every
+ * rtnetlink link event.
+ */
+int
+ni_server_listen_ethtool_events(void)
+{
+	struct ni_ethtool_nl *state = &ni_ethtool_nl;
+	ni_socket_t *sock;
+	int ret;
+
+	if (state->monitor)
+		return 0;
+
+	if (!ni_ethtool_nl_probe() || !state->monitor_group)
+		return -1;
+
+	if (!(state->monitor_sock = nl_socket_alloc())) {
+		ni_error("Cannot allocate ethtool netlink event socket: %m");
+		return -1;
+	}
+
+	nl_socket_modify_cb(state->monitor_sock, NL_CB_VALID, NL_CB_CUSTOM,
+				ni_ethtool_nl_monitor_process, NULL);
+	nl_socket_disable_seq_check(state->monitor_sock);
+
+	if ((ret = nl_connect(state->monitor_sock, NETLINK_GENERIC)) < 0 ||
+	    (ret = nl_socket_add_membership(state->monitor_sock, state->monitor_group)) < 0) {
+		ni_error("Cannot open ethtool netlink event socket: %s", nl_geterror(ret));
+		goto failure;
+	}
+	nl_socket_set_nonblocking(state->monitor_sock);
+
+	if (!(sock = ni_socket_wrap(nl_socket_get_fd(state->monitor_sock), SOCK_DGRAM))) {
+		ni_error("Cannot wrap ethtool netlink event socket: %m");
+		goto failure;
+	}
+
+	sock->receive = ni_ethtool_nl_monitor_receive;
+	sock->close = ni_ethtool_nl_monitor_close;
+	sock->handle_error = ni_ethtool_nl_monitor_error;
+	state->monitor = sock;
+
+	ni_socket_activate(sock);
+	return 0;
+
+failure:
+	nl_socket_free(state->monitor_sock);
+	state->monitor_sock = NULL;
+	return -1;
+}
+
+ni_bool_t
+ni_ethtool_nl_monitor_active(void)
+{
+	return ni_ethtool_nl.monitor != NULL;
+}
+
+#else /* HAVE_LINUX_ETHTOOL_NETLINK_H */
+
+ni_bool_t
+ni_ethtool_nl_available(void)
+{
+	return FALSE;
+}
+
+struct nl_msg *
+ni_ethtool_nl_msg_new(unsigned int cmd, unsigned int hdr_attr, const char *ifname,
+			unsigned int flags)
+{
+	return NULL;
+}
+
+int
+ni_ethtool_nl_call(struct nl_msg *msg, struct ni_nlmsg_list *list)
+{
+	return -1;
+}
+
+int
+ni_ethtool_nl_parse(struct nlmsghdr *h, unsigned int cmd, struct nlattr **tb, int maxattr)
+{
+	return -1;
+}
+
+int
+ni_server_listen_ethtool_events(void)
+{
+	return -1;
+}
+
+ni_bool_t
+ni_ethtool_nl_monitor_active(void)
+{
+	return FALSE;
+}
+
+#endif /* HAVE_LINUX_ETHTOOL_NETLINK_H */
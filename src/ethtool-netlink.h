@@ -0,0 +1,26 @@
+/*
+ * Ethtool generic netlink (ETHTOOL_GENL) interface
+ *
+ * Copyright (C) 2026 SUSE LLC
+ */
+#ifndef __WICKED_ETHTOOL_NETLINK_H__
+#define __WICKED_ETHTOOL_NETLINK_H__
+
+#include <netlink/netlink.h>
+#include <wicked/types.h>
+
+struct ni_nlmsg_list;
+
+/* the request header is the first attribute of all ethtool messages */
+#define NI_ETHTOOL_NL_HEADER_ATTR	1
+
+extern ni_bool_t	ni_ethtool_nl_available(void);
+extern struct nl_msg *	ni_ethtool_nl_msg_new(unsigned int cmd, unsigned int hdr_attr,
+					const char *ifname, unsigned int flags);
+extern int		ni_ethtool_nl_call(struct nl_msg *, struct ni_nlmsg_list *);
+extern int		ni_ethtool_nl_parse(struct nlmsghdr *, unsigned int cmd,
+					struct nlattr **tb, int maxattr);
+
+extern ni_bool_t	ni_ethtool_nl_monitor_active(void);
+
+#endif /* __WICKED_ETHTOOL_NETLINK_H__ */
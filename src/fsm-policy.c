@@ -512,12 +512,100 @@ ni_fsm_policy_get_origin(const ni_fsm_policy_t *policy)
 static int
 __ni_fsm_policy_compare(const void *a, const void *b)
 {
-	const ni_fsm_policy_t *pa = a;
-	const ni_fsm_policy_t *pb = b;
+	const ni_fsm_policy_t *pa = *(const ni_fsm_policy_t * const *) a;
+	const ni_fsm_policy_t *pb = *(const ni_fsm_policy_t * const *) b;
 
 	return ((int) pa->weight) - ((int) pb->weight);
 }
 
+static int
+__ni_fsm_policy_compare_seq(const void *a, const void *b)
+{
+	const ni_fsm_policy_t *pa = *(const ni_fsm_policy_t * const *) a;
+	const ni_fsm_policy_t *pb = *(const ni_fsm_policy_t * const *) b;
+	int ret;
+
+	if ((ret = __ni_fsm_policy_compare(a, b)))
+		return ret;
+	return pa->seq < pb->seq ? -1 : pa->seq > pb->seq;
+}
+
+static ni_bool_t
+__ni_fsm_policy_is_valid_config(const ni_fsm_policy_t *policy)
+{
+	if (!ni_ifpolicy_name_is_valid(policy->name)) {
+		ni_error("policy with invalid name %s", policy->name);
+		return FALSE;
+	}
+
+	if (policy->type != NI_IFPOLICY_TYPE_CONFIG) {
+		ni_error("policy %s: wrong type %d", policy->name, policy->type);
+		return FALSE;
+	}
+
+	if (!policy->match) {
+		ni_error("policy %s: no valid <match>", policy->name);
+		return FALSE;
+	}
+	return TRUE;
+}
+
+void
+ni_fsm_policy_array_destroy(ni_fsm_policy_array_t *array)
+{
+	if (array) {
+		free(array->data);
+		array->data = NULL;
+		array->count = 0;
+	}
+}
+
+/*
+ * Obtain the valid config policies, sorted by weight and sequence.
+ * The array does not hold references, use it for one pass only.
+ */
+unsigned int
+ni_fsm_policy_get_valid_policies(const ni_fsm_t *fsm, ni_fsm_policy_array_t *array)
+{
+	ni_fsm_policy_t *policy;
+	unsigned int count = 0;
+
+	ni_fsm_policy_array_destroy(array);
+	for (policy = fsm->policies; policy; policy = policy->next)
+		count++;
+	if (!count)
+		return 0;
+
+	array->data = xcalloc(count, sizeof(array->data[0]));
+	for (policy = fsm->policies; policy; policy = policy->next) {
+		if (__ni_fsm_policy_is_valid_config(policy))
+			array->data[array->count++] = policy;
+	}
+
+	qsort(array->data, array->count, sizeof(array->data[0]), __ni_fsm_policy_compare_seq);
+	return array->count;
+}
+
+/*
+ * Find the best (highest weight) applicable policy of a sorted array,
+ * without evaluating the conditions of the lower weighted ones.
+ */
+ni_fsm_policy_t *
+ni_fsm_policy_array_best_applicable(const ni_fsm_t *fsm, const ni_fsm_policy_array_t *array,
+				ni_ifworker_t *w)
+{
+	unsigned int i;
+
+	if (!fsm || !array || !w)
+		return NULL;
+
+	for (i = array->count; i-- > 0; ) {
+		if (ni_fsm_policy_applicable(fsm, array->data[i], w))
+			return array->data[i];
+	}
+	return NULL;
+}
+
 /*
  * Obtain the list of applicable policies
  */
@@ -534,20 +622,8 @@ ni_fsm_policy_get_applicable_policies(const ni_fsm_t *fsm, ni_ifworker_t *w,
 	}
 
 	for (policy = fsm->policies; policy; policy = policy->next) {
-		if (!ni_ifpolicy_name_is_valid(policy->name)) {
-			ni_error("policy with invalid name %s", policy->name);
+		if (!__ni_fsm_policy_is_valid_config(policy))
 			continue;
-		}
-
-		if (policy->type != NI_IFPOLICY_TYPE_CONFIG) {
-			ni_error("policy %s: wrong type %d", policy->name, policy->type);
-			continue;
-		}
-
-		if (!policy->match) {
-			ni_error("policy %s: no valid <match>", policy->name);
-			continue;
-		}
 
 		if (ni_fsm_policy_applicable(fsm, policy, w)) {
 			if (count < max)
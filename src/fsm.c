@@ -26,6 +26,7 @@
 #include <wicked/client.h>
 #include <wicked/bridge.h>
 #include <wicked/ovs.h>
+#include <wicked/metrics.h>
 #include <xml-schema.h>
 
 #include "dbus-objects/model.h"
@@ -5099,6 +5100,7 @@ ni_fsm_schedule(ni_fsm_t *fsm)
 			ni_ifworker_t *w = fsm->workers.data[i];
 			ni_fsm_transition_t *action;
 			unsigned int prev_state;
+			struct timeval start;
 			int rv;
 
 			ni_ifworker_get(w);
@@ -5157,7 +5159,9 @@ ni_fsm_schedule(ni_fsm_t *fsm)
 			prev_state = w->fsm.state;
 			ni_fsm_events_block(fsm);
 
+			ni_metric_start(&start);
 			rv = action->call_func(fsm, w, action);
+			ni_metric_record_since(NI_METRIC_FSM_STEP, &start);
 			if (w->fsm.next_action)
 				w->fsm.next_action++;
 
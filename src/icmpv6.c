@@ -2,6 +2,7 @@
 #include "config.h"
 #endif
 
+#include <errno.h>
 #include <unistd.h>
 #include <sys/socket.h>
 #include <netinet/in.h>
@@ -18,6 +19,10 @@
 #include "util_priv.h"
 #include "buffer.h"
 
+#define NI_ICMPV6_RA_HASH_SIZE		64
+#define NI_ICMPV6_RA_RECV_BATCH		8
+#define NI_ICMPV6_RA_RECV_SIZE		1500
+
 typedef struct ni_icmpv6_ra_socket ni_icmpv6_ra_socket_t;
 
 struct ni_icmpv6_ra_socket {
@@ -26,6 +31,25 @@ struct ni_icmpv6_ra_socket {
 	ni_socket_t *	sock;
 };
 
+typedef struct ni_icmpv6_ra_listener ni_icmpv6_ra_listener_t;
+
+struct ni_icmpv6_ra_listener {
+	ni_icmpv6_ra_listener_t *	next;
+	unsigned int			ifindex;
+	ni_icmpv6_ra_callback_t *	callback;
+	void *				user_data;
+};
+
+/*
+ * A single raw socket shared by all interfaces: it sends the router
+ * solicits and receives the advertisements, demultiplexed by ifindex.
+ */
+static struct {
+	ni_socket_t *			sock;
+	unsigned int			listeners;
+	ni_icmpv6_ra_listener_t *	hash[NI_ICMPV6_RA_HASH_SIZE];
+} ni_icmpv6_ra_shared;
+
 static int
 __ni_icmpv6_ra_sock_send_options(int fd)
 {
@@ -48,7 +72,6 @@ __ni_icmpv6_ra_sock_send_options(int fd)
 	return 0;
 }
 
-#if 0
 static int
 __ni_icmpv6_ra_sock_recv_options(int fd)
 {
@@ -80,12 +103,10 @@ __ni_icmpv6_ra_sock_advert_filter(int fd)
 	ICMP6_FILTER_SETPASS (ND_ROUTER_ADVERT, &filter);
 	if(setsockopt(fd, SOL_ICMPV6, ICMP6_FILTER, &filter, sizeof (filter)) < 0) {
 		ni_error("Unable to apply router-advert filter: %m");
-		close(fd);
 		return -1;
 	}
 	return 0;
 }
-#endif
 
 static int
 __ni_icmpv6_ra_sock_open(void)
@@ -170,35 +191,6 @@ ni_icmpv6_ra_socket_open(ni_icmpv6_ra_socket_t *ras)
 	return TRUE;
 }
 
-#if 0
-static void
-__ni_icmpv6_ra_receive(ni_socket_t *sock)
-{
-	/* Basically the parsing code is in ifevent.c
-	 * (__ni_rtevent_newprefix) as the NEWPREFIX
-	 * netlink message is almost same.
-	 */
-	(void)sock;
-	ni_trace("%s", __func__);
-}
-
-ni_bool_t
-ni_icmpv6_ra_monitor_open(ni_icmpv6_ra_socket_t *ras)
-{
-	if (!ni_icmpv6_ra_socket_open(ras))
-		return FALSE;
-
-	if (__ni_icmpv6_ra_sock_recv_options(ras->sock->__fd) < 0 ||
-	    __ni_icmpv6_ra_sock_advert_filter(ras->sock->__fd) < 0) {
-		ni_icmpv6_ra_socket_close(ras);
-		return FALSE;
-	}
-
-	ras->sock->receive = __ni_icmpv6_ra_receive;
-	ni_buffer_init_dynamic(&sock->rbuf, 8192);
-	return TRUE;
-}
-#endif
 
 ni_bool_t
 ni_icmpv6_ra_solicit_build(ni_buffer_t *buf, ni_hwaddr_t *hwa)
@@ -226,8 +218,8 @@ ni_icmpv6_ra_solicit_build(ni_buffer_t *buf, ni_hwaddr_t *hwa)
 	return TRUE;
 }
 
-ni_bool_t
-ni_icmpv6_ra_solicit_send(ni_icmpv6_ra_socket_t *ras)
+static ni_bool_t
+__ni_icmpv6_ra_solicit_sendmsg(int fd, unsigned int ifindex, ni_buffer_t *buf)
 {
 	static const char *all_routers_mc = "ff02::2";
 	struct in6_pktinfo *pinfo;
@@ -237,18 +229,9 @@ ni_icmpv6_ra_solicit_send(ni_icmpv6_ra_socket_t *ras)
 	struct msghdr   msg;
 	ni_sockaddr_t	addr;
 
-	if (!ras || !ras->sock || !ras->dev.index)
-		return FALSE;
-
 	if (ni_sockaddr_parse(&addr, all_routers_mc, AF_INET6) < 0)
 		return FALSE;
 
-	ni_buffer_reset(&ras->sock->wbuf);
-	if (!ni_icmpv6_ra_solicit_build(&ras->sock->wbuf, &ras->hwa)) {
-		ni_buffer_reset(&ras->sock->wbuf);
-		return FALSE;
-	}
-
 	memset(&cmsgbuf, 0, sizeof(cmsgbuf));
 	cmsg = (struct cmsghdr *)cmsgbuf;
 	cmsg->cmsg_len = CMSG_LEN(sizeof(*pinfo));
@@ -256,11 +239,12 @@ ni_icmpv6_ra_solicit_send(ni_icmpv6_ra_socket_t *ras)
 	cmsg->cmsg_type = IPV6_PKTINFO;
 
 	pinfo = (struct in6_pktinfo *)CMSG_DATA(cmsg);
-	pinfo->ipi6_ifindex = ras->dev.index;
+	pinfo->ipi6_ifindex = ifindex;
 
-	iov.iov_base = ni_buffer_head(&ras->sock->wbuf);
-	iov.iov_len  = ni_buffer_count(&ras->sock->wbuf);
+	iov.iov_base = ni_buffer_head(buf);
+	iov.iov_len  = ni_buffer_count(buf);
 
+	memset(&msg, 0, sizeof(msg));
 	msg.msg_name = &addr.six;
 	msg.msg_namelen = sizeof(addr.six);
 	msg.msg_iov = &iov;
@@ -268,25 +252,247 @@ ni_icmpv6_ra_solicit_send(ni_icmpv6_ra_socket_t *ras)
 	msg.msg_control = cmsgbuf;
 	msg.msg_controllen = CMSG_SPACE(sizeof(*pinfo));
 
-	if (sendmsg(ras->sock->__fd, &msg, 0) == -1)
+	if (sendmsg(fd, &msg, 0) == -1)
 		return FALSE;
 	return TRUE;
 }
 
 ni_bool_t
-ni_icmpv6_ra_solicit(const ni_netdev_ref_t *ref, const ni_hwaddr_t *hwa)
+ni_icmpv6_ra_solicit_send(ni_icmpv6_ra_socket_t *ras)
 {
-	ni_icmpv6_ra_socket_t *ras;
 	ni_bool_t sent;
 
-	ras = ni_icmpv6_ra_socket_new(ref, hwa);
-	if (!ni_icmpv6_ra_socket_open(ras)) {
-		ni_icmpv6_ra_socket_free(ras);
+	if (!ras || !ras->sock || !ras->dev.index)
+		return FALSE;
+
+	ni_buffer_reset(&ras->sock->wbuf);
+	if (!ni_icmpv6_ra_solicit_build(&ras->sock->wbuf, &ras->hwa)) {
+		ni_buffer_reset(&ras->sock->wbuf);
 		return FALSE;
 	}
 
-	sent = ni_icmpv6_ra_solicit_send(ras);
-	ni_icmpv6_ra_socket_free(ras);
+	sent = __ni_icmpv6_ra_solicit_sendmsg(ras->sock->__fd, ras->dev.index, &ras->sock->wbuf);
+	ni_buffer_reset(&ras->sock->wbuf);
 	return sent;
 }
 
+/*
+ * Shared router advertisement socket
+ */
+static ni_icmpv6_ra_listener_t **
+__ni_icmpv6_ra_listener_bucket(unsigned int ifindex)
+{
+	return &ni_icmpv6_ra_shared.hash[ifindex % NI_ICMPV6_RA_HASH_SIZE];
+}
+
+static void
+__ni_icmpv6_ra_dispatch(unsigned int ifindex, const struct nd_router_advert *ra,
+			size_t len, const ni_sockaddr_t *from)
+{
+	ni_icmpv6_ra_listener_t *l, *next;
+
+	for (l = *__ni_icmpv6_ra_listener_bucket(ifindex); l; l = next) {
+		next = l->next;
+		if (l->ifindex == ifindex)
+			l->callback(ifindex, ra, len, from, l->user_data);
+	}
+}
+
+static void
+__ni_icmpv6_ra_process(const struct mmsghdr *mm, const unsigned char *data)
+{
+	const struct msghdr *msg = &mm->msg_hdr;
+	const struct nd_router_advert *ra;
+	const struct in6_pktinfo *pinfo = NULL;
+	const struct sockaddr_in6 *sin6;
+	struct cmsghdr *cmsg;
+	ni_sockaddr_t from;
+	int hoplimit = -1;
+
+	for (cmsg = CMSG_FIRSTHDR(msg); cmsg; cmsg = CMSG_NXTHDR((struct msghdr *)msg, cmsg)) {
+		if (cmsg->cmsg_level != IPPROTO_IPV6)
+			continue;
+
+		if (cmsg->cmsg_type == IPV6_PKTINFO &&
+		    cmsg->cmsg_len >= CMSG_LEN(sizeof(*pinfo)))
+			pinfo = (const struct in6_pktinfo *)CMSG_DATA(cmsg);
+		else
+		if (cmsg->cmsg_type == IPV6_HOPLIMIT &&
+		    cmsg->cmsg_len >= CMSG_LEN(sizeof(hoplimit)))
+			memcpy(&hoplimit, CMSG_DATA(cmsg), sizeof(hoplimit));
+	}
+
+	if (!pinfo || !pinfo->ipi6_ifindex)
+		return;
+
+	/* RFC 4861, 6.1.2: must be link-local and not forwarded */
+	sin6 = msg->msg_name;
+	if (hoplimit != 255 || msg->msg_namelen < sizeof(*sin6) ||
+	    !IN6_IS_ADDR_LINKLOCAL(&sin6->sin6_addr))
+		return;
+
+	ra = (const struct nd_router_advert *)data;
+	if (mm->msg_len < sizeof(*ra) || ra->nd_ra_type != ND_ROUTER_ADVERT ||
+	    ra->nd_ra_code != 0)
+		return;
+
+	ni_sockaddr_set_ipv6(&from, sin6->sin6_addr, 0);
+	from.six.sin6_scope_id = pinfo->ipi6_ifindex;
+	__ni_icmpv6_ra_dispatch(pinfo->ipi6_ifindex, ra, mm->msg_len, &from);
+}
+
+static void
+__ni_icmpv6_ra_receive(ni_socket_t *sock)
+{
+	static unsigned char data[NI_ICMPV6_RA_RECV_BATCH][NI_ICMPV6_RA_RECV_SIZE];
+	static unsigned char ctrl[NI_ICMPV6_RA_RECV_BATCH][CMSG_SPACE(sizeof(struct in6_pktinfo)) +
+							   CMSG_SPACE(sizeof(int))];
+	struct sockaddr_in6 from[NI_ICMPV6_RA_RECV_BATCH];
+	struct mmsghdr mm[NI_ICMPV6_RA_RECV_BATCH];
+	struct iovec iov[NI_ICMPV6_RA_RECV_BATCH];
+	unsigned int i;
+	int n;
+
+	do {
+		memset(mm, 0, sizeof(mm));
+		for (i = 0; i < NI_ICMPV6_RA_RECV_BATCH; ++i) {
+			iov[i].iov_base = data[i];
+			iov[i].iov_len  = sizeof(data[i]);
+			mm[i].msg_hdr.msg_name = &from[i];
+			mm[i].msg_hdr.msg_namelen = sizeof(from[i]);
+			mm[i].msg_hdr.msg_iov = &iov[i];
+			mm[i].msg_hdr.msg_iovlen = 1;
+			mm[i].msg_hdr.msg_control = ctrl[i];
+			mm[i].msg_hdr.msg_controllen = sizeof(ctrl[i]);
+		}
+
+		n = recvmmsg(sock->__fd, mm, NI_ICMPV6_RA_RECV_BATCH, MSG_DONTWAIT, NULL);
+		if (n < 0) {
+			if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+				ni_debug_socket("icmpv6: unable to receive router advertisements: %m");
+			return;
+		}
+
+		for (i = 0; i < (unsigned int)n; ++i)
+			__ni_icmpv6_ra_process(&mm[i], data[i]);
+
+		/* a listener callback may have closed the socket */
+	} while (n == NI_ICMPV6_RA_RECV_BATCH && ni_icmpv6_ra_shared.sock == sock);
+}
+
+static void
+__ni_icmpv6_ra_shared_close(void)
+{
+	ni_socket_t *sock;
+
+	if ((sock = ni_icmpv6_ra_shared.sock)) {
+		ni_icmpv6_ra_shared.sock = NULL;
+		ni_socket_close(sock);
+	}
+}
+
+static ni_socket_t *
+__ni_icmpv6_ra_shared_socket(void)
+{
+	ni_socket_t *sock;
+	int fd;
+
+	if (ni_icmpv6_ra_shared.sock)
+		return ni_icmpv6_ra_shared.sock;
+
+	if ((fd = __ni_icmpv6_ra_sock_open()) < 0)
+		return NULL;
+
+	if (__ni_icmpv6_ra_sock_send_options(fd) < 0 ||
+	    __ni_icmpv6_ra_sock_recv_options(fd) < 0 ||
+	    __ni_icmpv6_ra_sock_advert_filter(fd) < 0) {
+		close(fd);
+		return NULL;
+	}
+
+	if (!(sock = ni_socket_wrap(fd, SOCK_RAW))) {
+		close(fd);
+		return NULL;
+	}
+
+	sock->receive = __ni_icmpv6_ra_receive;
+	if (!ni_socket_activate(sock)) {
+		ni_socket_release(sock);
+		return NULL;
+	}
+
+	ni_icmpv6_ra_shared.sock = sock;
+	return sock;
+}
+
+/*
+ * Register a callback for router advertisements received on ifindex
+ */
+ni_bool_t
+ni_icmpv6_ra_listen(unsigned int ifindex, ni_icmpv6_ra_callback_t *callback, void *user_data)
+{
+	ni_icmpv6_ra_listener_t *l, **bucket;
+
+	if (!ifindex || !callback)
+		return FALSE;
+
+	bucket = __ni_icmpv6_ra_listener_bucket(ifindex);
+	for (l = *bucket; l; l = l->next) {
+		if (l->ifindex == ifindex && l->user_data == user_data) {
+			l->callback = callback;
+			return TRUE;
+		}
+	}
+
+	if (!__ni_icmpv6_ra_shared_socket())
+		return FALSE;
+
+	l = xcalloc(1, sizeof(*l));
+	l->ifindex = ifindex;
+	l->callback = callback;
+	l->user_data = user_data;
+	l->next = *bucket;
+	*bucket = l;
+	ni_icmpv6_ra_shared.listeners++;
+	return TRUE;
+}
+
+void
+ni_icmpv6_ra_unlisten(unsigned int ifindex, void *user_data)
+{
+	ni_icmpv6_ra_listener_t *l, **pos;
+
+	for (pos = __ni_icmpv6_ra_listener_bucket(ifindex); (l = *pos); pos = &l->next) {
+		if (l->ifindex == ifindex && l->user_data == user_data) {
+			*pos = l->next;
+			free(l);
+			if (!--ni_icmpv6_ra_shared.listeners)
+				__ni_icmpv6_ra_shared_close();
+			return;
+		}
+	}
+}
+
+ni_bool_t
+ni_icmpv6_ra_solicit(const ni_netdev_ref_t *ref, const ni_hwaddr_t *hwa)
+{
+	ni_buffer_t buf;
+	ni_socket_t *sock;
+	ni_bool_t sent;
+
+	if (!ref || !ref->index)
+		return FALSE;
+
+	if (!(sock = __ni_icmpv6_ra_shared_socket()))
+		return FALSE;
+
+	ni_buffer_init_dynamic(&buf, 64);
+	sent = ni_icmpv6_ra_solicit_build(&buf, (ni_hwaddr_t *)hwa) &&
+		__ni_icmpv6_ra_solicit_sendmsg(sock->__fd, ref->index, &buf);
+	ni_buffer_destroy(&buf);
+
+	/* nobody is interested in the answer directly */
+	if (!ni_icmpv6_ra_shared.listeners)
+		__ni_icmpv6_ra_shared_close();
+	return sent;
+}
@@ -137,9 +137,13 @@ static int	__ni_rtnl_link_delete(const ni_netdev_t *);
 
 static int	__ni_rtnl_link_add_port_up(const ni_netdev_t *, const char *, unsigned int);
 static int	__ni_rtnl_link_add_slave_down(const ni_netdev_t *, const char *, unsigned int);
+static int	__ni_rtnl_link_del_slave(const ni_netdev_ref_t *, const char *);
+static int	__ni_rtnl_link_change_bridge(const ni_netdev_t *, const ni_bridge_t *,
+						const ni_bridge_port_t *);
 
 static int	__ni_rtnl_send_deladdr(ni_netdev_t *, const ni_address_t *);
-static int	__ni_rtnl_send_newaddr(ni_netdev_t *, const ni_address_t *, int);
+static struct nl_msg *	__ni_rtnl_deladdr_msg(ni_netdev_t *, const ni_address_t *);
+static struct nl_msg *	__ni_rtnl_newaddr_msg(ni_netdev_t *, const ni_address_t *, int);
 static int	__ni_rtnl_send_delroute(ni_netdev_t *, ni_route_t *);
 static int	__ni_rtnl_send_newroute(ni_netdev_t *, ni_route_t *, int);
 static int	__ni_rtnl_send_newrule(const ni_rule_t *, int);
@@ -1200,10 +1204,8 @@ ni_system_interface_delete(ni_netconfig_t *nc, const char *ifname)
 		break;
 
 	case NI_IFTYPE_BOND:
-		if (ni_sysfs_bonding_delete_master(dev->name) < 0) {
-			ni_error("could not destroy bonding interface %s", dev->name);
+		if (ni_system_bond_delete(nc, dev) < 0)
 			return -1;
-		}
 		break;
 
 	default:
@@ -1624,8 +1626,9 @@ ni_system_bridge_setup(ni_netconfig_t *nc, ni_netdev_t *dev, const ni_bridge_t *
 		return -1;
 	}
 
-	if (ni_sysfs_bridge_update_config(dev->name, bcfg) < 0) {
-		ni_error("%s: failed to update sysfs attributes for %s", __func__, dev->name);
+	if (__ni_rtnl_link_change_bridge(dev, bcfg, NULL) < 0 &&
+	    ni_sysfs_bridge_update_config(dev->name, bcfg) < 0) {
+		ni_error("%s: failed to update bridge attributes for %s", __func__, dev->name);
 		return -1;
 	}
 #if 0
@@ -1747,6 +1750,18 @@ ni_system_bridge_add_port(ni_netconfig_t *nc, ni_netdev_t *brdev, const ni_bridg
 	if (__ni_rtnl_link_add_port_up(pif, brdev->name, brdev->link.ifindex) == 0) {
 		ni_netdev_ref_set(&pif->link.masterdev, brdev->name,
 				brdev->link.ifindex);
+
+		/* slave data is accepted only once the port is enslaved */
+		if (port->priority == NI_BRIDGE_VALUE_NOT_SET &&
+		    port->path_cost == NI_BRIDGE_VALUE_NOT_SET)
+			return 0;
+
+		if (__ni_rtnl_link_change_bridge(pif, NULL, port) < 0 &&
+		    (rv = ni_sysfs_bridge_port_update_config(pif->name, port)) < 0) {
+			ni_error("%s: failed to configure port %s: %s",
+				brdev->name, pif->name, ni_strerror(rv));
+			return rv;
+		}
 		return 0;
 	}
 
@@ -1774,7 +1789,7 @@ ni_system_bridge_add_port(ni_netconfig_t *nc, ni_netdev_t *brdev, const ni_bridg
 	if (!ni_string_eq(new_port->ifname, pif->name))
 		ni_string_dup(&new_port->ifname, pif->name);
 
-	if (!ni_bridge_add_port(bridge, new_port))
+	if (ni_bridge_add_port(bridge, new_port) < 0)
 		ni_bridge_port_free(new_port);
 	return 0;
 }
@@ -1787,6 +1802,8 @@ int
 ni_system_bridge_remove_port(ni_netdev_t *dev, unsigned int port_ifindex)
 {
 	ni_bridge_t *bridge = ni_netdev_get_bridge(dev);
+	ni_bridge_port_t *port;
+	ni_netdev_ref_t ref;
 	int rv;
 
 	if (port_ifindex == 0) {
@@ -1794,7 +1811,12 @@ ni_system_bridge_remove_port(ni_netdev_t *dev, unsigned int port_ifindex)
 		return -NI_ERROR_DEVICE_NOT_KNOWN;
 	}
 
-	if ((rv = __ni_brioctl_del_port(dev->name, port_ifindex)) < 0) {
+	port = ni_bridge_port_by_index(bridge, port_ifindex);
+	ref.name = port ? port->ifname : NULL;
+	ref.index = port_ifindex;
+
+	if (__ni_rtnl_link_del_slave(&ref, dev->name) < 0 &&
+	    (rv = __ni_brioctl_del_port(dev->name, port_ifindex)) < 0) {
 		ni_error("%s: cannot remove port: %s", dev->name, ni_strerror(rv));
 		return rv;
 	}
@@ -2040,8 +2062,8 @@ ni_system_bond_setup(ni_netconfig_t *nc, ni_netdev_t *dev, const ni_netdev_t *cf
 /*
  * Shutdown a bonding device
  */
-int
-ni_system_bond_shutdown(ni_netdev_t *dev)
+static int
+ni_system_bond_shutdown_sysfs(ni_netdev_t *dev)
 {
 	ni_string_array_t list = NI_STRING_ARRAY_INIT;
 	unsigned int i;
@@ -2060,17 +2082,65 @@ cleanup:
 	return rv;
 }
 
+static int
+ni_system_bond_shutdown_netlink(ni_netdev_t *dev)
+{
+	ni_bonding_t *bond;
+	unsigned int i;
+
+	/* the slave list is maintained from the IFLA_MASTER of the slaves */
+	if (!(bond = dev->bonding) || !bond->slaves.count)
+		return 0;
+
+	for (i = 0; i < bond->slaves.count; ++i) {
+		ni_bonding_slave_t *slave = bond->slaves.data[i];
+
+		if (!slave)
+			continue;
+
+		if (__ni_rtnl_link_del_slave(&slave->device, dev->name) < 0)
+			return -1;
+	}
+	return 0;
+}
+
+int
+ni_system_bond_shutdown(ni_netdev_t *dev)
+{
+	if (!dev || dev->link.type != NI_IFTYPE_BOND)
+		return -1;
+
+	switch (ni_config_bonding_ctl()) {
+	case NI_CONFIG_BONDING_CTL_SYSFS:
+		return ni_system_bond_shutdown_sysfs(dev);
+
+	case NI_CONFIG_BONDING_CTL_NETLINK:
+	default:
+		return ni_system_bond_shutdown_netlink(dev);
+	}
+}
+
 /*
  * Delete a bonding device
  */
 int
 ni_system_bond_delete(ni_netconfig_t *nc, ni_netdev_t *dev)
 {
-	if (ni_sysfs_bonding_delete_master(dev->name) < 0) {
-		ni_error("could not destroy bonding interface %s", dev->name);
-		return -1;
+	switch (ni_config_bonding_ctl()) {
+	case NI_CONFIG_BONDING_CTL_SYSFS:
+		if (ni_sysfs_bonding_delete_master(dev->name) < 0)
+			break;
+		return 0;
+
+	case NI_CONFIG_BONDING_CTL_NETLINK:
+	default:
+		if (__ni_rtnl_link_delete(dev) < 0)
+			break;
+		return 0;
 	}
-	return 0;
+
+	ni_error("could not destroy bonding interface %s", dev->name);
+	return -1;
 }
 
 /*
@@ -2111,14 +2181,25 @@ ni_system_bond_add_slave(ni_netconfig_t *nc, ni_netdev_t *dev, unsigned int slav
 	if (ni_bonding_has_slave(bond, slave_dev->name))
 		return 0;
 
-	ni_bonding_get_slave_names(bond, &slave_names);
-	ni_string_array_append(&slave_names, slave_dev->name);
-	if (ni_sysfs_bonding_set_list_attr(dev->name, "slaves", &slave_names) < 0) {
+	switch (ni_config_bonding_ctl()) {
+	case NI_CONFIG_BONDING_CTL_SYSFS:
+		ni_bonding_get_slave_names(bond, &slave_names);
+		ni_string_array_append(&slave_names, slave_dev->name);
+		if (ni_sysfs_bonding_set_list_attr(dev->name, "slaves", &slave_names) < 0) {
+			ni_string_array_destroy(&slave_names);
+			ni_error("%s: could not update list of slaves", dev->name);
+			return -NI_ERROR_PERMISSION_DENIED;
+		}
 		ni_string_array_destroy(&slave_names);
-		ni_error("%s: could not update list of slaves", dev->name);
-		return -NI_ERROR_PERMISSION_DENIED;
+		break;
+
+	case NI_CONFIG_BONDING_CTL_NETLINK:
+	default:
+		if (__ni_rtnl_link_add_slave_down(slave_dev, dev->name, dev->link.ifindex) < 0)
+			return -NI_ERROR_PERMISSION_DENIED;
+		ni_netdev_ref_set(&slave_dev->link.masterdev, dev->name, dev->link.ifindex);
+		break;
 	}
-	ni_string_array_destroy(&slave_names);
 	ni_bonding_add_slave(bond, slave_dev->name);
 
 	return 0;
@@ -2152,45 +2233,213 @@ ni_system_bond_remove_slave(ni_netconfig_t *nc, ni_netdev_t *dev, unsigned int s
 			return 0;
 	}
 
-	ni_bonding_slave_array_delete(&bond->slaves, idx);
-	ni_bonding_get_slave_names(bond, &slave_names);
-	if (ni_sysfs_bonding_set_list_attr(dev->name, "slaves", &slave_names) < 0) {
+	switch (ni_config_bonding_ctl()) {
+	case NI_CONFIG_BONDING_CTL_SYSFS:
+		ni_bonding_slave_array_delete(&bond->slaves, idx);
+		ni_bonding_get_slave_names(bond, &slave_names);
+		if (ni_sysfs_bonding_set_list_attr(dev->name, "slaves", &slave_names) < 0) {
+			ni_string_array_destroy(&slave_names);
+			ni_error("%s: could not update list of slaves", dev->name);
+			return -NI_ERROR_PERMISSION_DENIED;
+		}
 		ni_string_array_destroy(&slave_names);
-		ni_error("%s: could not update list of slaves", dev->name);
-		return -NI_ERROR_PERMISSION_DENIED;
+		break;
+
+	case NI_CONFIG_BONDING_CTL_NETLINK:
+	default:
+		if (__ni_rtnl_link_del_slave(&bond->slaves.data[idx]->device, dev->name) < 0)
+			return -NI_ERROR_PERMISSION_DENIED;
+		ni_bonding_slave_array_delete(&bond->slaves, idx);
+		ni_netdev_ref_destroy(&slave_dev->link.masterdev);
+		break;
 	}
-	ni_string_array_destroy(&slave_names);
 
 	return 0;
 }
 
 /*
- * Create a team device
+ * Team and ppp devices are created by their teamd or pppd service.
+ * Instead of waiting for them, the creation is completed when the
+ * main loop processes the NEWLINK event of the device and failed
+ * when the start job failed or the device did not appear in time.
  */
-int
-ni_system_team_create(ni_netconfig_t *nc, const ni_netdev_t *cfg, ni_netdev_t **dev_ret)
+#define NI_SYSTEM_NETDEV_WAIT_TIMEOUT	(10 * 1000)	/* msec */
+
+typedef struct ni_system_netdev_wait	ni_system_netdev_wait_t;
+
+struct ni_system_netdev_wait {
+	ni_system_netdev_wait_t *		next;
+
+	char *					ifname;
+	ni_iftype_t				iftype;
+	const ni_timer_t *			timer;
+
+	ni_system_netdev_create_callback_t *	callback;
+	void *					user_data;
+};
+
+static ni_system_netdev_wait_t *		ni_system_netdev_waits;
+
+static ni_system_netdev_wait_t *
+ni_system_netdev_wait_find(const char *ifname)
 {
-	unsigned int i;
+	ni_system_netdev_wait_t *wait;
+
+	for (wait = ni_system_netdev_waits; wait; wait = wait->next) {
+		if (ni_string_eq(wait->ifname, ifname))
+			return wait;
+	}
+	return NULL;
+}
+
+static ni_system_netdev_wait_t *
+ni_system_netdev_wait_unlink(const char *ifname)
+{
+	ni_system_netdev_wait_t **pos, *wait;
+
+	for (pos = &ni_system_netdev_waits; (wait = *pos); pos = &wait->next) {
+		if (ni_string_eq(wait->ifname, ifname)) {
+			*pos = wait->next;
+			wait->next = NULL;
+			return wait;
+		}
+	}
+	return NULL;
+}
+
+static void
+ni_system_netdev_wait_complete(ni_netconfig_t *nc, ni_system_netdev_wait_t *wait,
+				ni_netdev_t *dev)
+{
+	const char *type = ni_linktype_type_to_name(wait->iftype);
+
+	if (wait->timer)
+		ni_timer_cancel(wait->timer);
+
+	if (dev && dev->link.type != wait->iftype) {
+		ni_error("%s: created %s interface, but found a %s type at index %u",
+				wait->ifname, type, ni_linktype_type_to_name(dev->link.type),
+				dev->link.ifindex);
+		dev = NULL;
+	}
+
+	if (dev) {
+		ni_debug_ifconfig("%s: created %s interface with index %u",
+				wait->ifname, type, dev->link.ifindex);
+	}
+
+	switch (wait->iftype) {
+	case NI_IFTYPE_TEAM:
+		if (dev)
+			ni_teamd_discover(dev);
+		break;
+	case NI_IFTYPE_PPP:
+		if (dev)
+			ni_pppd_discover(dev, nc);
+		else
+			ni_pppd_config_file_remove(wait->ifname);
+		break;
+	default:
+		break;
+	}
+
+	wait->callback(wait->ifname, dev, wait->user_data);
+	ni_string_free(&wait->ifname);
+	free(wait);
+}
+
+static void
+ni_system_netdev_wait_timeout(void *user_data, const ni_timer_t *timer)
+{
+	ni_system_netdev_wait_t *wait = user_data;
+
+	if (wait->timer != timer)
+		return;
+
+	wait->timer = NULL;
+	if (ni_system_netdev_wait_unlink(wait->ifname) == wait) {
+		ni_error("%s: %s interface did not appear", wait->ifname,
+				ni_linktype_type_to_name(wait->iftype));
+		ni_system_netdev_wait_complete(ni_global_state_handle(0), wait, NULL);
+	}
+}
+
+static void
+ni_system_netdev_wait_job_done(const char *service, int result, void *user_data)
+{
+	ni_system_netdev_wait_t *wait;
+	char *ifname = user_data;
+
+	if (result < 0 && (wait = ni_system_netdev_wait_unlink(ifname)))
+		ni_system_netdev_wait_complete(ni_global_state_handle(0), wait, NULL);
+	free(ifname);
+}
+
+/*
+ * Called with the device of each NEWLINK event
+ */
+void
+__ni_system_netdev_appeared(ni_netconfig_t *nc, ni_netdev_t *dev)
+{
+	ni_system_netdev_wait_t *wait;
+
+	if (ni_system_netdev_waits && (wait = ni_system_netdev_wait_unlink(dev->name)))
+		ni_system_netdev_wait_complete(nc, wait, dev);
+}
+
+/*
+ * Start the service creating the device; the callback is completed
+ * right away when the device exists already.
+ */
+static int
+ni_system_netdev_wait_start(ni_netconfig_t *nc, const ni_netdev_t *cfg,
+			int (*start)(const ni_netdev_t *, ni_systemctl_job_callback_t *, void *),
+			ni_system_netdev_create_callback_t *callback, void *user_data)
+{
+	ni_system_netdev_wait_t *wait;
+	ni_netdev_t *dev = NULL;
+	char *ifname;
 	int ret;
 
-	if (!cfg || cfg->link.type != NI_IFTYPE_TEAM || !cfg->team || !ni_config_teamd_enabled())
+	if (!callback || ni_netdev_by_name(nc, cfg->name) || ni_system_netdev_wait_find(cfg->name))
 		return -1;
 
-	if (ni_teamd_service_start(cfg))
+	ifname = xstrdup(cfg->name);
+	if (start(cfg, ni_system_netdev_wait_job_done, ifname)) {
+		free(ifname);
 		return -1;
-
-	/* Wait for sysfs to appear */
-	for (i = 0; i < 400; ++i) {
-		if (ni_netdev_name_to_index(cfg->name))
-			break;
-		usleep(25000);
 	}
 
-	ret = __ni_system_netdev_create(nc, cfg->name, 0, NI_IFTYPE_TEAM, dev_ret);
-	if (dev_ret && *dev_ret) {
-		ni_teamd_discover(*dev_ret);
+	wait = xcalloc(1, sizeof(*wait));
+	ni_string_dup(&wait->ifname, cfg->name);
+	wait->iftype = cfg->link.type;
+	wait->callback = callback;
+	wait->user_data = user_data;
+
+	if (ni_netdev_name_to_index(cfg->name)) {
+		ret = __ni_system_netdev_create(nc, cfg->name, 0, cfg->link.type, &dev);
+		ni_system_netdev_wait_complete(nc, wait, ret < 0 ? NULL : dev);
+		return 0;
 	}
-	return ret;
+
+	wait->timer = ni_timer_register(NI_SYSTEM_NETDEV_WAIT_TIMEOUT,
+					ni_system_netdev_wait_timeout, wait);
+	wait->next = ni_system_netdev_waits;
+	ni_system_netdev_waits = wait;
+	return 0;
+}
+
+/*
+ * Create a team device
+ */
+int
+ni_system_team_create(ni_netconfig_t *nc, const ni_netdev_t *cfg,
+			ni_system_netdev_create_callback_t *callback, void *user_data)
+{
+	if (!cfg || cfg->link.type != NI_IFTYPE_TEAM || !cfg->team || !ni_config_teamd_enabled())
+		return -1;
+
+	return ni_system_netdev_wait_start(nc, cfg, ni_teamd_service_start, callback, user_data);
 }
 
 int
@@ -2299,32 +2548,13 @@ ni_system_tuntap_delete(ni_netdev_t *dev)
  * Create a ppp device
  */
 int
-ni_system_ppp_create(ni_netconfig_t *nc, const ni_netdev_t *cfg, ni_netdev_t **dev_ret)
+ni_system_ppp_create(ni_netconfig_t *nc, const ni_netdev_t *cfg,
+			ni_system_netdev_create_callback_t *callback, void *user_data)
 {
-	unsigned int i;
-	int ret;
-
 	if (!cfg || cfg->link.type != NI_IFTYPE_PPP || !cfg->ppp)
 		return -1;
 
-	if (ni_pppd_service_start(cfg))
-		return -1;
-
-	/* Wait for sysfs to appear */
-	for (i = 0; i < 400; ++i) {
-		if (ni_netdev_name_to_index(cfg->name))
-			break;
-		usleep(25000);
-	}
-
-	ret = __ni_system_netdev_create(nc, cfg->name, 0, NI_IFTYPE_PPP, dev_ret);
-	if (ret < 0)
-		ni_pppd_config_file_remove(cfg->name);
-	else if (dev_ret && *dev_ret) {
-		ni_pppd_discover(*dev_ret, nc);
-	}
-
-	return ret;
+	return ni_system_netdev_wait_start(nc, cfg, ni_pppd_service_start, callback, user_data);
 }
 
 int
@@ -3591,6 +3821,116 @@ nla_put_failure:
 	return -1;
 }
 
+/*
+ * Bridge and bridge port settings; times are in clock_t (USER_HZ)
+ */
+static int
+__ni_rtnl_link_put_bridge(struct nl_msg *msg, const ni_bridge_t *bridge)
+{
+	struct nlattr *linkinfo;
+	struct nlattr *infodata;
+
+	if (!(linkinfo = nla_nest_start(msg, IFLA_LINKINFO)))
+		goto nla_put_failure;
+
+	NLA_PUT_STRING(msg, IFLA_INFO_KIND, "bridge");
+
+	if (!(infodata = nla_nest_start(msg, IFLA_INFO_DATA)))
+		goto nla_put_failure;
+
+	NLA_PUT_U32(msg, IFLA_BR_STP_STATE, bridge->stp ? 1 : 0);
+	if (bridge->priority != NI_BRIDGE_VALUE_NOT_SET)
+		NLA_PUT_U16(msg, IFLA_BR_PRIORITY, bridge->priority);
+	if (bridge->forward_delay != NI_BRIDGE_VALUE_NOT_SET)
+		NLA_PUT_U32(msg, IFLA_BR_FORWARD_DELAY,
+				(unsigned int)(bridge->forward_delay * 100.0));
+	if (bridge->ageing_time != NI_BRIDGE_VALUE_NOT_SET)
+		NLA_PUT_U32(msg, IFLA_BR_AGEING_TIME,
+				(unsigned int)(bridge->ageing_time * 100.0));
+	if (bridge->hello_time != NI_BRIDGE_VALUE_NOT_SET)
+		NLA_PUT_U32(msg, IFLA_BR_HELLO_TIME,
+				(unsigned int)(bridge->hello_time * 100.0));
+	if (bridge->max_age != NI_BRIDGE_VALUE_NOT_SET)
+		NLA_PUT_U32(msg, IFLA_BR_MAX_AGE,
+				(unsigned int)(bridge->max_age * 100.0));
+
+	nla_nest_end(msg, infodata);
+	nla_nest_end(msg, linkinfo);
+	return 0;
+
+nla_put_failure:
+	return -1;
+}
+
+static int
+__ni_rtnl_link_put_bridge_port(struct nl_msg *msg, const ni_bridge_port_t *port)
+{
+	struct nlattr *linkinfo;
+	struct nlattr *infodata;
+
+	if (!(linkinfo = nla_nest_start(msg, IFLA_LINKINFO)))
+		goto nla_put_failure;
+
+	NLA_PUT_STRING(msg, IFLA_INFO_SLAVE_KIND, "bridge");
+
+	if (!(infodata = nla_nest_start(msg, IFLA_INFO_SLAVE_DATA)))
+		goto nla_put_failure;
+
+	if (port->priority != NI_BRIDGE_VALUE_NOT_SET)
+		NLA_PUT_U16(msg, IFLA_BRPORT_PRIORITY, port->priority);
+	if (port->path_cost != NI_BRIDGE_VALUE_NOT_SET)
+		NLA_PUT_U32(msg, IFLA_BRPORT_COST, port->path_cost);
+
+	nla_nest_end(msg, infodata);
+	nla_nest_end(msg, linkinfo);
+	return 0;
+
+nla_put_failure:
+	return -1;
+}
+
+/*
+ * Apply the bridge (port) config in one RTM_NEWLINK
+ */
+static int
+__ni_rtnl_link_change_bridge(const ni_netdev_t *dev, const ni_bridge_t *bridge,
+				const ni_bridge_port_t *port)
+{
+	struct ifinfomsg ifi;
+	struct nl_msg *msg;
+	int rv;
+
+	memset(&ifi, 0, sizeof(ifi));
+	ifi.ifi_family = AF_UNSPEC;
+	ifi.ifi_index = dev->link.ifindex;
+
+	msg = nlmsg_alloc_simple(RTM_NEWLINK, NLM_F_REQUEST);
+	if (nlmsg_append(msg, &ifi, sizeof(ifi), NLMSG_ALIGNTO) < 0)
+		goto nla_put_failure;
+
+	if (bridge && __ni_rtnl_link_put_bridge(msg, bridge) < 0)
+		goto nla_put_failure;
+	if (port && __ni_rtnl_link_put_bridge_port(msg, port) < 0)
+		goto nla_put_failure;
+
+	if ((rv = ni_nl_talk(msg, NULL)) < 0) {
+		ni_debug_ifconfig("%s: unable to change bridge%s settings: %s",
+				dev->name, port ? " port" : "", nl_geterror(rv));
+		nlmsg_free(msg);
+		return rv;
+	}
+
+	ni_debug_ifconfig("%s: bridge%s settings changed", dev->name, port ? " port" : "");
+	nlmsg_free(msg);
+	return 0;
+
+nla_put_failure:
+	ni_error("%s: failed to encode netlink message to change bridge%s settings",
+			dev->name, port ? " port" : "");
+	nlmsg_free(msg);
+	return -1;
+}
+
 static int
 __ni_rtnl_link_put_tunnel(struct nl_msg *msg, const ni_linkinfo_t *link,
 			const ni_tunnel_t *tunnel, unsigned int type)
@@ -4230,6 +4570,46 @@ failed:
 	return -1;
 }
 
+/*
+ * Release a (bond) slave from its master
+ */
+static int
+__ni_rtnl_link_del_slave(const ni_netdev_ref_t *slave, const char *mname)
+{
+	struct ifinfomsg ifi;
+	struct nl_msg *msg;
+	unsigned int ifindex;
+
+	if (!slave || !mname)
+		return -1;
+
+	if (!(ifindex = slave->index) && !(ifindex = ni_netdev_name_to_index(slave->name)))
+		return 0;
+
+	memset(&ifi, 0, sizeof(ifi));
+	ifi.ifi_family = AF_UNSPEC;
+	ifi.ifi_index = ifindex;
+
+	msg = nlmsg_alloc_simple(RTM_NEWLINK, NLM_F_REQUEST);
+	if (nlmsg_append(msg, &ifi, sizeof(ifi), NLMSG_ALIGNTO) < 0)
+		goto nla_put_failure;
+
+	NLA_PUT_U32(msg, IFLA_MASTER, 0);
+
+	if (ni_nl_talk(msg, NULL) < 0)
+		goto failed;
+
+	ni_debug_ifconfig("successfully released %s from master %s", slave->name, mname);
+	nlmsg_free(msg);
+	return 0;
+
+nla_put_failure:
+	ni_error("failed to encode netlink message to release %s from %s", slave->name, mname);
+failed:
+	nlmsg_free(msg);
+	return -1;
+}
+
 /*
  * (Re-)configure an interface
  */
@@ -4289,6 +4669,60 @@ nla_put_failure:
 	goto out;
 }
 
+/*
+ * Set ipv4 devconf values in one RTM_SETLINK request;
+ * the flags are the IPV4_DEVCONF_* indexes (linux/ip.h).
+ */
+int
+__ni_rtnl_link_set_ipv4_conf(const ni_netdev_t *dev, const unsigned int *flags,
+				const int *values, unsigned int count)
+{
+	struct nlattr *afspec, *inet, *conf;
+	struct ifinfomsg ifi;
+	struct nl_msg *msg;
+	unsigned int i;
+	int rv = -1;
+
+	if (!dev || !dev->link.ifindex || !flags || !values || !count)
+		return -1;
+
+	memset(&ifi, 0, sizeof(ifi));
+	ifi.ifi_family = AF_UNSPEC;
+	ifi.ifi_index = dev->link.ifindex;
+
+	msg = nlmsg_alloc_simple(RTM_SETLINK, 0);
+	if (nlmsg_append(msg, &ifi, sizeof(ifi), NLMSG_ALIGNTO) < 0)
+		goto nla_put_failure;
+
+	if (!(afspec = nla_nest_start(msg, IFLA_AF_SPEC)))
+		goto nla_put_failure;
+	if (!(inet = nla_nest_start(msg, AF_INET)))
+		goto nla_put_failure;
+	if (!(conf = nla_nest_start(msg, IFLA_INET_CONF)))
+		goto nla_put_failure;
+
+	for (i = 0; i < count; ++i)
+		NLA_PUT_U32(msg, flags[i], values[i]);
+
+	nla_nest_end(msg, conf);
+	nla_nest_end(msg, inet);
+	nla_nest_end(msg, afspec);
+
+	if ((rv = ni_nl_talk(msg, NULL)) < 0) {
+		ni_debug_ifconfig("%s: cannot set ipv4 devconf via netlink, using sysctl",
+				dev->name);
+		rv = -1;
+	}
+
+out:
+	nlmsg_free(msg);
+	return rv;
+
+nla_put_failure:
+	rv = -1;
+	goto out;
+}
+
 static int
 addattr_sockaddr(struct nl_msg *msg, int type, const ni_sockaddr_t *addr)
 {
@@ -4339,13 +4773,111 @@ __ni_netdev_address_in_list(ni_address_t *list, const ni_address_t *ap)
 	return NULL;
 }
 
-static int
-__ni_rtnl_send_newaddr(ni_netdev_t *dev, const ni_address_t *ap, int flags)
+/*
+ * Same as __ni_netdev_address_in_list, using an index of the list
+ */
+static ni_address_t *
+__ni_netdev_address_in_index(const ni_address_index_t *index, ni_address_t *list,
+				const ni_address_t *ap)
+{
+	ni_address_t *ap2;
+
+	if (ap->local_addr.ss_family != AF_INET && ap->local_addr.ss_family != AF_INET6)
+		return NULL;
+
+	if (!(ap2 = ni_address_index_find(index, &ap->local_addr)))
+		return NULL;
+
+	if (ap->local_addr.ss_family == AF_INET6 ||
+	    ni_sockaddr_equal(&ap->peer_addr, &ap2->peer_addr))
+		return ap2;
+
+	/* duplicate local address with another peer */
+	return __ni_netdev_address_in_list(list, ap);
+}
+
+/*
+ * Indexes of the lease address lists, to find the owner leases of many
+ * device addresses without scanning all lease addresses for each one.
+ */
+typedef struct ni_lease_address_index {
+	struct ni_lease_address_index *	next;
+	const ni_addrconf_lease_t *	lease;
+	ni_address_index_t *		index;
+} ni_lease_address_index_t;
+
+static const ni_address_index_t *
+ni_lease_address_index_get(ni_lease_address_index_t **list, const ni_addrconf_lease_t *lease)
+{
+	ni_lease_address_index_t *item;
+
+	for (item = *list; item; item = item->next) {
+		if (item->lease == lease)
+			return item->index;
+	}
+
+	item = xcalloc(1, sizeof(*item));
+	item->lease = lease;
+	item->index = ni_address_index_build(lease->addrs);
+	item->next = *list;
+	*list = item;
+	return item->index;
+}
+
+static void
+ni_lease_address_index_free(ni_lease_address_index_t **list)
+{
+	ni_lease_address_index_t *item;
+
+	while ((item = *list) != NULL) {
+		*list = item->next;
+		ni_address_index_free(item->index);
+		free(item);
+	}
+}
+
+static ni_addrconf_lease_t *
+__ni_netdev_address_to_lease_indexed(ni_netdev_t *dev, const ni_address_t *ap,
+				unsigned int minprio, ni_lease_address_index_t **indexes)
+{
+	ni_addrconf_lease_t *lease;
+	ni_addrconf_lease_t *found = NULL;
+	const ni_address_t *la;
+	unsigned int prio;
+
+	for (lease = dev->leases; lease; lease = lease->next) {
+		if (ap->family != lease->family)
+			continue;
+
+		if ((prio = ni_addrconf_lease_get_priority(lease)) < minprio)
+			continue;
+
+		la = ni_address_index_find(ni_lease_address_index_get(indexes, lease),
+						&ap->local_addr);
+		if (!la)
+			continue;
+
+		if (la->prefixlen != ap->prefixlen
+		 || !ni_sockaddr_equal(&la->peer_addr, &ap->peer_addr)
+		 || !ni_sockaddr_equal(&la->anycast_addr, &ap->anycast_addr)) {
+			/* duplicate local address, check them all */
+			if (!__ni_lease_owns_address(lease, ap))
+				continue;
+		}
+
+		if (!found || prio > ni_addrconf_lease_get_priority(found))
+			found = lease;
+	}
+
+	return found;
+}
+
+static struct nl_msg *
+__ni_rtnl_newaddr_msg(ni_netdev_t *dev, const ni_address_t *ap, int flags)
 {
 	unsigned int omit = IFA_F_TENTATIVE|IFA_F_DADFAILED;
 	struct ifaddrmsg ifa;
 	struct nl_msg *msg;
-	int err;
 
 	ni_debug_ifconfig("%s(%s/%u)", __FUNCTION__,
 			ni_sockaddr_print(&ap->local_addr), ap->prefixlen);
@@ -4424,29 +4956,19 @@ __ni_rtnl_send_newaddr(ni_netdev_t *dev, const ni_address_t *ap, int flags)
 			goto nla_put_failure;
 	}
 
-	if ((err = ni_nl_talk(msg, NULL)) && abs(err) != NLE_EXIST) {
-		ni_error("%s(%s/%u): ni_nl_talk failed [%s]", __func__,
-				ni_sockaddr_print(&ap->local_addr),
-				ap->prefixlen,  nl_geterror(err));
-		goto failed;
-	}
-
-	nlmsg_free(msg);
-	return 0;
+	return msg;
 
 nla_put_failure:
 	ni_error("failed to encode netlink attr");
-failed:
 	nlmsg_free(msg);
-	return -1;
+	return NULL;
 }
 
-static int
-__ni_rtnl_send_deladdr(ni_netdev_t *dev, const ni_address_t *ap)
+static struct nl_msg *
+__ni_rtnl_deladdr_msg(ni_netdev_t *dev, const ni_address_t *ap)
 {
 	struct ifaddrmsg ifa;
 	struct nl_msg *msg;
-	int err;
 
 	ni_debug_ifconfig("%s(%s/%u)", __FUNCTION__, ni_sockaddr_print(&ap->local_addr), ap->prefixlen);
 
@@ -4470,21 +4992,33 @@ __ni_rtnl_send_deladdr(ni_netdev_t *dev, const ni_address_t *ap)
 			goto nla_put_failure;
 	}
 
+	return msg;
+
+nla_put_failure:
+	ni_error("failed to encode netlink attr");
+	nlmsg_free(msg);
+	return NULL;
+}
+
+static int
+__ni_rtnl_send_deladdr(ni_netdev_t *dev, const ni_address_t *ap)
+{
+	struct nl_msg *msg;
+	int err;
+
+	if (!(msg = __ni_rtnl_deladdr_msg(dev, ap)))
+		return -1;
+
 	if ((err = ni_nl_talk(msg, NULL)) < 0) {
 		ni_error("%s(%s/%u): rtnl_talk failed: %s", __func__,
 				ni_sockaddr_print(&ap->local_addr),
 				ap->prefixlen,  nl_geterror(err));
-		goto failed;
+		nlmsg_free(msg);
+		return -1;
 	}
 
 	nlmsg_free(msg);
 	return 0;
-
-nla_put_failure:
-	ni_error("failed to encode netlink attr");
-failed:
-	nlmsg_free(msg);
-	return -1;
 }
 
 /*
@@ -5193,6 +5727,121 @@ ni_address_updater_arp_send(ni_addrconf_updater_t *updater, ni_netdev_t *dev)
 	return FALSE;
 }
 
+/*
+ * Address changes computed by the address reconciliation and sent
+ * to the kernel in one pipelined netlink burst.
+ */
+typedef struct ni_address_change {
+	struct nl_msg *		msg;
+	ni_address_t *		ap;		/* address on the device */
+	ni_address_t *		new_addr;	/* lease address to set */
+} ni_address_change_t;
+
+typedef struct ni_address_changes {
+	unsigned int		count;
+	unsigned int		size;
+	ni_address_change_t *	data;
+} ni_address_changes_t;
+
+#define NI_ADDRESS_CHANGES_INIT	{ .count = 0, .size = 0, .data = NULL }
+#define NI_ADDRESS_CHANGES_CHUNK	16
+
+static void
+ni_address_changes_add(ni_address_changes_t *changes, struct nl_msg *msg,
+			ni_address_t *ap, ni_address_t *new_addr)
+{
+	ni_address_change_t *change;
+
+	if (!msg)
+		return;
+
+	if (changes->count == changes->size) {
+		changes->size += NI_ADDRESS_CHANGES_CHUNK;
+		changes->data = xrealloc(changes->data,
+				changes->size * sizeof(*changes->data));
+	}
+
+	change = &changes->data[changes->count++];
+	change->msg = msg;
+	change->ap = ap;
+	change->new_addr = new_addr;
+}
+
+static void
+ni_address_changes_destroy(ni_address_changes_t *changes)
+{
+	unsigned int i;
+
+	for (i = 0; i < changes->count; ++i)
+		nlmsg_free(changes->data[i].msg);
+	free(changes->data);
+	memset(changes, 0, sizeof(*changes));
+}
+
+/*
+ * Send the changes and apply the results: a replaced device address
+ * takes over the lease address, a new lease address becomes owned by
+ * the lease. Returns -1 when adding a new address failed.
+ */
+static int
+ni_address_changes_commit(ni_netdev_t *dev, ni_address_changes_t *changes,
+			ni_addrconf_mode_t owner, ni_address_updater_t *au)
+{
+	ni_address_change_t *change;
+	struct nl_msg **msgs;
+	unsigned int i;
+	int *errors;
+	int ret = 0;
+
+	if (!changes->count)
+		return 0;
+
+	msgs = xcalloc(changes->count, sizeof(*msgs));
+	errors = xcalloc(changes->count, sizeof(*errors));
+	for (i = 0; i < changes->count; ++i)
+		msgs[i] = changes->data[i].msg;
+
+	ni_nl_talk_batch(msgs, errors, changes->count);
+
+	for (i = 0; i < changes->count; ++i) {
+		const ni_address_t *ap;
+
+		change = &changes->data[i];
+		ap = change->new_addr ? change->new_addr : change->ap;
+
+		if (nlmsg_hdr(change->msg)->nlmsg_type == RTM_DELADDR) {
+			if (errors[i] < 0) {
+				ni_error("%s: deleting address %s/%u failed: %s",
+						dev->name,
+						ni_sockaddr_print(&ap->local_addr),
+						ap->prefixlen, nl_geterror(errors[i]));
+			}
+			continue;
+		}
+
+		if (errors[i] < 0 && abs(errors[i]) != NLE_EXIST) {
+			ni_error("%s: setting address %s/%u failed: %s",
+					dev->name,
+					ni_sockaddr_print(&ap->local_addr),
+					ap->prefixlen, nl_geterror(errors[i]));
+			if (!change->ap)
+				ret = -1;
+			continue;
+		}
+
+		change->new_addr->owner = owner;
+		if (change->ap)
+			ni_address_copy(change->ap, change->new_addr);
+		else if (au)
+			ni_arp_notify_add_address(&au->notify, change->new_addr);
+	}
+
+	free(errors);
+	free(msgs);
+	ni_address_changes_destroy(changes);
+	return ret;
+}
+
 static int
 __ni_netdev_update_addrs(ni_netdev_t *dev,
 				const ni_addrconf_lease_t *old_lease,
@@ -5201,11 +5850,14 @@ __ni_netdev_update_addrs(ni_netdev_t *dev,
 {
 	unsigned int max_changes = NI_ADDRCONF_UPDATER_MAX_ADDR_CHANGES;
 	ni_addrconf_mode_t owner = NI_ADDRCONF_NONE;
+	ni_address_changes_t changes = NI_ADDRESS_CHANGES_INIT;
+	ni_lease_address_index_t *lease_indexes = NULL;
+	ni_address_index_t *new_index = NULL;
 	ni_address_updater_t *au;
 	unsigned int family = AF_UNSPEC;
 	ni_address_t *ap, *next;
 	unsigned int minprio;
-	int rv;
+	int rv = 0;
 
 	do {
 		__ni_global_seqno++;
@@ -5216,6 +5868,7 @@ __ni_netdev_update_addrs(ni_netdev_t *dev,
 		owner = new_lease->type;
 		for (ap = new_lease->addrs; ap; ap = ap->next)
 			ap->owner = owner;
+		new_index = ni_address_index_build(new_lease->addrs);
 	} else
 	if (old_lease) {
 		family = old_lease->family;
@@ -5225,7 +5878,8 @@ __ni_netdev_update_addrs(ni_netdev_t *dev,
 	updater->timeout = NI_ADDRCONF_UPDATER_MAX_ADDR_TIMEOUT;
 	if (!(au = ni_address_updater_init(updater, dev, family))) {
 		ni_error("%s: unable to initialize address updater", dev->name);
-		return -1;
+		rv = -1;
+		goto done;
 	}
 
 	for (ap = dev->addrs; ap; ap = next) {
@@ -5237,7 +5891,8 @@ __ni_netdev_update_addrs(ni_netdev_t *dev,
 
 		/* See if the config list contains the address we've found in the
 		 * system. */
-		new_addr = new_lease ? __ni_netdev_address_in_list(new_lease->addrs, ap) : NULL;
+		new_addr = new_lease ? __ni_netdev_address_in_index(new_index,
+						new_lease->addrs, ap) : NULL;
 
 		/* Do not touch addresses not managed by us. */
 		if (ap->owner == NI_ADDRCONF_NONE) {
@@ -5261,7 +5916,8 @@ __ni_netdev_update_addrs(ni_netdev_t *dev,
 		if (ap->owner == owner) {
 			ni_addrconf_lease_t *other;
 
-			if ((other = __ni_netdev_address_to_lease(dev, ap, minprio)) != NULL)
+			if ((other = __ni_netdev_address_to_lease_indexed(dev, ap,
+							minprio, &lease_indexes)) != NULL)
 				ap->owner = other->type;
 		}
 
@@ -5304,32 +5960,36 @@ __ni_netdev_update_addrs(ni_netdev_t *dev,
 					dev->name,
 					ni_sockaddr_print(&ap->local_addr), ap->prefixlen);
 
-			if (replace < 0)
-				__ni_rtnl_send_deladdr(dev, ap);
-
-			if ((rv = __ni_rtnl_send_newaddr(dev, new_addr, NLM_F_REPLACE)) < 0)
-				continue;
-
-			new_addr->owner = new_lease->type;
-			ni_address_copy(ap, new_addr);
+			if (replace < 0) {
+				ni_address_changes_add(&changes,
+						__ni_rtnl_deladdr_msg(dev, ap), ap, NULL);
+			}
+			ni_address_changes_add(&changes,
+					__ni_rtnl_newaddr_msg(dev, new_addr, NLM_F_REPLACE),
+					ap, new_addr);
 		} else {
 			if (max_changes == 0)
 				break;
 			else max_changes--;
 
-			if ((rv = __ni_rtnl_send_deladdr(dev, ap)) < 0)
-				continue;
+			ni_address_changes_add(&changes,
+					__ni_rtnl_deladdr_msg(dev, ap), ap, NULL);
 		}
 	}
+	ni_address_changes_commit(dev, &changes, owner, NULL);
 
-	if (max_changes == 0)
-		return 1;
+	if (max_changes == 0) {
+		rv = 1;
+		goto done;
+	}
 
 	/* Loop over all addresses in the configuration and create
 	 * those that don't exist yet.
 	 */
-	if (family == AF_INET && ni_address_updater_arp_send(updater, dev))
-		return 1;
+	if (family == AF_INET && ni_address_updater_arp_send(updater, dev)) {
+		rv = 1;
+		goto done;
+	}
 
 	for (ap = new_lease ? new_lease->addrs : NULL ; ap; ap = ap->next) {
 		unsigned int count = 0;
@@ -5358,21 +6018,25 @@ __ni_netdev_update_addrs(ni_netdev_t *dev,
 				ap->prefixlen);
 
 		__ni_netdev_addr_complete(dev, ap);
-		if ((rv = __ni_rtnl_send_newaddr(dev, ap, NLM_F_CREATE)) < 0)
-			return rv;
-
-		ap->owner = new_lease->type;
-
-		ni_arp_notify_add_address(&au->notify, ap);
+		ni_address_changes_add(&changes,
+				__ni_rtnl_newaddr_msg(dev, ap, NLM_F_CREATE), NULL, ap);
 	}
+	if ((rv = ni_address_changes_commit(dev, &changes, owner, au)) < 0)
+		goto done;
 
-	if (family == AF_INET && ni_address_updater_arp_send(updater, dev))
-		return 1;
+	if (family == AF_INET && ni_address_updater_arp_send(updater, dev)) {
+		rv = 1;
+		goto done;
+	}
 
 	if (max_changes == 0)
-		return 1;
+		rv = 1;
 
-	return 0;
+done:
+	ni_address_changes_destroy(&changes);
+	ni_lease_address_index_free(&lease_indexes);
+	ni_address_index_free(new_index);
+	return rv;
 }
 
 /*
@@ -20,6 +20,8 @@
 #include <wicked/socket.h>
 #include <wicked/route.h>
 #include <wicked/ipv6.h>
+#include <wicked/metrics.h>
+#include <wicked/snapshot.h>
 
 #include "netinfo_priv.h"
 #include "socket_priv.h"
@@ -356,6 +358,7 @@ __ni_rtevent_newlink(ni_netconfig_t *nc, const struct sockaddr_nl *nladdr, struc
 		}
 	}
 
+	__ni_system_netdev_appeared(nc, dev);
 	__ni_netdev_process_events(nc, dev, old_flags);
 
 	if ((nla = nlmsg_find_attr(h, sizeof(*ifi), IFLA_WIRELESS)) != NULL)
@@ -452,7 +455,7 @@ __ni_rtevent_newprefix(ni_netconfig_t *nc, const struct sockaddr_nl *nladdr, str
 	if ((old = ni_ipv6_ra_pinfo_list_remove(&ipv6->radv.pinfo, pi)) != NULL) {
 		if (pi->lifetime.valid_lft > 0) {
 			/* Replace with updated prefix info - most recent in front */
-			ni_ipv6_ra_pinfo_list_prepend(&ipv6->radv.pinfo, pi);
+			ni_ipv6_ra_info_pinfo_add(&ipv6->radv, pi);
 			__ni_netdev_prefix_event(dev, NI_EVENT_PREFIX_UPDATE, pi);
 		} else {
 			/* A lifetime of 0 means the router requests a prefix remove;
@@ -463,7 +466,7 @@ __ni_rtevent_newprefix(ni_netconfig_t *nc, const struct sockaddr_nl *nladdr, str
 		free(old);
 	} else if (pi->lifetime.valid_lft > 0) {
 		/* Add prefix info - most recent in front */
-		ni_ipv6_ra_pinfo_list_prepend(&ipv6->radv.pinfo, pi);
+		ni_ipv6_ra_info_pinfo_add(&ipv6->radv, pi);
 		__ni_netdev_prefix_event(dev, NI_EVENT_PREFIX_UPDATE, pi);
 	} else {
 		/* Request to remove unhandled prefix (missed event?), ignore it. */
@@ -517,10 +520,10 @@ __ni_rtevent_deladdr(ni_netconfig_t *nc, const struct sockaddr_nl *nladdr, struc
 		return -1;
 	}
 
-	if ((ap = ni_address_list_find(dev->addrs, &tmp.local_addr)) != NULL) {
+	if ((ap = ni_netdev_address_find(dev, &tmp.local_addr)) != NULL) {
 		__ni_netdev_addr_event(dev, NI_EVENT_ADDRESS_DELETE, ap);
 
-		__ni_address_list_remove(&dev->addrs, ap);
+		ni_netdev_address_remove(dev, ap);
 	}
 	ni_string_free(&tmp.label);
 
@@ -705,7 +708,7 @@ __ni_rtevent_process_rdnss_info(ni_netdev_t *dev, const struct nd_opt_hdr *opt,
 			continue;
 		}
 
-		if (!ni_ipv6_ra_rdnss_list_update(&ipv6->radv.rdnss, addr,
+		if (!ni_ipv6_ra_info_rdnss_update(&ipv6->radv, addr,
 					lifetime, &acquired)) {
 			server = inet_ntop(AF_INET6, addr, buf, sizeof(buf));
 			ni_debug_verbose(NI_LOG_DEBUG, NI_TRACE_IPV6|NI_TRACE_EVENTS,
@@ -767,7 +770,7 @@ __ni_rtevent_process_dnssl_info(ni_netdev_t *dev, const struct nd_opt_hdr *opt,
 					"%s: ignoring suspect DNSSL domain: %s",
 					dev->name, ni_print_suspect(domain, length));
 			} else
-			if (!ni_ipv6_ra_dnssl_list_update(&ipv6->radv.dnssl,
+			if (!ni_ipv6_ra_info_dnssl_update(&ipv6->radv,
 						domain, lifetime, &acquired)) {
 				ni_debug_verbose(NI_LOG_DEBUG, NI_TRACE_IPV6|NI_TRACE_EVENTS,
 						"%s: unable to track ipv6 dnssl domain %s",
@@ -895,8 +898,10 @@ static int
 __ni_rtevent_process_cb(struct nl_msg *msg, void *ptr)
 {
 	const struct sockaddr_nl *sender = nlmsg_get_src(msg);
+	struct timeval start;
 	struct nlmsghdr *nlh;
 	ni_netconfig_t *nc;
+	int rv;
 
 	if ((nc = ni_global_state_handle(0)) == NULL)
 		return NL_SKIP;
@@ -908,12 +913,16 @@ __ni_rtevent_process_cb(struct nl_msg *msg, void *ptr)
 	}
 
 	nlh = nlmsg_hdr(msg);
-	if (__ni_rtevent_process(nc, sender, nlh) < 0) {
+	ni_metric_start(&start);
+	rv = __ni_rtevent_process(nc, sender, nlh);
+	ni_metric_record_since(NI_METRIC_NETLINK_EVENT, &start);
+	if (rv < 0) {
 		ni_debug_events("ignoring %s rtnetlink event",
 			ni_rtnl_msg_type_to_name(nlh->nlmsg_type, "unknown"));
 		return NL_SKIP;
 	}
 
+	ni_snapshot_invalidate();
 	return NL_OK;
 }
 
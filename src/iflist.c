@@ -23,6 +23,7 @@
 #include <wicked/route.h>
 #include <wicked/bridge.h>
 #include <wicked/bonding.h>
+#include <wicked/ethernet.h>
 #include <wicked/system.h>
 #include <wicked/vlan.h>
 #include <wicked/vxlan.h>
@@ -59,6 +60,7 @@
 #include "pppd.h"
 #include "teamd.h"
 #include "ovs.h"
+#include "ethtool-netlink.h"
 
 
 static int		__ni_process_ifinfomsg(ni_linkinfo_t *link, struct nlmsghdr *h,
@@ -69,7 +71,7 @@ static int		__ni_netdev_process_newroute(ni_netdev_t *, struct nlmsghdr *,
 					struct rtmsg *, ni_netconfig_t *);
 static int		__ni_netdev_process_newrule(struct nlmsghdr *, struct fib_rule_hdr *,
 					ni_netconfig_t *);
-static int		__ni_discover_bridge(ni_netdev_t *);
+static int		__ni_discover_bridge(ni_netdev_t *, struct nlattr **, ni_netconfig_t *);
 static int		__ni_discover_bond(ni_netdev_t *, struct nlattr **, ni_netconfig_t *);
 static int		__ni_discover_addrconf(ni_netdev_t *);
 static int		__ni_discover_infiniband(ni_netdev_t *, ni_netconfig_t *);
@@ -91,13 +93,43 @@ struct ni_rtnl_info {
 
 struct ni_rtnl_query {
 	struct ni_rtnl_info	link_info;
-	struct ni_rtnl_info	addr_info;
 	struct ni_rtnl_info	ipv6_info;
-	struct ni_rtnl_info	route_info;
 	struct ni_rtnl_info	rule_info;
 	unsigned int		ifindex;
 };
 
+/*
+ * Query the link of one interface: a RTM_GETLINK request with the
+ * ifindex set is answered directly by the kernel, without a dump.
+ */
+static int
+__ni_rtnl_query_ifindex(struct ni_rtnl_info *qr, int af, unsigned int ifindex)
+{
+	struct ifinfomsg ifi;
+	struct nl_msg *msg;
+	int rv = -NLE_NOMEM;
+
+	ni_nlmsg_list_init(&qr->nlmsg_list);
+	qr->entry = NULL;
+
+	memset(&ifi, 0, sizeof(ifi));
+	ifi.ifi_family = af;
+	ifi.ifi_index = ifindex;
+
+	if (!(msg = nlmsg_alloc_simple(RTM_GETLINK, NLM_F_REQUEST)))
+		return rv;
+
+	if ((rv = nlmsg_append(msg, &ifi, sizeof(ifi), NLMSG_ALIGNTO)) >= 0 &&
+	    (rv = ni_nl_talk(msg, &qr->nlmsg_list)) >= 0)
+		qr->entry = qr->nlmsg_list.head;
+	else
+		ni_debug_socket("[%u]: RTM_GETLINK request failed: %s",
+				ifindex, nl_geterror(rv));
+
+	nlmsg_free(msg);
+	return rv;
+}
+
 /*
  * Query netlink for all relevant information
  */
@@ -140,36 +172,23 @@ static void
 ni_rtnl_query_destroy(struct ni_rtnl_query *q)
 {
 	ni_nlmsg_list_destroy(&q->link_info.nlmsg_list);
-	ni_nlmsg_list_destroy(&q->addr_info.nlmsg_list);
 	ni_nlmsg_list_destroy(&q->ipv6_info.nlmsg_list);
-	ni_nlmsg_list_destroy(&q->route_info.nlmsg_list);
 	ni_nlmsg_list_destroy(&q->rule_info.nlmsg_list);
 }
 
-static int
-ni_rtnl_query(struct ni_rtnl_query *q, unsigned int ifindex, unsigned int family)
-{
-	memset(q, 0, sizeof(*q));
-	q->ifindex = ifindex;
-
-	if (__ni_rtnl_query(&q->link_info, AF_UNSPEC, RTM_GETLINK) < 0
-	 || (family != AF_INET && __ni_rtnl_query(&q->ipv6_info, AF_INET6, RTM_GETLINK) < 0)
-	 || __ni_rtnl_query(&q->addr_info, family, RTM_GETADDR) < 0
-	 || __ni_rtnl_query(&q->route_info, family, RTM_GETROUTE) < 0) {
-		ni_rtnl_query_destroy(q);
-		return -1;
-	}
-
-	return 0;
-}
-
 static int
 ni_rtnl_query_link(struct ni_rtnl_query *q, unsigned int ifindex)
 {
+	int rv;
+
 	memset(q, 0, sizeof(*q));
 	q->ifindex = ifindex;
 
-	if (__ni_rtnl_query(&q->link_info, AF_UNSPEC, RTM_GETLINK) < 0) {
+	if (ifindex)
+		rv = __ni_rtnl_query_ifindex(&q->link_info, AF_UNSPEC, ifindex);
+	else
+		rv = __ni_rtnl_query(&q->link_info, AF_UNSPEC, RTM_GETLINK);
+	if (rv < 0) {
 		ni_rtnl_query_destroy(q);
 		return -1;
 	}
@@ -229,68 +248,6 @@ ni_rtnl_query_next_ipv6_link_info(struct ni_rtnl_query *q, struct nlmsghdr **hp)
 	return NULL;
 }
 
-static int
-ni_rtnl_query_addr_info(struct ni_rtnl_query *q, unsigned int ifindex, unsigned int family)
-{
-	memset(q, 0, sizeof(*q));
-	q->ifindex = ifindex;
-
-	if (__ni_rtnl_query(&q->addr_info, family, RTM_GETADDR) < 0) {
-		ni_rtnl_query_destroy(q);
-		return -1;
-	}
-
-	return 0;
-}
-
-static inline struct ifaddrmsg *
-ni_rtnl_query_next_addr_info(struct ni_rtnl_query *q, struct nlmsghdr **hp)
-{
-	struct nlmsghdr *h;
-
-	while ((h = __ni_rtnl_info_next(&q->addr_info)) != NULL) {
-		struct ifaddrmsg *ifa;
-
-		if ((ifa = ni_rtnl_ifaddrmsg(h, RTM_NEWADDR)) != NULL) {
-			if (!q->ifindex || q->ifindex == ifa->ifa_index) {
-				*hp = h;
-				return ifa;
-			}
-		}
-	}
-	return NULL;
-}
-
-static int
-ni_rtnl_query_route_info(struct ni_rtnl_query *q, unsigned int family)
-{
-	memset(q, 0, sizeof(*q));
-
-	if (__ni_rtnl_query(&q->route_info, family, RTM_GETROUTE) < 0) {
-		ni_rtnl_query_destroy(q);
-		return -1;
-	}
-
-	return 0;
-}
-
-static inline struct rtmsg *
-ni_rtnl_query_next_route_info(struct ni_rtnl_query *q, struct nlmsghdr **hp)
-{
-	struct nlmsghdr *h;
-
-	while ((h = __ni_rtnl_info_next(&q->route_info)) != NULL) {
-		struct rtmsg *rtm;
-
-		if (!(rtm = ni_rtnl_rtmsg(h, RTM_NEWROUTE)))
-			continue;
-
-		*hp = h;
-		return rtm;
-	}
-	return NULL;
-}
-
 static int
 ni_rtnl_query_rule_info(struct ni_rtnl_query *q, unsigned int family)
 {
@@ -331,12 +288,15 @@ ni_address_list_reset_seq(ni_address_t *addrs)
 }
 
 static void
-ni_address_list_drop_by_seq(ni_address_t **tail, unsigned int seq)
+ni_address_list_drop_by_seq(ni_netdev_t *dev, unsigned int seq)
 {
+	ni_address_t **tail = &dev->addrs;
 	ni_address_t *ap;
 
 	while ((ap = *tail)) {
 		if (ap->seq != seq) {
+			if (dev->addr_index && !ni_address_index_delete(dev->addr_index, ap))
+				ni_netdev_addrs_changed(dev);
 			*tail = ap->next;
 			ni_address_free(ap);
 		} else {
@@ -436,6 +396,14 @@ __ni_refresh_bonding_master_bind(ni_netdev_t *master, ni_linkinfo_t *link, const
 	ni_bonding_slave_set_info(slave, link->slave.bond);
 }
 
+static inline void
+__ni_refresh_bridge_master_bind(ni_netdev_t *master, ni_linkinfo_t *link, const char *ifname)
+{
+	const ni_netdev_ref_t ref = { .name = (char *)ifname, .index = link->ifindex };
+
+	ni_bridge_bind_port(ni_netdev_get_bridge(master), &ref, link->slave.bridge);
+}
+
 static void
 __ni_refresh_bind_master(ni_netconfig_t *nc, ni_netdev_t *dev)
 {
@@ -457,6 +425,9 @@ __ni_refresh_bind_master(ni_netconfig_t *nc, ni_netdev_t *dev)
 	case NI_IFTYPE_BOND:
 		__ni_refresh_bonding_master_bind(master, &dev->link, dev->name);
 		break;
+	case NI_IFTYPE_BRIDGE:
+		__ni_refresh_bridge_master_bind(master, &dev->link, dev->name);
+		break;
 
 	default:
 		break;
@@ -483,6 +454,14 @@ __ni_refresh_bonding_master_unbind(ni_netdev_t *master, ni_linkinfo_t *link, con
 	ni_bonding_unbind_slave(master->bonding, &ref, master->name);
 }
 
+static inline void
+__ni_refresh_bridge_master_unbind(ni_netdev_t *master, ni_linkinfo_t *link, const char *ifname)
+{
+	const ni_netdev_ref_t ref = { .name = (char *)ifname, .index = link->ifindex };
+
+	ni_bridge_unbind_port(master->bridge, &ref);
+}
+
 static void
 __ni_refresh_unbind_master(ni_netconfig_t *nc, ni_netdev_t *dev)
 {
@@ -501,6 +480,9 @@ __ni_refresh_unbind_master(ni_netconfig_t *nc, ni_netdev_t *dev)
 	case NI_IFTYPE_BOND:
 		__ni_refresh_bonding_master_unbind(master, &dev->link, dev->name);
 		break;
+	case NI_IFTYPE_BRIDGE:
+		__ni_refresh_bridge_master_unbind(master, &dev->link, dev->name);
+		break;
 
 	default:
 		break;
@@ -508,6 +490,137 @@ __ni_refresh_unbind_master(ni_netconfig_t *nc, ni_netdev_t *dev)
 }
 
 
+/*
+ * Streamed netlink dumps, processing each reply as it is received.
+ * The kernel filters by ifindex when it supports strict checking,
+ * the handlers filter again for kernels which don't.
+ */
+struct ni_rtnl_dump {
+	ni_netconfig_t *	nc;
+	ni_netdev_t *		dev;
+	ni_netdev_t **		tail;
+	unsigned int		seqno;
+};
+
+static int
+ni_rtnl_dump(int af, int type, unsigned int ifindex,
+		ni_nl_dump_handler_t *handler, struct ni_rtnl_dump *dump)
+{
+	int rv;
+
+	do {
+		rv = ni_nl_dump_process(af, type, ifindex, handler, dump);
+	} while (rv == -NLE_DUMP_INTR);
+
+	return rv;
+}
+
+static int
+ni_rtnl_dump_newlink(struct nlmsghdr *h, void *user_data)
+{
+	struct ni_rtnl_dump *dump = user_data;
+	ni_netconfig_t *nc = dump->nc;
+	struct ifinfomsg *ifi;
+	struct nlattr *nla;
+	const char *ifname;
+	ni_netdev_t *dev;
+
+	if (!(ifi = ni_rtnl_ifinfomsg(h, RTM_NEWLINK)))
+		return 0;
+
+	if (dump->dev && dump->dev->link.ifindex != (unsigned int)ifi->ifi_index)
+		return 0;
+
+	if ((nla = nlmsg_find_attr(h, sizeof(*ifi), IFLA_IFNAME)) == NULL) {
+		ni_warn("RTM_NEWLINK message without IFNAME");
+		return 0;
+	}
+	ifname = nla_get_string(nla);
+
+	/* Create interface if it doesn't exist. */
+	if (!(dev = dump->dev) && !(dev = ni_netdev_by_index(nc, ifi->ifi_index))) {
+		ni_pci_dev_t *pci_dev;
+
+		if (!(dev = ni_netdev_new(ifname, ifi->ifi_index)))
+			return -1;
+
+		if ((pci_dev = ni_sysfs_netdev_get_pci(ifname)) != NULL)
+			ni_netdev_set_pci(dev, pci_dev);
+
+		/* FIXME: use ni_netconfig_device_append() */
+		*dump->tail = dev;
+		dump->tail = &dev->next;
+	} else {
+		if (!ni_string_eq(dev->name, ifname))
+			ni_string_dup(&dev->name, ifname);
+
+		/* Clear out addresses and routes */
+		ni_address_list_reset_seq(dev->addrs);
+		ni_route_tables_reset_seq(dev->routes);
+	}
+
+	dev->seq = dump->seqno;
+
+	if (__ni_netdev_process_newlink(dev, h, ifi, nc) < 0)
+		ni_error("Problem parsing RTM_NEWLINK message for %s", dev->name);
+	return 0;
+}
+
+static int
+ni_rtnl_dump_newlink_ipv6(struct nlmsghdr *h, void *user_data)
+{
+	struct ni_rtnl_dump *dump = user_data;
+	struct ifinfomsg *ifi;
+	ni_netdev_t *dev;
+
+	if (!(ifi = ni_rtnl_ifinfomsg(h, RTM_NEWLINK)))
+		return 0;
+
+	if ((dev = ni_netdev_by_index(dump->nc, ifi->ifi_index)) == NULL)
+		return 0;
+
+	if (__ni_netdev_process_newlink_ipv6(dev, h, ifi) < 0)
+		ni_error("Problem parsing IPv6 RTM_NEWLINK message for %s", dev->name);
+	return 0;
+}
+
+static int
+ni_rtnl_dump_newaddr(struct nlmsghdr *h, void *user_data)
+{
+	struct ni_rtnl_dump *dump = user_data;
+	struct ifaddrmsg *ifa;
+	ni_netdev_t *dev;
+
+	if (!(ifa = ni_rtnl_ifaddrmsg(h, RTM_NEWADDR)))
+		return 0;
+
+	if ((dev = dump->dev) != NULL) {
+		if (dev->link.ifindex != ifa->ifa_index)
+			return 0;
+	} else
+	if ((dev = ni_netdev_by_index(dump->nc, ifa->ifa_index)) == NULL)
+		return 0;
+
+	if (__ni_netdev_process_newaddr(dev, h, ifa) < 0)
+		ni_error("Problem parsing RTM_NEWADDR message for %s", dev->name);
+	return 0;
+}
+
+static int
+ni_rtnl_dump_newroute(struct nlmsghdr *h, void *user_data)
+{
+	struct ni_rtnl_dump *dump = user_data;
+	struct rtmsg *rtm;
+
+	if (!(rtm = ni_rtnl_rtmsg(h, RTM_NEWROUTE)))
+		return 0;
+
+	if (__ni_netdev_process_newroute(dump->dev, h, rtm, dump->nc) < 0)
+		ni_error("Problem parsing RTM_NEWROUTE message");
+	return 0;
+}
+
+
 /*
  * Refresh all interfaces
  */
@@ -522,11 +635,10 @@ int
 __ni_system_refresh_all(ni_netconfig_t *nc, ni_netdev_t **del_list)
 {
 	static int refresh = 0;
-	struct ni_rtnl_query query;
-	struct nlmsghdr *h;
+	struct ni_rtnl_dump dump;
+	unsigned int family;
 	ni_netdev_t **tail, *dev;
 	unsigned int seqno;
-	int res = -1;
 
 	do {
 		seqno = ++__ni_global_seqno;
@@ -541,102 +653,39 @@ __ni_system_refresh_all(ni_netconfig_t *nc, ni_netdev_t **del_list)
 				"Full refresh of all interfaces (enforced)");
 	}
 
-	if (ni_rtnl_query(&query, 0, ni_netconfig_get_family_filter(nc)) < 0)
-		goto failed;
+	memset(&dump, 0, sizeof(dump));
+	dump.nc = nc;
+	dump.seqno = seqno;
+	family = ni_netconfig_get_family_filter(nc);
 
 	/* Find tail of iflist */
 	tail = ni_netconfig_device_list_head(nc);
 	while ((dev = *tail) != NULL)
 		tail = &dev->next;
+	dump.tail = tail;
 
-	while (1) {
-		struct ifinfomsg *ifi;
-		struct nlattr *nla;
-		char *ifname = NULL;
-
-		if (!(ifi = ni_rtnl_query_next_link_info(&query, &h)))
-			break;
-
-		if ((nla = nlmsg_find_attr(h, sizeof(*ifi), IFLA_IFNAME)) == NULL) {
-			ni_warn("RTM_NEWLINK message without IFNAME");
-			continue;
-		}
-		ifname = nla_get_string(nla);
-
-		/* Create interface if it doesn't exist. */
-		if ((dev = ni_netdev_by_index(nc, ifi->ifi_index)) == NULL) {
-			ni_pci_dev_t *pci_dev;
-
-			dev = ni_netdev_new(ifname, ifi->ifi_index);
-			if (!dev)
-				goto failed;
-
-			if ((pci_dev = ni_sysfs_netdev_get_pci(ifname)) != NULL)
-				ni_netdev_set_pci(dev, pci_dev);
-
-			/* FIXME: use ni_netconfig_device_append() */
-			*tail = dev;
-			tail = &dev->next;
-		} else {
-			if (!ni_string_eq(dev->name, ifname))
-				ni_string_dup(&dev->name, ifname);
-
-			/* Clear out addresses and routes */
-			ni_address_list_reset_seq(dev->addrs);
-			ni_route_tables_reset_seq(dev->routes);
-		}
-
-		dev->seq = seqno;
-
-		if (__ni_netdev_process_newlink(dev, h, ifi, nc) < 0)
-			ni_error("Problem parsing RTM_NEWLINK message for %s", ifname);
-	}
+	if (ni_rtnl_dump(AF_UNSPEC, RTM_GETLINK, 0, ni_rtnl_dump_newlink, &dump) < 0)
+		return -1;
 
 	for (dev = ni_netconfig_devlist(nc); dev; dev = dev->next) {
 		__ni_refresh_bind_master(nc, dev);
 		__ni_refresh_bind_lower(nc, dev);
 	}
 
-	while (1) {
-		struct ifinfomsg *ifi;
-
-		if (!(ifi = ni_rtnl_query_next_ipv6_link_info(&query, &h)))
-			break;
-
-		if ((dev = ni_netdev_by_index(nc, ifi->ifi_index)) == NULL)
-			continue;
-
-		if (__ni_netdev_process_newlink_ipv6(dev, h, ifi) < 0)
-			ni_error("Problem parsing IPv6 RTM_NEWLINK message for %s", dev->name);
-	}
-
-	while (1) {
-		struct ifaddrmsg *ifa;
-
-		if (!(ifa = ni_rtnl_query_next_addr_info(&query, &h)))
-			break;
-
-		if ((dev = ni_netdev_by_index(nc, ifa->ifa_index)) == NULL)
-			continue;
-
-		if (__ni_netdev_process_newaddr(dev, h, ifa) < 0)
-			ni_error("Problem parsing RTM_NEWADDR message for %s", dev->name);
-	}
-
-	while (1) {
-		struct rtmsg *rtm;
+	if (family != AF_INET &&
+	    ni_rtnl_dump(AF_INET6, RTM_GETLINK, 0, ni_rtnl_dump_newlink_ipv6, &dump) < 0)
+		return -1;
 
-		if (!(rtm = ni_rtnl_query_next_route_info(&query, &h)))
-			break;
+	if (ni_rtnl_dump(family, RTM_GETADDR, 0, ni_rtnl_dump_newaddr, &dump) < 0)
+		return -1;
 
-		if (__ni_netdev_process_newroute(NULL, h, rtm, nc) < 0)
-			ni_error("Problem parsing RTM_NEWROUTE message");
-	}
+	if (ni_rtnl_dump(family, RTM_GETROUTE, 0, ni_rtnl_dump_newroute, &dump) < 0)
+		return -1;
 
 	/* Cull any interfaces that went away */
 	tail = ni_netconfig_device_list_head(nc);
 	while ((dev = *tail) != NULL) {
-		ni_address_list_drop_by_seq(&dev->addrs, seqno);
+		ni_address_list_drop_by_seq(dev, seqno);
 		ni_route_tables_drop_by_seq(nc, dev->routes, seqno);
 		if (dev->seq != seqno) {
 			*tail = dev->next;
@@ -660,11 +709,7 @@ __ni_system_refresh_all(ni_netconfig_t *nc, ni_netdev_t **del_list)
 	if (!ni_netconfig_discover_filtered(nc, NI_NETCONFIG_DISCOVER_ROUTE_RULES))
 		(void)__ni_system_refresh_rules(nc);
 
-	res = 0;
-
-failed:
-	ni_rtnl_query_destroy(&query);
-	return res;
+	return 0;
 }
 
 /*
@@ -674,8 +719,10 @@ int
 __ni_system_refresh_interface(ni_netconfig_t *nc, ni_netdev_t *dev)
 {
 	struct ni_rtnl_query query;
+	struct ni_rtnl_dump dump;
 	struct nlmsghdr *h;
-	int res = -1;
+	unsigned int family;
+	int rv = 0;
 
 	ni_debug_verbose(NI_LOG_DEBUG1, NI_TRACE_EVENTS,
 			"Full refresh of %s interface",
@@ -685,63 +732,35 @@ __ni_system_refresh_interface(ni_netconfig_t *nc, ni_netdev_t *dev)
 		__ni_global_seqno++;
 	} while (!__ni_global_seqno);
 
-	if (ni_rtnl_query(&query, dev->link.ifindex, ni_netconfig_get_family_filter(nc)) < 0)
-		goto failed;
+	memset(&dump, 0, sizeof(dump));
+	dump.nc = nc;
+	dump.dev = dev;
+	dump.seqno = __ni_global_seqno;
+	family = ni_netconfig_get_family_filter(nc);
 
 	dev->seq = 0;
-	while (1) {
-		struct ifinfomsg *ifi;
-		struct nlattr *nla;
-		const char *ifname;
-
-		if (!(ifi = ni_rtnl_query_next_link_info(&query, &h)))
-			break;
-
-		if ((nla = nlmsg_find_attr(h, sizeof(*ifi), IFLA_IFNAME)) == NULL) {
-			ni_warn("RTM_NEWLINK message without IFNAME");
-			continue;
-		}
-
-		ifname = nla_get_string(nla);
-		if (!ni_string_eq(dev->name, ifname))
-			ni_string_dup(&dev->name, ifname);
-
-		/* Clear out addresses and routes */
-		dev->seq = __ni_global_seqno;
-		ni_address_list_reset_seq(dev->addrs);
-		ni_route_tables_reset_seq(dev->routes);
-
-		if (__ni_netdev_process_newlink(dev, h, ifi, nc) < 0)
-			ni_error("Problem parsing RTM_NEWLINK message for %s", dev->name);
-	}
-
-	while (1) {
-		struct ifaddrmsg *ifa;
+	if (ni_rtnl_query_link(&query, dev->link.ifindex) < 0)
+		return -1;
 
-		if (!(ifa = ni_rtnl_query_next_addr_info(&query, &h)))
+	while ((h = __ni_rtnl_info_next(&query.link_info)) != NULL) {
+		if ((rv = ni_rtnl_dump_newlink(h, &dump)) < 0)
 			break;
-
-		if (__ni_netdev_process_newaddr(dev, h, ifa) < 0)
-			ni_error("Problem parsing RTM_NEWADDR message for %s", dev->name);
 	}
-	ni_address_list_drop_by_seq(&dev->addrs, dev->seq);
-
-	while (1) {
-		struct rtmsg *rtm;
+	ni_rtnl_query_destroy(&query);
+	if (rv < 0)
+		return -1;
 
-		if (!(rtm = ni_rtnl_query_next_route_info(&query, &h)))
-			break;
+	if (ni_rtnl_dump(family, RTM_GETADDR, dev->link.ifindex,
+				ni_rtnl_dump_newaddr, &dump) < 0)
+		return -1;
+	ni_address_list_drop_by_seq(dev, dev->seq);
 
-		if (__ni_netdev_process_newroute(dev, h, rtm, nc) < 0)
-			ni_error("Problem parsing RTM_NEWROUTE message");
-	}
+	if (ni_rtnl_dump(family, RTM_GETROUTE, dev->link.ifindex,
+				ni_rtnl_dump_newroute, &dump) < 0)
+		return -1;
 	ni_route_tables_drop_by_seq(nc, dev->routes, dev->seq);
 
-	res = 0;
-
-failed:
-	ni_rtnl_query_destroy(&query);
-	return res;
+	return 0;
 }
 
 /*
@@ -750,11 +769,9 @@ failed:
 int
 __ni_system_refresh_addrs(ni_netconfig_t *nc, unsigned int family)
 {
-	struct ni_rtnl_query query;
-	struct nlmsghdr *h;
+	struct ni_rtnl_dump dump;
 	unsigned int seqno;
 	ni_netdev_t *dev;
-	int res = -1;
 
 	ni_debug_verbose(NI_LOG_DEBUG1, NI_TRACE_EVENTS,
 			"Refresh of all %s%saddresses",
@@ -765,43 +782,26 @@ __ni_system_refresh_addrs(ni_netconfig_t *nc, unsigned int family)
 		seqno = ++__ni_global_seqno;
 	} while (!seqno);
 
-	if (ni_rtnl_query_addr_info(&query, 0, family) < 0)
-		goto failed;
-
 	for (dev = ni_netconfig_devlist(nc); dev; dev = dev->next) {
 		ni_address_list_reset_seq(dev->addrs);
 		dev->seq = seqno;
 	}
 
-	while (1) {
-		struct ifaddrmsg *ifa;
-
-		if (!(ifa = ni_rtnl_query_next_addr_info(&query, &h)))
-			break;
-
-		if ((dev = ni_netdev_by_index(nc, ifa->ifa_index)) == NULL)
-			continue;
-
-		if (__ni_netdev_process_newaddr(dev, h, ifa) < 0)
-			ni_error("Problem parsing RTM_NEWADDR message for %s", dev->name);
-	}
+	memset(&dump, 0, sizeof(dump));
+	dump.nc = nc;
+	if (ni_rtnl_dump(family, RTM_GETADDR, 0, ni_rtnl_dump_newaddr, &dump) < 0)
+		return -1;
 
 	for (dev = ni_netconfig_devlist(nc); dev; dev = dev->next)
-		ni_address_list_drop_by_seq(&dev->addrs, seqno);
-
-	res = 0;
+		ni_address_list_drop_by_seq(dev, seqno);
 
-failed:
-	ni_rtnl_query_destroy(&query);
-	return res;
+	return 0;
 }
 
 int
 __ni_system_refresh_interface_addrs(ni_netconfig_t *nc, ni_netdev_t *dev)
 {
-	struct ni_rtnl_query query;
-	struct nlmsghdr *h;
-	int res = -1;
+	struct ni_rtnl_dump dump;
 
 	ni_debug_verbose(NI_LOG_DEBUG1, NI_TRACE_EVENTS,
 			"Refresh of %s interface addresses",
@@ -811,26 +811,17 @@ __ni_system_refresh_interface_addrs(ni_netconfig_t *nc, ni_netdev_t *dev)
 		dev->seq = ++__ni_global_seqno;
 	} while (!dev->seq);
 
-	if (ni_rtnl_query_addr_info(&query, dev->link.ifindex, ni_netconfig_get_family_filter(nc)) < 0)
-		goto failed;
+	memset(&dump, 0, sizeof(dump));
+	dump.nc = nc;
+	dump.dev = dev;
 
 	ni_address_list_reset_seq(dev->addrs);
-	while (1) {
-		struct ifaddrmsg *ifa;
-
-		if (!(ifa = ni_rtnl_query_next_addr_info(&query, &h)))
-			break;
-
-		if (__ni_netdev_process_newaddr(dev, h, ifa) < 0)
-			ni_error("Problem parsing RTM_NEWADDR message for %s", dev->name);
-	}
-	ni_address_list_drop_by_seq(&dev->addrs, dev->seq);
-
-	res = 0;
+	if (ni_rtnl_dump(ni_netconfig_get_family_filter(nc), RTM_GETADDR,
+				dev->link.ifindex, ni_rtnl_dump_newaddr, &dump) < 0)
+		return -1;
+	ni_address_list_drop_by_seq(dev, dev->seq);
 
-failed:
-	ni_rtnl_query_destroy(&query);
-	return res;
+	return 0;
 }
 
 /*
@@ -877,11 +868,9 @@ failed:
 int
 __ni_system_refresh_routes(ni_netconfig_t *nc)
 {
-	struct ni_rtnl_query query;
-	struct nlmsghdr *h;
+	struct ni_rtnl_dump dump;
 	unsigned int seqno;
 	ni_netdev_t *dev;
-	int res = -1;
 
 	ni_debug_verbose(NI_LOG_DEBUG1, NI_TRACE_EVENTS,
 			"Refresh all routes");
@@ -890,38 +879,25 @@ __ni_system_refresh_routes(ni_netconfig_t *nc)
 		seqno = ++__ni_global_seqno;
 	} while (!seqno);
 
-	if (ni_rtnl_query_route_info(&query, ni_netconfig_get_family_filter(nc)) < 0)
-		goto failed;
-
 	for (dev = ni_netconfig_devlist(nc); dev; dev = dev->next)
 		ni_route_tables_reset_seq(dev->routes);
 
-	while (1) {
-		struct rtmsg *rtm;
-
-		if (!(rtm = ni_rtnl_query_next_route_info(&query, &h)))
-			break;
-
-		if (__ni_netdev_process_newroute(NULL, h, rtm, nc) < 0)
-			ni_error("Problem parsing RTM_NEWROUTE message");
-	}
+	memset(&dump, 0, sizeof(dump));
+	dump.nc = nc;
+	if (ni_rtnl_dump(ni_netconfig_get_family_filter(nc), RTM_GETROUTE, 0,
+				ni_rtnl_dump_newroute, &dump) < 0)
+		return -1;
 
 	for (dev = ni_netconfig_devlist(nc); dev; dev = dev->next)
 		ni_route_tables_drop_by_seq(nc, dev->routes, seqno);
 
-	res = 0;
-
-failed:
-	ni_rtnl_query_destroy(&query);
-	return res;
+	return 0;
 }
 
 int
 __ni_system_refresh_interface_routes(ni_netconfig_t *nc, ni_netdev_t *dev)
 {
-	struct ni_rtnl_query query;
-	struct nlmsghdr *h;
-	int res = -1;
+	struct ni_rtnl_dump dump;
 
 	ni_debug_verbose(NI_LOG_DEBUG1, NI_TRACE_EVENTS,
 			"Refresh of %s interface routes",
@@ -931,26 +907,17 @@ __ni_system_refresh_interface_routes(ni_netconfig_t *nc, ni_netdev_t *dev)
 		dev->seq = ++__ni_global_seqno;
 	} while (!dev->seq);
 
-	if (ni_rtnl_query_route_info(&query, ni_netconfig_get_family_filter(nc)) < 0)
-		goto failed;
+	memset(&dump, 0, sizeof(dump));
+	dump.nc = nc;
+	dump.dev = dev;
 
 	ni_route_tables_reset_seq(dev->routes);
-	while (1) {
-		struct rtmsg *rtm;
-
-		if (!(rtm = ni_rtnl_query_next_route_info(&query, &h)))
-			break;
-
-		if (__ni_netdev_process_newroute(dev, h, rtm, nc) < 0)
-			ni_error("Problem parsing RTM_NEWROUTE message");
-	}
+	if (ni_rtnl_dump(ni_netconfig_get_family_filter(nc), RTM_GETROUTE,
+				dev->link.ifindex, ni_rtnl_dump_newroute, &dump) < 0)
+		return -1;
 	ni_route_tables_drop_by_seq(nc, dev->routes, dev->seq);
 
-	res = 0;
-
-failed:
-	ni_rtnl_query_destroy(&query);
-	return res;
+	return 0;
 }
 
 
@@ -1272,6 +1239,9 @@ __ni_process_ifinfomsg_masterdev_unbind(ni_linkinfo_t *link, const char *ifname,
 		case NI_IFTYPE_BOND:
 			ni_bonding_unbind_slave(master->bonding, &ref, master->name);
 			break;
+		case NI_IFTYPE_BRIDGE:
+			ni_bridge_unbind_port(master->bridge, &ref);
+			break;
 		default:
 			break;
 		}
@@ -1291,6 +1261,11 @@ __ni_process_ifinfomsg_masterdev_bind(ni_linkinfo_t *link, const char *ifname,
 		case NI_IFTYPE_BOND:
 			ni_bonding_bind_slave(master->bonding, &ref, master->name);
 			break;
+		case NI_IFTYPE_BRIDGE:
+			ni_bridge_bind_port(ni_netdev_get_bridge(master), &ref,
+					link->slave.type == NI_IFTYPE_BRIDGE ?
+					link->slave.bridge : NULL);
+			break;
 		default:
 			break;
 		}
@@ -1420,6 +1395,89 @@ __ni_process_ifinfomsg_bond_slave_data(ni_linkinfo_t *link, const char *ifname,
 	}
 }
 
+static void
+__ni_bridge_id_print(char **str, const struct nlattr *aptr)
+{
+	const struct ifla_bridge_id *id;
+	char buf[32];
+
+	if ((size_t)nla_len(aptr) < sizeof(*id))
+		return;
+
+	/* the same format as used in sysfs */
+	id = nla_data(aptr);
+	snprintf(buf, sizeof(buf), "%.2x%.2x.%.2x%.2x%.2x%.2x%.2x%.2x",
+			id->prio[0], id->prio[1],
+			id->addr[0], id->addr[1], id->addr[2],
+			id->addr[3], id->addr[4], id->addr[5]);
+	ni_string_dup(str, buf);
+}
+
+static inline void
+__ni_process_ifinfomsg_bridge_port_data(ni_linkinfo_t *link, const char *ifname, struct nlattr *data)
+{
+	/* static const */ struct nla_policy	__port_policy[IFLA_BRPORT_MAX+1] = {
+		[IFLA_BRPORT_STATE]			= { .type = NLA_U8	},
+		[IFLA_BRPORT_PRIORITY]			= { .type = NLA_U16	},
+		[IFLA_BRPORT_COST]			= { .type = NLA_U32	},
+		[IFLA_BRPORT_MODE]			= { .type = NLA_U8	},
+		[IFLA_BRPORT_ROOT_ID]			= { .type = NLA_UNSPEC	},
+		[IFLA_BRPORT_BRIDGE_ID]			= { .type = NLA_UNSPEC	},
+		[IFLA_BRPORT_DESIGNATED_PORT]		= { .type = NLA_U16	},
+		[IFLA_BRPORT_DESIGNATED_COST]		= { .type = NLA_U16	},
+		[IFLA_BRPORT_ID]			= { .type = NLA_U16	},
+		[IFLA_BRPORT_NO]			= { .type = NLA_U16	},
+		[IFLA_BRPORT_TOPOLOGY_CHANGE_ACK]	= { .type = NLA_U8	},
+		[IFLA_BRPORT_CONFIG_PENDING]		= { .type = NLA_U8	},
+		[IFLA_BRPORT_MESSAGE_AGE_TIMER]		= { .type = NLA_U64	},
+		[IFLA_BRPORT_FORWARD_DELAY_TIMER]	= { .type = NLA_U64	},
+		[IFLA_BRPORT_HOLD_TIMER]		= { .type = NLA_U64	},
+	};
+	struct nlattr *tb[IFLA_BRPORT_MAX+1];
+	ni_bridge_port_t *port = link->slave.bridge;
+	ni_bridge_port_status_t *ps = &port->status;
+
+	if (nla_parse_nested(tb, IFLA_BRPORT_MAX, data, __port_policy) < 0) {
+		ni_warn("%s: unable to parse bridge port data", ifname);
+		return;
+	}
+
+	if (tb[IFLA_BRPORT_STATE])
+		ps->state = nla_get_u8(tb[IFLA_BRPORT_STATE]);
+	if (tb[IFLA_BRPORT_PRIORITY])
+		port->priority = ps->priority = nla_get_u16(tb[IFLA_BRPORT_PRIORITY]);
+	if (tb[IFLA_BRPORT_COST])
+		port->path_cost = ps->path_cost = nla_get_u32(tb[IFLA_BRPORT_COST]);
+	if (tb[IFLA_BRPORT_MODE])
+		ps->hairpin_mode = nla_get_u8(tb[IFLA_BRPORT_MODE]);
+	if (tb[IFLA_BRPORT_ROOT_ID])
+		__ni_bridge_id_print(&ps->designated_root, tb[IFLA_BRPORT_ROOT_ID]);
+	if (tb[IFLA_BRPORT_BRIDGE_ID])
+		__ni_bridge_id_print(&ps->designated_bridge, tb[IFLA_BRPORT_BRIDGE_ID]);
+	if (tb[IFLA_BRPORT_DESIGNATED_PORT])
+		ps->designated_port = nla_get_u16(tb[IFLA_BRPORT_DESIGNATED_PORT]);
+	if (tb[IFLA_BRPORT_DESIGNATED_COST])
+		ps->designated_cost = nla_get_u16(tb[IFLA_BRPORT_DESIGNATED_COST]);
+	if (tb[IFLA_BRPORT_ID])
+		ps->port_id = nla_get_u16(tb[IFLA_BRPORT_ID]);
+	if (tb[IFLA_BRPORT_NO])
+		ps->port_no = nla_get_u16(tb[IFLA_BRPORT_NO]);
+	if (tb[IFLA_BRPORT_TOPOLOGY_CHANGE_ACK])
+		ps->change_ack = nla_get_u8(tb[IFLA_BRPORT_TOPOLOGY_CHANGE_ACK]);
+	if (tb[IFLA_BRPORT_CONFIG_PENDING])
+		ps->config_pending = nla_get_u8(tb[IFLA_BRPORT_CONFIG_PENDING]);
+	if (tb[IFLA_BRPORT_MESSAGE_AGE_TIMER])
+		ps->message_age_timer = nla_get_u64(tb[IFLA_BRPORT_MESSAGE_AGE_TIMER]);
+	if (tb[IFLA_BRPORT_FORWARD_DELAY_TIMER])
+		ps->forward_delay_timer = nla_get_u64(tb[IFLA_BRPORT_FORWARD_DELAY_TIMER]);
+	if (tb[IFLA_BRPORT_HOLD_TIMER])
+		ps->hold_timer = nla_get_u64(tb[IFLA_BRPORT_HOLD_TIMER]);
+
+	ni_debug_verbose(NI_LOG_DEBUG2, NI_TRACE_EVENTS,
+			"%s: bridge port state=%d priority=%u path_cost=%u",
+			ifname, ps->state, port->priority, port->path_cost);
+}
+
 static inline void
 __ni_process_ifinfomsg_slave_data(ni_linkinfo_t *link, const char *ifname,
 		ni_netdev_t *master, const char *kind, struct nlattr *data)
@@ -1457,6 +1515,23 @@ __ni_process_ifinfomsg_slave_data(ni_linkinfo_t *link, const char *ifname,
 			__ni_process_ifinfomsg_bond_slave_data(link, ifname, data);
 		break;
 
+	case NI_IFTYPE_BRIDGE:
+		if (!data)
+			return;
+
+		link->slave.bridge = ni_bridge_port_new(NULL, ifname, link->ifindex);
+		__ni_process_ifinfomsg_bridge_port_data(link, ifname, data);
+
+		if (master && master->link.type == NI_IFTYPE_BRIDGE) {
+			const ni_netdev_ref_t ref = {
+				.name = (char *)ifname, .index = link->ifindex
+			};
+
+			ni_bridge_bind_port(ni_netdev_get_bridge(master), &ref,
+						link->slave.bridge);
+		}
+		break;
+
 	default:
 		break;
 	}
@@ -1778,6 +1853,8 @@ __ni_process_ifinfomsg_af_spec(ni_netdev_t *dev, struct nlattr *ifla_af_spec, ni
 	 * not every newlink provides device sysctl's;
 	 * we get them on a refresh and on any change
 	 * and this is IMO completely sufficient.
+	 * Once the kernel has shown to provide them,
+	 * we don't read them from /proc/sys any more.
 	 */
 	static ni_bool_t ipv4_conf = FALSE;
 	static ni_bool_t ipv6_conf = FALSE;
@@ -1800,11 +1877,9 @@ __ni_process_ifinfomsg_af_spec(ni_netdev_t *dev, struct nlattr *ifla_af_spec, ni
 		}
 	}
 
-		return 0;
-
 	/* don't read sysfs when device (name) is not ready */
 	if (ni_netdev_device_is_ready(dev) &&
-	    ni_netconfig_discover_filtered(nc, NI_NETCONFIG_DISCOVER_LINK_EXTERN)) {
+	    !ni_netconfig_discover_filtered(nc, NI_NETCONFIG_DISCOVER_LINK_EXTERN)) {
 		if (!ipv4_conf) {
 			ni_system_ipv4_devinfo_get(dev, NULL);
 		}
@@ -1824,6 +1899,7 @@ __ni_netdev_process_newlink(ni_netdev_t *dev, struct nlmsghdr *h,
 				struct ifinfomsg *ifi, ni_netconfig_t *nc)
 {
 	struct nlattr *tb[IFLA_MAX+1];
+	unsigned int ifflags = dev->link.ifflags;
 	int rv;
 
 	memset(tb, 0, sizeof(tb));
@@ -1872,6 +1948,13 @@ __ni_netdev_process_newlink(ni_netdev_t *dev, struct nlmsghdr *h,
 		if (ni_netconfig_discover_filtered(nc, NI_NETCONFIG_DISCOVER_LINK_EXTERN))
 			break;
 
+		/* ethtool notifications keep the settings up to date,
+		 * a link state change may still change speed/duplex */
+		if (ni_ethtool_nl_monitor_active() && dev->ethernet &&
+		    dev->ethernet->autoneg_enable != NI_TRISTATE_DEFAULT &&
+		    ifflags == dev->link.ifflags)
+			break;
+
 		__ni_system_ethernet_refresh(dev);
 		break;
 
@@ -1881,7 +1964,7 @@ __ni_netdev_process_newlink(ni_netdev_t *dev, struct nlmsghdr *h,
 		break;
 
 	case NI_IFTYPE_BRIDGE:
-		__ni_discover_bridge(dev);
+		__ni_discover_bridge(dev, tb, nc);
 		break;
 	case NI_IFTYPE_BOND:
 		__ni_discover_bond(dev, tb, nc);
@@ -2877,9 +2960,9 @@ __ni_netdev_process_newaddr_event(ni_netdev_t *dev, struct nlmsghdr *h, struct i
 	if (__ni_rtnl_parse_newaddr(dev->link.ifflags, h, ifa, &tmp) < 0)
 		return -1;
 
-	ap = ni_address_list_find(dev->addrs, &tmp.local_addr);
+	ap = ni_netdev_address_find(dev, &tmp.local_addr);
 	if (!ap) {
-		ap = ni_address_new(tmp.family, tmp.prefixlen, &tmp.local_addr, &dev->addrs);
+		ap = ni_netdev_address_new(dev, tmp.family, tmp.prefixlen, &tmp.local_addr);
 		if (!ap) {
 			ni_string_free(&tmp.label);
 			return -1;
@@ -3451,17 +3534,11 @@ failure:
  * Discover bridge topology
  */
 static int
-__ni_discover_bridge(ni_netdev_t *dev)
+__ni_discover_bridge_sysfs(ni_netdev_t *dev, ni_bridge_t *bridge)
 {
-	ni_bridge_t *bridge;
 	ni_string_array_t ports;
 	unsigned int i;
 
-	if (dev->link.type != NI_IFTYPE_BRIDGE)
-		return 0;
-
-	bridge = ni_netdev_get_bridge(dev);
-
 	ni_sysfs_bridge_get_config(dev->name, bridge);
 	ni_sysfs_bridge_get_status(dev->name, &bridge->status);
 
@@ -3490,6 +3567,139 @@ __ni_discover_bridge(ni_netdev_t *dev)
 	return 0;
 }
 
+static int
+__ni_discover_bridge_netlink_master(ni_netdev_t *dev, ni_bridge_t *bridge, struct nlattr *info_data)
+{
+	/* static const */ struct nla_policy	__bridge_policy[IFLA_BR_MAX+1] = {
+		[IFLA_BR_FORWARD_DELAY]			= { .type = NLA_U32	},
+		[IFLA_BR_HELLO_TIME]			= { .type = NLA_U32	},
+		[IFLA_BR_MAX_AGE]			= { .type = NLA_U32	},
+		[IFLA_BR_AGEING_TIME]			= { .type = NLA_U32	},
+		[IFLA_BR_STP_STATE]			= { .type = NLA_U32	},
+		[IFLA_BR_PRIORITY]			= { .type = NLA_U16	},
+		[IFLA_BR_ROOT_ID]			= { .type = NLA_UNSPEC	},
+		[IFLA_BR_BRIDGE_ID]			= { .type = NLA_UNSPEC	},
+		[IFLA_BR_ROOT_PORT]			= { .type = NLA_U16	},
+		[IFLA_BR_ROOT_PATH_COST]		= { .type = NLA_U32	},
+		[IFLA_BR_TOPOLOGY_CHANGE]		= { .type = NLA_U8	},
+		[IFLA_BR_TOPOLOGY_CHANGE_DETECTED]	= { .type = NLA_U8	},
+		[IFLA_BR_HELLO_TIMER]			= { .type = NLA_U64	},
+		[IFLA_BR_TCN_TIMER]			= { .type = NLA_U64	},
+		[IFLA_BR_TOPOLOGY_CHANGE_TIMER]		= { .type = NLA_U64	},
+		[IFLA_BR_GC_TIMER]			= { .type = NLA_U64	},
+		[IFLA_BR_GROUP_ADDR]			= { .type = NLA_UNSPEC	},
+	};
+	struct nlattr *tb[IFLA_BR_MAX+1];
+	ni_bridge_status_t *bs = &bridge->status;
+
+	if (nla_parse_nested(tb, IFLA_BR_MAX, info_data, __bridge_policy) < 0) {
+		ni_error("%s: Unable to parse bridge IFLA_INFO_DATA", dev->name);
+		return -1;
+	}
+
+	/* times are in clock_t (USER_HZ) as in sysfs */
+	if (tb[IFLA_BR_STP_STATE]) {
+		bs->stp_state = nla_get_u32(tb[IFLA_BR_STP_STATE]);
+		bridge->stp = bs->stp_state ? TRUE : FALSE;
+	}
+	if (tb[IFLA_BR_PRIORITY])
+		bridge->priority = nla_get_u16(tb[IFLA_BR_PRIORITY]);
+	if (tb[IFLA_BR_FORWARD_DELAY])
+		bridge->forward_delay = (double)nla_get_u32(tb[IFLA_BR_FORWARD_DELAY]) / 100.0;
+	if (tb[IFLA_BR_AGEING_TIME])
+		bridge->ageing_time = (double)nla_get_u32(tb[IFLA_BR_AGEING_TIME]) / 100.0;
+	if (tb[IFLA_BR_HELLO_TIME])
+		bridge->hello_time = (double)nla_get_u32(tb[IFLA_BR_HELLO_TIME]) / 100.0;
+	if (tb[IFLA_BR_MAX_AGE])
+		bridge->max_age = (double)nla_get_u32(tb[IFLA_BR_MAX_AGE]) / 100.0;
+
+	if (tb[IFLA_BR_ROOT_ID])
+		__ni_bridge_id_print(&bs->root_id, tb[IFLA_BR_ROOT_ID]);
+	if (tb[IFLA_BR_BRIDGE_ID])
+		__ni_bridge_id_print(&bs->bridge_id, tb[IFLA_BR_BRIDGE_ID]);
+	if (tb[IFLA_BR_GROUP_ADDR] && (unsigned int)nla_len(tb[IFLA_BR_GROUP_ADDR]) ==
+					ni_link_address_length(ARPHRD_ETHER)) {
+		const unsigned char *a = nla_data(tb[IFLA_BR_GROUP_ADDR]);
+		char buf[32];
+
+		snprintf(buf, sizeof(buf), "%02x:%02x:%02x:%02x:%02x:%02x",
+				a[0], a[1], a[2], a[3], a[4], a[5]);
+		ni_string_dup(&bs->group_addr, buf);
+	}
+	if (tb[IFLA_BR_ROOT_PORT])
+		bs->root_port = nla_get_u16(tb[IFLA_BR_ROOT_PORT]);
+	if (tb[IFLA_BR_ROOT_PATH_COST])
+		bs->root_path_cost = nla_get_u32(tb[IFLA_BR_ROOT_PATH_COST]);
+	if (tb[IFLA_BR_TOPOLOGY_CHANGE])
+		bs->topology_change = nla_get_u8(tb[IFLA_BR_TOPOLOGY_CHANGE]);
+	if (tb[IFLA_BR_TOPOLOGY_CHANGE_DETECTED])
+		bs->topology_change_detected = nla_get_u8(tb[IFLA_BR_TOPOLOGY_CHANGE_DETECTED]);
+	if (tb[IFLA_BR_HELLO_TIMER])
+		bs->hello_timer = nla_get_u64(tb[IFLA_BR_HELLO_TIMER]);
+	if (tb[IFLA_BR_TCN_TIMER])
+		bs->tcn_timer = nla_get_u64(tb[IFLA_BR_TCN_TIMER]);
+	if (tb[IFLA_BR_TOPOLOGY_CHANGE_TIMER])
+		bs->topology_change_timer = nla_get_u64(tb[IFLA_BR_TOPOLOGY_CHANGE_TIMER]);
+	if (tb[IFLA_BR_GC_TIMER])
+		bs->gc_timer = nla_get_u64(tb[IFLA_BR_GC_TIMER]);
+
+	ni_debug_verbose(NI_LOG_DEBUG2, NI_TRACE_EVENTS,
+			"%s: bridge stp=%u priority=%u bridge-id=%s root-id=%s",
+			dev->name, bs->stp_state, bridge->priority,
+			bs->bridge_id, bs->root_id);
+	return 0;
+}
+
+static int
+__ni_discover_bridge_netlink(ni_netdev_t *dev, ni_bridge_t *bridge, struct nlattr **tb)
+{
+	/* static const */ struct nla_policy	__info_data_policy[IFLA_INFO_MAX+1] = {
+		[IFLA_INFO_KIND]			= { .type = NLA_STRING	},
+		[IFLA_INFO_DATA]			= { .type = NLA_NESTED	},
+	};
+	struct nlattr *info[IFLA_INFO_MAX+1];
+	/* set once the kernel reported IFLA_BR_* data, sysfs is used before */
+	static ni_bool_t supported = FALSE;
+
+	if (!tb || !tb[IFLA_LINKINFO])
+		return supported ? 0 : 1;
+
+	if (nla_parse_nested(info, IFLA_INFO_MAX, tb[IFLA_LINKINFO], __info_data_policy) < 0) {
+		ni_warn("%s: Unable to parse IFLA_LINKINFO newlink attribute, using sysfs",
+				dev->name);
+		return 1;
+	}
+
+	if (!info[IFLA_INFO_KIND] || !ni_string_eq("bridge", nla_get_string(info[IFLA_INFO_KIND])))
+		return supported ? 0 : 1;
+
+	if (!info[IFLA_INFO_DATA])
+		return supported ? 0 : 1;
+
+	/* kernel reports bridge and port attributes, ports bind themselves */
+	supported = TRUE;
+
+	/* a parse error of this message falls back to sysfs this time */
+	return __ni_discover_bridge_netlink_master(dev, bridge, info[IFLA_INFO_DATA]) < 0 ? 1 : 0;
+}
+
+static int
+__ni_discover_bridge(ni_netdev_t *dev, struct nlattr **tb, ni_netconfig_t *nc)
+{
+	ni_bridge_t *bridge;
+	int ret;
+
+	if (dev->link.type != NI_IFTYPE_BRIDGE)
+		return 0;
+
+	bridge = ni_netdev_get_bridge(dev);
+
+	if ((ret = __ni_discover_bridge_netlink(dev, bridge, tb)) <= 0)
+		return ret;
+
+	return __ni_discover_bridge_sysfs(dev, bridge);
+}
+
 /*
  * Discover bonding configuration
  */
@@ -3869,25 +4079,28 @@ __ni_discover_bond_netlink(ni_netdev_t *dev, struct nlattr **tb, ni_netconfig_t
 		/* _here_, we handle only these attrs */
 	};
 	struct nlattr *info[IFLA_INFO_MAX+1];
-	static int fallback = 1;
+	/* set once the kernel reported IFLA_BOND_* data, sysfs is used before */
+	static ni_bool_t supported = FALSE;
 
 	if (!tb || !tb[IFLA_LINKINFO])
-		return fallback;
+		return supported ? 0 : 1;
 
 	if (nla_parse_nested(info, IFLA_INFO_MAX, tb[IFLA_LINKINFO], __info_data_policy) < 0) {
-		ni_error("%s: Unable to parse IFLA_LINKINFO newlink attribute", dev->name);
-		return -1;
+		ni_warn("%s: Unable to parse IFLA_LINKINFO newlink attribute, using sysfs",
+				dev->name);
+		return 1;
 	}
 
 	if (!info[IFLA_INFO_KIND] || !ni_string_eq("bond", nla_get_string(info[IFLA_INFO_KIND])))
-		return fallback; /* just a safe guard, we've already checked this   */
+		return supported ? 0 : 1; /* just a safe guard, we've already checked this */
 
 	if (!info[IFLA_INFO_DATA])
-		return fallback; /* ahm... no data provided in this newlink message */
+		return supported ? 0 : 1; /* ahm... no data provided in this newlink message */
 
-	fallback = 0;		 /* disable sysfs fallback, kernel supports netlink */
+	supported = TRUE;
 
-	return __ni_discover_bond_netlink_master(dev, info[IFLA_INFO_DATA], nc);
+	/* a parse error of this message falls back to sysfs this time */
+	return __ni_discover_bond_netlink_master(dev, info[IFLA_INFO_DATA], nc) < 0 ? 1 : 0;
 }
 
 static int
@@ -12,6 +12,7 @@
 #include <wicked/ipv4.h>
 #include <errno.h>
 
+#include "netinfo_priv.h"
 #include "util_priv.h"
 #include "sysfs.h"
 
@@ -186,19 +187,19 @@ ni_system_ipv4_devinfo_get(ni_netdev_t *dev, ni_ipv4_devinfo_t *ipv4)
  * Update the device's IPv4 settings
  */
 static inline int
-__change_int(const char *ifname, const char *attr, int value)
+__change_int(ni_sysctl_ifconfig_t *ctl, const char *attr, int value)
 {
 	if (!ni_tristate_is_set(value))
 		return 1;
 
-	if (ni_sysctl_ipv4_ifconfig_set_int(ifname, attr, value) < 0) {
+	if (ni_sysctl_ifconfig_set_int(ctl, attr, value) < 0) {
 		if (errno == EROFS || errno == ENOENT) {
 			ni_info("%s: cannot set ipv4.conf.%s = %d attribute: %m",
-					ifname, attr, value);
+					ctl->ifname, attr, value);
 			return 1;
 		} else {
 			ni_warn("%s: cannot set ipv4.conf.%s = %d attribute: %m",
-					ifname, attr, value);
+					ctl->ifname, attr, value);
 			return -errno;
 		}
 	}
@@ -212,13 +213,72 @@ __tristate_changed(ni_tristate_t cfg, ni_tristate_t sys)
 	return ni_tristate_is_set(cfg) && cfg != sys;
 }
 
+/*
+ * A pending devconf change; sysctl_only marks knobs where the
+ * sysctl handler does more than storing the value (forwarding
+ * disables LRO), which the netlink IFLA_INET_CONF path skips.
+ */
+typedef struct ni_ipv4_devconf_change {
+	unsigned int		flag;
+	int			value;
+	ni_tristate_t *		state;
+	ni_bool_t		sysctl_only;
+} ni_ipv4_devconf_change_t;
+
+#define NI_IPV4_DEVCONF_CHANGE_MAX	3
+
+static int
+__ni_ipv4_devconf_apply(ni_netdev_t *dev, ni_ipv4_devconf_change_t *changes, unsigned int count)
+{
+	unsigned int flags[NI_IPV4_DEVCONF_CHANGE_MAX];
+	int values[NI_IPV4_DEVCONF_CHANGE_MAX];
+	ni_sysctl_ifconfig_t ctl;
+	unsigned int i, n;
+	int ret = 0;
+
+	for (i = n = 0; i < count; ++i) {
+		if (changes[i].sysctl_only)
+			continue;
+		flags[n] = changes[i].flag;
+		values[n] = changes[i].value;
+		n++;
+	}
+
+	/* one RTM_SETLINK for all of them when the kernel supports it */
+	if (n && __ni_rtnl_link_set_ipv4_conf(dev, flags, values, n) == 0) {
+		for (i = 0; i < count; ++i) {
+			if (changes[i].sysctl_only)
+				continue;
+			*changes[i].state = changes[i].value;
+			changes[i].flag = 0;
+		}
+	}
+
+	ni_sysctl_ifconfig_init(&ctl, "ipv4", dev->name);
+	for (i = 0; i < count && ret >= 0; ++i) {
+		const char *name;
+
+		if (!changes[i].flag)
+			continue;
+
+		name = ni_format_uint_mapped(changes[i].flag, __ipv4_devconf_sysctl_name_map);
+		ret = __change_int(&ctl, name, changes[i].value);
+		if (ret == 0)
+			*changes[i].state = changes[i].value;
+	}
+	ni_sysctl_ifconfig_destroy(&ctl);
+
+	return ret < 0 ? ret : 0;
+}
+
 int
 ni_system_ipv4_devinfo_set(ni_netdev_t *dev, const ni_ipv4_devconf_t *conf)
 {
+	ni_ipv4_devconf_change_t changes[NI_IPV4_DEVCONF_CHANGE_MAX];
 	ni_ipv4_devinfo_t *ipv4;
 	ni_tristate_t arp_notify;
 	ni_bool_t can_arp;
-	int ret;
+	unsigned int count = 0;
 
 	if (!conf || !(ipv4 = ni_netdev_get_ipv4(dev)))
 		return -1;
@@ -227,11 +287,10 @@ ni_system_ipv4_devinfo_set(ni_netdev_t *dev, const ni_ipv4_devconf_t *conf)
 		ni_tristate_set(&ipv4->conf.enabled, conf->enabled);
 
 	if (__tristate_changed(conf->forwarding, ipv4->conf.forwarding)) {
-		ret = __change_int(dev->name, "forwarding", conf->forwarding);
-		if (ret < 0)
-			return ret;
-		if (ret == 0)
-			ipv4->conf.forwarding = conf->forwarding;
+		changes[count++] = (ni_ipv4_devconf_change_t) {
+			NI_IPV4_DEVCONF_FORWARDING, conf->forwarding,
+			&ipv4->conf.forwarding, TRUE
+		};
 	}
 
 	can_arp = ni_netdev_supports_arp(dev);
@@ -244,22 +303,23 @@ ni_system_ipv4_devinfo_set(ni_netdev_t *dev, const ni_ipv4_devconf_t *conf)
 			conf->arp_notify : conf->arp_verify;
 
 	if (__tristate_changed(arp_notify, ipv4->conf.arp_notify)) {
-		ret = __change_int(dev->name, "arp_notify", arp_notify);
-		if (ret < 0)
-			return ret;
-		if (ret == 0)
-			ipv4->conf.arp_notify = arp_notify;
+		changes[count++] = (ni_ipv4_devconf_change_t) {
+			NI_IPV4_DEVCONF_ARP_NOTIFY, arp_notify,
+			&ipv4->conf.arp_notify, FALSE
+		};
 	}
 
 	if (__tristate_changed(conf->accept_redirects, ipv4->conf.accept_redirects)) {
-		ret = __change_int(dev->name, "accept_redirects", conf->accept_redirects);
-		if (ret < 0)
-			return ret;
-		if (ret == 0)
-			ipv4->conf.accept_redirects = conf->accept_redirects;
+		changes[count++] = (ni_ipv4_devconf_change_t) {
+			NI_IPV4_DEVCONF_ACCEPT_REDIRECTS, conf->accept_redirects,
+			&ipv4->conf.accept_redirects, FALSE
+		};
 	}
 
-	return 0;
+	if (!count)
+		return 0;
+
+	return __ni_ipv4_devconf_apply(dev, changes, count);
 }
 
 static inline const char *
@@ -248,19 +248,19 @@ ni_system_ipv6_devinfo_get(ni_netdev_t *dev, ni_ipv6_devinfo_t *ipv6)
  * Update the device's IPv6 settings
  */
 static inline int
-__change_int(const char *ifname, const char *attr, int value)
+__change_int(ni_sysctl_ifconfig_t *ctl, const char *attr, int value)
 {
 	if (!ni_tristate_is_set(value))
 		return 1;
 
-	if (ni_sysctl_ipv6_ifconfig_set_int(ifname, attr, value) < 0) {
+	if (ni_sysctl_ifconfig_set_int(ctl, attr, value) < 0) {
 		if (errno == EROFS || errno == ENOENT) {
 			ni_info("%s: cannot set ipv6.conf.%s = %d attribute: %m",
-					ifname, attr, value);
+					ctl->ifname, attr, value);
 			return 1;
 		} else {
 			ni_warn("%s: cannot set ipv6.conf.%s = %d attribute: %m",
-					ifname, attr, value);
+					ctl->ifname, attr, value);
 			return -errno;
 		}
 	}
@@ -277,8 +277,9 @@ __tristate_changed(ni_tristate_t cfg, ni_tristate_t sys)
 int
 ni_system_ipv6_devinfo_set(ni_netdev_t *dev, const ni_ipv6_devconf_t *conf)
 {
+	ni_sysctl_ifconfig_t ctl;
 	ni_ipv6_devinfo_t *ipv6;
-	int ret;
+	int ret = 0;
 
 	if (!conf || !(ipv6 = ni_netdev_get_ipv6(dev)))
 		return -1;
@@ -292,11 +293,17 @@ ni_system_ipv6_devinfo_set(ni_netdev_t *dev, const ni_ipv6_devconf_t *conf)
 		return 0;
 	}
 
+	/*
+	 * The kernel does not accept IFLA_INET6_CONF in RTM_SETLINK,
+	 * so we write the sysctls, keeping the conf directory open.
+	 */
+	ni_sysctl_ifconfig_init(&ctl, "ipv6", dev->name);
+
 	if (__tristate_changed(conf->enabled, ipv6->conf.enabled)) {
-		ret = __change_int(dev->name, "disable_ipv6",
+		ret = __change_int(&ctl, "disable_ipv6",
 				ni_tristate_is_enabled(conf->enabled) ? 0 : 1);
 		if (ret < 0)
-			return ret;
+			goto done;
 		if (ret == 0)
 			ni_tristate_set(&ipv6->conf.enabled, conf->enabled);
 	}
@@ -304,21 +311,22 @@ ni_system_ipv6_devinfo_set(ni_netdev_t *dev, const ni_ipv6_devconf_t *conf)
 	/* If we're disabling IPv6 on this interface, we're done! */
 	if (ni_tristate_is_disabled(conf->enabled)) {
 		ni_ipv6_ra_info_reset(&dev->ipv6->radv);
-		return 0;
+		ret = 0;
+		goto done;
 	}
 
 	if (__tristate_changed(conf->forwarding, ipv6->conf.forwarding)) {
-		ret = __change_int(dev->name, "forwarding", conf->forwarding);
+		ret = __change_int(&ctl, "forwarding", conf->forwarding);
 		if (ret < 0)
-			return ret;
+			goto done;
 		if (ret == 0)
 			ipv6->conf.forwarding = conf->forwarding;
 	}
 
 	if (__tristate_changed(conf->autoconf, ipv6->conf.autoconf)) {
-		ret = __change_int(dev->name, "autoconf", conf->autoconf);
+		ret = __change_int(&ctl, "autoconf", conf->autoconf);
 		if (ret < 0)
-			return ret;
+			goto done;
 		if (ret == 0)
 			ipv6->conf.autoconf = conf->autoconf;
 	}
@@ -326,40 +334,43 @@ ni_system_ipv6_devinfo_set(ni_netdev_t *dev, const ni_ipv6_devconf_t *conf)
 	if (__tristate_changed(conf->privacy, ipv6->conf.privacy)) {
 		/* kernel is using -1 for loopback, ptp, ... */
 		int privacy = conf->privacy > 2 ? 2 : conf->privacy;
-		ret = __change_int(dev->name, "use_tempaddr", privacy);
+		ret = __change_int(&ctl, "use_tempaddr", privacy);
 		if (ret < 0)
-			return ret;
+			goto done;
 		if (ret == 0)
 			ipv6->conf.privacy = privacy;
 	}
 
 	if (__tristate_changed(conf->accept_ra, ipv6->conf.accept_ra)) {
 		int accept_ra = conf->accept_ra > 2 ? 2 : conf->accept_ra;
-		ret = __change_int(dev->name, "accept_ra", accept_ra);
+		ret = __change_int(&ctl, "accept_ra", accept_ra);
 		if (ret < 0)
-			return ret;
+			goto done;
 		if (ret == 0)
 			ipv6->conf.accept_ra = accept_ra;
 	}
 
 	if (__tristate_changed(conf->accept_dad, ipv6->conf.accept_dad)) {
 		int accept_dad = conf->accept_dad > 2 ? 2 : conf->accept_dad;
-		ret = __change_int(dev->name, "accept_dad", accept_dad);
+		ret = __change_int(&ctl, "accept_dad", accept_dad);
 		if (ret < 0)
-			return ret;
+			goto done;
 		if (ret == 0)
 			ipv6->conf.accept_dad = accept_dad;
 	}
 
 	if (__tristate_changed(conf->accept_redirects, ipv6->conf.accept_redirects)) {
-		ret = __change_int(dev->name, "accept_redirects", conf->accept_redirects);
+		ret = __change_int(&ctl, "accept_redirects", conf->accept_redirects);
 		if (ret < 0)
-			return ret;
+			goto done;
 		if (ret == 0)
 			ipv6->conf.accept_redirects = conf->accept_redirects;
 	}
 
-	return 0;
+	ret = 0;
+done:
+	ni_sysctl_ifconfig_destroy(&ctl);
+	return ret;
 }
 
 void
@@ -368,6 +379,54 @@ ni_ipv6_ra_info_flush(ni_ipv6_ra_info_t *radv)
 	ni_ipv6_ra_pinfo_list_destroy(&radv->pinfo);
 	ni_ipv6_ra_rdnss_list_destroy(&radv->rdnss);
 	ni_ipv6_ra_dnssl_list_destroy(&radv->dnssl);
+	memset(&radv->expire, 0, sizeof(radv->expire));
+}
+
+/*
+ * The expire hint records the earliest deadline of all entries, so
+ * the lists are walked only once it has been reached. Refreshed or
+ * removed entries may leave it too early, causing an extra walk only.
+ */
+static inline time_t
+ni_ipv6_ra_deadline(unsigned int lifetime, const struct timeval *acquired)
+{
+	if (lifetime == NI_LIFETIME_INFINITE || lifetime == NI_LIFETIME_EXPIRED)
+		return 0;
+	if (!acquired || !timerisset(acquired))
+		return 0;
+	return acquired->tv_sec + lifetime;
+}
+
+static void
+ni_ipv6_ra_info_expire_hint(ni_ipv6_ra_info_t *radv, unsigned int lifetime,
+				const struct timeval *acquired)
+{
+	time_t deadline;
+
+	if (!(deadline = ni_ipv6_ra_deadline(lifetime, acquired)))
+		return;
+
+	if (!radv->expire.lifetime || deadline <
+	    ni_ipv6_ra_deadline(radv->expire.lifetime, &radv->expire.acquired)) {
+		radv->expire.lifetime = lifetime;
+		radv->expire.acquired = *acquired;
+	}
+}
+
+static void
+ni_ipv6_ra_info_expire_rehint(ni_ipv6_ra_info_t *radv)
+{
+	ni_ipv6_ra_pinfo_t *pi;
+	ni_ipv6_ra_rdnss_t *rdnss;
+	ni_ipv6_ra_dnssl_t *dnssl;
+
+	memset(&radv->expire, 0, sizeof(radv->expire));
+	for (pi = radv->pinfo; pi; pi = pi->next)
+		ni_ipv6_ra_info_expire_hint(radv, pi->lifetime.valid_lft, &pi->lifetime.acquired);
+	for (rdnss = radv->rdnss; rdnss; rdnss = rdnss->next)
+		ni_ipv6_ra_info_expire_hint(radv, rdnss->lifetime, &rdnss->acquired);
+	for (dnssl = radv->dnssl; dnssl; dnssl = dnssl->next)
+		ni_ipv6_ra_info_expire_hint(radv, dnssl->lifetime, &dnssl->acquired);
 }
 
 unsigned int
@@ -381,6 +440,12 @@ ni_ipv6_ra_info_expire(ni_ipv6_ra_info_t *radv, const struct timeval *current)
 		current = &now;
 	}
 
+	if (radv->expire.lifetime) {
+		left = ni_lifetime_left(radv->expire.lifetime, &radv->expire.acquired, current);
+		if (left != NI_LIFETIME_EXPIRED)
+			return left;
+	}
+
 	if ((left = ni_ipv6_ra_pinfo_list_expire(&radv->pinfo, current)) && left < lifetime)
 		lifetime = left;
 
@@ -390,9 +455,39 @@ ni_ipv6_ra_info_expire(ni_ipv6_ra_info_t *radv, const struct timeval *current)
 	if ((left = ni_ipv6_ra_dnssl_list_expire(&radv->dnssl, current)) && left < lifetime)
 		lifetime = left;
 
+	ni_ipv6_ra_info_expire_rehint(radv);
 	return lifetime;
 }
 
+void
+ni_ipv6_ra_info_pinfo_add(ni_ipv6_ra_info_t *radv, ni_ipv6_ra_pinfo_t *pi)
+{
+	ni_ipv6_ra_pinfo_list_prepend(&radv->pinfo, pi);
+	ni_ipv6_ra_info_expire_hint(radv, pi->lifetime.valid_lft, &pi->lifetime.acquired);
+}
+
+ni_bool_t
+ni_ipv6_ra_info_rdnss_update(ni_ipv6_ra_info_t *radv, const struct in6_addr *ipv6,
+				unsigned int lifetime, const struct timeval *acquired)
+{
+	if (!ni_ipv6_ra_rdnss_list_update(&radv->rdnss, ipv6, lifetime, acquired))
+		return FALSE;
+
+	ni_ipv6_ra_info_expire_hint(radv, lifetime, acquired);
+	return TRUE;
+}
+
+ni_bool_t
+ni_ipv6_ra_info_dnssl_update(ni_ipv6_ra_info_t *radv, const char *domain,
+				unsigned int lifetime, const struct timeval *acquired)
+{
+	if (!ni_ipv6_ra_dnssl_list_update(&radv->dnssl, domain, lifetime, acquired))
+		return FALSE;
+
+	ni_ipv6_ra_info_expire_hint(radv, lifetime, acquired);
+	return TRUE;
+}
+
 void
 ni_ipv6_ra_pinfo_free(ni_ipv6_ra_pinfo_t *pi)
 {
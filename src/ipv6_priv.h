@@ -15,6 +15,16 @@
 extern void			ni_ipv6_ra_info_flush(ni_ipv6_ra_info_t *);
 extern unsigned int		ni_ipv6_ra_info_expire(ni_ipv6_ra_info_t *,
 							const struct timeval *);
+extern void			ni_ipv6_ra_info_pinfo_add(ni_ipv6_ra_info_t *,
+							ni_ipv6_ra_pinfo_t *);
+extern ni_bool_t		ni_ipv6_ra_info_rdnss_update(ni_ipv6_ra_info_t *,
+							const struct in6_addr *,
+							unsigned int lifetime,
+							const struct timeval *);
+extern ni_bool_t		ni_ipv6_ra_info_dnssl_update(ni_ipv6_ra_info_t *,
+							const char *domain,
+							unsigned int lifetime,
+							const struct timeval *);
 
 extern void			ni_ipv6_ra_pinfo_free(ni_ipv6_ra_pinfo_t *);
 extern void			ni_ipv6_ra_pinfo_list_destroy(ni_ipv6_ra_pinfo_t **);
@@ -42,7 +52,18 @@ extern ni_bool_t		ni_ipv6_ra_dnssl_list_update(ni_ipv6_ra_dnssl_t **,
 							unsigned int lifetime,
 							const struct timeval *);
 
+struct nd_router_advert;
+typedef void			ni_icmpv6_ra_callback_t(unsigned int ifindex,
+							const struct nd_router_advert *,
+							size_t len, const ni_sockaddr_t *,
+							void *user_data);
+
 extern ni_bool_t		ni_icmpv6_ra_solicit(const ni_netdev_ref_t *,
 							const ni_hwaddr_t *);
+extern ni_bool_t		ni_icmpv6_ra_listen(unsigned int ifindex,
+							ni_icmpv6_ra_callback_t *,
+							void *user_data);
+extern void			ni_icmpv6_ra_unlisten(unsigned int ifindex,
+							void *user_data);
 
 #endif /* __IPV6_PRIV_H__ */
@@ -8,10 +8,12 @@
 #endif
 
 #include <unistd.h>
+#include <limits.h>
 #include <errno.h>
 #include <sys/socket.h>
 #include <sys/ioctl.h>
 #include <fcntl.h>
+#include <poll.h>
 #include <netinet/in.h>
 #include <net/if.h>
 #include <net/if_arp.h>
@@ -21,6 +23,7 @@
 #include <linux/ppp_defs.h>
 #define aligned_u64 uint64_t
 #include <linux/if_ppp.h>
+#include <linux/neighbour.h>
 #include <netlink/msg.h>
 #include <netlink/route/rtnl.h>
 #include <netlink/genl/genl.h>
@@ -32,6 +35,7 @@
 #include "sysfs.h"
 #include "kernel.h"
 #include <wicked/ppp.h>
+#include <wicked/metrics.h>
 #include <wicked/tuntap.h>
 
 /* FIXME: we should really make this configurable */
@@ -541,6 +545,7 @@ ni_nl_dump_store(int af, int type, struct ni_nlmsg_list *list)
 		.msg_type = -1,
 		.list = list,
 	};
+	struct timeval start;
 	struct nl_cb *cb;
 	const char *name;
 	int rv;
@@ -551,6 +556,8 @@ ni_nl_dump_store(int af, int type, struct ni_nlmsg_list *list)
 		return -NLE_BAD_SOCK;
 	}
 
+	ni_metric_start(&start);
+
 	if ((rv = nl_rtgen_request(nl_sock, type, af, NLM_F_DUMP)) < 0) {
 		ni_error("%s: failed to send request", name);
 		return rv;
@@ -575,6 +582,7 @@ retry:
 		/* debug only, we repeat the query */
 		ni_debug_socket("%s: failed to receive response: %s",
 				name, nl_geterror(rv));
+		ni_metric_count(NI_METRIC_NETLINK_DUMP_INTR);
 		break;
 	default:
 		ni_error("%s: failed to receive response: %s",
@@ -582,6 +590,241 @@ retry:
 		break;
 	}
 	nl_cb_put(cb);
+	ni_metric_record_since(NI_METRIC_NETLINK_DUMP, &start);
+	return rv;
+}
+
+/*
+ * Streamed dumps use a socket of their own: strict checking changes the
+ * request validation and must not affect users of the global socket.
+ */
+#ifndef SOL_NETLINK
+#define SOL_NETLINK			270
+#endif
+#ifndef NETLINK_GET_STRICT_CHK
+#define NETLINK_GET_STRICT_CHK		12
+#endif
+#define NI_NL_DUMP_MSG_BUFSIZE		32768
+
+static struct {
+	ni_netlink_t *		handle;
+	ni_bool_t		strict;
+} __ni_nl_dump;
+
+struct __ni_nl_dump_stream {
+	ni_nl_dump_handler_t *	handler;
+	void *			user_data;
+	int			error;
+};
+
+static ni_bool_t
+__ni_nl_dump_set_strict(ni_netlink_t *nl, ni_bool_t enable)
+{
+	int value = enable ? 1 : 0;
+
+	return setsockopt(nl_socket_get_fd(nl->nl_sock), SOL_NETLINK,
+			NETLINK_GET_STRICT_CHK, &value, sizeof(value)) == 0;
+}
+
+static ni_netlink_t *
+__ni_nl_dump_handle(void)
+{
+	ni_netlink_t *nl;
+
+	if ((nl = __ni_nl_dump.handle) != NULL)
+		return nl;
+
+	if (!(nl = __ni_netlink_open(NETLINK_ROUTE)))
+		return NULL;
+
+	nl_socket_set_msg_buf_size(nl->nl_sock, NI_NL_DUMP_MSG_BUFSIZE);
+	__ni_nl_dump.strict = __ni_nl_dump_set_strict(nl, TRUE);
+	if (!__ni_nl_dump.strict)
+		ni_debug_socket("netlink strict checking not supported, "
+				"filtering dumps in userspace");
+
+	__ni_nl_dump.handle = nl;
+	return nl;
+}
+
+/*
+ * Build a dump request with a complete family header, so strict checking
+ * accepts it. Kernels without strict checking ignore the filters.
+ */
+static struct nl_msg *
+__ni_nl_dump_request(int af, int type, unsigned int ifindex)
+{
+	struct nl_msg *msg;
+	int rv = 0;
+
+	if (!(msg = nlmsg_alloc_simple(type, NLM_F_REQUEST | NLM_F_DUMP)))
+		return NULL;
+
+	switch (type) {
+	case RTM_GETLINK: {
+			/* link dumps cannot be filtered by index */
+			struct ifinfomsg ifi = { .ifi_family = af };
+
+			rv = nlmsg_append(msg, &ifi, sizeof(ifi), NLMSG_ALIGNTO);
+		}
+		break;
+	case RTM_GETADDR: {
+			struct ifaddrmsg ifa = { .ifa_family = af, .ifa_index = ifindex };
+
+			rv = nlmsg_append(msg, &ifa, sizeof(ifa), NLMSG_ALIGNTO);
+		}
+		break;
+	case RTM_GETROUTE: {
+			struct rtmsg rtm = { .rtm_family = af };
+
+			rv = nlmsg_append(msg, &rtm, sizeof(rtm), NLMSG_ALIGNTO);
+			if (!rv && ifindex)
+				rv = nla_put_u32(msg, RTA_OIF, ifindex);
+		}
+		break;
+	case RTM_GETNEIGH: {
+			struct ndmsg ndm = { .ndm_family = af };
+
+			rv = nlmsg_append(msg, &ndm, sizeof(ndm), NLMSG_ALIGNTO);
+			if (!rv && ifindex)
+				rv = nla_put_u32(msg, NDA_IFINDEX, ifindex);
+		}
+		break;
+	case RTM_GETRULE: {
+			struct fib_rule_hdr frh = { .family = af };
+
+			rv = nlmsg_append(msg, &frh, sizeof(frh), NLMSG_ALIGNTO);
+		}
+		break;
+	default: {
+			struct rtgenmsg rtg = { .rtgen_family = af };
+
+			rv = nlmsg_append(msg, &rtg, sizeof(rtg), NLMSG_ALIGNTO);
+		}
+		break;
+	}
+
+	if (rv < 0) {
+		nlmsg_free(msg);
+		return NULL;
+	}
+	return msg;
+}
+
+static int
+__ni_nl_dump_stream_valid(struct nl_msg *msg, void *p)
+{
+	const struct sockaddr_nl *sender = nlmsg_get_src(msg);
+	struct __ni_nl_dump_stream *data = p;
+
+	if (sender->nl_pid) {
+		ni_warn("received netlink message from %d - spoof", sender->nl_pid);
+		return NL_SKIP;
+	}
+
+	/* after a handler failure, just drain the rest of the dump */
+	if (data->error < 0)
+		return NL_SKIP;
+
+	if (data->handler(nlmsg_hdr(msg), data->user_data) < 0)
+		data->error = -NLE_FAILURE;
+
+	return NL_OK;
+}
+
+static int
+__ni_nl_dump_stream(ni_netlink_t *nl, struct nl_msg *msg, const char *name,
+		struct __ni_nl_dump_stream *data)
+{
+	struct nl_cb *cb;
+	int rv;
+
+	if ((rv = nl_send_auto(nl->nl_sock, msg)) < 0) {
+		ni_error("%s: failed to send request", name);
+		return rv;
+	}
+
+	if (!(cb = __ni_nl_cb_clone(nl)))
+		return -NLE_NOMEM;
+
+	nl_cb_set(cb, NL_CB_VALID, NL_CB_CUSTOM, __ni_nl_dump_stream_valid, data);
+	do {
+		rv = nl_recvmsgs(nl->nl_sock, cb);
+	} while (rv == -NLE_AGAIN);
+
+	nl_cb_put(cb);
+	return rv;
+}
+
+/*
+ * Issue a DUMP request, filtered by the kernel to ifindex when strict
+ * checking is available, and pass each reply to the handler as it is
+ * received instead of storing the whole dump first.
+ * The handler has to check the ifindex itself for the fallback case.
+ */
+int
+ni_nl_dump_process(int af, int type, unsigned int ifindex,
+		ni_nl_dump_handler_t *handler, void *user_data)
+{
+	struct __ni_nl_dump_stream data = {
+		.handler = handler,
+		.user_data = user_data,
+	};
+	struct timeval start;
+	struct nl_msg *msg;
+	ni_netlink_t *nl;
+	const char *name;
+	int rv;
+
+	name = ni_rtnl_msg_type_to_name(type, __func__);
+	if (!handler)
+		return -NLE_INVAL;
+
+	if (!(nl = __ni_nl_dump_handle())) {
+		ni_error("%s: no netlink socket", name);
+		return -NLE_BAD_SOCK;
+	}
+
+	if (!(msg = __ni_nl_dump_request(af, type, ifindex))) {
+		ni_error("%s: unable to build dump request", name);
+		return -NLE_NOMEM;
+	}
+
+	ni_metric_start(&start);
+	rv = __ni_nl_dump_stream(nl, msg, name, &data);
+	if (rv == -NLE_INVAL && __ni_nl_dump.strict) {
+		/* the request has been rejected before any reply */
+		ni_warn("%s: strict dump request rejected, disabling kernel filtering",
+				name);
+		__ni_nl_dump_set_strict(nl, FALSE);
+		__ni_nl_dump.strict = FALSE;
+
+		/* a resend would reuse the completed, stale sequence number */
+		nlmsg_free(msg);
+		if (!(msg = __ni_nl_dump_request(af, type, ifindex))) {
+			ni_error("%s: unable to build dump request", name);
+			return -NLE_NOMEM;
+		}
+		rv = __ni_nl_dump_stream(nl, msg, name, &data);
+	}
+	nlmsg_free(msg);
+
+	switch (rv) {
+	case NLE_SUCCESS:
+		rv = data.error;
+		break;
+	case -NLE_DUMP_INTR:
+		/* debug only, the caller repeats the query */
+		ni_debug_socket("%s: failed to receive response: %s",
+				name, nl_geterror(rv));
+		ni_metric_count(NI_METRIC_NETLINK_DUMP_INTR);
+		break;
+	default:
+		ni_error("%s: failed to receive response: %s",
+				name, nl_geterror(rv));
+		break;
+	}
+	ni_metric_record_since(NI_METRIC_NETLINK_DUMP, &start);
 	return rv;
 }
 
@@ -591,22 +834,168 @@ retry:
 int
 ni_nl_talk(struct nl_msg *msg, struct ni_nlmsg_list *list)
 {
+	return ni_nl_talk_handle(__ni_global_netlink, msg, list);
+}
 
-	if (!__ni_global_netlink) {
+/*
+ * Same as ni_nl_talk, using a netlink handle other than the global one
+ */
+int
+ni_nl_talk_handle(ni_netlink_t *nl, struct nl_msg *msg, struct ni_nlmsg_list *list)
+{
+
+	if (!nl) {
 		ni_error("%s: no netlink socket", __func__);
 		return -NLE_BAD_SOCK;
 	}
 
 	if (list == NULL) {
-		return __ni_nl_talk(__ni_global_netlink, msg, NULL, NULL);
+		return __ni_nl_talk(nl, msg, NULL, NULL);
 	} else {
 		struct __ni_nl_dump_state data = {
 			.msg_type = -1,
 			.list = list,
 		};
 
-		return __ni_nl_talk(__ni_global_netlink, msg, __ni_nl_dump_valid, &data);
+		return __ni_nl_talk(nl, msg, __ni_nl_dump_valid, &data);
+	}
+}
+
+/*
+ * Send a burst of requests without waiting for each ack in turn and
+ * match the acks to the requests by their sequence numbers. The result
+ * of each request is stored in errors as 0 or a negative libnl error.
+ */
+#define NI_NL_TALK_BATCH_WINDOW		64
+#define NI_NL_BATCH_PENDING		INT_MIN
+
+struct __ni_nl_batch_state {
+	struct nl_msg **	msgs;
+	int *			errors;
+	unsigned int		first;
+	unsigned int		count;
+	unsigned int		pending;
+};
+
+static void
+__ni_nl_batch_done(struct __ni_nl_batch_state *state, uint32_t seq, int err)
+{
+	unsigned int i;
+
+	for (i = state->first; i < state->first + state->count; ++i) {
+		if (nlmsg_hdr(state->msgs[i])->nlmsg_seq != seq)
+			continue;
+		if (state->errors[i] == NI_NL_BATCH_PENDING) {
+			state->errors[i] = err;
+			state->pending--;
+		}
+		return;
 	}
+	ni_debug_socket("%s: ignoring ack for unknown sequence %u", __func__, seq);
+}
+
+static int
+__ni_nl_batch_seq_check(struct nl_msg *msg, void *arg)
+{
+	return NL_OK;
+}
+
+static int
+__ni_nl_batch_ack_handler(struct nl_msg *msg, void *arg)
+{
+	__ni_nl_batch_done(arg, nlmsg_hdr(msg)->nlmsg_seq, 0);
+	return NL_SKIP;
+}
+
+static int
+__ni_nl_batch_error_handler(struct sockaddr_nl *sender, struct nlmsgerr *err, void *arg)
+{
+	__ni_nl_batch_done(arg, err->msg.nlmsg_seq, -nl_syserr2nlerr(err->error));
+	return NL_SKIP;
+}
+
+/*
+ * The kernel queues the rtnetlink acks while processing the requests,
+ * so after a receive error the remaining ones are already on the socket.
+ * Consume them, so the next request on the shared socket does not pick
+ * them up as a reply with a sequence mismatch.
+ */
+static void
+__ni_nl_batch_drain(struct nl_sock *nl_sock, struct nl_cb *cb)
+{
+	struct pollfd pfd;
+
+	pfd.fd = nl_socket_get_fd(nl_sock);
+	pfd.events = POLLIN;
+	pfd.revents = 0;
+	while (poll(&pfd, 1, 0) == 1 && (pfd.revents & POLLIN)) {
+		nl_recvmsgs(nl_sock, cb);
+		pfd.revents = 0;
+	}
+}
+
+int
+ni_nl_talk_batch(struct nl_msg **msgs, int *errors, unsigned int count)
+{
+	struct __ni_nl_batch_state state = {
+		.msgs = msgs,
+		.errors = errors,
+	};
+	struct nl_sock *nl_sock;
+	struct nl_cb *cb;
+	unsigned int i;
+	int rv = 0;
+
+	if (!__ni_global_netlink || !(nl_sock = __ni_global_netlink->nl_sock)) {
+		ni_error("%s: no netlink socket", __func__);
+		return -NLE_BAD_SOCK;
+	}
+
+	if (!(cb = __ni_nl_cb_clone(__ni_global_netlink)))
+		return -NLE_NOMEM;
+
+	nl_cb_set(cb, NL_CB_SEQ_CHECK, NL_CB_CUSTOM, __ni_nl_batch_seq_check, NULL);
+	nl_cb_set(cb, NL_CB_ACK, NL_CB_CUSTOM, __ni_nl_batch_ack_handler, &state);
+	nl_cb_err(cb, NL_CB_CUSTOM, __ni_nl_batch_error_handler, &state);
+
+	for (state.first = 0; state.first < count; state.first += state.count) {
+		state.count = count - state.first;
+		if (state.count > NI_NL_TALK_BATCH_WINDOW)
+			state.count = NI_NL_TALK_BATCH_WINDOW;
+		state.pending = 0;
+
+		for (i = state.first; i < state.first + state.count; ++i) {
+			if ((errors[i] = nl_send_auto(nl_sock, msgs[i])) < 0) {
+				ni_error("%s: unable to send: %s", __func__,
+						nl_geterror(errors[i]));
+				continue;
+			}
+			errors[i] = NI_NL_BATCH_PENDING;
+			state.pending++;
+		}
+
+		while (state.pending) {
+			rv = nl_recvmsgs(nl_sock, cb);
+			if (rv < 0 && rv != -NLE_AGAIN) {
+				ni_debug_socket("%s: recv failed: %s", __func__, nl_geterror(rv));
+				break;
+			}
+			rv = 0;
+		}
+		if (rv < 0)
+			break;
+	}
+	if (rv < 0)
+		__ni_nl_batch_drain(nl_sock, cb);
+
+	/* requests without ack or not sent at all */
+	for (i = 0; i < count; ++i) {
+		if (i >= state.first + state.count || errors[i] == NI_NL_BATCH_PENDING)
+			errors[i] = rv < 0 ? rv : -NLE_FAILURE;
+	}
+
+	nl_cb_put(cb);
+	return rv;
 }
 
 #define ni_t2n(x)	[x] = #x
@@ -85,8 +85,15 @@ struct ni_nlmsg_list {
 };
 
 extern int	ni_nl_talk(struct nl_msg *, struct ni_nlmsg_list *);
+extern int	ni_nl_talk_handle(struct __ni_netlink *, struct nl_msg *, struct ni_nlmsg_list *);
+extern int	ni_nl_talk_batch(struct nl_msg **, int *, unsigned int);
 extern int	ni_nl_dump_store(int af, int type, struct ni_nlmsg_list *list);
 
+typedef int	ni_nl_dump_handler_t(struct nlmsghdr *, void *);
+
+extern int	ni_nl_dump_process(int af, int type, unsigned int ifindex,
+				ni_nl_dump_handler_t *, void *);
+
 extern void	ni_nlmsg_list_init(struct ni_nlmsg_list *);
 extern void	ni_nlmsg_list_destroy(struct ni_nlmsg_list *);
 
@@ -45,6 +45,8 @@
 
 #include "appconfig.h"
 #include "leasefile.h"
+#include "leasejournal.h"
+#include "buffer.h"
 #include "dhcp.h"
 #include "dhcp4/lease.h"
 #include "dhcp6/lease.h"
@@ -1233,104 +1235,10 @@ static void			__ni_addrconf_lease_file_remove(
 				const char *, const char *, int, int);
 
 /*
- * Write a lease to a file
+ * Read a lease from a xml lease file
  */
-int
-ni_addrconf_lease_file_write(const char *ifname, ni_addrconf_lease_t *lease)
-{
-	char tempname[PATH_MAX] = {'\0'};
-	ni_bool_t fallback = FALSE;
-	char *filename = NULL;
-	xml_node_t *xml = NULL;
-	FILE *fp = NULL;
-	int ret = -1;
-	int fd;
-
-	if (lease->state == NI_ADDRCONF_STATE_RELEASED) {
-		ni_addrconf_lease_file_remove(ifname, lease->type, lease->family);
-		return 0;
-	}
-
-	if (!__ni_addrconf_lease_file_path(&filename, ni_config_storedir(),
-					ifname, lease->type, lease->family)) {
-		ni_error("Cannot construct lease file name: %m");
-		return -1;
-	}
-
-	ni_debug_dhcp("Preparing xml lease data for '%s'", filename);
-	if ((ret = ni_addrconf_lease_to_xml(lease, &xml, ifname)) != 0) {
-		if (ret > 0) {
-			ni_debug_dhcp("Skipped, %s:%s leases are disabled",
-		                        ni_addrfamily_type_to_name(lease->family),
-					ni_addrconf_type_to_name(lease->type));
-		} else {
-			ni_error("Unable to represent %s:%s lease as XML",
-					ni_addrfamily_type_to_name(lease->family),
-					ni_addrconf_type_to_name(lease->type));
-		}
-		goto failed;
-	}
-
-	snprintf(tempname, sizeof(tempname), "%s.XXXXXX", filename);
-	if ((fd = mkstemp(tempname)) < 0) {
-		if (errno == EROFS && __ni_addrconf_lease_file_path(&filename,
-						ni_config_statedir(), ifname,
-						lease->type, lease->family)) {
-			ni_debug_dhcp("Read-only filesystem, try fallback to %s",
-					filename);
-			snprintf(tempname, sizeof(tempname), "%s.XXXXXX", filename);
-			fd = mkstemp(tempname);
-			fallback = TRUE;
-		}
-		if (fd < 0) {
-			ni_error("Cannot create temporary lease file '%s': %m",
-					tempname);
-			tempname[0] = '\0';
-			ret = -1;
-			goto failed;
-		}
-	}
-	if ((fp = fdopen(fd, "we")) == NULL) {
-		ret = -1;
-		close(fd);
-		ni_error("Cannot reopen temporary lease file '%s': %m", tempname);
-		goto failed;
-	}
-
-	ni_debug_dhcp("Writing lease to temporary file for '%s'", filename);
-	xml_node_print(xml, fp);
-	fclose(fp);
-	xml_node_free(xml);
-
-	if ((ret = rename(tempname, filename)) != 0) {
-		ni_error("Unable to rename temporary lease file '%s' to '%s': %m",
-				tempname, filename);
-		goto failed;
-	} else if (!fallback) {
-		__ni_addrconf_lease_file_remove(ni_config_statedir(),
-				ifname, lease->type, lease->family);
-	}
-
-	ni_debug_dhcp("Lease written to file '%s'", filename);
-	ni_string_free(&filename);
-	return 0;
-
-failed:
-	if (fp)
-		fclose(fp);
-	if (xml)
-		xml_node_free(xml);
-	if (tempname[0])
-		unlink(tempname);
-	ni_string_free(&filename);
-	return -1;
-}
-
-/*
- * Read a lease from a file
- */
-ni_addrconf_lease_t *
-ni_addrconf_lease_file_read(const char *ifname, int type, int family)
+static ni_addrconf_lease_t *
+ni_addrconf_lease_file_import(const char *ifname, int type, int family)
 {
 	ni_addrconf_lease_t *lease = NULL;
 	xml_node_t *xml = NULL, *lnode;
@@ -1395,6 +1303,213 @@ ni_addrconf_lease_file_read(const char *ifname, int type, int family)
 	return lease;
 }
 
+/*
+ * Drop a lease from an existing lease journal
+ */
+static void
+__ni_addrconf_lease_journal_del(const char *dir, const char *ifname, int type, int family)
+{
+	ni_lease_journal_t *journal;
+
+	journal = ni_lease_journal_open(dir, type, family, FALSE);
+	if (!ni_lease_journal_has(journal, ifname))
+		return;
+
+	/* reopen it writable */
+	journal = ni_lease_journal_open(dir, type, family, TRUE);
+	if (ni_lease_journal_del(journal, ifname) < 0)
+		ni_warn("%s: unable to remove %s lease",
+				ni_lease_journal_path(journal), ifname);
+}
+
+/*
+ * Move the acquired timestamps of the lease and its (DHCPv6) IAs,
+ * which change on every renewal, from the lease xml into a stamp,
+ * one line per timestamp in document order.
+ */
+static void
+__ni_addrconf_lease_xml_take_times(xml_node_t *node, ni_stringbuf_t *stamp)
+{
+	xml_node_t *child;
+
+	for (child = node->children; child; child = child->next) {
+		if (ni_string_eq(child->name, "acquired")) {
+			ni_stringbuf_puts(stamp, child->cdata);
+			ni_stringbuf_putc(stamp, '\n');
+			ni_string_free(&child->cdata);
+		} else {
+			__ni_addrconf_lease_xml_take_times(child, stamp);
+		}
+	}
+}
+
+/*
+ * Apply the timestamps of a stamp to the lease xml
+ */
+static void
+__ni_addrconf_lease_xml_apply_times(xml_node_t *node, const char **stamp)
+{
+	xml_node_t *child;
+	char *time = NULL;
+	size_t len;
+
+	for (child = node->children; child && **stamp; child = child->next) {
+		if (ni_string_eq(child->name, "acquired")) {
+			len = strcspn(*stamp, "\n");
+			ni_string_set(&time, *stamp, len);
+			xml_node_set_cdata(child, time);
+			*stamp += len;
+			if (**stamp == '\n')
+				(*stamp)++;
+		} else {
+			__ni_addrconf_lease_xml_apply_times(child, stamp);
+		}
+	}
+	ni_string_free(&time);
+}
+
+/*
+ * Write a lease to the lease journal; a renewal which changes only
+ * the acquired timestamps is coalesced to a stamp of the times.
+ */
+int
+ni_addrconf_lease_file_write(const char *ifname, ni_addrconf_lease_t *lease)
+{
+	ni_stringbuf_t stamp = NI_STRINGBUF_INIT_DYNAMIC;
+	ni_lease_journal_t *journal;
+	xml_node_t *xml = NULL;
+	char *data = NULL;
+	char *content;
+	uint64_t hash;
+	ni_bool_t fallback = FALSE;
+	int ret;
+
+	if (lease->state == NI_ADDRCONF_STATE_RELEASED) {
+		ni_addrconf_lease_file_remove(ifname, lease->type, lease->family);
+		return 0;
+	}
+
+	if ((ret = ni_addrconf_lease_to_xml(lease, &xml, ifname)) != 0) {
+		if (ret > 0) {
+			ni_debug_dhcp("Skipped, %s:%s leases are disabled",
+					ni_addrfamily_type_to_name(lease->family),
+					ni_addrconf_type_to_name(lease->type));
+		} else {
+			ni_error("Unable to represent %s:%s lease as XML",
+					ni_addrfamily_type_to_name(lease->family),
+					ni_addrconf_type_to_name(lease->type));
+		}
+		return -1;
+	}
+	data = xml_node_sprint(xml);
+	__ni_addrconf_lease_xml_take_times(xml, &stamp);
+	content = xml_node_sprint(xml);
+	xml_node_free(xml);
+	if (!data || !content) {
+		ni_error("Unable to format %s:%s lease",
+				ni_addrfamily_type_to_name(lease->family),
+				ni_addrconf_type_to_name(lease->type));
+		ni_stringbuf_destroy(&stamp);
+		free(content);
+		free(data);
+		return -1;
+	}
+	hash = ni_lease_journal_hash(content, strlen(content));
+	free(content);
+
+	journal = ni_lease_journal_open(ni_config_storedir(), lease->type, lease->family, TRUE);
+	if (!journal && errno == EROFS) {
+		ni_debug_dhcp("Read-only filesystem, try fallback to %s",
+				ni_config_statedir());
+		journal = ni_lease_journal_open(ni_config_statedir(),
+					lease->type, lease->family, TRUE);
+		fallback = TRUE;
+	}
+	if (!journal) {
+		ni_error("Cannot open %s:%s lease journal: %m",
+				ni_addrfamily_type_to_name(lease->family),
+				ni_addrconf_type_to_name(lease->type));
+		ni_stringbuf_destroy(&stamp);
+		free(data);
+		return -1;
+	}
+
+	ret = ni_lease_journal_put(journal, ifname, data, strlen(data), hash, stamp.string);
+	ni_stringbuf_destroy(&stamp);
+	free(data);
+	if (ret < 0)
+		return -1;
+
+	if (ret == 0) {
+		ni_debug_dhcp("%s: %s:%s lease written to '%s'", ifname,
+				ni_addrfamily_type_to_name(lease->family),
+				ni_addrconf_type_to_name(lease->type),
+				ni_lease_journal_path(journal));
+	}
+
+	/* drop obsolete copies, as the xml lease file write did */
+	if (!fallback) {
+		__ni_addrconf_lease_journal_del(ni_config_statedir(),
+					ifname, lease->type, lease->family);
+		__ni_addrconf_lease_file_remove(ni_config_statedir(),
+					ifname, lease->type, lease->family);
+	}
+	__ni_addrconf_lease_file_remove(ni_config_storedir(),
+				ifname, lease->type, lease->family);
+	return 0;
+}
+
+/*
+ * Read a lease from the lease journal or a xml lease file
+ */
+static ni_addrconf_lease_t *
+__ni_addrconf_lease_journal_read(const char *dir, const char *ifname, int type, int family)
+{
+	ni_addrconf_lease_t *lease = NULL;
+	ni_lease_journal_t *journal;
+	xml_document_t *doc;
+	const char *times;
+	char *stamp = NULL;
+	ni_buffer_t buf;
+	size_t len = 0;
+	char *data;
+
+	if (!(journal = ni_lease_journal_open(dir, type, family, FALSE)))
+		return NULL;
+
+	if (!(data = ni_lease_journal_get(journal, ifname, &len, &stamp)))
+		return NULL;
+
+	ni_debug_dhcp("Reading %s lease from %s", ifname, ni_lease_journal_path(journal));
+	ni_buffer_init_reader(&buf, data, len);
+	doc = xml_document_from_buffer(&buf, ni_lease_journal_path(journal));
+	if (doc && (times = stamp))
+		__ni_addrconf_lease_xml_apply_times(xml_document_root(doc), &times);
+	if (!doc || ni_addrconf_lease_from_xml(&lease, xml_document_root(doc), ifname) < 0) {
+		ni_error("Unable to parse %s lease in '%s'", ifname,
+				ni_lease_journal_path(journal));
+		lease = NULL;
+	}
+	xml_document_free(doc);
+	ni_string_free(&stamp);
+	free(data);
+	return lease;
+}
+
+ni_addrconf_lease_t *
+ni_addrconf_lease_file_read(const char *ifname, int type, int family)
+{
+	ni_addrconf_lease_t *lease;
+
+	if ((lease = __ni_addrconf_lease_journal_read(ni_config_statedir(), ifname, type, family)))
+		return lease;
+	if ((lease = __ni_addrconf_lease_journal_read(ni_config_storedir(), ifname, type, family)))
+		return lease;
+
+	/* leases written before the journal was used */
+	return ni_addrconf_lease_file_import(ifname, type, family);
+}
+
 /*
  * Remove a lease file
  */
@@ -1415,6 +1530,9 @@ __ni_addrconf_lease_file_remove(const char *dir, const char *ifname,
 void
 ni_addrconf_lease_file_remove(const char *ifname, int type, int family)
 {
+	__ni_addrconf_lease_journal_del(ni_config_statedir(), ifname, type, family);
+	__ni_addrconf_lease_journal_del(ni_config_storedir(), ifname, type, family);
+
 	__ni_addrconf_lease_file_remove(ni_config_statedir(), ifname, type, family);
 	__ni_addrconf_lease_file_remove(ni_config_storedir(), ifname, type, family);
 }
@@ -1436,6 +1554,13 @@ ni_addrconf_lease_file_exists(const char *ifname, int type, int family)
 {
 	char *filename = NULL;
 
+	if (ni_lease_journal_has(ni_lease_journal_open(ni_config_statedir(),
+				type, family, FALSE), ifname))
+		return TRUE;
+	if (ni_lease_journal_has(ni_lease_journal_open(ni_config_storedir(),
+				type, family, FALSE), ifname))
+		return TRUE;
+
 	if (__ni_addrconf_lease_file_path(&filename, ni_config_statedir(), ifname, type, family)) {
 		if (ni_file_exists(filename)) {
 			ni_string_free(&filename);
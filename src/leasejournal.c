@@ -0,0 +1,954 @@
+/*
+ * Addrconf lease journal
+ *
+ * The journal file starts with a header followed by records:
+ *
+ *	header	magic, version
+ *	record	magic, tag, name length, data length, data hash, check
+ *		interface name, lease data
+ *
+ * A PUT record stores the (xml serialized) lease of an interface,
+ * a DEL record drops it; the last record of an interface wins.
+ * A STAMP record stores the times of a renewal which did not change
+ * the lease content (with the content hash of the PUT it updates).
+ * The check covers the whole record and detects torn appends,
+ * which are truncated by the next writer. The fields are in host
+ * byte order: the journal is a local cache, not an exchange format.
+ * A journal with an invalid header or of another version is moved
+ * aside by the next writer, which starts a new one.
+ *
+ * Copyright (C) 2026 SUSE LLC
+ */
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <limits.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/file.h>
+
+#include <wicked/util.h>
+#include <wicked/logging.h>
+#include <wicked/netinfo.h>
+#include <wicked/addrconf.h>
+#include <wicked/socket.h>
+
+#include "leasejournal.h"
+#include "util_priv.h"
+
+#define NI_LEASE_JOURNAL_MAGIC		0x4a4c494eU	/* "NILJ" */
+#define NI_LEASE_JOURNAL_VERSION	1U
+#define NI_LEASE_JOURNAL_REC_MAGIC	0x3152454cU	/* "LER1" */
+#define NI_LEASE_JOURNAL_NAME_MAX	255U
+#define NI_LEASE_JOURNAL_DATA_MAX	(1U << 20)
+#define NI_LEASE_JOURNAL_ENTRY_CHUNK	16
+#define NI_LEASE_JOURNAL_BROKEN_SUFFIX	".broken"
+
+enum {
+	NI_LEASE_JOURNAL_PUT		= 1,
+	NI_LEASE_JOURNAL_DEL		= 2,
+	NI_LEASE_JOURNAL_STAMP		= 3,
+};
+
+typedef struct ni_lease_journal_hdr {
+	uint32_t		magic;
+	uint32_t		version;
+} ni_lease_journal_hdr_t;
+
+typedef struct ni_lease_journal_rec {
+	uint32_t		magic;
+	uint16_t		tag;
+	uint16_t		namelen;
+	uint32_t		datalen;
+	uint32_t		reserved;
+	uint64_t		hash;
+	uint64_t		check;
+} ni_lease_journal_rec_t;
+
+typedef struct ni_lease_journal_entry {
+	char *			ifname;
+	uint64_t		hash;
+	off_t			offset;
+	size_t			size;
+
+	char *			stamp;		/* last stamp, if known		*/
+	off_t			stamp_offset;	/* STAMP record after the PUT	*/
+	size_t			stamp_size;
+} ni_lease_journal_entry_t;
+
+struct ni_lease_journal {
+	ni_lease_journal_t *	next;
+
+	char *			path;
+	int			fd;
+	dev_t			dev;
+	ino_t			ino;
+	ni_bool_t		writable;
+
+	off_t			size;		/* end of the valid records	*/
+	off_t			live;		/* header + live PUT and STAMPs	*/
+
+	unsigned int		count;
+	ni_lease_journal_entry_t *entries;
+	unsigned int		index_size;	/* power of 2, > 2 * count	*/
+	unsigned int *		index;		/* entry position + 1 or 0	*/
+
+	unsigned int		pending;	/* records not flushed yet	*/
+	struct timeval		synced;
+	const ni_timer_t *	timer;
+};
+
+static ni_lease_journal_t *	ni_lease_journals;
+
+/*
+ * FNV-1a, used for the content hash and the record check
+ */
+#define NI_LEASE_JOURNAL_FNV_INIT	0xcbf29ce484222325ULL
+#define NI_LEASE_JOURNAL_FNV_PRIME	0x100000001b3ULL
+
+static uint64_t
+ni_lease_journal_fnv(uint64_t hash, const void *data, size_t len)
+{
+	const unsigned char *p = data;
+
+	while (len--) {
+		hash ^= *p++;
+		hash *= NI_LEASE_JOURNAL_FNV_PRIME;
+	}
+	return hash;
+}
+
+static uint64_t
+ni_lease_journal_rec_check(const ni_lease_journal_rec_t *rec, const char *name, const char *data)
+{
+	ni_lease_journal_rec_t tmp = *rec;
+	uint64_t check;
+
+	tmp.check = 0;
+	check = ni_lease_journal_fnv(NI_LEASE_JOURNAL_FNV_INIT, &tmp, sizeof(tmp));
+	check = ni_lease_journal_fnv(check, name, rec->namelen);
+	return ni_lease_journal_fnv(check, data, rec->datalen);
+}
+
+/*
+ * In-memory index of the live records, hashed by interface name
+ * using open addressing with linear probing.
+ */
+static unsigned int
+ni_lease_journal_index_slot(const ni_lease_journal_t *journal, const char *ifname)
+{
+	uint64_t hash = ni_lease_journal_fnv(NI_LEASE_JOURNAL_FNV_INIT, ifname, strlen(ifname));
+
+	return (unsigned int)hash & (journal->index_size - 1);
+}
+
+static void
+ni_lease_journal_index_rebuild(ni_lease_journal_t *journal)
+{
+	unsigned int i, slot, mask;
+
+	free(journal->index);
+	journal->index_size = 2 * NI_LEASE_JOURNAL_ENTRY_CHUNK;
+	while (journal->index_size <= 2 * journal->count)
+		journal->index_size <<= 1;
+	journal->index = xcalloc(journal->index_size, sizeof(journal->index[0]));
+
+	mask = journal->index_size - 1;
+	for (i = 0; i < journal->count; ++i) {
+		slot = ni_lease_journal_index_slot(journal, journal->entries[i].ifname);
+		while (journal->index[slot])
+			slot = (slot + 1) & mask;
+		journal->index[slot] = i + 1;
+	}
+}
+
+static ni_lease_journal_entry_t *
+ni_lease_journal_entry_find(ni_lease_journal_t *journal, const char *ifname)
+{
+	ni_lease_journal_entry_t *entry;
+	unsigned int slot, mask;
+
+	if (!journal->count)
+		return NULL;
+
+	mask = journal->index_size - 1;
+	slot = ni_lease_journal_index_slot(journal, ifname);
+	while (journal->index[slot]) {
+		entry = &journal->entries[journal->index[slot] - 1];
+		if (ni_string_eq(entry->ifname, ifname))
+			return entry;
+		slot = (slot + 1) & mask;
+	}
+	return NULL;
+}
+
+static void
+ni_lease_journal_entry_set(ni_lease_journal_t *journal, const char *ifname,
+			uint64_t hash, off_t offset, size_t size, const char *stamp)
+{
+	ni_lease_journal_entry_t *entry;
+	unsigned int slot, mask;
+
+	if ((entry = ni_lease_journal_entry_find(journal, ifname))) {
+		journal->live -= entry->size + entry->stamp_size;
+	} else {
+		if ((journal->count % NI_LEASE_JOURNAL_ENTRY_CHUNK) == 0) {
+			journal->entries = xrealloc(journal->entries,
+					(journal->count + NI_LEASE_JOURNAL_ENTRY_CHUNK) *
+					sizeof(journal->entries[0]));
+		}
+		entry = &journal->entries[journal->count++];
+		memset(entry, 0, sizeof(*entry));
+		entry->ifname = xstrdup(ifname);
+
+		if (journal->index_size <= 2 * journal->count) {
+			ni_lease_journal_index_rebuild(journal);
+		} else {
+			mask = journal->index_size - 1;
+			slot = ni_lease_journal_index_slot(journal, ifname);
+			while (journal->index[slot])
+				slot = (slot + 1) & mask;
+			journal->index[slot] = journal->count;
+		}
+	}
+	entry->hash = hash;
+	entry->offset = offset;
+	entry->size = size;
+	ni_string_dup(&entry->stamp, stamp);
+	entry->stamp_offset = 0;
+	entry->stamp_size = 0;
+	journal->live += size;
+}
+
+static void
+ni_lease_journal_entry_stamp(ni_lease_journal_t *journal, const char *ifname,
+			uint64_t hash, off_t offset, size_t size,
+			const char *stamp, size_t len)
+{
+	ni_lease_journal_entry_t *entry;
+
+	/* a stamp of another (older) lease content is obsolete */
+	entry = ni_lease_journal_entry_find(journal, ifname);
+	if (!entry || entry->hash != hash)
+		return;
+
+	journal->live -= entry->stamp_size;
+	free(entry->stamp);
+	entry->stamp = xmalloc(len + 1);
+	memcpy(entry->stamp, stamp, len);
+	entry->stamp[len] = '\0';
+	entry->stamp_offset = offset;
+	entry->stamp_size = size;
+	journal->live += size;
+}
+
+static void
+ni_lease_journal_entry_drop(ni_lease_journal_t *journal, const char *ifname)
+{
+	ni_lease_journal_entry_t *entry;
+	unsigned int pos, slot, next, home, mask;
+
+	if (!(entry = ni_lease_journal_entry_find(journal, ifname)))
+		return;
+
+	/* remove the index slot, shifting back the following probe chain */
+	mask = journal->index_size - 1;
+	pos = entry - journal->entries;
+	slot = ni_lease_journal_index_slot(journal, ifname);
+	while (journal->index[slot] != pos + 1)
+		slot = (slot + 1) & mask;
+	for (next = (slot + 1) & mask; journal->index[next]; next = (next + 1) & mask) {
+		home = ni_lease_journal_index_slot(journal,
+				journal->entries[journal->index[next] - 1].ifname);
+		if (slot <= next ? (slot < home && home <= next) : (slot < home || home <= next))
+			continue;
+		journal->index[slot] = journal->index[next];
+		slot = next;
+	}
+	journal->index[slot] = 0;
+
+	journal->live -= entry->size + entry->stamp_size;
+	free(entry->ifname);
+	free(entry->stamp);
+	journal->count--;
+	if (pos == journal->count)
+		return;
+
+	/* move the last entry into the hole and repoint its slot */
+	journal->entries[pos] = journal->entries[journal->count];
+	slot = ni_lease_journal_index_slot(journal, journal->entries[pos].ifname);
+	while (journal->index[slot] != journal->count + 1)
+		slot = (slot + 1) & mask;
+	journal->index[slot] = pos + 1;
+}
+
+static void
+ni_lease_journal_entries_clear(ni_lease_journal_t *journal)
+{
+	while (journal->count) {
+		journal->count--;
+		free(journal->entries[journal->count].ifname);
+		free(journal->entries[journal->count].stamp);
+	}
+	if (journal->index)
+		memset(journal->index, 0, journal->index_size * sizeof(journal->index[0]));
+	journal->live = sizeof(ni_lease_journal_hdr_t);
+	journal->size = 0;
+}
+
+static ni_bool_t
+ni_lease_journal_hdr_valid(const ni_lease_journal_t *journal)
+{
+	ni_lease_journal_hdr_t hdr;
+
+	return pread(journal->fd, &hdr, sizeof(hdr), 0) == sizeof(hdr) &&
+		hdr.magic == NI_LEASE_JOURNAL_MAGIC &&
+		hdr.version == NI_LEASE_JOURNAL_VERSION;
+}
+
+/*
+ * Scan the records from the current end of the valid data; this
+ * picks up records appended by another process as well.
+ */
+static int
+ni_lease_journal_scan(ni_lease_journal_t *journal, off_t end)
+{
+	char name[NI_LEASE_JOURNAL_NAME_MAX + 1];
+	ni_lease_journal_rec_t rec;
+	char *buf, *ptr;
+	off_t pos, len;
+
+	if (journal->size == 0) {
+		if (end == 0)
+			return 0;
+
+		if (!ni_lease_journal_hdr_valid(journal)) {
+			ni_warn("%s: not a valid lease journal", journal->path);
+			return -1;
+		}
+		journal->size = sizeof(ni_lease_journal_hdr_t);
+	}
+
+	if (end <= journal->size)
+		return 0;
+
+	len = end - journal->size;
+	buf = xmalloc(len);
+	if (pread(journal->fd, buf, len, journal->size) != len) {
+		ni_error("%s: unable to read lease journal: %m", journal->path);
+		free(buf);
+		return -1;
+	}
+
+	for (pos = 0, ptr = buf; pos + (off_t)sizeof(rec) <= len; ) {
+		size_t size;
+
+		memcpy(&rec, ptr, sizeof(rec));
+		if (rec.magic != NI_LEASE_JOURNAL_REC_MAGIC || !rec.namelen ||
+		    rec.namelen > NI_LEASE_JOURNAL_NAME_MAX ||
+		    rec.datalen > NI_LEASE_JOURNAL_DATA_MAX)
+			break;
+
+		size = sizeof(rec) + rec.namelen + rec.datalen;
+		if (pos + (off_t)size > len)
+			break;
+
+		if (rec.check != ni_lease_journal_rec_check(&rec, ptr + sizeof(rec),
+							ptr + sizeof(rec) + rec.namelen))
+			break;
+
+		memcpy(name, ptr + sizeof(rec), rec.namelen);
+		name[rec.namelen] = '\0';
+
+		switch (rec.tag) {
+		case NI_LEASE_JOURNAL_PUT:
+			ni_lease_journal_entry_set(journal, name, rec.hash,
+					journal->size + pos, size, NULL);
+			break;
+		case NI_LEASE_JOURNAL_DEL:
+			ni_lease_journal_entry_drop(journal, name);
+			break;
+		case NI_LEASE_JOURNAL_STAMP:
+			ni_lease_journal_entry_stamp(journal, name, rec.hash,
+					journal->size + pos, size,
+					ptr + sizeof(rec) + rec.namelen, rec.datalen);
+			break;
+		default:
+			break;
+		}
+		pos += size;
+		ptr += size;
+	}
+	free(buf);
+
+	journal->size += pos;
+	if (pos < len) {
+		ni_debug_dhcp("%s: ignoring %lu bytes of incomplete records",
+				journal->path, (unsigned long)(len - pos));
+	}
+	return 0;
+}
+
+/*
+ * Move a journal with an invalid header or of another version aside,
+ * unless another writer did it already while we waited for the lock.
+ */
+static int
+ni_lease_journal_move_aside(ni_lease_journal_t *journal)
+{
+	char *broken = NULL;
+	struct stat st;
+	int ret = 0;
+
+	if (flock(journal->fd, LOCK_EX) < 0)
+		return -1;
+
+	if (stat(journal->path, &st) == 0 &&
+	    st.st_dev == journal->dev && st.st_ino == journal->ino &&
+	    !ni_lease_journal_hdr_valid(journal)) {
+		ni_string_printf(&broken, "%s%s", journal->path,
+				NI_LEASE_JOURNAL_BROKEN_SUFFIX);
+		if (rename(journal->path, broken) < 0) {
+			ni_error("%s: unable to move invalid lease journal aside: %m",
+					journal->path);
+			ret = -1;
+		} else {
+			ni_warn("%s: not a valid lease journal, moved to %s",
+					journal->path, broken);
+		}
+		ni_string_free(&broken);
+	}
+
+	flock(journal->fd, LOCK_UN);
+	close(journal->fd);
+	journal->fd = -1;
+	return ret;
+}
+
+/*
+ * (Re)open the journal file, e.g. after another process compacted it
+ */
+static int
+ni_lease_journal_reopen(ni_lease_journal_t *journal)
+{
+	ni_lease_journal_hdr_t hdr;
+	unsigned int retry;
+	struct stat st;
+	int flags;
+
+	if (journal->fd >= 0)
+		close(journal->fd);
+	journal->fd = -1;
+	ni_lease_journal_entries_clear(journal);
+
+	flags = O_CLOEXEC | (journal->writable ? O_RDWR | O_CREAT : O_RDONLY);
+	for (retry = 0; ; ++retry) {
+		if ((journal->fd = open(journal->path, flags, 0600)) < 0)
+			return -1;
+
+		if (fstat(journal->fd, &st) < 0) {
+			close(journal->fd);
+			journal->fd = -1;
+			return -1;
+		}
+		journal->dev = st.st_dev;
+		journal->ino = st.st_ino;
+
+		if (st.st_size == 0 && journal->writable) {
+			hdr.magic = NI_LEASE_JOURNAL_MAGIC;
+			hdr.version = NI_LEASE_JOURNAL_VERSION;
+			if (pwrite(journal->fd, &hdr, sizeof(hdr), 0) != sizeof(hdr)) {
+				ni_error("%s: unable to initialize lease journal: %m", journal->path);
+				close(journal->fd);
+				journal->fd = -1;
+				return -1;
+			}
+			journal->size = sizeof(hdr);
+			return 0;
+		}
+
+		/* readers leave an invalid journal to the next writer */
+		if (!journal->writable || retry >= 3 || st.st_size == 0 ||
+		    ni_lease_journal_hdr_valid(journal))
+			return ni_lease_journal_scan(journal, st.st_size);
+
+		if (ni_lease_journal_move_aside(journal) < 0)
+			return -1;
+	}
+}
+
+/*
+ * Pick up changes made by other processes since the last access
+ */
+static int
+ni_lease_journal_refresh(ni_lease_journal_t *journal)
+{
+	struct stat st;
+
+	if (journal->fd < 0 || stat(journal->path, &st) < 0 ||
+	    st.st_dev != journal->dev || st.st_ino != journal->ino)
+		return ni_lease_journal_reopen(journal);
+
+	if (st.st_size > journal->size)
+		return ni_lease_journal_scan(journal, st.st_size);
+
+	return 0;
+}
+
+static int
+ni_lease_journal_lock(ni_lease_journal_t *journal)
+{
+	unsigned int retry;
+	struct stat st;
+
+	/* a compaction may replace the file while we wait for the lock */
+	for (retry = 0; retry < 3; ++retry) {
+		if (ni_lease_journal_refresh(journal) < 0)
+			return -1;
+
+		if (flock(journal->fd, LOCK_EX) < 0)
+			return -1;
+
+		if (stat(journal->path, &st) == 0 &&
+		    st.st_dev == journal->dev && st.st_ino == journal->ino) {
+			/* pick up appends of other writers, drop torn ones */
+			if (st.st_size > journal->size &&
+			    ni_lease_journal_scan(journal, st.st_size) < 0)
+				break;
+			if (st.st_size > journal->size &&
+			    ftruncate(journal->fd, journal->size) < 0)
+				break;
+			return 0;
+		}
+		flock(journal->fd, LOCK_UN);
+	}
+	flock(journal->fd, LOCK_UN);
+	return -1;
+}
+
+static void
+ni_lease_journal_unlock(ni_lease_journal_t *journal)
+{
+	if (journal->fd >= 0)
+		flock(journal->fd, LOCK_UN);
+}
+
+/*
+ * Bounded flush policy: records are synced to disk after at most
+ * NI_LEASE_JOURNAL_SYNC_DELAY msec or NI_LEASE_JOURNAL_SYNC_COUNT
+ * records, whatever comes first.
+ */
+static int
+ni_lease_journal_sync(ni_lease_journal_t *journal)
+{
+	if (!journal || journal->fd < 0)
+		return -1;
+
+	if (journal->timer) {
+		ni_timer_cancel(journal->timer);
+		journal->timer = NULL;
+	}
+
+	ni_timer_get_time(&journal->synced);
+	if (!journal->pending)
+		return 0;
+
+	journal->pending = 0;
+	if (fdatasync(journal->fd) < 0) {
+		ni_error("%s: unable to sync lease journal: %m", journal->path);
+		return -1;
+	}
+	return 0;
+}
+
+static void
+ni_lease_journal_sync_timeout(void *user_data, const ni_timer_t *timer)
+{
+	ni_lease_journal_t *journal = user_data;
+
+	if (journal->timer != timer)
+		return;
+
+	journal->timer = NULL;
+	ni_lease_journal_sync(journal);
+}
+
+static void
+ni_lease_journal_sync_maybe(ni_lease_journal_t *journal)
+{
+	struct timeval now, delta;
+
+	journal->pending++;
+	ni_timer_get_time(&now);
+	timersub(&now, &journal->synced, &delta);
+
+	if (journal->pending >= NI_LEASE_JOURNAL_SYNC_COUNT ||
+	    delta.tv_sec * 1000 + delta.tv_usec / 1000 >= NI_LEASE_JOURNAL_SYNC_DELAY) {
+		ni_lease_journal_sync(journal);
+	} else if (!journal->timer) {
+		journal->timer = ni_timer_register(NI_LEASE_JOURNAL_SYNC_DELAY,
+						ni_lease_journal_sync_timeout, journal);
+	}
+}
+
+static int
+ni_lease_journal_copy(ni_lease_journal_t *journal, int fd, char **buf, off_t offset, size_t size)
+{
+	*buf = xrealloc(*buf, size);
+	if (pread(journal->fd, *buf, size, offset) != (ssize_t)size ||
+	    write(fd, *buf, size) != (ssize_t)size)
+		return -1;
+	return 0;
+}
+
+/*
+ * Rewrite the live records into a new file replacing the journal;
+ * the caller holds the lock.
+ */
+static int
+ni_lease_journal_compact_locked(ni_lease_journal_t *journal)
+{
+	char tempname[PATH_MAX];
+	ni_lease_journal_hdr_t hdr;
+	ni_lease_journal_entry_t *entries = NULL;
+	off_t offset;
+	unsigned int i;
+	char *buf = NULL;
+	struct stat st;
+	int fd;
+
+	snprintf(tempname, sizeof(tempname), "%s.XXXXXX", journal->path);
+	if ((fd = mkstemp(tempname)) < 0) {
+		ni_error("%s: unable to create temporary journal: %m", journal->path);
+		return -1;
+	}
+
+	hdr.magic = NI_LEASE_JOURNAL_MAGIC;
+	hdr.version = NI_LEASE_JOURNAL_VERSION;
+	if (write(fd, &hdr, sizeof(hdr)) != sizeof(hdr))
+		goto failed;
+
+	if (journal->count)
+		entries = xcalloc(journal->count, sizeof(entries[0]));
+
+	offset = sizeof(hdr);
+	for (i = 0; i < journal->count; ++i) {
+		const ni_lease_journal_entry_t *entry = &journal->entries[i];
+
+		if (ni_lease_journal_copy(journal, fd, &buf, entry->offset, entry->size) < 0)
+			goto failed;
+		entries[i].offset = offset;
+		offset += entry->size;
+
+		if (!entry->stamp_size)
+			continue;
+		if (ni_lease_journal_copy(journal, fd, &buf, entry->stamp_offset,
+						entry->stamp_size) < 0)
+			goto failed;
+		entries[i].stamp_offset = offset;
+		offset += entry->stamp_size;
+	}
+
+	if (fdatasync(fd) < 0 || fstat(fd, &st) < 0 || rename(tempname, journal->path) < 0)
+		goto failed;
+
+	ni_debug_dhcp("%s: compacted lease journal from %lu to %lu bytes",
+			journal->path, (unsigned long)journal->size,
+			(unsigned long)offset);
+
+	/* keep the lock on the replaced file until we're done */
+	flock(fd, LOCK_EX);
+	close(journal->fd);
+	journal->fd = fd;
+	journal->dev = st.st_dev;
+	journal->ino = st.st_ino;
+	journal->size = offset;
+	journal->live = offset;
+	for (i = 0; i < journal->count; ++i) {
+		journal->entries[i].offset = entries[i].offset;
+		journal->entries[i].stamp_offset = entries[i].stamp_offset;
+	}
+	journal->pending = 0;
+
+	free(entries);
+	free(buf);
+	return 0;
+
+failed:
+	ni_error("%s: unable to compact lease journal: %m", journal->path);
+	close(fd);
+	unlink(tempname);
+	free(entries);
+	free(buf);
+	return -1;
+}
+
+static void
+ni_lease_journal_compact_maybe(ni_lease_journal_t *journal)
+{
+	if (journal->size < NI_LEASE_JOURNAL_COMPACT_MIN || journal->size < 2 * journal->live)
+		return;
+
+	ni_lease_journal_compact_locked(journal);
+}
+
+/*
+ * Append a record; the caller holds the lock
+ */
+static int
+ni_lease_journal_append(ni_lease_journal_t *journal, unsigned int tag, const char *ifname,
+			const char *data, size_t len, uint64_t hash, const char *stamp)
+{
+	ni_lease_journal_rec_t rec;
+	size_t namelen = strlen(ifname);
+	size_t size;
+	char *buf;
+	ssize_t ret;
+
+	memset(&rec, 0, sizeof(rec));
+	rec.magic = NI_LEASE_JOURNAL_REC_MAGIC;
+	rec.tag = tag;
+	rec.namelen = namelen;
+	rec.datalen = len;
+	rec.hash = hash;
+	rec.check = ni_lease_journal_rec_check(&rec, ifname, data);
+
+	size = sizeof(rec) + namelen + len;
+	buf = xmalloc(size);
+	memcpy(buf, &rec, sizeof(rec));
+	memcpy(buf + sizeof(rec), ifname, namelen);
+	if (len)
+		memcpy(buf + sizeof(rec) + namelen, data, len);
+
+	/* one write per record, a torn one is dropped by the next scan */
+	ret = pwrite(journal->fd, buf, size, journal->size);
+	free(buf);
+	if (ret != (ssize_t)size) {
+		ni_error("%s: unable to append to lease journal: %m", journal->path);
+		if (ret > 0 && ftruncate(journal->fd, journal->size) < 0)
+			ni_error("%s: unable to truncate lease journal: %m", journal->path);
+		return -1;
+	}
+
+	switch (tag) {
+	case NI_LEASE_JOURNAL_PUT:
+		ni_lease_journal_entry_set(journal, ifname, hash, journal->size, size, stamp);
+		break;
+	case NI_LEASE_JOURNAL_DEL:
+		ni_lease_journal_entry_drop(journal, ifname);
+		break;
+	case NI_LEASE_JOURNAL_STAMP:
+		ni_lease_journal_entry_stamp(journal, ifname, hash, journal->size, size,
+						data, len);
+		break;
+	default:
+		break;
+	}
+	journal->size += size;
+
+	ni_lease_journal_sync_maybe(journal);
+	ni_lease_journal_compact_maybe(journal);
+	return 0;
+}
+
+/*
+ * Content hash of lease data; callers hash the data without the
+ * times which change on every renewal and pass them as stamp.
+ */
+uint64_t
+ni_lease_journal_hash(const char *data, size_t len)
+{
+	return ni_lease_journal_fnv(NI_LEASE_JOURNAL_FNV_INIT, data, len);
+}
+
+/*
+ * Store the lease data of an interface with the stamp of its times.
+ * Returns 1 when the content hash is unchanged: then only a changed
+ * stamp is appended in a small STAMP record, else nothing is written.
+ */
+int
+ni_lease_journal_put(ni_lease_journal_t *journal, const char *ifname,
+			const char *data, size_t len, uint64_t hash, const char *stamp)
+{
+	ni_lease_journal_entry_t *entry;
+	int ret;
+
+	if (!journal || !journal->writable || ni_string_empty(ifname) ||
+	    strlen(ifname) > NI_LEASE_JOURNAL_NAME_MAX || !data ||
+	    len > NI_LEASE_JOURNAL_DATA_MAX)
+		return -1;
+
+	if (ni_lease_journal_lock(journal) < 0) {
+		ni_error("%s: unable to lock lease journal: %m", journal->path);
+		return -1;
+	}
+
+	entry = ni_lease_journal_entry_find(journal, ifname);
+	if (!entry || entry->hash != hash) {
+		ret = ni_lease_journal_append(journal, NI_LEASE_JOURNAL_PUT,
+						ifname, data, len, hash, stamp);
+	} else
+	if (!ni_string_empty(stamp) && !ni_string_eq(entry->stamp, stamp)) {
+		ni_debug_dhcp("%s: %s lease unchanged, write coalesced to a stamp",
+				journal->path, ifname);
+		ret = ni_lease_journal_append(journal, NI_LEASE_JOURNAL_STAMP,
+						ifname, stamp, strlen(stamp), hash, stamp);
+		if (ret == 0)
+			ret = 1;
+	} else {
+		ni_debug_dhcp("%s: %s lease unchanged, write coalesced",
+				journal->path, ifname);
+		ret = 1;
+	}
+
+	ni_lease_journal_unlock(journal);
+	return ret;
+}
+
+int
+ni_lease_journal_del(ni_lease_journal_t *journal, const char *ifname)
+{
+	int ret = 0;
+
+	if (!journal || !journal->writable || ni_string_empty(ifname) ||
+	    strlen(ifname) > NI_LEASE_JOURNAL_NAME_MAX)
+		return -1;
+
+	if (ni_lease_journal_lock(journal) < 0) {
+		ni_error("%s: unable to lock lease journal: %m", journal->path);
+		return -1;
+	}
+
+	if (ni_lease_journal_entry_find(journal, ifname))
+		ret = ni_lease_journal_append(journal, NI_LEASE_JOURNAL_DEL,
+						ifname, NULL, 0, 0, NULL);
+
+	ni_lease_journal_unlock(journal);
+	return ret;
+}
+
+/*
+ * Return a copy of the current lease data of an interface and of
+ * the stamp of a later renewal, if any, to apply to the data.
+ */
+char *
+ni_lease_journal_get(ni_lease_journal_t *journal, const char *ifname, size_t *len,
+			char **stamp)
+{
+	ni_lease_journal_entry_t *entry;
+	ni_lease_journal_rec_t rec;
+	char *buf, *data;
+
+	if (!journal || ni_string_empty(ifname) || ni_lease_journal_refresh(journal) < 0)
+		return NULL;
+
+	if (!(entry = ni_lease_journal_entry_find(journal, ifname)))
+		return NULL;
+
+	buf = xmalloc(entry->size + 1);
+	if (pread(journal->fd, buf, entry->size, entry->offset) != (ssize_t)entry->size) {
+		ni_error("%s: unable to read lease journal: %m", journal->path);
+		free(buf);
+		return NULL;
+	}
+
+	memcpy(&rec, buf, sizeof(rec));
+	if (rec.check != ni_lease_journal_rec_check(&rec, buf + sizeof(rec),
+						buf + sizeof(rec) + rec.namelen)) {
+		ni_error("%s: %s lease record is corrupted", journal->path, ifname);
+		free(buf);
+		return NULL;
+	}
+
+	data = buf + sizeof(rec) + rec.namelen;
+	memmove(buf, data, rec.datalen);
+	buf[rec.datalen] = '\0';
+	if (len)
+		*len = rec.datalen;
+	if (stamp)
+		ni_string_dup(stamp, entry->stamp_size ? entry->stamp : NULL);
+	return buf;
+}
+
+ni_bool_t
+ni_lease_journal_has(ni_lease_journal_t *journal, const char *ifname)
+{
+	if (!journal || ni_string_empty(ifname) || ni_lease_journal_refresh(journal) < 0)
+		return FALSE;
+
+	return ni_lease_journal_entry_find(journal, ifname) != NULL;
+}
+
+const char *
+ni_lease_journal_path(const ni_lease_journal_t *journal)
+{
+	return journal ? journal->path : NULL;
+}
+
+/*
+ * Journals are opened once and kept for the life time of the process
+ */
+ni_lease_journal_t *
+ni_lease_journal_open(const char *dir, int type, int family, ni_bool_t create)
+{
+	const char *t = ni_addrconf_type_to_name(type);
+	const char *f = ni_addrfamily_type_to_name(family);
+	ni_lease_journal_t *journal;
+	char *path = NULL;
+
+	if (ni_string_empty(dir) || !t || !f)
+		return NULL;
+
+	ni_string_printf(&path, "%s/leases-%s-%s.journal", dir, t, f);
+	for (journal = ni_lease_journals; journal; journal = journal->next) {
+		if (ni_string_eq(journal->path, path))
+			break;
+	}
+
+	if (journal) {
+		ni_string_free(&path);
+		if (create && !journal->writable) {
+			journal->writable = TRUE;
+			if (ni_lease_journal_reopen(journal) < 0) {
+				journal->writable = FALSE;
+				return NULL;
+			}
+		}
+		return journal->fd >= 0 || ni_lease_journal_reopen(journal) == 0 ?
+			journal : NULL;
+	}
+
+	if (!create && !ni_file_exists(path)) {
+		ni_string_free(&path);
+		return NULL;
+	}
+
+	journal = xcalloc(1, sizeof(*journal));
+	journal->path = path;
+	journal->fd = -1;
+	journal->writable = create;
+	journal->live = sizeof(ni_lease_journal_hdr_t);
+
+	if (ni_lease_journal_reopen(journal) < 0) {
+		if (errno != ENOENT && errno != EROFS)
+			ni_error("%s: unable to open lease journal: %m", journal->path);
+		free(journal->entries);
+		free(journal->index);
+		ni_string_free(&journal->path);
+		free(journal);
+		return NULL;
+	}
+
+	ni_timer_get_time(&journal->synced);
+	journal->next = ni_lease_journals;
+	ni_lease_journals = journal;
+	return journal;
+}
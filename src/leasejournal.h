@@ -0,0 +1,41 @@
+/*
+ * Addrconf lease journal
+ *
+ * Copyright (C) 2026 SUSE LLC
+ */
+#ifndef   __WICKED_ADDRCONF_LEASEJOURNAL_H__
+#define   __WICKED_ADDRCONF_LEASEJOURNAL_H__
+
+#include <stdint.h>
+#include <wicked/types.h>
+
+/*
+ * Append-only lease store, one journal per lease type and family
+ * (and thus per writing supplicant) in a directory.
+ *
+ * Each record carries the interface name and the serialized lease
+ * with a content hash provided by the caller; a put with unchanged
+ * hash is coalesced, e.g. when only the renewal time has changed:
+ * the new times are then stored in a small stamp record only.
+ * Records are flushed to disk after a bounded delay or count and
+ * the journal is compacted once superseded records dominate it.
+ */
+typedef struct ni_lease_journal	ni_lease_journal_t;
+
+#define NI_LEASE_JOURNAL_SYNC_DELAY	1000	/* msec	*/
+#define NI_LEASE_JOURNAL_SYNC_COUNT	64	/* records */
+#define NI_LEASE_JOURNAL_COMPACT_MIN	65536	/* bytes */
+
+extern ni_lease_journal_t *	ni_lease_journal_open(const char *dir, int type, int family,
+							ni_bool_t create);
+extern uint64_t			ni_lease_journal_hash(const char *data, size_t len);
+extern int			ni_lease_journal_put(ni_lease_journal_t *, const char *ifname,
+							const char *data, size_t len, uint64_t hash,
+							const char *stamp);
+extern int			ni_lease_journal_del(ni_lease_journal_t *, const char *ifname);
+extern char *			ni_lease_journal_get(ni_lease_journal_t *, const char *ifname,
+							size_t *len, char **stamp);
+extern ni_bool_t		ni_lease_journal_has(ni_lease_journal_t *, const char *ifname);
+extern const char *		ni_lease_journal_path(const ni_lease_journal_t *);
+
+#endif /* __WICKED_ADDRCONF_LEASEJOURNAL_H__ */
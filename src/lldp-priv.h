@@ -44,3 +44,5 @@ enum ni_lldp_802_1_tlv {
 	NI_LLDP_IEEE_802_1_TLV_MAX
 
 };
+
+extern int		ni_lldp_pdu_parse(ni_lldp_t *, ni_buffer_t *);
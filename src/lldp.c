@@ -114,7 +114,6 @@ static void		ni_lldp_receive(ni_socket_t *);
 static ni_lldp_peer_t *	ni_lldp_peer_new(const void *raw_id, unsigned int raw_id_len);
 static void		ni_lldp_peer_unlink_and_free(ni_lldp_peer_t **);
 static int		ni_lldp_pdu_build(const ni_lldp_t *, ni_dcbx_state_t *, ni_buffer_t *);
-static int		ni_lldp_pdu_parse(ni_lldp_t *, ni_buffer_t *);
 static int		ni_lldp_pdu_get_raw_id(ni_buffer_t *, const void **, unsigned int *);
 
 static ni_lldp_ieee_802_1_t *ni_lldp_ieee_802_1_clone(const ni_lldp_ieee_802_1_t *);
@@ -1232,7 +1231,7 @@ ni_lldp_tlv_get_port_id(ni_lldp_t *lldp, ni_buffer_t *bp)
 	if ((subtype = ni_buffer_getc(bp)) < 0)
 		return -1;
 
-	lldp->chassis_id.type = subtype;
+	lldp->port_id.type = subtype;
 	switch (lldp->port_id.type) {
 	case NI_LLDP_PORT_ID_INTERFACE_ALIAS:
 	case NI_LLDP_PORT_ID_PORT_COMPONENT:
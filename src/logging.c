@@ -11,9 +11,13 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <strings.h>
 #include <syslog.h>
+#include <signal.h>
 #include <unistd.h>
+#include <errno.h>
 #include <sys/time.h>
+#include <sys/uio.h>
 #include <time.h>
 
 #include <wicked/logging.h>
@@ -34,8 +38,10 @@ static ni_bool_t	ni_debug_user_specified = FALSE;
 static unsigned int	ni_log_syslog;
 static const char *	ni_log_ident;
 static unsigned int	ni_log_opts;
+static ni_bool_t	ni_log_ring_active;
 
 static void		__ni_log_level_set(unsigned int level);
+static void		__ni_log_ring_setup(void);
 
 /*
  * debug options short text representation
@@ -306,6 +312,10 @@ ni_log_level_set(const char *name)
 void
 ni_log_close(void)
 {
+	if (ni_log_ring_active) {
+		ni_log_flush();
+		ni_log_ring_active = FALSE;
+	}
 	if (ni_log_syslog) {
 		closelog();
 	}
@@ -317,6 +327,7 @@ ni_log_close(void)
 void
 ni_log_reopen(void)
 {
+	ni_log_flush();
 	if (ni_log_syslog) {
 		closelog();
 		openlog(ni_log_ident, ni_log_opts, ni_log_syslog);
@@ -435,6 +446,20 @@ ni_log_destination_stderr(const char *progname, const char *args)
 	return TRUE;
 }
 
+static ni_bool_t
+ni_log_destination_ring(const char *progname, const char *args)
+{
+	ni_log_close();
+
+	ni_log_ident = progname;
+	if (!__ni_stderr_parse_args(args ? args : "", &ni_log_opts))
+		return FALSE;
+
+	__ni_log_ring_setup();
+	ni_log_ring_active = TRUE;
+	return TRUE;
+}
+
 ni_bool_t
 ni_log_destination(const char *progname, const char *destination)
 {
@@ -444,6 +469,7 @@ ni_log_destination(const char *progname, const char *destination)
 	} *dest, destination_map[] = {
 		{ "stderr", ni_log_destination_stderr },
 		{ "syslog", ni_log_destination_syslog },
+		{ "ring",   ni_log_destination_ring   },
 		{ NULL,     NULL                      }
 	};
 	const char *options = "";
@@ -455,6 +481,7 @@ ni_log_destination(const char *progname, const char *destination)
 	/*
 	 * stderr[:[options]]
 	 * syslog[:[facility]:[options]]
+	 * ring[:[options]]
 	 */
 	len = strcspn(destination, ":");
 	if (destination[len] == ':') {
@@ -469,7 +496,398 @@ ni_log_destination(const char *progname, const char *destination)
 	return FALSE;
 }
 
-static inline void
+/*
+ * Log ring: messages are formatted into a fixed size slot by the
+ * caller, while the (syscall) output is deferred and written in
+ * batches before the event loop blocks in poll, on errors and when
+ * the ring is full. Slots are reserved lock-free, as the resolver
+ * worker thread may log too.
+ *
+ * Debug messages are rate limited per facility; suppressed messages
+ * are kept in the ring (but not written out) for the crash dump of
+ * the last entries.
+ */
+#define NI_LOG_RING_SIZE	512		/* slots			*/
+#define NI_LOG_RING_MSGLEN	480		/* message incl. end and '\n'	*/
+#define NI_LOG_RING_BATCH	32		/* messages per writev		*/
+#define NI_LOG_RING_DUMP	64		/* messages in crash dump	*/
+#define NI_LOG_RATE_LIMIT	200		/* debug messages per facility and second */
+
+typedef struct ni_log_ring_entry {
+	volatile unsigned long	seq;		/* position + 1 once committed	*/
+	struct timeval		time;
+	const char *		tag;
+	ni_bool_t		suppressed;
+	unsigned int		len;
+	char			msg[NI_LOG_RING_MSGLEN];
+} ni_log_ring_entry_t;
+
+typedef struct ni_log_ring {
+	volatile unsigned long	head;		/* next position to reserve	*/
+	volatile unsigned long	tail;		/* next position to write out	*/
+	volatile int		flushing;
+	ni_log_ring_entry_t	entry[NI_LOG_RING_SIZE];
+} ni_log_ring_t;
+
+typedef struct ni_log_rate {
+	unsigned int		tokens;
+	unsigned int		dropped;
+	struct timeval		last;
+} ni_log_rate_t;
+
+static ni_log_ring_t *		ni_log_ring;
+static ni_log_rate_t		ni_log_rate[32];
+
+static const int		ni_log_crash_signals[] = {
+	SIGSEGV, SIGBUS, SIGILL, SIGFPE, SIGABRT
+};
+static struct sigaction		ni_log_crash_saved[sizeof(ni_log_crash_signals)/sizeof(int)];
+
+static void			__ni_log_stderr(const char *, const char *, va_list, const char *);
+
+static void
+__ni_log_crash_handler(int sig)
+{
+	unsigned int i;
+
+	ni_log_ring_dump(STDERR_FILENO, NI_LOG_RING_DUMP);
+
+	for (i = 0; i < sizeof(ni_log_crash_signals)/sizeof(int); ++i) {
+		if (ni_log_crash_signals[i] == sig)
+			sigaction(sig, &ni_log_crash_saved[i], NULL);
+	}
+	raise(sig);
+}
+
+static void
+__ni_log_ring_setup(void)
+{
+	struct sigaction sa;
+	unsigned int i;
+
+	if (ni_log_ring)
+		return;
+
+	ni_log_ring = xcalloc(1, sizeof(*ni_log_ring));
+	atexit(ni_log_flush);
+
+	memset(&sa, 0, sizeof(sa));
+	sa.sa_handler = __ni_log_crash_handler;
+	sigemptyset(&sa.sa_mask);
+	for (i = 0; i < sizeof(ni_log_crash_signals)/sizeof(int); ++i)
+		sigaction(ni_log_crash_signals[i], &sa, &ni_log_crash_saved[i]);
+}
+
+static ni_log_ring_entry_t *
+__ni_log_ring_reserve(ni_log_ring_t *ring, unsigned long *pos)
+{
+	unsigned long head;
+
+	do {
+		head = ring->head;
+		if (head - ring->tail >= NI_LOG_RING_SIZE)
+			return NULL;
+	} while (!__sync_bool_compare_and_swap(&ring->head, head, head + 1));
+
+	*pos = head;
+	return &ring->entry[head % NI_LOG_RING_SIZE];
+}
+
+static ni_bool_t
+__ni_log_rate_allow(unsigned int facility, const struct timeval *now, unsigned int *dropped)
+{
+	ni_log_rate_t *rate;
+	struct timeval delta;
+	unsigned long refill;
+
+	if (!facility)
+		return TRUE;
+
+	rate = &ni_log_rate[ffs(facility) - 1];
+	if (!timerisset(&rate->last) || timercmp(now, &rate->last, <)) {
+		rate->tokens = NI_LOG_RATE_LIMIT;
+		rate->last = *now;
+	} else {
+		timersub(now, &rate->last, &delta);
+		refill = delta.tv_sec * NI_LOG_RATE_LIMIT +
+			 delta.tv_usec / (1000000 / NI_LOG_RATE_LIMIT);
+		if (refill) {
+			rate->tokens = refill >= NI_LOG_RATE_LIMIT ? NI_LOG_RATE_LIMIT :
+					min_t(unsigned long, rate->tokens + refill, NI_LOG_RATE_LIMIT);
+			rate->last = *now;
+		}
+	}
+
+	if (!rate->tokens) {
+		rate->dropped++;
+		return FALSE;
+	}
+	rate->tokens--;
+	*dropped = rate->dropped;
+	rate->dropped = 0;
+	return TRUE;
+}
+
+static void			__ni_log_ring_printf(int, const char *, const char *, ...)
+							__attribute__ ((format (printf, 3, 4)));
+
+static void
+__ni_log_ring_put(int prio, unsigned int facility, const char *tag,
+			const char *fmt, va_list ap, const char *end)
+{
+	ni_log_ring_entry_t *entry;
+	unsigned int dropped = 0;
+	unsigned long pos;
+	struct timeval now;
+	ni_bool_t suppressed, truncated = FALSE;
+	size_t elen = strlen(end);
+	va_list cp;
+	int len;
+
+	gettimeofday(&now, NULL);
+	suppressed = !__ni_log_rate_allow(facility, &now, &dropped);
+	if (dropped) {
+		__ni_log_ring_printf(LOG_NOTICE, "Notice: ", "%u %s debug messages suppressed",
+				dropped, ni_debug_facility_to_name(1U << (ffs(facility) - 1)));
+	}
+
+	if (!(entry = __ni_log_ring_reserve(ni_log_ring, &pos))) {
+		ni_log_flush();
+		if (!(entry = __ni_log_ring_reserve(ni_log_ring, &pos))) {
+			/* another thread is writing the ring out */
+			if (!suppressed)
+				__ni_log_stderr(tag, fmt, ap, end);
+			return;
+		}
+	}
+
+	va_copy(cp, ap);
+	len = vsnprintf(entry->msg, sizeof(entry->msg), fmt, cp);
+	va_end(cp);
+	if (len < 0)
+		len = 0;
+	if ((size_t)len + elen + 1 > sizeof(entry->msg)) {
+		len = sizeof(entry->msg) - elen - 1;
+		truncated = TRUE;
+	}
+	memcpy(entry->msg + len, end, elen);
+	entry->msg[len + elen] = '\n';
+
+	entry->time = now;
+	entry->tag = tag;
+	entry->len = len + elen + 1;
+	/* keep a truncated copy for the dump, write out the full one */
+	entry->suppressed = suppressed || truncated;
+	__sync_synchronize();
+	entry->seq = pos + 1;
+
+	if (suppressed)
+		return;
+
+	if (truncated) {
+		ni_log_flush();
+		__ni_log_stderr(tag, fmt, ap, end);
+	} else if (prio <= LOG_ERR) {
+		ni_log_flush();
+	}
+}
+
+static void
+__ni_log_ring_printf(int prio, const char *tag, const char *fmt, ...)
+{
+	va_list ap;
+
+	va_start(ap, fmt);
+	__ni_log_ring_put(prio, 0, tag, fmt, ap, "");
+	va_end(ap);
+}
+
+static size_t
+__ni_log_ring_header(char *buf, size_t size, const struct timeval *tv, pid_t pid)
+{
+	static time_t sec = -1;
+	static char stamp[64], zone[32];
+	size_t len = 0;
+	int n = 0;
+
+	/* localtime is called once per second only */
+	if ((ni_log_opts & NI_LOG_TIME) && tv->tv_sec != sec) {
+		struct tm lt;
+		char tzsign;
+
+		localtime_r(&tv->tv_sec, &lt);
+		if (lt.tm_gmtoff < 0) {
+			lt.tm_gmtoff *= -1;
+			tzsign = '-';
+		} else {
+			tzsign = '+';
+		}
+		snprintf(stamp, sizeof(stamp), "%04d-%02d-%02dT%02d:%02d:%02d",
+				lt.tm_year + 1900, lt.tm_mon + 1, lt.tm_mday,
+				lt.tm_hour, lt.tm_min, lt.tm_sec);
+		snprintf(zone, sizeof(zone), "%c%02ld:%02ld", tzsign,
+				lt.tm_gmtoff/3600, (lt.tm_gmtoff%3600)/60);
+		sec = tv->tv_sec;
+	}
+	if (ni_log_opts & NI_LOG_TIME)
+		n = snprintf(buf, size, "%s.%06ld%s ", stamp, (long)tv->tv_usec, zone);
+	len = n < 0 ? 0 : min_t(size_t, n, size - 1);
+
+	if (ni_log_opts & NI_LOG_PID) {
+		if (ni_log_opts & NI_LOG_IDENT)
+			n = snprintf(buf + len, size - len, "%s[%d]: ", ni_log_ident, pid);
+		else
+			n = snprintf(buf + len, size - len, "[%d]: ", pid);
+	} else if (ni_log_opts & NI_LOG_IDENT) {
+		n = snprintf(buf + len, size - len, "%s: ", ni_log_ident);
+	} else {
+		n = 0;
+	}
+	len += n < 0 ? 0 : min_t(size_t, n, size - len - 1);
+	return len;
+}
+
+static void
+__ni_log_writev(int fd, struct iovec *iov, int cnt)
+{
+	ssize_t ret;
+
+	while (cnt > 0) {
+		ret = writev(fd, iov, cnt);
+		if (ret < 0) {
+			if (errno == EINTR)
+				continue;
+			return;
+		}
+		while (cnt > 0 && (size_t)ret >= iov->iov_len) {
+			ret -= iov->iov_len;
+			iov++;
+			cnt--;
+		}
+		if (cnt > 0) {
+			iov->iov_base = (char *)iov->iov_base + ret;
+			iov->iov_len -= ret;
+		}
+	}
+}
+
+/*
+ * Write out the pending ring messages
+ */
+void
+ni_log_flush(void)
+{
+	struct iovec iov[NI_LOG_RING_BATCH * 3];
+	char hdr[NI_LOG_RING_BATCH][128];
+	ni_log_ring_t *ring = ni_log_ring;
+	ni_log_ring_entry_t *entry;
+	unsigned long tail;
+	unsigned int cnt;
+	int n, err;
+	pid_t pid;
+
+	if (!ring || ring->tail == ring->head)
+		return;
+	if (__sync_lock_test_and_set(&ring->flushing, 1))
+		return;
+
+	err = errno;
+	pid = getpid();
+	tail = ring->tail;
+	do {
+		for (n = 0, cnt = 0; cnt < NI_LOG_RING_BATCH; ++cnt) {
+			entry = &ring->entry[(tail + cnt) % NI_LOG_RING_SIZE];
+			if (entry->seq != tail + cnt + 1)
+				break;
+			__sync_synchronize();
+			if (entry->suppressed)
+				continue;
+
+			iov[n].iov_base = hdr[cnt];
+			iov[n].iov_len  = __ni_log_ring_header(hdr[cnt], sizeof(hdr[cnt]),
+								&entry->time, pid);
+			n++;
+			iov[n].iov_base = (char *)entry->tag;
+			iov[n].iov_len  = strlen(entry->tag);
+			n++;
+			iov[n].iov_base = entry->msg;
+			iov[n].iov_len  = entry->len;
+			n++;
+		}
+		if (n)
+			__ni_log_writev(STDERR_FILENO, iov, n);
+
+		tail += cnt;
+		__sync_synchronize();
+		ring->tail = tail;
+	} while (cnt == NI_LOG_RING_BATCH);
+
+	__sync_lock_release(&ring->flushing);
+	errno = err;
+}
+
+static size_t
+__ni_log_dump_ulong(char *buf, unsigned long val, unsigned int width)
+{
+	char tmp[24];
+	size_t len = 0, i;
+
+	do {
+		tmp[len++] = '0' + val % 10;
+		val /= 10;
+	} while (val || len < width);
+
+	for (i = 0; i < len; ++i)
+		buf[i] = tmp[len - i - 1];
+	return len;
+}
+
+/*
+ * Dump the last (written and suppressed) ring messages; async signal safe.
+ */
+void
+ni_log_ring_dump(int fd, unsigned int count)
+{
+	static const char title[] = "--- last log messages ---\n";
+	ni_log_ring_t *ring = ni_log_ring;
+	ni_log_ring_entry_t *entry;
+	unsigned long pos, head;
+	struct iovec iov[3];
+	char stamp[48];
+	size_t len;
+
+	if (!ring || fd < 0)
+		return;
+
+	head = ring->head;
+	count = min_t(unsigned int, count, NI_LOG_RING_SIZE);
+	pos = head > count ? head - count : 0;
+
+	iov[0].iov_base = (char *)title;
+	iov[0].iov_len  = sizeof(title) - 1;
+	__ni_log_writev(fd, iov, 1);
+
+	for ( ; pos != head; ++pos) {
+		entry = &ring->entry[pos % NI_LOG_RING_SIZE];
+		if (entry->seq != pos + 1)
+			continue;
+
+		len = __ni_log_dump_ulong(stamp, entry->time.tv_sec, 1);
+		stamp[len++] = '.';
+		len += __ni_log_dump_ulong(stamp + len, entry->time.tv_usec, 6);
+		stamp[len++] = ' ';
+
+		iov[0].iov_base = stamp;
+		iov[0].iov_len  = len;
+		iov[1].iov_base = (char *)entry->tag;
+		iov[1].iov_len  = strlen(entry->tag);
+		iov[2].iov_base = entry->msg;
+		iov[2].iov_len  = entry->len;
+		__ni_log_writev(fd, iov, 3);
+	}
+}
+
+static void
 __ni_log_stderr(const char *tag, const char *fmt, va_list ap, const char *end)
 {
 	/* rfc5424 / rfc3339 timestamp with ms precision, e.g.:
@@ -508,6 +926,19 @@ __ni_log_stderr(const char *tag, const char *fmt, va_list ap, const char *end)
 	fprintf(stderr, "%s\n", end);
 }
 
+static inline void
+__ni_log_vmsg(int prio, unsigned int facility, const char *tag,
+		const char *fmt, va_list ap, const char *end)
+{
+	if (ni_log_ring_active) {
+		__ni_log_ring_put(prio, facility, tag, fmt, ap, end);
+	} else if (!ni_log_syslog) {
+		__ni_log_stderr(tag, fmt, ap, end);
+	} else {
+		vsyslog(prio, fmt, ap);
+	}
+}
+
 void
 ni_info(const char *fmt, ...)
 {
@@ -517,11 +948,7 @@ ni_info(const char *fmt, ...)
 		return;
 
 	va_start(ap, fmt);
-	if (!ni_log_syslog) {
-		__ni_log_stderr("Info: ", fmt, ap, "");
-	} else {
-		vsyslog(LOG_INFO, fmt, ap);
-	}
+	__ni_log_vmsg(LOG_INFO, 0, "Info: ", fmt, ap, "");
 	va_end(ap);
 }
 
@@ -534,11 +961,7 @@ ni_note(const char *fmt, ...)
 		return;
 
 	va_start(ap, fmt);
-	if (!ni_log_syslog) {
-		__ni_log_stderr("Notice: ", fmt, ap, "");
-	} else {
-		vsyslog(LOG_NOTICE, fmt, ap);
-	}
+	__ni_log_vmsg(LOG_NOTICE, 0, "Notice: ", fmt, ap, "");
 	va_end(ap);
 }
 
@@ -551,11 +974,7 @@ ni_warn(const char *fmt, ...)
 		return;
 
 	va_start(ap, fmt);
-	if (!ni_log_syslog) {
-		__ni_log_stderr("Warning: ", fmt, ap, "");
-	} else {
-		vsyslog(LOG_WARNING, fmt, ap);
-	}
+	__ni_log_vmsg(LOG_WARNING, 0, "Warning: ", fmt, ap, "");
 	va_end(ap);
 }
 
@@ -565,11 +984,7 @@ ni_error(const char *fmt, ...)
 	va_list ap;
 
 	va_start(ap, fmt);
-	if (!ni_log_syslog) {
-		__ni_log_stderr("Error: ", fmt, ap, "");
-	} else {
-		vsyslog(LOG_ERR, fmt, ap);
-	}
+	__ni_log_vmsg(LOG_ERR, 0, "Error: ", fmt, ap, "");
 	va_end(ap);
 }
 
@@ -583,11 +998,7 @@ ni_error_extra(const char *fmt, ...)
 	va_list ap;
 
 	va_start(ap, fmt);
-	if (!ni_log_syslog) {
-		__ni_log_stderr("       ", fmt, ap, "");
-	} else {
-		vsyslog(LOG_ERR, fmt, ap);
-	}
+	__ni_log_vmsg(LOG_ERR, 0, "       ", fmt, ap, "");
 	va_end(ap);
 }
 
@@ -600,11 +1011,23 @@ ni_trace(const char *fmt, ...)
 		return;
 
 	va_start(ap, fmt);
-	if (!ni_log_syslog) {
-		__ni_log_stderr("::: ", fmt, ap, "");
-	} else {
-		vsyslog(LOG_DEBUG, fmt, ap);
-	}
+	__ni_log_vmsg(LOG_DEBUG, 0, "::: ", fmt, ap, "");
+	va_end(ap);
+}
+
+/*
+ * ni_trace variant used by the ni_debug_* macros, rate limited in the log ring
+ */
+void
+__ni_trace(unsigned int facility, const char *fmt, ...)
+{
+	va_list ap;
+
+	if (ni_log_level < NI_LOG_DEBUG)
+		return;
+
+	va_start(ap, fmt);
+	__ni_log_vmsg(LOG_DEBUG, facility, "::: ", fmt, ap, "");
 	va_end(ap);
 }
 
@@ -614,13 +1037,8 @@ ni_fatal(const char *fmt, ...)
 	va_list ap;
 
 	va_start(ap, fmt);
-	if (!ni_log_syslog) {
-		__ni_log_stderr("FATAL ERROR: *** ", fmt, ap, " ***");
-	} else {
-		vsyslog(LOG_CRIT, fmt, ap);
-	}
+	__ni_log_vmsg(LOG_CRIT, 0, "FATAL ERROR: *** ", fmt, ap, " ***");
 	va_end(ap);
 
 	exit(1);
 }
-
@@ -0,0 +1,213 @@
+/*
+ * Built-in latency histograms and counters
+ *
+ * Copyright (C) 2026 SUSE LLC
+ */
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <string.h>
+#include <time.h>
+
+#include <wicked/util.h>
+#include <wicked/metrics.h>
+
+/*
+ * Log-linear (HDR style) buckets: values below 4 usec have a bucket
+ * each, above every power of 2 is split into 4 linear sub-buckets,
+ * so the bucket bounds are within 25% of the recorded values.
+ */
+#define NI_METRIC_SUB_BITS	2
+#define NI_METRIC_SUB_COUNT	(1U << NI_METRIC_SUB_BITS)
+#define NI_METRIC_MSB_MAX	40		/* ~12 days in usec */
+#define NI_METRIC_BUCKETS	(NI_METRIC_MSB_MAX * NI_METRIC_SUB_COUNT)
+
+typedef struct ni_metric {
+	uint64_t		count;
+	uint64_t		sum;
+	uint64_t		max;
+	uint64_t		bucket[NI_METRIC_BUCKETS];
+} ni_metric_t;
+
+static const struct {
+	const char *		name;
+	const char *		description;
+	ni_bool_t		histogram;
+} ni_metric_map[NI_METRIC_MAX] = {
+	[NI_METRIC_SOCKET_DISPATCH]	= { "socket-dispatch",
+		"Socket event processing per main loop wakeup",		TRUE	},
+	[NI_METRIC_TIMER_LAG]		= { "timer-lag",
+		"Delay of timer callbacks behind their expiry",		TRUE	},
+	[NI_METRIC_NETLINK_DUMP]	= { "netlink-dump",
+		"Duration of rtnetlink dump requests",			TRUE	},
+	[NI_METRIC_NETLINK_EVENT]	= { "netlink-event",
+		"Processing of rtnetlink event messages",		TRUE	},
+	[NI_METRIC_DBUS_METHOD]		= { "dbus-method",
+		"Dispatch of incoming DBus method calls",		TRUE	},
+	[NI_METRIC_DBUS_CALL]		= { "dbus-call",
+		"Round trip of outgoing DBus method calls",		TRUE	},
+	[NI_METRIC_FSM_STEP]		= { "fsm-step",
+		"Interface worker state transition calls",		TRUE	},
+	[NI_METRIC_DHCP4_EXCHANGE]	= { "dhcp4-exchange",
+		"DHCPv4 transaction start to server reply",		TRUE	},
+	[NI_METRIC_DHCP6_EXCHANGE]	= { "dhcp6-exchange",
+		"DHCPv6 transaction start to server reply",		TRUE	},
+
+	[NI_METRIC_NETLINK_DUMP_INTR]	= { "netlink-dump-interrupted",
+		"Restarted (interrupted) rtnetlink dumps",		FALSE	},
+	[NI_METRIC_DBUS_METHOD_FAILED]	= { "dbus-method-failed",
+		"Incoming DBus method calls returning an error",	FALSE	},
+	[NI_METRIC_DBUS_CALL_FAILED]	= { "dbus-call-failed",
+		"Outgoing DBus method calls failed",			FALSE	},
+};
+
+static ni_metric_t		ni_metrics[NI_METRIC_MAX];
+
+const char *
+ni_metric_name(ni_metric_id_t id)
+{
+	return id < NI_METRIC_MAX ? ni_metric_map[id].name : NULL;
+}
+
+const char *
+ni_metric_description(ni_metric_id_t id)
+{
+	return id < NI_METRIC_MAX ? ni_metric_map[id].description : NULL;
+}
+
+ni_bool_t
+ni_metric_is_histogram(ni_metric_id_t id)
+{
+	return id < NI_METRIC_MAX && ni_metric_map[id].histogram;
+}
+
+static inline unsigned int
+ni_metric_bucket_index(uint64_t value)
+{
+	unsigned int msb;
+
+	if (value < NI_METRIC_SUB_COUNT)
+		return value;
+
+	msb = 63 - __builtin_clzll(value);
+	if (msb >= NI_METRIC_MSB_MAX)
+		return NI_METRIC_BUCKETS - 1;
+
+	return (msb - NI_METRIC_SUB_BITS + 1) * NI_METRIC_SUB_COUNT +
+		((value >> (msb - NI_METRIC_SUB_BITS)) & (NI_METRIC_SUB_COUNT - 1));
+}
+
+static inline uint64_t
+ni_metric_bucket_bound(unsigned int index)
+{
+	unsigned int shift, sub;
+
+	if (index < NI_METRIC_SUB_COUNT)
+		return index;
+
+	shift = index / NI_METRIC_SUB_COUNT - 1;
+	sub   = index % NI_METRIC_SUB_COUNT;
+	return ((uint64_t)(NI_METRIC_SUB_COUNT + sub + 1) << shift) - 1;
+}
+
+void
+ni_metric_count(ni_metric_id_t id)
+{
+	if (id < NI_METRIC_MAX)
+		__sync_fetch_and_add(&ni_metrics[id].count, 1);
+}
+
+void
+ni_metric_record(ni_metric_id_t id, uint64_t usec)
+{
+	ni_metric_t *metric;
+	uint64_t max;
+
+	if (id >= NI_METRIC_MAX || !ni_metric_map[id].histogram)
+		return;
+
+	metric = &ni_metrics[id];
+	__sync_fetch_and_add(&metric->count, 1);
+	__sync_fetch_and_add(&metric->sum, usec);
+	__sync_fetch_and_add(&metric->bucket[ni_metric_bucket_index(usec)], 1);
+
+	while ((max = metric->max) < usec &&
+	       !__sync_bool_compare_and_swap(&metric->max, max, usec))
+		;
+}
+
+/*
+ * Latency measurements use the monotonic clock
+ */
+void
+ni_metric_start(struct timeval *start)
+{
+	struct timespec ts;
+
+	if (!start)
+		return;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	start->tv_sec  = ts.tv_sec;
+	start->tv_usec = ts.tv_nsec / 1000;
+}
+
+void
+ni_metric_record_since(ni_metric_id_t id, const struct timeval *start)
+{
+	struct timeval now, delta;
+
+	if (!start || !timerisset(start))
+		return;
+
+	ni_metric_start(&now);
+	if (timercmp(&now, start, <))
+		return;
+
+	timersub(&now, start, &delta);
+	ni_metric_record(id, (uint64_t)delta.tv_sec * 1000000 + delta.tv_usec);
+}
+
+static uint64_t
+ni_metric_quantile(const ni_metric_t *metric, uint64_t count, unsigned int percent)
+{
+	uint64_t rank, seen = 0;
+	unsigned int i;
+
+	rank = (count * percent + 99) / 100;
+	for (i = 0; i < NI_METRIC_BUCKETS; ++i) {
+		seen += metric->bucket[i];
+		if (seen >= rank && seen)
+			return min_t(uint64_t, ni_metric_bucket_bound(i), metric->max);
+	}
+	return metric->max;
+}
+
+ni_bool_t
+ni_metric_get_stats(ni_metric_id_t id, ni_metric_stats_t *stats)
+{
+	const ni_metric_t *metric;
+
+	if (id >= NI_METRIC_MAX || !stats)
+		return FALSE;
+
+	memset(stats, 0, sizeof(*stats));
+	metric = &ni_metrics[id];
+	stats->count = metric->count;
+	if (!ni_metric_map[id].histogram || !stats->count)
+		return TRUE;
+
+	stats->sum = metric->sum;
+	stats->max = metric->max;
+	stats->p50 = ni_metric_quantile(metric, stats->count, 50);
+	stats->p90 = ni_metric_quantile(metric, stats->count, 90);
+	stats->p99 = ni_metric_quantile(metric, stats->count, 99);
+	return TRUE;
+}
+
+void
+ni_metrics_reset(void)
+{
+	memset(ni_metrics, 0, sizeof(ni_metrics));
+}
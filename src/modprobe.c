@@ -1,5 +1,14 @@
 /*
- * Helper to call modprobe
+ * Helper to load kernel modules
+ *
+ * Modules which are already loaded or built into the kernel are
+ * detected using /sys/module, /proc/modules and modules.builtin,
+ * so requesting them again is a cheap no-op. Missing modules are
+ * resolved via modules.alias and modules.dep and loaded in-process
+ * using finit_module(2); anything we can't handle ourselves (e.g.
+ * compressed modules or modprobe.d install/softdep rules) is left
+ * to the modprobe utility. The modprobe.d alias, blacklist and
+ * options rules are applied as modprobe does.
  *
  * Copyright (C) 2013 Marius Tomaschewski <mt@suse.de>
  */
@@ -7,8 +16,20 @@
 #include "config.h"
 #endif
 
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <fnmatch.h>
+#include <unistd.h>
+#include <sys/utsname.h>
+#include <sys/syscall.h>
+
 #include <wicked/util.h>
+#include <wicked/logging.h>
 #include "process.h"
+#include "modprobe.h"
 
 #ifndef NI_MODPROBE_BIN
 #define NI_MODPROBE_BIN "/sbin/modprobe"
@@ -17,17 +38,524 @@
 #define NI_MODPROBE_OPT "-qs"
 #endif
 
-int
-ni_modprobe(const char *module, const char *options)
+static const char *	ni_modprobe_config_dirs[] = {
+	"/etc/modprobe.d",
+	"/run/modprobe.d",
+	"/usr/local/lib/modprobe.d",
+	"/usr/lib/modprobe.d",
+	"/lib/modprobe.d",
+	NULL
+};
+
+static struct ni_modprobe_state {
+	char *			root;
+	char *			release;
+
+	ni_bool_t		builtin_read;
+	ni_string_array_t	builtin;
+	ni_var_array_t		aliases;
+
+	ni_bool_t		config_read;
+	ni_string_array_t	alias_patterns;
+	ni_string_array_t	alias_modules;
+	ni_string_array_t	blacklist;
+	ni_string_array_t	commands;
+	ni_var_array_t		options;
+} ni_modprobe_state = {
+	.builtin	= NI_STRING_ARRAY_INIT,
+	.aliases	= NI_VAR_ARRAY_INIT,
+	.alias_patterns	= NI_STRING_ARRAY_INIT,
+	.alias_modules	= NI_STRING_ARRAY_INIT,
+	.blacklist	= NI_STRING_ARRAY_INIT,
+	.commands	= NI_STRING_ARRAY_INIT,
+	.options	= NI_VAR_ARRAY_INIT,
+};
+
+/*
+ * Use an alternative root directory and/or kernel release,
+ * e.g. to test against a fake module tree. NULL resets to
+ * the system defaults.
+ */
+void
+ni_modprobe_init(const char *root, const char *release)
+{
+	struct ni_modprobe_state *state = &ni_modprobe_state;
+
+	ni_string_dup(&state->root, root && !ni_string_eq(root, "/") ? root : NULL);
+	ni_string_dup(&state->release, release);
+
+	state->builtin_read = FALSE;
+	ni_string_array_destroy(&state->builtin);
+	ni_var_array_destroy(&state->aliases);
+
+	state->config_read = FALSE;
+	ni_string_array_destroy(&state->alias_patterns);
+	ni_string_array_destroy(&state->alias_modules);
+	ni_string_array_destroy(&state->blacklist);
+	ni_string_array_destroy(&state->commands);
+	ni_var_array_destroy(&state->options);
+}
+
+static const char *
+ni_modprobe_path(char **path, const char *fmt, ...)
+{
+	char *rel = NULL;
+	va_list ap;
+	int ret;
+
+	va_start(ap, fmt);
+	ret = vasprintf(&rel, fmt, ap);
+	va_end(ap);
+	if (ret < 0)
+		return NULL;
+
+	ni_string_printf(path, "%s%s", ni_modprobe_state.root ?: "", rel);
+	free(rel);
+	return *path;
+}
+
+static const char *
+ni_modprobe_release(void)
+{
+	struct ni_modprobe_state *state = &ni_modprobe_state;
+	struct utsname uts;
+
+	if (!state->release) {
+		if (uname(&uts) < 0)
+			return NULL;
+		ni_string_dup(&state->release, uts.release);
+	}
+	return state->release;
+}
+
+static const char *
+ni_modprobe_modules_file(char **path, const char *name)
+{
+	const char *release;
+
+	if (!(release = ni_modprobe_release()))
+		return NULL;
+	return ni_modprobe_path(path, "/lib/modules/%s/%s", release, name);
+}
+
+/*
+ * Module names use '-' and '_' interchangeably
+ */
+static char *
+ni_modprobe_name_normalize(char *name)
+{
+	char *p;
+
+	for (p = name; p && *p; ++p) {
+		if (*p == '-')
+			*p = '_';
+	}
+	return name;
+}
+
+/*
+ * Return the normalized module name of a "kernel/net/foo/foo-bar.ko.xz"
+ * module path as used in modules.dep and modules.builtin.
+ */
+static char *
+ni_modprobe_name_from_path(char **name, const char *path)
+{
+	const char *base;
+	char *sfx;
+
+	if (!(base = ni_basename(path)) || !ni_string_dup(name, base))
+		return NULL;
+
+	if ((sfx = strstr(*name, ".ko")) != NULL)
+		*sfx = '\0';
+	return ni_modprobe_name_normalize(*name);
+}
+
+static void
+ni_modprobe_read_builtin(void)
+{
+	struct ni_modprobe_state *state = &ni_modprobe_state;
+	char *path = NULL, *name = NULL;
+	char line[1024];
+	FILE *fp;
+
+	if (state->builtin_read)
+		return;
+	state->builtin_read = TRUE;
+
+	if (!ni_modprobe_modules_file(&path, "modules.builtin") ||
+	    !(fp = fopen(path, "re"))) {
+		ni_string_free(&path);
+		return;
+	}
+
+	while (fgets(line, sizeof(line), fp)) {
+		line[strcspn(line, "\r\n")] = '\0';
+		if (ni_modprobe_name_from_path(&name, line) && *name)
+			ni_string_array_append(&state->builtin, name);
+	}
+	fclose(fp);
+
+	ni_string_free(&name);
+	ni_string_free(&path);
+}
+
+static ni_bool_t
+ni_modprobe_proc_modules_has(const char *module)
+{
+	char *path = NULL;
+	char line[1024];
+	ni_bool_t found = FALSE;
+	FILE *fp;
+
+	if (!ni_modprobe_path(&path, "/proc/modules") || !(fp = fopen(path, "re"))) {
+		ni_string_free(&path);
+		return FALSE;
+	}
+
+	while (!found && fgets(line, sizeof(line), fp)) {
+		line[strcspn(line, " \t\r\n")] = '\0';
+		found = ni_string_eq(ni_modprobe_name_normalize(line), module);
+	}
+	fclose(fp);
+
+	ni_string_free(&path);
+	return found;
+}
+
+/*
+ * Check if the (normalized) module is loaded or built in.
+ * Built in modules appear in /sys/module only when they
+ * have parameters, so we consult modules.builtin as well.
+ */
+static ni_bool_t
+ni_modprobe_module_present(const char *module)
+{
+	struct ni_modprobe_state *state = &ni_modprobe_state;
+	char *path = NULL;
+	ni_bool_t present;
+
+	ni_modprobe_read_builtin();
+	if (ni_string_array_index(&state->builtin, module) >= 0)
+		return TRUE;
+
+	if (!ni_modprobe_path(&path, "/sys/module"))
+		return FALSE;
+
+	if (ni_isdir(path)) {
+		ni_modprobe_path(&path, "/sys/module/%s", module);
+		present = ni_isdir(path);
+	} else {
+		present = ni_modprobe_proc_modules_has(module);
+	}
+
+	ni_string_free(&path);
+	return present;
+}
+
+/*
+ * Find the modules.dep entry for a module, returning the module
+ * file path and its dependencies.
+ */
+static ni_bool_t
+ni_modprobe_dep_lookup(const char *module, char **file, ni_string_array_t *deps)
+{
+	char *path = NULL, *name = NULL;
+	char line[4096], *sep;
+	ni_bool_t found = FALSE;
+	FILE *fp;
+
+	if (!ni_modprobe_modules_file(&path, "modules.dep") || !(fp = fopen(path, "re"))) {
+		ni_string_free(&path);
+		return FALSE;
+	}
+
+	while (!found && fgets(line, sizeof(line), fp)) {
+		line[strcspn(line, "\r\n")] = '\0';
+		if (!(sep = strchr(line, ':')))
+			continue;
+		*sep++ = '\0';
+
+		if (!ni_modprobe_name_from_path(&name, line) || !ni_string_eq(name, module))
+			continue;
+
+		ni_modprobe_modules_file(file, line);
+		ni_string_split(deps, sep, " \t", 0);
+		found = TRUE;
+	}
+	fclose(fp);
+
+	ni_string_free(&name);
+	ni_string_free(&path);
+	return found;
+}
+
+/*
+ * Read the modprobe.d rules once: a file in an earlier directory
+ * overrides the file with the same name in the later ones.
+ */
+static void
+ni_modprobe_config_parse(const char *path)
+{
+	struct ni_modprobe_state *state = &ni_modprobe_state;
+	char line[4096], *cmd, *name, *rest;
+	ni_var_t *var;
+	FILE *fp;
+
+	if (!(fp = fopen(path, "re")))
+		return;
+
+	while (fgets(line, sizeof(line), fp)) {
+		cmd  = strtok(line, " \t\r\n");
+		name = strtok(NULL, " \t\r\n");
+		rest = strtok(NULL, "\r\n");
+		if (!cmd || !name || *cmd == '#')
+			continue;
+
+		ni_modprobe_name_normalize(name);
+		if (ni_string_eq(cmd, "alias")) {
+			if (!(rest = strtok(rest, " \t")))
+				continue;
+			ni_string_array_append(&state->alias_patterns, name);
+			ni_string_array_append(&state->alias_modules,
+					ni_modprobe_name_normalize(rest));
+		} else
+		if (ni_string_eq(cmd, "blacklist")) {
+			ni_string_array_append(&state->blacklist, name);
+		} else
+		if (ni_string_eq(cmd, "options")) {
+			if (!rest)
+				continue;
+			if ((var = ni_var_array_get(&state->options, name))) {
+				char *opts = NULL;
+
+				ni_string_printf(&opts, "%s %s", var->value, rest);
+				ni_var_array_set(&state->options, name, opts);
+				ni_string_free(&opts);
+			} else {
+				ni_var_array_set(&state->options, name, rest);
+			}
+		} else
+		if (ni_string_eq(cmd, "install") || ni_string_eq(cmd, "softdep")) {
+			ni_debug_readwrite("%s: %s rule for module %s", path, cmd, name);
+			if (ni_string_array_index(&state->commands, name) < 0)
+				ni_string_array_append(&state->commands, name);
+		}
+	}
+	fclose(fp);
+}
+
+static void
+ni_modprobe_config_read(void)
+{
+	struct ni_modprobe_state *state = &ni_modprobe_state;
+	ni_string_array_t files = NI_STRING_ARRAY_INIT;
+	ni_string_array_t seen = NI_STRING_ARRAY_INIT;
+	const char **dir;
+	char *path = NULL;
+	unsigned int i;
+
+	if (state->config_read)
+		return;
+	state->config_read = TRUE;
+
+	for (dir = ni_modprobe_config_dirs; *dir; ++dir) {
+		if (!ni_modprobe_path(&path, "%s", *dir))
+			break;
+
+		ni_string_array_destroy(&files);
+		ni_scandir(path, "*.conf", &files);
+		for (i = 0; i < files.count; ++i) {
+			if (ni_string_array_index(&seen, files.data[i]) >= 0)
+				continue;
+			ni_string_array_append(&seen, files.data[i]);
+
+			ni_modprobe_path(&path, "%s/%s", *dir, files.data[i]);
+			ni_modprobe_config_parse(path);
+		}
+	}
+
+	ni_string_array_destroy(&files);
+	ni_string_array_destroy(&seen);
+	ni_string_free(&path);
+}
+
+/*
+ * Resolve an alias (e.g. "rtnl-link-bond") to a module name using
+ * the modprobe.d aliases first, then modules.alias while skipping
+ * blacklisted modules; names without a match are returned unchanged.
+ * Lookup results are cached either way.
+ */
+static const char *
+ni_modprobe_alias_resolve(const char *name)
+{
+	struct ni_modprobe_state *state = &ni_modprobe_state;
+	char *path = NULL, *alias = NULL;
+	const char *module = NULL;
+	char line[4096], *pattern, *target;
+	unsigned int i;
+	ni_var_t *var;
+	FILE *fp;
+
+	if ((var = ni_var_array_get(&state->aliases, name)))
+		return var->value;
+
+	ni_modprobe_config_read();
+	ni_string_dup(&alias, name);
+	ni_modprobe_name_normalize(alias);
+
+	for (i = 0; !module && i < state->alias_patterns.count; ++i) {
+		if (!fnmatch(state->alias_patterns.data[i], alias, 0))
+			module = state->alias_modules.data[i];
+	}
+
+	if (!module && ni_modprobe_modules_file(&path, "modules.alias") &&
+	    (fp = fopen(path, "re"))) {
+		while (!module && fgets(line, sizeof(line), fp)) {
+			if (strncmp(line, "alias ", 6))
+				continue;
+
+			pattern = strtok(line + 6, " \t\r\n");
+			target  = strtok(NULL, " \t\r\n");
+			if (!pattern || !target)
+				continue;
+
+			ni_modprobe_name_normalize(pattern);
+			if (fnmatch(pattern, alias, 0))
+				continue;
+
+			ni_modprobe_name_normalize(target);
+			if (ni_string_array_index(&state->blacklist, target) >= 0) {
+				ni_debug_readwrite("Skipping blacklisted module %s for alias %s",
+						target, name);
+				continue;
+			}
+			module = target;
+		}
+		fclose(fp);
+	}
+	ni_string_free(&path);
+
+	ni_var_array_set(&state->aliases, name, module ? module : name);
+	ni_string_free(&alias);
+	if ((var = ni_var_array_get(&state->aliases, name)) && var->value)
+		return var->value;
+	return name;
+}
+
+/*
+ * Apply modprobe.d rules for a module: collect its "options" and
+ * refuse to handle modules with install or softdep rules ourselves.
+ */
+static int
+ni_modprobe_config_apply(const char *module, ni_stringbuf_t *options)
+{
+	struct ni_modprobe_state *state = &ni_modprobe_state;
+	ni_var_t *var;
+
+	ni_modprobe_config_read();
+	if (ni_string_array_index(&state->commands, module) >= 0)
+		return -1;
+
+	if ((var = ni_var_array_get(&state->options, module)) && var->value) {
+		ni_stringbuf_putc(options, ' ');
+		ni_stringbuf_puts(options, var->value);
+	}
+	return 0;
+}
+
+static int
+ni_modprobe_load_file(const char *module, const char *file, const char *options)
+{
+#if defined(SYS_finit_module)
+	size_t len = ni_string_len(file);
+	int fd, ret, err;
+
+	/* the kernel decompresses modules only with MODULE_INIT_COMPRESSED_FILE */
+	if (len < 3 || strcmp(file + len - 3, ".ko"))
+		return -1;
+
+	if ((fd = open(file, O_RDONLY | O_CLOEXEC)) < 0) {
+		ni_debug_readwrite("Cannot open module file %s: %m", file);
+		return -1;
+	}
+
+	ret = syscall(SYS_finit_module, fd, options ? options : "", 0);
+	err = errno;
+	close(fd);
+
+	if (ret < 0 && err != EEXIST) {
+		errno = err;
+		ni_debug_readwrite("Cannot load module %s from %s: %m", module, file);
+		return -1;
+	}
+
+	ni_debug_readwrite("Loaded module %s%s%s", module,
+			options ? " " : "", options ? options : "");
+	return 0;
+#else
+	return -1;
+#endif
+}
+
+/*
+ * Load a module and its dependencies in-process.
+ */
+static int
+ni_modprobe_load(const char *module, const char *options)
+{
+	ni_string_array_t deps = NI_STRING_ARRAY_INIT;
+	ni_stringbuf_t opts = NI_STRINGBUF_INIT_DYNAMIC;
+	char *file = NULL, *dep = NULL, *name = NULL;
+	unsigned int i;
+	int rv = -1;
+
+	if (!ni_modprobe_dep_lookup(module, &file, &deps))
+		goto cleanup;
+
+	/* modules.dep lists the dependency loaded first last */
+	for (i = deps.count; i-- > 0; ) {
+		ni_stringbuf_clear(&opts);
+
+		if (!ni_modprobe_name_from_path(&name, deps.data[i]))
+			goto cleanup;
+		if (ni_modprobe_module_present(name))
+			continue;
+		if (ni_modprobe_config_apply(name, &opts) < 0)
+			goto cleanup;
+		if (!ni_modprobe_modules_file(&dep, deps.data[i]) ||
+		    ni_modprobe_load_file(name, dep, opts.string) < 0)
+			goto cleanup;
+	}
+
+	ni_stringbuf_clear(&opts);
+	if (ni_modprobe_config_apply(module, &opts) < 0)
+		goto cleanup;
+	if (!ni_string_empty(options)) {
+		ni_stringbuf_putc(&opts, ' ');
+		ni_stringbuf_puts(&opts, options);
+	}
+
+	ni_stringbuf_trim_head(&opts, " ");
+	rv = ni_modprobe_load_file(module, file, opts.string);
+
+cleanup:
+	ni_string_array_destroy(&deps);
+	ni_stringbuf_destroy(&opts);
+	ni_string_free(&file);
+	ni_string_free(&dep);
+	ni_string_free(&name);
+	return rv;
+}
+
+static int
+ni_modprobe_exec(const char *module, const char *options)
 {
 	ni_string_array_t argv;
 	ni_shellcmd_t *cmd;
 	ni_process_t *pi;
 	int rv;
 
-	if (ni_string_len(module) == 0)
-		return -1;
-
 	ni_string_array_init(&argv);
 	if (ni_string_array_append(&argv, NI_MODPROBE_BIN) < 0 ||
 	    ni_string_array_append(&argv, NI_MODPROBE_OPT) < 0 ||
@@ -56,3 +584,50 @@ ni_modprobe(const char *module, const char *options)
 	return rv;
 }
 
+/*
+ * Check whether a module (or alias) is loaded or built in
+ */
+static ni_bool_t
+ni_modprobe_present(const char *module, char **name)
+{
+	if (!ni_string_dup(name, module))
+		return FALSE;
+	if (ni_modprobe_module_present(ni_modprobe_name_normalize(*name)))
+		return TRUE;
+
+	if (!ni_string_dup(name, ni_modprobe_alias_resolve(module)))
+		return FALSE;
+	return ni_modprobe_module_present(ni_modprobe_name_normalize(*name));
+}
+
+ni_bool_t
+ni_modprobe_loaded(const char *module)
+{
+	ni_bool_t present;
+	char *name = NULL;
+
+	if (ni_string_empty(module))
+		return FALSE;
+
+	present = ni_modprobe_present(module, &name);
+	ni_string_free(&name);
+	return present;
+}
+
+int
+ni_modprobe(const char *module, const char *options)
+{
+	char *name = NULL;
+	int rv = 0;
+
+	if (ni_string_len(module) == 0)
+		return -1;
+
+	if (!ni_modprobe_present(module, &name)) {
+		if (!name || ni_modprobe_load(name, options) < 0)
+			rv = ni_modprobe_exec(module, options);
+	}
+
+	ni_string_free(&name);
+	return rv;
+}
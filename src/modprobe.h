@@ -1,5 +1,5 @@
 /*
- * Helper to call modprobe
+ * Helper to load kernel modules
  *
  * Copyright (C) 2013 Marius Tomaschewski <mt@suse.de>
  */
@@ -7,6 +7,8 @@
 #ifndef __WICKED_MODPROBE_H__
 #define __WICKED_MODPROBE_H__
 
-extern int	ni_modprobe(const char *module, const char *options);
+extern int		ni_modprobe(const char *module, const char *options);
+extern ni_bool_t	ni_modprobe_loaded(const char *module);
+extern void		ni_modprobe_init(const char *root, const char *release);
 
 #endif /* __WICKED_MODPROBE_H__ */
@@ -71,6 +71,7 @@ ni_netdev_new(const char *name, unsigned int index)
 void
 ni_netdev_clear_addresses(ni_netdev_t *dev)
 {
+	ni_netdev_addrs_changed(dev);
 	ni_address_list_destroy(&dev->addrs);
 }
 
@@ -87,6 +88,10 @@ ni_netdev_slaveinfo_destroy(ni_slaveinfo_t *slave)
 	case NI_IFTYPE_BOND:
 		ni_bonding_slave_info_free(slave->bond);
 		break;
+	case NI_IFTYPE_BRIDGE:
+		if (slave->bridge)
+			ni_bridge_port_free(slave->bridge);
+		break;
 	default:
 		break;
 	}
@@ -743,6 +748,57 @@ ni_netdev_get_event_uuid(ni_netdev_t *dev, ni_event_t ev)
 	return NULL;
 }
 
+/*
+ * Device addresses, looked up via an index by local address.
+ * The index is built on first use and kept in sync by the functions
+ * below; code modifying dev->addrs directly has to drop it using
+ * ni_netdev_addrs_changed.
+ */
+void
+ni_netdev_addrs_changed(ni_netdev_t *dev)
+{
+	ni_address_index_free(dev->addr_index);
+	dev->addr_index = NULL;
+}
+
+ni_address_t *
+ni_netdev_address_find(ni_netdev_t *dev, const ni_sockaddr_t *addr)
+{
+	if (!dev || !addr)
+		return NULL;
+
+	if (!dev->addr_index)
+		dev->addr_index = ni_address_index_build(dev->addrs);
+
+	return ni_address_index_find(dev->addr_index, addr);
+}
+
+ni_address_t *
+ni_netdev_address_new(ni_netdev_t *dev, int af, unsigned int prefixlen,
+			const ni_sockaddr_t *addr)
+{
+	ni_address_t *ap;
+
+	if (!dev || !(ap = ni_address_new(af, prefixlen, addr, &dev->addrs)))
+		return NULL;
+
+	if (dev->addr_index)
+		ni_address_index_insert(dev->addr_index, ap);
+	return ap;
+}
+
+ni_bool_t
+ni_netdev_address_remove(ni_netdev_t *dev, ni_address_t *ap)
+{
+	if (!dev || !ap)
+		return FALSE;
+
+	if (dev->addr_index && !ni_address_index_delete(dev->addr_index, ap))
+		ni_netdev_addrs_changed(dev);
+
+	return __ni_address_list_remove(&dev->addrs, ap);
+}
+
 /*
  * Locate any lease for the same addrconf mechanism
  */
@@ -74,6 +74,8 @@ extern void		__ni_netdev_event(ni_netconfig_t *, ni_netdev_t *, ni_event_t);
 
 extern int		__ni_ipv4_devconf_process_flags(ni_netdev_t *, int32_t *, unsigned int);
 extern int		__ni_ipv6_devconf_process_flags(ni_netdev_t *, int32_t *, unsigned int);
+extern int		__ni_rtnl_link_set_ipv4_conf(const ni_netdev_t *, const unsigned int *,
+					const int *, unsigned int);
 
 extern void		__ni_routes_clear(ni_netconfig_t *);
 
@@ -91,6 +93,7 @@ extern int		__ni_device_refresh_link_info(ni_netconfig_t *, ni_linkinfo_t *);
 extern int		__ni_device_refresh_ipv6_link_info(ni_netconfig_t *, ni_netdev_t *);
 extern int		__ni_system_interface_configure(ni_netconfig_t *, ni_netdev_t *, const ni_netdev_t *);
 extern int		__ni_system_interface_delete(ni_netconfig_t *, const char *);
+extern void		__ni_system_netdev_appeared(ni_netconfig_t *, ni_netdev_t *);
 extern int		__ni_system_interface_stats_refresh(ni_netconfig_t *, ni_netdev_t *);
 extern int		__ni_system_interface_flush_addrs(ni_netconfig_t *, ni_netdev_t *);
 extern int		__ni_system_interface_flush_routes(ni_netconfig_t *, ni_netdev_t *);
@@ -195,6 +198,7 @@ extern int		ni_arp_send_reply(ni_arp_socket_t *, struct in_addr,
 extern int		ni_arp_send_grat_reply(ni_arp_socket_t *, struct in_addr);
 extern int		ni_arp_send_grat_request(ni_arp_socket_t *, struct in_addr);
 extern int		ni_arp_send(ni_arp_socket_t *, const ni_arp_packet_t *);
+extern int		ni_arp_parse(ni_arp_socket_t *, ni_buffer_t *, ni_arp_packet_t *);
 
 typedef struct ni_arp_verify {
 	unsigned int		nprobes;
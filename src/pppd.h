@@ -28,10 +28,13 @@
 #include <wicked/types.h>
 #include <wicked/ppp.h>
 
+#include "systemctl.h"
+
 extern int				ni_pppd_config_file_remove(const char *);
 extern int				ni_pppd_discover(ni_netdev_t *, ni_netconfig_t *);
 
-extern int				ni_pppd_service_start(const ni_netdev_t *);
+extern int				ni_pppd_service_start(const ni_netdev_t *,
+						ni_systemctl_job_callback_t *, void *);
 extern int				ni_pppd_service_stop (const char *);
 
 #endif /* NI_PPPD_CLIENT_H */
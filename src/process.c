@@ -10,10 +10,13 @@
 #include <fcntl.h>
 #include <sys/wait.h>
 #include <sys/socket.h>
+#include <sys/syscall.h>
 #include <sys/time.h>
 #include <unistd.h>
+#include <string.h>
 #include <errno.h>
 #include <signal.h>
+#include <spawn.h>
 
 #include <wicked/logging.h>
 #include <wicked/socket.h>
@@ -493,6 +496,98 @@ ni_process_run_and_capture_output(ni_process_t *pi, ni_buffer_t *out_buffer)
 	return __ni_process_run_info(pi);
 }
 
+/*
+ * Close all descriptors from minfd on in the child process.
+ * close_range(2) avoids a close call per possible descriptor,
+ * which is expensive with a high RLIMIT_NOFILE.
+ */
+static void
+__ni_process_close_fds(int minfd)
+{
+	int maxfd, fd;
+
+#if defined(HAVE_CLOSE_RANGE)
+	if (close_range(minfd, ~0U, 0) == 0)
+		return;
+#elif defined(SYS_close_range)
+	if (syscall(SYS_close_range, minfd, ~0U, 0) == 0)
+		return;
+#endif
+	maxfd = getdtablesize();
+	for (fd = minfd; fd < maxfd; ++fd)
+		close(fd);
+}
+
+#if defined(HAVE_POSIX_SPAWN_FILE_ACTIONS_ADDCHDIR_NP) && \
+    defined(HAVE_POSIX_SPAWN_FILE_ACTIONS_ADDCLOSEFROM_NP)
+/*
+ * Execute an external command using posix_spawn, which does not
+ * copy the page tables of the (possibly large) parent process.
+ */
+static char **
+__ni_process_spawn_array(const ni_string_array_t *array)
+{
+	char **data;
+
+	data = xcalloc(array->count + 1, sizeof(char *));
+	if (array->count)
+		memcpy(data, array->data, array->count * sizeof(char *));
+	return data;
+}
+
+static int
+__ni_process_spawn(ni_process_t *pi, int *pfd)
+{
+	posix_spawn_file_actions_t actions;
+	char **argv, **envp;
+	pid_t pid;
+	int err;
+
+	if ((err = posix_spawn_file_actions_init(&actions))) {
+		errno = err;
+		ni_error("%s: unable to init spawn actions: %m", __func__);
+		return NI_PROCESS_FAILURE;
+	}
+
+	err = posix_spawn_file_actions_addchdir_np(&actions, "/");
+	if (!err)
+		err = posix_spawn_file_actions_addopen(&actions, 0, "/dev/null", O_RDONLY, 0);
+	if (!err && pfd)
+		err = posix_spawn_file_actions_adddup2(&actions, pfd[1], 1);
+	if (!err && pfd)
+		err = posix_spawn_file_actions_adddup2(&actions, pfd[1], 2);
+	if (!err)
+		err = posix_spawn_file_actions_addclosefrom_np(&actions, 3);
+	if (err) {
+		posix_spawn_file_actions_destroy(&actions);
+		errno = err;
+		ni_error("%s: unable to prepare spawn actions: %m", __func__);
+		return NI_PROCESS_FAILURE;
+	}
+
+	argv = __ni_process_spawn_array(&pi->argv);
+	envp = __ni_process_spawn_array(&pi->environ);
+
+	err = posix_spawn(&pid, argv[0], &actions, NULL, argv, envp);
+
+	posix_spawn_file_actions_destroy(&actions);
+	free(argv);
+	free(envp);
+
+	if (err) {
+		errno = err;
+		ni_error("%s: cannot execute %s: %m", __func__, pi->argv.data[0]);
+		return NI_PROCESS_FAILURE;
+	}
+
+	pi->pid = pid;
+	pi->status = -1;
+	ni_timer_get_time(&pi->started);
+	return NI_PROCESS_SUCCESS;
+}
+#define NI_PROCESS_SPAWN	1
+#endif
+
 int
 __ni_process_run(ni_process_t *pi, int *pfd)
 {
@@ -511,6 +606,11 @@ __ni_process_run(ni_process_t *pi, int *pfd)
 
 	signal(SIGCHLD, ni_process_sigchild);
 
+#if defined(NI_PROCESS_SPAWN)
+	if (!pi->exec)
+		return __ni_process_spawn(pi, pfd);
+#endif
+
 	if ((pid = fork()) < 0) {
 		ni_error("%s: unable to fork child process: %m", __func__);
 		return NI_PROCESS_FAILURE;
@@ -520,7 +620,6 @@ __ni_process_run(ni_process_t *pi, int *pfd)
 	ni_timer_get_time(&pi->started);
 
 	if (pid == 0) {
-		int maxfd;
 		int fd;
 
 		if (chdir("/") < 0)
@@ -537,9 +636,7 @@ __ni_process_run(ni_process_t *pi, int *pfd)
 				ni_warn("%s: cannot dup pipe out descriptor: %m", __func__);
 		}
 
-		maxfd = getdtablesize();
-		for (fd = 3; fd < maxfd; ++fd)
-			close(fd);
+		__ni_process_close_fds(3);
 
 		/* NULL terminate argv and env lists */
 		ni_string_array_append(&pi->argv, NULL);
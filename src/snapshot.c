@@ -0,0 +1,655 @@
+/*
+ * Read-only snapshot of the interface state published by wickedd
+ *
+ * wickedd writes the snapshot into a temporary file and renames it
+ * over the published one, so a reader mapping the file always sees
+ * a complete and immutable snapshot; an update is detected by the
+ * changed inode (or generation). The snapshot is rebuilt once per
+ * main loop iteration, but only published when its content changed.
+ *
+ * Copyright (C) 2026 SUSE LLC
+ */
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+
+#include <wicked/util.h>
+#include <wicked/logging.h>
+#include <wicked/netinfo.h>
+#include <wicked/address.h>
+#include <wicked/route.h>
+#include <wicked/addrconf.h>
+#include <wicked/socket.h>
+#include <wicked/snapshot.h>
+
+#include "client/client_state.h"
+#include "appconfig.h"
+#include "util_priv.h"
+
+#define NI_SNAPSHOT_ALIGN(n)	(((n) + 7) & ~(size_t)7)
+
+struct ni_snapshot {
+	char *			path;
+	dev_t			dev;
+	ino_t			ino;
+
+	const unsigned char *	data;
+	size_t			size;
+	const ni_snapshot_header_t *hdr;
+};
+
+#define NI_SNAPSHOT_BACKOFF_MAX		300	/* max write retry delay in sec */
+
+static struct {
+	unsigned char *		data;		/* last published, unstamped */
+	size_t			size;
+	uint64_t		generation;
+
+	ni_bool_t		dirty;		/* state changed since publish */
+	unsigned int		backoff;	/* write retry delay in sec    */
+	struct timeval		retry;		/* no write retry before       */
+} ni_snapshot_published = {
+	.dirty		= TRUE,
+};
+
+const char *
+ni_snapshot_default_path(void)
+{
+	static char path[PATH_MAX];
+	const char *statedir = WICKED_STATEDIR;
+
+	/* readers must not create the state dir as ni_config_statedir does */
+	if (ni_global.config && ni_global.config->statedir.path)
+		statedir = ni_global.config->statedir.path;
+
+	snprintf(path, sizeof(path), "%s/%s", statedir, NI_SNAPSHOT_FILE);
+	return path;
+}
+
+/*
+ * Building the snapshot
+ */
+static void
+ni_snapshot_put_sockaddr(unsigned char *dst, const ni_sockaddr_t *sa)
+{
+	switch (sa->ss_family) {
+	case AF_INET:
+		memcpy(dst, &sa->sin.sin_addr, sizeof(sa->sin.sin_addr));
+		break;
+	case AF_INET6:
+		memcpy(dst, &sa->six.sin6_addr, sizeof(sa->six.sin6_addr));
+		break;
+	default:
+		break;
+	}
+}
+
+static uint32_t
+ni_snapshot_put_string(unsigned char *strings, uint32_t *used, const char *str)
+{
+	uint32_t offset = *used;
+	size_t len;
+
+	if (ni_string_empty(str))
+		return 0;
+
+	len = strlen(str) + 1;
+	memcpy(strings + offset, str, len);
+	*used += len;
+	return offset;
+}
+
+static void
+ni_snapshot_put_netdev(ni_snapshot_netdev_t *sd, const ni_netdev_t *dev)
+{
+	const ni_client_state_t *cs;
+
+	strncpy(sd->name, dev->name, sizeof(sd->name) - 1);
+	if (dev->link.masterdev.name)
+		strncpy(sd->master, dev->link.masterdev.name, sizeof(sd->master) - 1);
+	sd->ifindex = dev->link.ifindex;
+	sd->type = dev->link.type;
+	sd->ifflags = dev->link.ifflags;
+	sd->oper_state = dev->link.oper_state;
+	sd->mtu = dev->link.mtu;
+	sd->link_required = ni_netdev_guess_link_required(dev);
+
+	sd->hwaddr_type = dev->link.hwaddr.type;
+	sd->hwaddr_len = min_t(unsigned int, dev->link.hwaddr.len, sizeof(sd->hwaddr));
+	memcpy(sd->hwaddr, dev->link.hwaddr.data, sd->hwaddr_len);
+
+	if ((cs = dev->client_state)) {
+		sd->has_client_state = 1;
+		sd->persistent = cs->control.persistent;
+		sd->usercontrol = cs->control.usercontrol;
+		sd->require_link = cs->control.require_link;
+		sd->config_owner = cs->config.owner;
+		sd->config_uuid = cs->config.uuid;
+	}
+}
+
+static void
+ni_snapshot_put_address(ni_snapshot_address_t *sa, const ni_address_t *ap)
+{
+	sa->family = ap->family;
+	sa->prefixlen = ap->prefixlen;
+	sa->flags = ap->flags;
+	sa->scope = ap->scope;
+	sa->owner = ap->owner;
+	ni_snapshot_put_sockaddr(sa->local, &ap->local_addr);
+	ni_snapshot_put_sockaddr(sa->peer, &ap->peer_addr);
+}
+
+static void
+ni_snapshot_put_route(ni_snapshot_route_t *sr, const ni_route_t *rp)
+{
+	sr->family = rp->family;
+	sr->prefixlen = rp->prefixlen;
+	sr->table = rp->table;
+	sr->type = rp->type;
+	sr->scope = rp->scope;
+	sr->protocol = rp->protocol;
+	sr->priority = rp->priority;
+	sr->owner = rp->owner;
+	sr->oif = rp->nh.device.index;
+	ni_snapshot_put_sockaddr(sr->destination, &rp->destination);
+	ni_snapshot_put_sockaddr(sr->gateway, &rp->nh.gateway);
+	ni_snapshot_put_sockaddr(sr->pref_src, &rp->pref_src);
+}
+
+static void
+ni_snapshot_put_lease(ni_snapshot_lease_t *sl, const ni_addrconf_lease_t *lease)
+{
+	sl->family = lease->family;
+	sl->type = lease->type;
+	sl->state = lease->state;
+	sl->flags = lease->flags;
+	sl->uuid = lease->uuid;
+}
+
+static void
+ni_snapshot_section_set(ni_snapshot_section_t *sect, size_t *offset,
+			unsigned int count, size_t size)
+{
+	sect->offset = *offset;
+	sect->count = count;
+	*offset = NI_SNAPSHOT_ALIGN(*offset + count * size);
+}
+
+static unsigned char *
+ni_snapshot_build(ni_netconfig_t *nc, size_t *sizep)
+{
+	unsigned int ndevs = 0, naddrs = 0, nroutes = 0, nleases = 0, i;
+	uint32_t nstrings = 1, strused = 1;
+	const ni_addrconf_lease_t *lease;
+	const ni_route_table_t *tab;
+	const ni_address_t *ap;
+	ni_snapshot_header_t head, *hdr;
+	ni_snapshot_netdev_t *sd;
+	ni_snapshot_address_t *sa;
+	ni_snapshot_route_t *sr;
+	ni_snapshot_lease_t *sl;
+	unsigned char *data;
+	ni_netdev_t *dev;
+	size_t size;
+
+	for (dev = ni_netconfig_devlist(nc); dev; dev = dev->next) {
+		if (ni_string_empty(dev->name))
+			continue;
+
+		ndevs++;
+		for (ap = dev->addrs; ap; ap = ap->next)
+			naddrs++;
+		for (tab = dev->routes; tab; tab = tab->next) {
+			for (i = 0; i < tab->routes.count; ++i) {
+				if (tab->routes.data[i])
+					nroutes++;
+			}
+		}
+		for (lease = dev->leases; lease; lease = lease->next)
+			nleases++;
+		if (dev->client_state && !ni_string_empty(dev->client_state->config.origin))
+			nstrings += strlen(dev->client_state->config.origin) + 1;
+	}
+
+	memset(&head, 0, sizeof(head));
+	size = NI_SNAPSHOT_ALIGN(sizeof(head));
+	ni_snapshot_section_set(&head.netdevs, &size, ndevs, sizeof(*sd));
+	ni_snapshot_section_set(&head.addrs, &size, naddrs, sizeof(*sa));
+	ni_snapshot_section_set(&head.routes, &size, nroutes, sizeof(*sr));
+	ni_snapshot_section_set(&head.leases, &size, nleases, sizeof(*sl));
+	ni_snapshot_section_set(&head.strings, &size, nstrings, 1);
+	head.magic = NI_SNAPSHOT_MAGIC;
+	head.version = NI_SNAPSHOT_VERSION;
+	head.size = size;
+
+	data = xcalloc(1, size);
+	hdr = (ni_snapshot_header_t *)data;
+	*hdr = head;
+
+	sd = (ni_snapshot_netdev_t *)(data + hdr->netdevs.offset);
+	sa = (ni_snapshot_address_t *)(data + hdr->addrs.offset);
+	sr = (ni_snapshot_route_t *)(data + hdr->routes.offset);
+	sl = (ni_snapshot_lease_t *)(data + hdr->leases.offset);
+	naddrs = nroutes = nleases = 0;
+
+	for (dev = ni_netconfig_devlist(nc); dev; dev = dev->next) {
+		if (ni_string_empty(dev->name))
+			continue;
+
+		ni_snapshot_put_netdev(sd, dev);
+		if (dev->client_state) {
+			sd->config_origin = ni_snapshot_put_string(data + hdr->strings.offset,
+						&strused, dev->client_state->config.origin);
+		}
+
+		sd->addr_first = naddrs;
+		for (ap = dev->addrs; ap; ap = ap->next, ++naddrs)
+			ni_snapshot_put_address(sa++, ap);
+		sd->addr_count = naddrs - sd->addr_first;
+
+		sd->route_first = nroutes;
+		for (tab = dev->routes; tab; tab = tab->next) {
+			for (i = 0; i < tab->routes.count; ++i) {
+				if (!tab->routes.data[i])
+					continue;
+				ni_snapshot_put_route(sr++, tab->routes.data[i]);
+				nroutes++;
+			}
+		}
+		sd->route_count = nroutes - sd->route_first;
+
+		sd->lease_first = nleases;
+		for (lease = dev->leases; lease; lease = lease->next, ++nleases)
+			ni_snapshot_put_lease(sl++, lease);
+		sd->lease_count = nleases - sd->lease_first;
+		sd++;
+	}
+
+	*sizep = size;
+	return data;
+}
+
+static int
+ni_snapshot_write(const char *path, const unsigned char *data, size_t size)
+{
+	char tempname[PATH_MAX];
+	size_t done = 0;
+	ssize_t ret;
+	int fd, err;
+
+	snprintf(tempname, sizeof(tempname), "%s.XXXXXX", path);
+	if ((fd = mkstemp(tempname)) < 0)
+		return -1;
+
+	if (fchmod(fd, 0644) < 0)
+		goto failed;
+
+	while (done < size) {
+		ret = write(fd, data + done, size - done);
+		if (ret < 0 && errno == EINTR)
+			continue;
+		if (ret <= 0)
+			goto failed;
+		done += ret;
+	}
+
+	if (close(fd) < 0) {
+		fd = -1;
+		goto failed;
+	}
+	fd = -1;
+
+	if (rename(tempname, path) < 0)
+		goto failed;
+	return 0;
+
+failed:
+	err = errno;
+	if (fd >= 0)
+		close(fd);
+	unlink(tempname);
+	errno = err;
+	return -1;
+}
+
+/*
+ * Mark the state as changed, e.g. on netlink events or
+ * D-Bus calls and signals, for the next publish call.
+ */
+void
+ni_snapshot_invalidate(void)
+{
+	ni_snapshot_published.dirty = TRUE;
+}
+
+/*
+ * Publish the state when it has been invalidated and changed
+ * since the last call. Failed writes are retried with backoff,
+ * the outdated snapshot is removed on the first failure.
+ * Returns 1 when a new snapshot has been written, 0 when
+ * it was unchanged and -1 on error.
+ */
+int
+ni_snapshot_publish(ni_netconfig_t *nc, const char *path)
+{
+	ni_snapshot_header_t *hdr;
+	unsigned char *data;
+	size_t size;
+	int rv;
+
+	struct timeval now;
+
+	if (!nc)
+		return -1;
+
+	if (!ni_snapshot_published.dirty)
+		return 0;
+
+	ni_timer_get_time(&now);
+	if (timerisset(&ni_snapshot_published.retry) &&
+	    timercmp(&now, &ni_snapshot_published.retry, <))
+		return -1;
+
+	if (!path) {
+		ni_config_statedir();
+		path = ni_snapshot_default_path();
+	}
+
+	data = ni_snapshot_build(nc, &size);
+	if (ni_snapshot_published.data && ni_snapshot_published.size == size &&
+	    !memcmp(ni_snapshot_published.data, data, size)) {
+		ni_snapshot_published.dirty = FALSE;
+		free(data);
+		return 0;
+	}
+
+	hdr = (ni_snapshot_header_t *)data;
+	hdr->generation = ni_snapshot_published.generation + 1;
+	hdr->pid = getpid();
+	rv = ni_snapshot_write(path, data, size);
+
+	/* keep it unstamped for the comparison, also on error to retry */
+	hdr->generation = 0;
+	hdr->pid = 0;
+	free(ni_snapshot_published.data);
+	if (rv < 0) {
+		free(data);
+		ni_snapshot_published.data = NULL;
+		ni_snapshot_published.size = 0;
+
+		/* report once, then retry with exponential backoff */
+		if (!ni_snapshot_published.backoff) {
+			ni_error("%s: unable to write snapshot: %m", path);
+			ni_snapshot_published.backoff = 1;
+
+			/* readers fall back to query the state meanwhile */
+			if (unlink(path) < 0 && errno != ENOENT)
+				ni_warn("%s: unable to remove stale snapshot: %m", path);
+		} else {
+			ni_debug_readwrite("%s: unable to write snapshot: %m", path);
+			ni_snapshot_published.backoff *= 2;
+			if (ni_snapshot_published.backoff > NI_SNAPSHOT_BACKOFF_MAX)
+				ni_snapshot_published.backoff = NI_SNAPSHOT_BACKOFF_MAX;
+		}
+		ni_snapshot_published.retry = now;
+		ni_snapshot_published.retry.tv_sec += ni_snapshot_published.backoff;
+		return -1;
+	}
+
+	if (ni_snapshot_published.backoff)
+		ni_note("%s: snapshot written again", path);
+	ni_snapshot_published.backoff = 0;
+	timerclear(&ni_snapshot_published.retry);
+	ni_snapshot_published.dirty = FALSE;
+	ni_snapshot_published.data = data;
+	ni_snapshot_published.size = size;
+	ni_snapshot_published.generation++;
+	ni_debug_readwrite("published state snapshot generation %llu (%zu bytes)",
+			(unsigned long long)ni_snapshot_published.generation, size);
+	return 1;
+}
+
+void
+ni_snapshot_unpublish(const char *path)
+{
+	if (!path)
+		path = ni_snapshot_default_path();
+
+	if (unlink(path) < 0 && errno != ENOENT)
+		ni_warn("%s: unable to remove snapshot: %m", path);
+
+	free(ni_snapshot_published.data);
+	memset(&ni_snapshot_published, 0, sizeof(ni_snapshot_published));
+	ni_snapshot_published.dirty = TRUE;
+}
+
+/*
+ * Reading the snapshot
+ */
+static ni_bool_t
+ni_snapshot_section_valid(const ni_snapshot_section_t *sect, size_t size, size_t recsize)
+{
+	if (sect->offset % 8 || sect->offset > size)
+		return FALSE;
+	return sect->count <= (size - sect->offset) / recsize;
+}
+
+static ni_bool_t
+ni_snapshot_valid(const ni_snapshot_t *snap)
+{
+	const ni_snapshot_header_t *hdr = snap->hdr;
+	const ni_snapshot_netdev_t *sd;
+	unsigned int i;
+
+	if (snap->size < sizeof(*hdr) || hdr->magic != NI_SNAPSHOT_MAGIC ||
+	    hdr->version != NI_SNAPSHOT_VERSION || hdr->size != snap->size)
+		return FALSE;
+
+	if (!ni_snapshot_section_valid(&hdr->netdevs, snap->size, sizeof(ni_snapshot_netdev_t)) ||
+	    !ni_snapshot_section_valid(&hdr->addrs,   snap->size, sizeof(ni_snapshot_address_t)) ||
+	    !ni_snapshot_section_valid(&hdr->routes,  snap->size, sizeof(ni_snapshot_route_t)) ||
+	    !ni_snapshot_section_valid(&hdr->leases,  snap->size, sizeof(ni_snapshot_lease_t)) ||
+	    !ni_snapshot_section_valid(&hdr->strings, snap->size, 1) || !hdr->strings.count)
+		return FALSE;
+
+	/* the string table has to be terminated */
+	if (snap->data[hdr->strings.offset + hdr->strings.count - 1] != '\0')
+		return FALSE;
+
+	for (i = 0; i < hdr->netdevs.count; ++i) {
+		sd = (const ni_snapshot_netdev_t *)(snap->data + hdr->netdevs.offset) + i;
+
+		if (sd->name[sizeof(sd->name) - 1] || sd->master[sizeof(sd->master) - 1] ||
+		    sd->addr_count > hdr->addrs.count ||
+		    sd->addr_first > hdr->addrs.count - sd->addr_count ||
+		    sd->route_count > hdr->routes.count ||
+		    sd->route_first > hdr->routes.count - sd->route_count ||
+		    sd->lease_count > hdr->leases.count ||
+		    sd->lease_first > hdr->leases.count - sd->lease_count ||
+		    sd->config_origin >= hdr->strings.count)
+			return FALSE;
+	}
+
+	/* a snapshot left behind by a crashed daemon is stale */
+	if (!hdr->pid || (kill(hdr->pid, 0) < 0 && errno != EPERM))
+		return FALSE;
+
+	return TRUE;
+}
+
+ni_snapshot_t *
+ni_snapshot_open(const char *path)
+{
+	ni_snapshot_t *snap;
+	struct stat st;
+	void *data;
+	int fd;
+
+	if (!path)
+		path = ni_snapshot_default_path();
+
+	if ((fd = open(path, O_RDONLY | O_CLOEXEC)) < 0) {
+		ni_debug_readwrite("%s: unable to open snapshot: %m", path);
+		return NULL;
+	}
+
+	if (fstat(fd, &st) < 0 || st.st_size < (off_t)sizeof(ni_snapshot_header_t) ||
+	    st.st_size > UINT32_MAX) {
+		close(fd);
+		ni_debug_readwrite("%s: invalid snapshot file", path);
+		return NULL;
+	}
+
+	data = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if (data == MAP_FAILED) {
+		ni_debug_readwrite("%s: unable to map snapshot: %m", path);
+		return NULL;
+	}
+
+	snap = xcalloc(1, sizeof(*snap));
+	ni_string_dup(&snap->path, path);
+	snap->dev = st.st_dev;
+	snap->ino = st.st_ino;
+	snap->data = data;
+	snap->size = st.st_size;
+	snap->hdr = data;
+
+	if (!ni_snapshot_valid(snap)) {
+		ni_debug_readwrite("%s: snapshot is invalid or stale", path);
+		ni_snapshot_close(snap);
+		return NULL;
+	}
+	return snap;
+}
+
+void
+ni_snapshot_close(ni_snapshot_t *snap)
+{
+	if (!snap)
+		return;
+
+	munmap((void *)snap->data, snap->size);
+	ni_string_free(&snap->path);
+	free(snap);
+}
+
+/*
+ * Whether the snapshot is still the published one; if not,
+ * the caller may reopen it to get the current state.
+ */
+ni_bool_t
+ni_snapshot_is_current(const ni_snapshot_t *snap)
+{
+	struct stat st;
+
+	if (!snap || stat(snap->path, &st) < 0)
+		return FALSE;
+
+	return st.st_dev == snap->dev && st.st_ino == snap->ino;
+}
+
+uint64_t
+ni_snapshot_generation(const ni_snapshot_t *snap)
+{
+	return snap ? snap->hdr->generation : 0;
+}
+
+unsigned int
+ni_snapshot_netdev_count(const ni_snapshot_t *snap)
+{
+	return snap ? snap->hdr->netdevs.count : 0;
+}
+
+const ni_snapshot_netdev_t *
+ni_snapshot_netdev_at(const ni_snapshot_t *snap, unsigned int n)
+{
+	if (!snap || n >= snap->hdr->netdevs.count)
+		return NULL;
+
+	return (const ni_snapshot_netdev_t *)(snap->data + snap->hdr->netdevs.offset) + n;
+}
+
+const ni_snapshot_netdev_t *
+ni_snapshot_netdev_by_name(const ni_snapshot_t *snap, const char *name)
+{
+	const ni_snapshot_netdev_t *sd;
+	unsigned int i;
+
+	if (ni_string_empty(name))
+		return NULL;
+
+	for (i = 0; (sd = ni_snapshot_netdev_at(snap, i)); ++i) {
+		if (ni_string_eq(sd->name, name))
+			return sd;
+	}
+	return NULL;
+}
+
+const ni_snapshot_netdev_t *
+ni_snapshot_netdev_by_index(const ni_snapshot_t *snap, unsigned int ifindex)
+{
+	const ni_snapshot_netdev_t *sd;
+	unsigned int i;
+
+	if (!ifindex)
+		return NULL;
+
+	for (i = 0; (sd = ni_snapshot_netdev_at(snap, i)); ++i) {
+		if (sd->ifindex == ifindex)
+			return sd;
+	}
+	return NULL;
+}
+
+const ni_snapshot_address_t *
+ni_snapshot_netdev_addr(const ni_snapshot_t *snap, const ni_snapshot_netdev_t *sd, unsigned int n)
+{
+	if (!snap || !sd || n >= sd->addr_count)
+		return NULL;
+
+	return (const ni_snapshot_address_t *)(snap->data + snap->hdr->addrs.offset) +
+		sd->addr_first + n;
+}
+
+const ni_snapshot_route_t *
+ni_snapshot_netdev_route(const ni_snapshot_t *snap, const ni_snapshot_netdev_t *sd, unsigned int n)
+{
+	if (!snap || !sd || n >= sd->route_count)
+		return NULL;
+
+	return (const ni_snapshot_route_t *)(snap->data + snap->hdr->routes.offset) +
+		sd->route_first + n;
+}
+
+const ni_snapshot_lease_t *
+ni_snapshot_netdev_lease(const ni_snapshot_t *snap, const ni_snapshot_netdev_t *sd, unsigned int n)
+{
+	if (!snap || !sd || n >= sd->lease_count)
+		return NULL;
+
+	return (const ni_snapshot_lease_t *)(snap->data + snap->hdr->leases.offset) +
+		sd->lease_first + n;
+}
+
+const char *
+ni_snapshot_string(const ni_snapshot_t *snap, uint32_t offset)
+{
+	if (!snap || !offset || offset >= snap->hdr->strings.count)
+		return NULL;
+
+	return (const char *)snap->data + snap->hdr->strings.offset + offset;
+}
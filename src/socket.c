@@ -24,6 +24,7 @@
 #include <wicked/logging.h>
 #include <wicked/xml.h>
 #include <wicked/socket.h>
+#include <wicked/metrics.h>
 #include "netinfo_priv.h"
 #include "socket_priv.h"
 #include "appconfig.h"
@@ -117,7 +118,7 @@ int
 ni_socket_array_wait(ni_socket_array_t *array, long timeout)
 {
 	struct pollfd pfd[array->count];
-	struct timeval now, expires;
+	struct timeval now, expires, start;
 	unsigned int i, socket_count;
 
 	/* First step - cleanup empty socket slots from the array. */
@@ -164,6 +165,9 @@ ni_socket_array_wait(ni_socket_array_t *array, long timeout)
 		return 1;
 	}
 
+	/* write out deferred log messages before we block */
+	ni_log_flush();
+
 	if (poll(pfd, socket_count, timeout) < 0) {
 		if (errno == EINTR)
 			return 0;
@@ -171,6 +175,7 @@ ni_socket_array_wait(ni_socket_array_t *array, long timeout)
 		return -1;
 	}
 
+	ni_metric_start(&start);
 	for (i = 0; i < socket_count; ++i) {
 		ni_socket_t *sock = array->data[i];
 
@@ -234,6 +239,7 @@ done_with_this_socket:
 	/* Finally cleanup deactivated/released sockets */
 	ni_socket_array_cleanup(array);
 
+	ni_metric_record_since(NI_METRIC_SOCKET_DISPATCH, &start);
 	return 0;
 }
 
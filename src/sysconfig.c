@@ -66,6 +66,8 @@ __ni_sysconfig_read(const char *filename, const char **varnames)
 	}
 
 	sc = ni_sysconfig_new(filename);
+	/* ifcfg files may carry hundreds of (indexed) variables */
+	ni_var_array_index_enable(&sc->vars);
 	while (fgets(linebuf, sizeof(linebuf), fp) != NULL) {
 		char *name, *value;
 		char *sp = linebuf;
@@ -298,6 +300,9 @@ ni_sysconfig_merge_defaults(const ni_sysconfig_t *config, const ni_sysconfig_t *
 	if (!config || !(merged =  ni_sysconfig_new(config->pathname)))
 		return NULL;
 
+	if (config->vars.index)
+		ni_var_array_index_enable(&merged->vars);
+
 	/* apply global defaults first  */
 	if (defaults)
 		ni_var_array_copy(&merged->vars, &defaults->vars);
@@ -393,16 +398,18 @@ int
 ni_sysconfig_find_matching(const ni_sysconfig_t *sc, const char *prefix,
 		ni_string_array_t *res)
 {
-	unsigned int i, pfxlen;
+	ni_uint_array_t pos = NI_UINT_ARRAY_INIT;
+	unsigned int i;
 	ni_var_t *var;
 
-	pfxlen = strlen(prefix);
-	for (i = 0, var = sc->vars.data; i < sc->vars.count; ++i, ++var) {
-		const char *value = var->value;
+	ni_var_array_find_prefix(&sc->vars, prefix, &pos);
+	for (i = 0; i < pos.count; ++i) {
+		var = &sc->vars.data[pos.data[i]];
 
-		if (value && *value && !strncmp(var->name, prefix, pfxlen))
+		if (var->value && *var->value)
 			ni_string_array_append(res, var->name);
 	}
+	ni_uint_array_destroy(&pos);
 	return res->count;
 }
 
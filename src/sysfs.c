@@ -9,6 +9,8 @@
 
 #include <unistd.h>
 #include <limits.h>
+#include <fcntl.h>
+#include <errno.h>
 #include <net/if_arp.h>
 
 #include <wicked/netinfo.h>
@@ -425,7 +427,7 @@ ni_sysfs_bridge_get_config(const char *ifname, ni_bridge_t *bridge)
 	if (ni_sysfs_netif_get_uint(ifname, SYSFS_BRIDGE_ATTR "/forward_delay", &ui) == 0)
 		bridge->forward_delay = (double)ui / 100.0;
 	if (ni_sysfs_netif_get_ulong(ifname, SYSFS_BRIDGE_ATTR "/ageing_time", &ul) == 0)
-		bridge->ageing_time = (double)ui / 100.0;
+		bridge->ageing_time = (double)ul / 100.0;
 	if (ni_sysfs_netif_get_uint(ifname, SYSFS_BRIDGE_ATTR "/hello_time", &ui) == 0)
 		bridge->hello_time = (double)ui / 100.0;
 	if (ni_sysfs_netif_get_uint(ifname, SYSFS_BRIDGE_ATTR "/max_age", &ui) == 0)
@@ -521,7 +523,7 @@ ni_sysfs_bridge_port_get_status(const char *ifname, ni_bridge_port_status_t *ps)
 
 	ni_sysfs_netif_get_int(ifname, SYSFS_BRIDGE_PORT_ATTR "/state", &ps->state);
 	ni_sysfs_netif_get_uint(ifname, SYSFS_BRIDGE_PORT_ATTR "/port_no", &ps->port_no);
-	ni_sysfs_netif_get_uint(ifname, SYSFS_BRIDGE_PORT_ATTR "/port_id", &ps->port_no);
+	ni_sysfs_netif_get_uint(ifname, SYSFS_BRIDGE_PORT_ATTR "/port_id", &ps->port_id);
 	ni_sysfs_netif_get_string(ifname, SYSFS_BRIDGE_PORT_ATTR "/designated_root", &ps->designated_root);
 	ni_sysfs_netif_get_string(ifname, SYSFS_BRIDGE_PORT_ATTR "/designated_bridge", &ps->designated_bridge);
 	ni_sysfs_netif_get_uint(ifname, SYSFS_BRIDGE_PORT_ATTR "/designated_port", &ps->designated_port);
@@ -689,6 +691,61 @@ ni_sysctl_ipv6_ifconfig_set_uint(const char *ifname, const char *ctl_name, unsig
 	return __ni_sysfs_printf(__ni_sysctl_ipv6_ifconfig_path(ifname, ctl_name), "%u", newval);
 }
 
+/*
+ * Batched writer for the sysctls of one interface; the conf
+ * directory is opened once on first use and the sysctl files
+ * are opened relative to it.
+ */
+void
+ni_sysctl_ifconfig_init(ni_sysctl_ifconfig_t *ctl, const char *family, const char *ifname)
+{
+	ctl->family = family;
+	ctl->ifname = ifname;
+	ctl->dirfd = -1;
+}
+
+void
+ni_sysctl_ifconfig_destroy(ni_sysctl_ifconfig_t *ctl)
+{
+	if (ctl->dirfd >= 0)
+		close(ctl->dirfd);
+	ctl->dirfd = -1;
+}
+
+int
+ni_sysctl_ifconfig_set_int(ni_sysctl_ifconfig_t *ctl, const char *ctl_name, int newval)
+{
+	char buf[32];
+	int fd, len, ret = 0;
+
+	if (ctl->dirfd < 0) {
+		char pathname[PATH_MAX];
+
+		snprintf(pathname, sizeof(pathname), "/proc/sys/net/%s/conf/%s",
+				ctl->family, ctl->ifname);
+		ctl->dirfd = open(pathname, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+		if (ctl->dirfd < 0)
+			return -1;
+	}
+
+	if ((fd = openat(ctl->dirfd, ctl_name, O_WRONLY | O_CLOEXEC)) < 0)
+		return -1;
+
+	len = snprintf(buf, sizeof(buf), "%d", newval);
+	if (write(fd, buf, len) != len)
+		ret = -1;
+
+	if (close(fd) < 0 || ret < 0) {
+		int err = errno;
+
+		ni_error("error writing to %s.conf.%s.%s: %m",
+				ctl->family, ctl->ifname, ctl_name);
+		errno = err;
+		return -1;
+	}
+	return 0;
+}
+
 /*
  * Print a value to a sysfs file
  */
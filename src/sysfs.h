@@ -59,4 +59,14 @@ extern int	ni_sysctl_ipv4_ifconfig_get_uint(const char *, const char *, unsigned
 extern int	ni_sysctl_ipv4_ifconfig_set_int(const char *, const char *, int);
 extern int	ni_sysctl_ipv4_ifconfig_set_uint(const char *, const char *, unsigned int);
 
+typedef struct ni_sysctl_ifconfig {
+	const char *	family;
+	const char *	ifname;
+	int		dirfd;
+} ni_sysctl_ifconfig_t;
+
+extern void	ni_sysctl_ifconfig_init(ni_sysctl_ifconfig_t *, const char *, const char *);
+extern void	ni_sysctl_ifconfig_destroy(ni_sysctl_ifconfig_t *);
+extern int	ni_sysctl_ifconfig_set_int(ni_sysctl_ifconfig_t *, const char *, int);
+
 #endif /* __NETINFO_SYSFS_H__ */
@@ -1,5 +1,5 @@
 /*
- *	Interfacing with systemd using systemctl
+ *	Interfacing with systemd via its D-Bus API or using systemctl
  *
  *	Copyright (C) 2016 SUSE Linux GmbH, Nuernberg, Germany.
  *
@@ -25,12 +25,449 @@
 #include "config.h"
 #endif
 
+#include <stdarg.h>
 #include <wicked/util.h>
 #include <wicked/logging.h>
+#include <wicked/socket.h>
+#include <wicked/dbus.h>
+#include <wicked/dbus-errors.h>
 
 #include "buffer.h"
 #include "process.h"
+#include "dbus-connection.h"
+#include "systemctl.h"
 
+#define NI_SYSTEMD_BUS_NAME		"org.freedesktop.systemd1"
+#define NI_SYSTEMD_OBJECT_PATH		"/org/freedesktop/systemd1"
+#define NI_SYSTEMD_MANAGER_INTERFACE	NI_SYSTEMD_BUS_NAME ".Manager"
+#define NI_SYSTEMD_UNIT_INTERFACE	NI_SYSTEMD_BUS_NAME ".Unit"
+#define NI_SYSTEMD_SERVICE_INTERFACE	NI_SYSTEMD_BUS_NAME ".Service"
+#define NI_SYSTEMD_PROPERTIES_INTERFACE	NI_DBUS_INTERFACE ".Properties"
+
+#define NI_SYSTEMD_CALL_TIMEOUT		(25 * 1000)
+#define NI_SYSTEMD_JOB_TIMEOUT		(300 * 1000)
+
+/*
+ * Unit jobs are queued on the system bus connection of the daemon
+ * attached using ni_systemctl_bus_attach without waiting: the reply
+ * to the call, carrying the job path, and the JobRemoved signal of
+ * the systemd manager completing the job callback are dispatched by
+ * the main loop.
+ */
+typedef struct ni_systemd_job	ni_systemd_job_t;
+
+typedef int			ni_systemd_tool_t(const char *);
+
+struct ni_systemd_job {
+	ni_systemd_job_t *		next;
+
+	dbus_uint32_t			serial;	/* of the call */
+	char *				path;	/* from the reply */
+	char *				unit;
+	const char *			method;
+	ni_systemd_tool_t *		fallback;
+	const ni_timer_t *		timer;
+
+	ni_systemctl_job_callback_t *	callback;
+	void *				user_data;
+};
+
+static ni_dbus_connection_t *	ni_systemd_bus;
+static ni_dbus_connection_t *	ni_systemd_handler_bus;
+static ni_bool_t		ni_systemd_subscribed;
+static ni_systemd_job_t *	ni_systemd_jobs;
+static ni_var_array_t		ni_systemd_removed = NI_VAR_ARRAY_INIT;
+
+
+/*
+ * Use the (system bus) connection of the daemon to talk to systemd;
+ * without one, units are controlled using the systemctl tool.
+ */
+void
+ni_systemctl_bus_attach(ni_dbus_connection_t *conn)
+{
+	ni_systemd_bus = conn;
+	ni_systemd_subscribed = FALSE;
+}
+
+/*
+ * Transport errors (no bus, connection lost, timeout) make us fall
+ * back to systemctl; replies from systemd such as NoSuchUnit are
+ * real failures.
+ */
+static ni_bool_t
+ni_systemd_bus_error(const DBusError *error)
+{
+	return dbus_error_has_name(error, DBUS_ERROR_NO_REPLY) ||
+		dbus_error_has_name(error, DBUS_ERROR_DISCONNECTED) ||
+		dbus_error_has_name(error, DBUS_ERROR_SERVICE_UNKNOWN) ||
+		dbus_error_has_name(error, DBUS_ERROR_NAME_HAS_NO_OWNER);
+}
+
+static ni_dbus_message_t *
+ni_systemd_message(const char *path, const char *interface, const char *method,
+		DBusError *error, int type, va_list ap)
+{
+	ni_dbus_message_t *call;
+
+	call = dbus_message_new_method_call(NI_SYSTEMD_BUS_NAME, path, interface, method);
+	if (!call) {
+		dbus_set_error(error, DBUS_ERROR_NO_MEMORY, "cannot allocate %s call", method);
+		return NULL;
+	}
+
+	if (!dbus_message_append_args_valist(call, type, ap)) {
+		dbus_message_unref(call);
+		dbus_set_error(error, DBUS_ERROR_NO_MEMORY, "cannot encode %s call", method);
+		return NULL;
+	}
+	return call;
+}
+
+/*
+ * Synchronous call, used to query unit properties only
+ */
+static ni_dbus_message_t *
+ni_systemd_call(const char *path, const char *interface, const char *method,
+		DBusError *error, int type, ...)
+{
+	ni_dbus_message_t *call, *reply;
+	va_list ap;
+
+	va_start(ap, type);
+	call = ni_systemd_message(path, interface, method, error, type, ap);
+	va_end(ap);
+	if (!call)
+		return NULL;
+
+	reply = ni_dbus_connection_call(ni_systemd_bus, call, NI_SYSTEMD_CALL_TIMEOUT, error);
+	dbus_message_unref(call);
+
+	if (!reply && ni_systemd_bus_error(error))
+		ni_systemd_subscribed = FALSE;
+	return reply;
+}
+
+/*
+ * Send a call without waiting for the reply, which is passed to the
+ * callback from the main loop. Returns the serial of the call or 0.
+ */
+static dbus_uint32_t
+ni_systemd_call_async(ni_dbus_async_callback_t *callback, const char *method,
+		int type, ...)
+{
+	DBusError error = DBUS_ERROR_INIT;
+	ni_dbus_message_t *call;
+	dbus_uint32_t serial = 0;
+	va_list ap;
+
+	va_start(ap, type);
+	call = ni_systemd_message(NI_SYSTEMD_OBJECT_PATH, NI_SYSTEMD_MANAGER_INTERFACE,
+			method, &error, type, ap);
+	va_end(ap);
+	if (!call) {
+		ni_error("systemd: %s", error.message);
+		dbus_error_free(&error);
+		return 0;
+	}
+
+	if (ni_dbus_connection_call_async(ni_systemd_bus, call, NI_SYSTEMD_CALL_TIMEOUT,
+					callback, NULL) == 0)
+		serial = dbus_message_get_serial(call);
+	dbus_message_unref(call);
+	return serial;
+}
+
+static void
+ni_systemd_job_free(ni_systemd_job_t *job)
+{
+	if (job->timer)
+		ni_timer_cancel(job->timer);
+	ni_string_free(&job->path);
+	ni_string_free(&job->unit);
+	free(job);
+}
+
+/*
+ * Jobs are found by their path or, while we wait for the reply
+ * to the call, by the serial of the call.
+ */
+static ni_systemd_job_t *
+ni_systemd_job_unlink(const char *path, dbus_uint32_t serial)
+{
+	ni_systemd_job_t **pos, *job;
+
+	for (pos = &ni_systemd_jobs; (job = *pos); pos = &job->next) {
+		if (path ? ni_string_eq(job->path, path) : !job->path && job->serial == serial) {
+			*pos = job->next;
+			job->next = NULL;
+			return job;
+		}
+	}
+	return NULL;
+}
+
+static ni_bool_t
+ni_systemd_job_awaits_reply(void)
+{
+	ni_systemd_job_t *job;
+
+	for (job = ni_systemd_jobs; job; job = job->next) {
+		if (!job->path)
+			return TRUE;
+	}
+	return FALSE;
+}
+
+static void
+ni_systemd_job_finish(ni_systemd_job_t *job, int result)
+{
+	if (job->callback)
+		job->callback(job->unit, result, job->user_data);
+	ni_systemd_job_free(job);
+}
+
+static void
+ni_systemd_job_complete(ni_systemd_job_t *job, const char *result)
+{
+	int rv = -1;
+
+	if (ni_string_eq(result, "done")) {
+		ni_debug_dbus("systemd: %s %s: job %s done", job->method, job->unit, job->path);
+		rv = 0;
+	} else {
+		ni_error("systemd: %s %s: job %s result: %s", job->method, job->unit,
+				job->path, result);
+	}
+	ni_systemd_job_finish(job, rv);
+}
+
+static void
+ni_systemd_job_timeout(void *user_data, const ni_timer_t *timer)
+{
+	ni_systemd_job_t *job = user_data;
+
+	if (job->timer != timer)
+		return;
+
+	job->timer = NULL;
+	if (ni_systemd_job_unlink(job->path, job->serial) == job)
+		ni_systemd_job_complete(job, "timeout");
+}
+
+static void
+ni_systemd_job_reply(ni_dbus_object_t *proxy, ni_dbus_message_t *reply)
+{
+	DBusError error = DBUS_ERROR_INIT;
+	const char *path = NULL;
+	ni_systemd_job_t *job;
+	const ni_var_t *var;
+
+	if (!(job = ni_systemd_job_unlink(NULL, dbus_message_get_reply_serial(reply))))
+		return;
+
+	if (dbus_set_error_from_message(&error, reply)) {
+		if (ni_systemd_bus_error(&error)) {
+			ni_debug_dbus("systemd: %s %s: %s, using systemctl", job->method,
+					job->unit, error.message);
+			ni_systemd_subscribed = FALSE;
+			ni_systemd_job_finish(job, job->fallback(job->unit) ? -1 : 0);
+		} else {
+			ni_error("systemd: %s %s failed: %s", job->method, job->unit,
+					error.message);
+			ni_systemd_job_finish(job, -1);
+		}
+	} else
+	if (!dbus_message_get_args(reply, &error, DBUS_TYPE_OBJECT_PATH, &path,
+				DBUS_TYPE_INVALID)) {
+		ni_error("systemd: %s %s: cannot decode job reply", job->method, job->unit);
+		ni_systemd_job_finish(job, -1);
+	} else {
+		ni_string_dup(&job->path, path);
+
+		/* the job may be removed and dispatched before its reply */
+		if ((var = ni_var_array_get(&ni_systemd_removed, path))) {
+			ni_systemd_job_complete(job, var->value);
+		} else {
+			ni_debug_dbus("systemd: %s %s: job %s queued", job->method,
+					job->unit, path);
+			job->next = ni_systemd_jobs;
+			ni_systemd_jobs = job;
+		}
+	}
+
+	if (!ni_systemd_job_awaits_reply())
+		ni_var_array_destroy(&ni_systemd_removed);
+	dbus_error_free(&error);
+}
+
+static void
+ni_systemd_signal(ni_dbus_connection_t *conn, ni_dbus_message_t *msg, void *user_data)
+{
+	const char *path = NULL, *unit = NULL, *result = NULL;
+	ni_systemd_job_t *job;
+	dbus_uint32_t id;
+
+	if (!ni_string_eq(dbus_message_get_member(msg), "JobRemoved"))
+		return;
+
+	if (!dbus_message_get_args(msg, NULL,
+				DBUS_TYPE_UINT32, &id,
+				DBUS_TYPE_OBJECT_PATH, &path,
+				DBUS_TYPE_STRING, &unit,
+				DBUS_TYPE_STRING, &result,
+				DBUS_TYPE_INVALID))
+		return;
+
+	if ((job = ni_systemd_job_unlink(path, 0)))
+		ni_systemd_job_complete(job, result);
+	else if (ni_systemd_job_awaits_reply())
+		ni_var_array_set(&ni_systemd_removed, path, result);
+}
+
+static void
+ni_systemd_subscribe_reply(ni_dbus_object_t *proxy, ni_dbus_message_t *reply)
+{
+	DBusError error = DBUS_ERROR_INIT;
+
+	if (dbus_set_error_from_message(&error, reply)) {
+		ni_debug_dbus("Cannot subscribe to systemd manager: %s", error.message);
+		ni_systemd_subscribed = FALSE;
+		dbus_error_free(&error);
+	}
+}
+
+static ni_bool_t
+ni_systemd_subscribe(void)
+{
+	if (!ni_systemd_bus)
+		return FALSE;
+
+	if (ni_systemd_subscribed)
+		return TRUE;
+
+	if (ni_systemd_handler_bus != ni_systemd_bus) {
+		ni_dbus_add_signal_handler(ni_systemd_bus, NI_SYSTEMD_BUS_NAME,
+				NI_SYSTEMD_OBJECT_PATH, NI_SYSTEMD_MANAGER_INTERFACE,
+				ni_systemd_signal, NULL);
+		ni_systemd_handler_bus = ni_systemd_bus;
+	}
+
+	/* systemd sends job signals to subscribed clients only; it
+	 * processes our calls in order, so we don't wait for it */
+	if (!ni_systemd_call_async(ni_systemd_subscribe_reply, "Subscribe", DBUS_TYPE_INVALID))
+		return FALSE;
+
+	ni_systemd_subscribed = TRUE;
+	return TRUE;
+}
+
+/*
+ * Queue a job to start or stop an unit in "replace" mode like systemctl
+ * does. Returns 0 when the call is sent: the callback is completed by
+ * the JobRemoved signal, with -1 when systemd failed the call and with
+ * the fallback tool result on transport errors. Returns 1 when the
+ * systemd bus is not available.
+ */
+static int
+ni_systemd_unit_job(const char *method, ni_systemd_tool_t *fallback, const char *unit,
+		ni_systemctl_job_callback_t *callback, void *user_data)
+{
+	const char *mode = "replace";
+	ni_systemd_job_t *job;
+	dbus_uint32_t serial;
+
+	if (!ni_systemd_subscribe())
+		return 1;
+
+	serial = ni_systemd_call_async(ni_systemd_job_reply, method,
+			DBUS_TYPE_STRING, &unit,
+			DBUS_TYPE_STRING, &mode,
+			DBUS_TYPE_INVALID);
+	if (!serial)
+		return 1;
+
+	job = xcalloc(1, sizeof(*job));
+	job->serial = serial;
+	ni_string_dup(&job->unit, unit);
+	job->method = method;
+	job->fallback = fallback;
+	job->callback = callback;
+	job->user_data = user_data;
+	job->timer = ni_timer_register(NI_SYSTEMD_JOB_TIMEOUT, ni_systemd_job_timeout, job);
+	job->next = ni_systemd_jobs;
+	ni_systemd_jobs = job;
+	return 0;
+}
+
+/*
+ * Retrieve an unit property using the org.freedesktop.DBus.Properties
+ * interface. The property is looked up in the generic unit interface
+ * first and then in the service specific one.
+ * Returns 1 when the systemd bus is not available.
+ */
+static int
+ni_systemd_unit_property(const char *unit, const char *property, char **result)
+{
+	static const char *interfaces[] = {
+		NI_SYSTEMD_UNIT_INTERFACE,
+		NI_SYSTEMD_SERVICE_INTERFACE,
+		NULL
+	};
+	DBusError error = DBUS_ERROR_INIT;
+	ni_dbus_variant_t value = NI_DBUS_VARIANT_INIT;
+	ni_dbus_message_t *reply = NULL;
+	const char **iface;
+	const char *str;
+	char *path = NULL;
+	int rv = -1;
+
+	if (!ni_systemd_subscribe())
+		return 1;
+
+	reply = ni_systemd_call(NI_SYSTEMD_OBJECT_PATH, NI_SYSTEMD_MANAGER_INTERFACE,
+			"LoadUnit", &error, DBUS_TYPE_STRING, &unit, DBUS_TYPE_INVALID);
+	if (!reply)
+		goto failure;
+
+	if (!dbus_message_get_args(reply, &error, DBUS_TYPE_OBJECT_PATH, &str,
+				DBUS_TYPE_INVALID) || !ni_string_dup(&path, str))
+		goto failure;
+	dbus_message_unref(reply);
+	reply = NULL;
+
+	for (iface = interfaces; *iface && !reply; ++iface) {
+		dbus_error_free(&error);
+		reply = ni_systemd_call(path, NI_SYSTEMD_PROPERTIES_INTERFACE, "Get",
+				&error, DBUS_TYPE_STRING, iface,
+				DBUS_TYPE_STRING, &property,
+				DBUS_TYPE_INVALID);
+		if (!ni_systemd_subscribed)
+			goto failure;
+	}
+	if (!reply)
+		goto failure;
+
+	if (ni_dbus_message_get_args_variants(reply, &value, 1) != 1 ||
+	    !(str = ni_dbus_variant_sprint(&value)) ||
+	    !ni_string_dup(result, str))
+		goto failure;
+
+	rv = 0;
+
+failure:
+	if (rv && !ni_systemd_subscribed)
+		rv = 1;
+	else if (rv)
+		ni_debug_dbus("systemd: cannot get %s property %s: %s", unit, property,
+				dbus_error_is_set(&error) ? error.message : "invalid reply");
+	ni_dbus_variant_destroy(&value);
+	if (reply)
+		dbus_message_unref(reply);
+	ni_string_free(&path);
+	dbus_error_free(&error);
+	return rv;
+}
 
 static const char *
 ni_systemctl_tool_path(void)
@@ -45,10 +482,10 @@ ni_systemctl_tool_path(void)
 }
 
 /*
- * systemd instance service methods
+ * systemd instance service methods using the systemctl tool
  */
-int
-ni_systemctl_service_start(const char *service)
+static int
+ni_systemctl_tool_service_start(const char *service)
 {
 	const char *systemctl;
 	ni_shellcmd_t *cmd;
@@ -88,8 +525,8 @@ failure:
 	return -1;
 }
 
-int
-ni_systemctl_service_stop(const char *service)
+static int
+ni_systemctl_tool_service_stop(const char *service)
 {
 	const char *systemctl;
 	ni_shellcmd_t *cmd;
@@ -129,8 +566,8 @@ failure:
 	return -1;
 }
 
-const char *
-ni_systemctl_service_show_property(const char *service, const char *property, char **result)
+static const char *
+ni_systemctl_tool_service_show_property(const char *service, const char *property, char **result)
 {
 	const char *systemctl;
 	char *complete = NULL;
@@ -204,3 +641,59 @@ failure:
 	ni_buffer_destroy(&buf);
 	return NULL;
 }
+
+/*
+ * systemd instance service methods, queuing a job at the systemd
+ * manager and falling back to systemctl without a system bus.
+ * When 0 is returned, the callback is completed with the job result
+ * once the job is finished (immediately when systemctl was used).
+ */
+int
+ni_systemctl_service_start(const char *service, ni_systemctl_job_callback_t *callback,
+				void *user_data)
+{
+	int rv;
+
+	if (ni_string_empty(service))
+		return -1;
+
+	if ((rv = ni_systemd_unit_job("StartUnit", ni_systemctl_tool_service_start,
+					service, callback, user_data)) <= 0)
+		return rv;
+
+	if ((rv = ni_systemctl_tool_service_start(service)) == 0 && callback)
+		callback(service, 0, user_data);
+	return rv;
+}
+
+int
+ni_systemctl_service_stop(const char *service, ni_systemctl_job_callback_t *callback,
+				void *user_data)
+{
+	int rv;
+
+	if (ni_string_empty(service))
+		return -1;
+
+	if ((rv = ni_systemd_unit_job("StopUnit", ni_systemctl_tool_service_stop,
+					service, callback, user_data)) <= 0)
+		return rv;
+
+	if ((rv = ni_systemctl_tool_service_stop(service)) == 0 && callback)
+		callback(service, 0, user_data);
+	return rv;
+}
+
+const char *
+ni_systemctl_service_show_property(const char *service, const char *property, char **result)
+{
+	int rv;
+
+	if (ni_string_empty(service) || ni_string_empty(property) || !result)
+		return NULL;
+
+	if ((rv = ni_systemd_unit_property(service, property, result)) <= 0)
+		return rv ? NULL : *result;
+
+	return ni_systemctl_tool_service_show_property(service, property, result);
+}
@@ -23,11 +23,20 @@
 #ifndef NI_SYSTEMCTL_H
 #define NI_SYSTEMCTL_H
 
+#include <wicked/dbus.h>
+
 /*
  * Systemd helpers
  */
-extern int		ni_systemctl_service_start(const char *);
-extern int		ni_systemctl_service_stop(const char *);
+typedef void		ni_systemctl_job_callback_t(const char *service, int result,
+						void *user_data);
+
+extern void		ni_systemctl_bus_attach(ni_dbus_connection_t *);
+
+extern int		ni_systemctl_service_start(const char *,
+						ni_systemctl_job_callback_t *, void *);
+extern int		ni_systemctl_service_stop(const char *,
+						ni_systemctl_job_callback_t *, void *);
 
 extern const char *	ni_systemctl_service_show_property(const char *, const char *, char **);
 
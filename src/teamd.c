@@ -1463,12 +1463,91 @@ ni_teamd_config_file_remove(const char *instance)
 
 /*
  * teamd systemd instance service methods
+ *
+ * The config file is written before the start job is queued and
+ * removed before the stop job. Only the latest job queued for an
+ * instance cleans up when it completes, so a failed or canceled
+ * start does not remove the config file a newer start has written.
+ */
+typedef struct ni_teamd_service_job {
+	char *				ifname;
+	unsigned int			seq;
+
+	ni_systemctl_job_callback_t *	callback;
+	void *				user_data;
+} ni_teamd_service_job_t;
+
+static ni_var_array_t			ni_teamd_service_jobs = NI_VAR_ARRAY_INIT;
+static unsigned int			ni_teamd_service_seq;
+
+static ni_teamd_service_job_t *
+ni_teamd_service_job_new(const char *ifname, ni_systemctl_job_callback_t *callback,
+				void *user_data)
+{
+	ni_teamd_service_job_t *job;
+
+	job = xcalloc(1, sizeof(*job));
+	ni_string_dup(&job->ifname, ifname);
+	job->seq = ++ni_teamd_service_seq;
+	job->callback = callback;
+	job->user_data = user_data;
+	ni_var_array_set_uint(&ni_teamd_service_jobs, ifname, job->seq);
+	return job;
+}
+
+static ni_bool_t
+ni_teamd_service_job_latest(const ni_teamd_service_job_t *job)
+{
+	unsigned int seq;
+
+	if (ni_var_array_get_uint(&ni_teamd_service_jobs, job->ifname, &seq) != 1 ||
+	    seq != job->seq)
+		return FALSE;
+
+	ni_var_array_remove(&ni_teamd_service_jobs, job->ifname);
+	return TRUE;
+}
+
+static void
+ni_teamd_service_job_free(ni_teamd_service_job_t *job)
+{
+	ni_string_free(&job->ifname);
+	free(job);
+}
+
+static void
+ni_teamd_service_start_done(const char *service, int result, void *user_data)
+{
+	ni_teamd_service_job_t *job = user_data;
+
+	if (ni_teamd_service_job_latest(job) && result < 0)
+		ni_teamd_config_file_remove(job->ifname);
+
+	if (job->callback)
+		job->callback(service, result, job->user_data);
+	ni_teamd_service_job_free(job);
+}
+
+static void
+ni_teamd_service_stop_done(const char *service, int result, void *user_data)
+{
+	ni_teamd_service_job_t *job = user_data;
+
+	ni_teamd_service_job_latest(job);
+	ni_teamd_service_job_free(job);
+}
+
+/*
+ * Queue the start of the teamd instance for the team device; when 0
+ * is returned, the callback is completed with the job result.
  */
 int
-ni_teamd_service_start(const ni_netdev_t *cfg)
+ni_teamd_service_start(const ni_netdev_t *cfg, ni_systemctl_job_callback_t *callback,
+			void *user_data)
 {
-	int rv;
+	ni_teamd_service_job_t *job;
 	char *service = NULL;
+	int rv;
 
 	if (!cfg || ni_string_empty(cfg->name) || !cfg->team)
 		return -1;
@@ -1476,10 +1555,14 @@ ni_teamd_service_start(const ni_netdev_t *cfg)
 	if (ni_teamd_config_file_write(cfg->name, cfg->team, &cfg->link.hwaddr) < 0)
 		return -1;
 
+	job = ni_teamd_service_job_new(cfg->name, callback, user_data);
 	ni_string_printf(&service, NI_TEAMD_SERVICE_FMT, cfg->name);
-	rv = ni_systemctl_service_start(service);
-	if (rv < 0)
-		ni_teamd_config_file_remove(cfg->name);
+	rv = ni_systemctl_service_start(service, ni_teamd_service_start_done, job);
+	if (rv) {
+		if (ni_teamd_service_job_latest(job))
+			ni_teamd_config_file_remove(cfg->name);
+		ni_teamd_service_job_free(job);
+	}
 
 	ni_string_free(&service);
 	return rv;
@@ -1488,13 +1571,20 @@ ni_teamd_service_start(const ni_netdev_t *cfg)
 int
 ni_teamd_service_stop(const char *ifname)
 {
-	int rv;
+	ni_teamd_service_job_t *job;
 	char *service = NULL;
+	int rv;
 
-	ni_string_printf(&service, NI_TEAMD_SERVICE_FMT, ifname);
-	rv = ni_systemctl_service_stop(service);
 	ni_teamd_config_file_remove(ifname);
 
+	job = ni_teamd_service_job_new(ifname, NULL, NULL);
+	ni_string_printf(&service, NI_TEAMD_SERVICE_FMT, ifname);
+	rv = ni_systemctl_service_stop(service, ni_teamd_service_stop_done, job);
+	if (rv) {
+		ni_teamd_service_job_latest(job);
+		ni_teamd_service_job_free(job);
+	}
+
 	ni_string_free(&service);
 	return rv;
 }
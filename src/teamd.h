@@ -28,6 +28,8 @@
 #include <wicked/types.h>
 #include <wicked/team.h>
 
+#include "systemctl.h"
+
 typedef struct ni_teamd_client		ni_teamd_client_t;
 
 ni_teamd_client_t *			ni_teamd_client_open(const char*);
@@ -45,7 +47,8 @@ extern int				ni_teamd_port_enslave(const ni_netdev_t *, const ni_netdev_t *, co
 
 extern int				ni_teamd_discover(ni_netdev_t *);
 
-extern int				ni_teamd_service_start(const ni_netdev_t *);
+extern int				ni_teamd_service_start(const ni_netdev_t *,
+						ni_systemctl_job_callback_t *, void *);
 extern int				ni_teamd_service_stop (const char *);
 
 extern ni_bool_t			ni_teamd_enabled(const char *);
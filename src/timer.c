@@ -9,6 +9,7 @@
 
 #include <sys/time.h>
 #include <wicked/socket.h>
+#include <wicked/metrics.h>
 #include "netinfo_priv.h"
 #include "util_priv.h"
 
@@ -97,6 +98,14 @@ ni_timer_next_timeout(void)
 				__func__, timer,
 				(long) now.tv_sec, (long) now.tv_usec,
 				(long) timer->expires.tv_sec, (long) timer->expires.tv_usec);
+		if (timercmp(&now, &timer->expires, >)) {
+			timersub(&now, &timer->expires, &delta);
+			ni_metric_record(NI_METRIC_TIMER_LAG,
+				(uint64_t)delta.tv_sec * 1000000 + delta.tv_usec);
+		} else {
+			ni_metric_record(NI_METRIC_TIMER_LAG, 0);
+		}
+
 		ni_timer_list = timer->next;
 		timer->callback(timer->user_data, timer);
 		free(timer);
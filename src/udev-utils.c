@@ -29,6 +29,9 @@
 #include <stdlib.h>
 #include <limits.h>
 #include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <sys/inotify.h>
 
 #include <wicked/types.h>
 #include <wicked/util.h>
@@ -44,6 +47,36 @@
 #define _PATH_SYS_CLASS_NET	"/sys/class/net"
 #endif
 
+#define NI_UDEV_RUN_DIR		"/run/udev"
+#define NI_UDEV_SYSTEMD_TAG	"systemd"
+
+/*
+ * udev runtime database reader state: the data/ directory watch
+ * invalidates the cache of the ready state by ifindex; an entry
+ * is valid for the interface name it has been checked for only.
+ */
+typedef struct ni_udev_db_entry {
+	unsigned int		ifindex;
+	char *			ifname;
+	ni_bool_t		ready;
+} ni_udev_db_entry_t;
+
+#define NI_UDEV_DB_ENTRY_CHUNK	16
+
+static struct ni_udev_db {
+	char *			rundir;
+	int			inotify;
+	ni_bool_t		watched;
+	unsigned int		count;
+	ni_udev_db_entry_t *	entries;
+} ni_udev_db = {
+	.rundir		= NULL,
+	.inotify	= -1,
+	.watched	= FALSE,
+	.count		= 0,
+	.entries	= NULL,
+};
+
 struct netdev_uinfo {
 	unsigned int	ifindex;
 	const char *	subsystem;
@@ -302,6 +335,258 @@ netdev_uinfo_ready(const ni_var_array_t *vars, const char *ifname, unsigned int
 	return -1;
 }
 
+static const char *
+ni_udev_db_rundir(void)
+{
+	return ni_udev_db.rundir ? ni_udev_db.rundir : NI_UDEV_RUN_DIR;
+}
+
+static ni_udev_db_entry_t *
+ni_udev_db_lookup(unsigned int ifindex)
+{
+	unsigned int i;
+
+	for (i = 0; i < ni_udev_db.count; ++i) {
+		if (ni_udev_db.entries[i].ifindex == ifindex)
+			return &ni_udev_db.entries[i];
+	}
+	return NULL;
+}
+
+static void
+ni_udev_db_remember(unsigned int ifindex, const char *ifname, ni_bool_t ready)
+{
+	ni_udev_db_entry_t *entry;
+
+	if (!(entry = ni_udev_db_lookup(ifindex))) {
+		if ((ni_udev_db.count % NI_UDEV_DB_ENTRY_CHUNK) == 0) {
+			ni_udev_db.entries = xrealloc(ni_udev_db.entries,
+					(ni_udev_db.count + NI_UDEV_DB_ENTRY_CHUNK) *
+					sizeof(ni_udev_db.entries[0]));
+		}
+		entry = &ni_udev_db.entries[ni_udev_db.count++];
+		entry->ifindex = ifindex;
+		entry->ifname = NULL;
+	}
+	ni_string_dup(&entry->ifname, ifname);
+	entry->ready = ready;
+}
+
+static void
+ni_udev_db_forget(unsigned int ifindex)
+{
+	ni_udev_db_entry_t *entry;
+
+	if (!(entry = ni_udev_db_lookup(ifindex)))
+		return;
+
+	ni_string_free(&entry->ifname);
+	*entry = ni_udev_db.entries[--ni_udev_db.count];
+}
+
+static void
+ni_udev_db_flush(void)
+{
+	while (ni_udev_db.count)
+		ni_string_free(&ni_udev_db.entries[--ni_udev_db.count].ifname);
+	free(ni_udev_db.entries);
+	ni_udev_db.entries = NULL;
+}
+
+/*
+ * (Re)set the udev run directory, e.g. to a test fixture;
+ * NULL resets to /run/udev and releases the cache state.
+ */
+void
+ni_udev_db_init(const char *rundir)
+{
+	if (ni_udev_db.inotify >= 0)
+		close(ni_udev_db.inotify);
+	ni_udev_db.inotify = -1;
+	ni_udev_db.watched = FALSE;
+	ni_udev_db_flush();
+	ni_string_dup(&ni_udev_db.rundir, rundir);
+}
+
+/*
+ * Watch the data/ directory; udev writes the db files via
+ * rename, so a moved_to/delete event tells us to re-read.
+ */
+static ni_bool_t
+ni_udev_db_watch(const char *datadir)
+{
+	if (ni_udev_db.watched)
+		return ni_udev_db.inotify >= 0;
+
+	ni_udev_db.watched = TRUE;
+	ni_udev_db.inotify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	if (ni_udev_db.inotify < 0) {
+		ni_debug_verbose(NI_LOG_DEBUG, NI_TRACE_EVENTS,
+				"udev db: cannot create inotify instance: %m");
+		return FALSE;
+	}
+
+	if (inotify_add_watch(ni_udev_db.inotify, datadir, IN_CREATE |
+				IN_CLOSE_WRITE | IN_MOVED_TO | IN_MOVED_FROM |
+				IN_DELETE | IN_DELETE_SELF) < 0) {
+		ni_debug_verbose(NI_LOG_DEBUG, NI_TRACE_EVENTS,
+				"udev db: cannot watch %s: %m", datadir);
+		close(ni_udev_db.inotify);
+		ni_udev_db.inotify = -1;
+		return FALSE;
+	}
+	return TRUE;
+}
+
+static void
+ni_udev_db_process_events(void)
+{
+	char buf[4096] __attribute__ ((aligned(__alignof__(struct inotify_event))));
+	const struct inotify_event *ev;
+	unsigned int ifindex;
+	ssize_t len;
+	char *ptr;
+
+	if (ni_udev_db.inotify < 0)
+		return;
+
+	while ((len = read(ni_udev_db.inotify, buf, sizeof(buf))) > 0) {
+		for (ptr = buf; ptr < buf + len; ptr += sizeof(*ev) + ev->len) {
+			ev = (const struct inotify_event *)ptr;
+
+			if (ev->mask & (IN_DELETE_SELF | IN_IGNORED)) {
+				/* watch is gone, set it up again on next query */
+				ni_udev_db_init(ni_udev_db.rundir);
+				return;
+			}
+			if (ev->mask & IN_Q_OVERFLOW) {
+				ni_udev_db_flush();
+				continue;
+			}
+			if (!ev->len || ev->name[0] != 'n')
+				continue;
+			if (ni_parse_uint(ev->name + 1, &ifindex, 10) == 0)
+				ni_udev_db_forget(ifindex);
+		}
+	}
+}
+
+/*
+ * The n<ifindex> data file is the net subsystem entry of the ifindex;
+ * INTERFACE and INTERFACE_OLD are recorded while udev renames it.
+ */
+struct ni_udev_db_info {
+	ni_bool_t		systemd;
+	char *			interface;
+	char *			interface_old;
+};
+
+static void
+ni_udev_db_info_read(struct ni_udev_db_info *info, FILE *fp,
+			const char *rundir, unsigned int ifindex)
+{
+	char line[BUFSIZ], path[PATH_MAX];
+
+	while (fgets(line, sizeof(line), fp)) {
+		line[strcspn(line, "\r\n")] = '\0';
+
+		/* G: are all tags, Q: the current tags (newer udev) */
+		if ((line[0] == 'G' || line[0] == 'Q') && line[1] == ':') {
+			if (ni_string_eq(line + 2, NI_UDEV_SYSTEMD_TAG))
+				info->systemd = TRUE;
+		} else
+		if (!strncmp(line, "E:INTERFACE=", sizeof("E:INTERFACE=") - 1)) {
+			ni_string_dup(&info->interface, line + sizeof("E:INTERFACE=") - 1);
+		} else
+		if (!strncmp(line, "E:INTERFACE_OLD=", sizeof("E:INTERFACE_OLD=") - 1)) {
+			ni_string_dup(&info->interface_old, line + sizeof("E:INTERFACE_OLD=") - 1);
+		}
+	}
+
+	if (!info->systemd) {
+		snprintf(path, sizeof(path), "%s/tags/%s/n%u", rundir,
+				NI_UDEV_SYSTEMD_TAG, ifindex);
+		info->systemd = ni_file_exists(path);
+	}
+}
+
+static void
+ni_udev_db_info_destroy(struct ni_udev_db_info *info)
+{
+	ni_string_free(&info->interface);
+	ni_string_free(&info->interface_old);
+}
+
+/*
+ * Check udev database for the initialized state of a network
+ * device, that is the n<ifindex> data file, the systemd tag and
+ * no pending rename (as netdev_uinfo_ready checks via udevadm).
+ *
+ * Returns 1 when ready, 0 when not and -1 without udev database.
+ */
+int
+ni_udev_db_netdev_ready(unsigned int ifindex, const char *ifname)
+{
+	struct ni_udev_db_info info = { .systemd = FALSE };
+	const char *rundir = ni_udev_db_rundir();
+	const ni_udev_db_entry_t *entry;
+	char path[PATH_MAX];
+	ni_bool_t ready;
+	FILE *fp;
+
+	if (!ifindex)
+		return -1;
+
+	snprintf(path, sizeof(path), "%s/data", rundir);
+	if (!ni_udev_db.watched && !ni_isdir(path))
+		return -1;
+
+	if (ni_udev_db_watch(path)) {
+		ni_udev_db_process_events();
+		entry = ni_udev_db_lookup(ifindex);
+		if (entry && ni_string_eq(entry->ifname, ifname))
+			return entry->ready ? 1 : 0;
+	}
+
+	snprintf(path, sizeof(path), "%s/data/n%u", rundir, ifindex);
+	if ((fp = fopen(path, "re"))) {
+		ni_udev_db_info_read(&info, fp, rundir, ifindex);
+		fclose(fp);
+		ready = info.systemd;
+	} else if (errno == ENOENT) {
+		ready = FALSE;
+	} else {
+		ni_debug_verbose(NI_LOG_DEBUG, NI_TRACE_EVENTS,
+				"udev db: cannot open %s: %m", path);
+		return -1;
+	}
+
+	if (ready && info.interface_old) {
+		ni_debug_verbose(NI_LOG_DEBUG3, NI_TRACE_EVENTS,
+				"udev db: device n%u interface_old still set to %s",
+				ifindex, info.interface_old);
+		ready = FALSE;
+	} else
+	if (ready && info.interface) {
+		if (!ni_string_eq(info.interface, ifname)) {
+			ni_debug_verbose(NI_LOG_DEBUG3, NI_TRACE_EVENTS,
+					"udev db: device n%u interface %s differs from %s",
+					ifindex, info.interface, ifname);
+			ready = FALSE;
+		}
+	}
+	ni_udev_db_info_destroy(&info);
+
+	ni_debug_verbose(NI_LOG_DEBUG3, NI_TRACE_EVENTS,
+			"udev db: device n%u is %s", ifindex,
+			ready ? "initialized" : "not initialized");
+
+	/* a rename of the device misses the entry of the old name */
+	if (ni_udev_db.inotify >= 0)
+		ni_udev_db_remember(ifindex, ifname, ready);
+	return ready ? 1 : 0;
+}
+
 static int
 ni_udev_netdev_update_name(ni_netdev_t *dev)
 {
@@ -328,6 +613,12 @@ ni_udev_netdev_is_ready(ni_netdev_t *dev)
 	ni_var_array_t *vars = NULL;
 	int ret, retry = 2;
 
+	/* read the udev database directly, udevadm only without it */
+	if (!dev || ni_udev_netdev_update_name(dev) < 0)
+		return FALSE;
+	if ((ret = ni_udev_db_netdev_ready(dev->link.ifindex, dev->name)) >= 0)
+		return ret > 0;
+
 	do {
 		/*
 		 * we're called to bootstrap before events listeners
@@ -31,4 +31,7 @@ extern ni_bool_t		ni_udev_is_active(void);
 extern ni_bool_t		ni_udev_net_subsystem_available(void);
 extern ni_bool_t		ni_udev_netdev_is_ready(ni_netdev_t *);
 
+extern void			ni_udev_db_init(const char *);
+extern int			ni_udev_db_netdev_ready(unsigned int, const char *);
+
 #endif /* WICKED_UDEV_UTILS_H */
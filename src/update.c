@@ -89,6 +89,8 @@ struct ni_updater_job {
 
 	const ni_updater_action_t *	actions;
 	ni_process_t *			process;
+	unsigned int			resolve;
+	unsigned int			lookups;
 	int				result;
 
 	char *				hostname;
@@ -471,7 +473,7 @@ ni_updater_job_cancel(ni_updater_job_t *job)
 {
 	ni_stringbuf_t out = NI_STRINGBUF_INIT_DYNAMIC;
 	if (job) {
-		if (job->state != NI_UPDATER_JOB_FINISHED || job->process)
+		if (job->state != NI_UPDATER_JOB_FINISHED || job->process || job->resolve)
 			ni_debug_verbose(NI_LOG_DEBUG1, NI_TRACE_EXTENSION,
 					"cancel %s", ni_updater_job_info(&out, job));
 		else
@@ -493,6 +495,11 @@ ni_updater_job_cancel(ni_updater_job_t *job)
 			ni_process_free(job->process);
 			job->process = NULL;
 		}
+		if (job->resolve) {
+			ni_resolve_async_cancel(job->resolve);
+			job->resolve = 0;
+			ni_updater_job_free(job);
+		}
 	}
 }
 
@@ -1437,49 +1444,81 @@ ni_system_updater_hostname_cleanup_wait(ni_updater_t *updater, ni_updater_job_t
 	return 0;
 }
 
-static int
-do_reverse_resolve_ip_address(int argc, char *const argv[], char *const envp[])
+static const ni_address_t *
+ni_system_updater_hostname_lookup_addr(const ni_updater_job_t *job, unsigned int n)
 {
-	unsigned int count = 0;
-	char *name = NULL;
-	int n;
+	const ni_address_t *ap;
 
-	if (argc < 1 || !argv)
-		return EXIT_FAILURE;
+	for (ap = job->lease->addrs; ap; ap = ap->next) {
+		if (ni_address_is_tentative(ap) || ni_address_is_duplicate(ap))
+			continue;
 
-	if (!freopen("/dev/null", "w", stderr))
-		{}
+		if (!ni_sockaddr_is_specified(&ap->local_addr))
+			continue;
 
-	for (n = 1; n < argc && argv[n]; ++n) {
-		ni_sockaddr_t addr;
+		if (n-- == 0)
+			return ap;
+	}
+	return NULL;
+}
 
-		if (ni_sockaddr_parse(&addr, argv[n], AF_UNSPEC) ||
-		    !ni_sockaddr_is_specified(&addr))
-			continue;
+static void			ni_system_updater_hostname_resolved(int, const char *,
+						const ni_sockaddr_t *, void *);
 
-		if (!ni_resolve_reverse_timed(&addr, &name,
-					NI_UPDATER_REVERSE_TIMEOUT)) {
-			fprintf(stdout, "%s", name);
-			fflush(stdout);
-			ni_string_free(&name);
-			return EXIT_SUCCESS;
-		}
+static ni_bool_t
+ni_system_updater_hostname_lookup_next(ni_updater_job_t *job)
+{
+	const ni_address_t *ap;
 
-		if (++count >= NI_UPDATER_REVERSE_MAX_CNT)
+	while (job->lookups < NI_UPDATER_REVERSE_MAX_CNT) {
+		if (!(ap = ni_system_updater_hostname_lookup_addr(job, job->lookups++)))
 			break;
+
+		job->resolve = ni_resolve_reverse_async(&ap->local_addr,
+					NI_UPDATER_REVERSE_TIMEOUT * 1000,
+					ni_system_updater_hostname_resolved, job);
+		if (job->resolve) {
+			ni_updater_job_ref(job);
+			ni_debug_extension("%s: started lease %s:%s state %s %s lookup of %s",
+					job->device.name,
+					ni_addrfamily_type_to_name(job->lease->family),
+					ni_addrconf_type_to_name(job->lease->type),
+					ni_addrconf_state_to_name(job->lease->state),
+					ni_updater_name(job->kind),
+					ni_sockaddr_print(&ap->local_addr));
+			return TRUE;
+		}
+	}
+	return FALSE;
+}
+
+static void
+ni_system_updater_hostname_resolved(int error, const char *name,
+				const ni_sockaddr_t *addr, void *user_data)
+{
+	ni_updater_job_t *job = user_data;
+
+	if (!job || !job->resolve)
+		return;
+
+	job->resolve = 0;
+	if (!error && name && ni_check_domain_name(name, strlen(name), 0)) {
+		ni_string_dup(&job->hostname, name);
+		job->result = 0;
+	} else if (!ni_system_updater_hostname_lookup_next(job)) {
+		job->result = 1;
 	}
-	return EXIT_FAILURE;
+
+	if (!job->resolve)
+		ni_updater_job_call_updater(job);
+	ni_updater_job_free(job);
 }
 
 static int
 ni_system_updater_hostname_lookup_call(ni_updater_t *updater, ni_updater_job_t *job)
 {
-	const ni_address_t *ap;
-	ni_shellcmd_t *shellcmd;
-	ni_process_t *pi;
-	int rv;
-
 	job->result = 0;
+	job->lookups = 0;
 
 	if (!ni_string_empty(job->lease->hostname)) {
 		ni_string_dup(&job->hostname, job->lease->hostname);
@@ -1490,54 +1529,29 @@ ni_system_updater_hostname_lookup_call(ni_updater_t *updater, ni_updater_job_t *
 	if (!can_try_reverse_lookup(job->lease))
 		return -1;
 
-	shellcmd = ni_shellcmd_parse("wickedd-resolver");
-	if (!shellcmd)
-		return -1;
-
-	pi = ni_process_new(shellcmd);
-	ni_shellcmd_free(shellcmd);
-	if (!pi)
+	if (!ni_system_updater_hostname_lookup_next(job))
 		return -1;
 
-	for (ap = job->lease->addrs; ap; ap = ap->next) {
-		const char *addr;
-
-		if (ni_address_is_tentative(ap) || ni_address_is_duplicate(ap))
-			continue;
-
-		if (!ni_sockaddr_is_specified(&ap->local_addr))
-			continue;
-
-		if ((addr = ni_sockaddr_print(&ap->local_addr)))
-			ni_string_array_append(&pi->argv, addr);
-	}
-	if (pi->argv.count <= 1) {
-		ni_process_free(pi);
-		return -1;
-	}
-
-	pi->exec = do_reverse_resolve_ip_address;
-	rv = ni_process_run(pi);
-	if (rv == NI_PROCESS_SUCCESS) {
-		job->process = pi;
-		pi->user_data = ni_updater_job_ref(job);
-		pi->notify_callback = ni_system_updater_notify;
-		ni_debug_extension("%s: started lease %s:%s state %s %s updater (%s) with pid %d",
-				job->device.name,
-				ni_addrfamily_type_to_name(job->lease->family),
-				ni_addrconf_type_to_name(job->lease->type),
-				ni_addrconf_state_to_name(job->lease->state),
-				ni_updater_name(job->kind),
-				ni_basename(shellcmd->command), pi->pid);
-	} else {
-		ni_process_free(pi);
-	}
-	return rv;
+	return 0;
 }
 static int
 ni_system_updater_hostname_lookup_wait(ni_updater_t *updater, ni_updater_job_t *job)
 {
-	return ni_system_updater_process_wait(updater, job, __func__);
+	if (job->resolve) {
+		ni_debug_verbose(NI_LOG_DEBUG1, NI_TRACE_EXTENSION,
+			"%s: waiting for %s job reverse lookup for lease %s:%s in state %s",
+			job->device.name, ni_updater_name(job->kind),
+			ni_addrfamily_type_to_name(job->lease->family),
+			ni_addrconf_type_to_name(job->lease->type),
+			ni_addrconf_state_to_name(job->lease->state));
+		return 1;
+	}
+
+	if (job->result == 0)
+		return 0;
+
+	job->result = 0;
+	return -1;
 }
 
 static int
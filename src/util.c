@@ -460,6 +460,163 @@ ni_uint_array_set(ni_uint_array_t *nua, unsigned int index, unsigned int num)
 	return TRUE;
 }
 
+/*
+ * Optional lookup index of a variable array.
+ *
+ * The hash maps variable names to their array position (stored as
+ * position + 1, so 0 marks an empty slot) and is maintained on every
+ * append. The sorted position list serves prefix lookups and is built
+ * lazily on the first prefix query after a modification.
+ */
+struct ni_var_index {
+	unsigned int		size;
+	unsigned int		used;
+	unsigned int *		slots;
+
+	ni_bool_t		sorted_valid;
+	unsigned int *		sorted;
+};
+
+#define NI_VAR_INDEX_MIN_SIZE	64
+
+static unsigned int
+__ni_var_index_hash(const char *name)
+{
+	unsigned int hash = 2166136261U;
+
+	/* FNV-1a; NULL hashes like the empty string */
+	if (name) {
+		while (*name) {
+			hash ^= (unsigned char)*name++;
+			hash *= 16777619U;
+		}
+	}
+	return hash;
+}
+
+static void
+__ni_var_index_insert(ni_var_index_t *index, const ni_var_array_t *nva, unsigned int pos)
+{
+	const char *name = nva->data[pos].name;
+	unsigned int mask = index->size - 1;
+	unsigned int h, slot;
+
+	h = __ni_var_index_hash(name) & mask;
+	while ((slot = index->slots[h]) != 0) {
+		/* keep the first occurrence, like the linear scan did */
+		if (ni_string_eq(nva->data[slot - 1].name, name))
+			return;
+		h = (h + 1) & mask;
+	}
+	index->slots[h] = pos + 1;
+	index->used++;
+}
+
+static void
+__ni_var_index_rehash(ni_var_index_t *index, const ni_var_array_t *nva)
+{
+	unsigned int size, i;
+
+	for (size = NI_VAR_INDEX_MIN_SIZE; size < 2 * nva->count; size <<= 1)
+		;
+
+	if (size != index->size) {
+		free(index->slots);
+		index->slots = xcalloc(size, sizeof(index->slots[0]));
+		index->size = size;
+	} else {
+		memset(index->slots, 0, size * sizeof(index->slots[0]));
+	}
+	index->used = 0;
+
+	for (i = 0; i < nva->count; ++i)
+		__ni_var_index_insert(index, nva, i);
+
+	index->sorted_valid = FALSE;
+}
+
+static void
+__ni_var_index_append(ni_var_array_t *nva, unsigned int pos)
+{
+	ni_var_index_t *index = nva->index;
+
+	if (!index)
+		return;
+
+	if (2 * (index->used + 1) > index->size)
+		__ni_var_index_rehash(index, nva);
+	else
+		__ni_var_index_insert(index, nva, pos);
+	index->sorted_valid = FALSE;
+}
+
+static ni_var_t *
+__ni_var_index_lookup(const ni_var_array_t *nva, const char *name)
+{
+	const ni_var_index_t *index = nva->index;
+	unsigned int mask = index->size - 1;
+	unsigned int h, slot;
+
+	h = __ni_var_index_hash(name) & mask;
+	while ((slot = index->slots[h]) != 0) {
+		if (ni_string_eq(nva->data[slot - 1].name, name))
+			return &nva->data[slot - 1];
+		h = (h + 1) & mask;
+	}
+	return NULL;
+}
+
+static void
+__ni_var_index_free(ni_var_index_t *index)
+{
+	if (index) {
+		free(index->slots);
+		free(index->sorted);
+		free(index);
+	}
+}
+
+static int
+__ni_var_index_sort_cmp(const void *a, const void *b, void *data)
+{
+	const ni_var_t *vars = data;
+	const char *na = vars[*(const unsigned int *)a].name;
+	const char *nb = vars[*(const unsigned int *)b].name;
+	int ret;
+
+	if ((ret = strcmp(na ? na : "", nb ? nb : "")))
+		return ret;
+	/* stable for duplicate names */
+	return (int)*(const unsigned int *)a - (int)*(const unsigned int *)b;
+}
+
+static int
+__ni_var_index_pos_cmp(const void *a, const void *b)
+{
+	unsigned int pa = *(const unsigned int *)a;
+	unsigned int pb = *(const unsigned int *)b;
+
+	return pa < pb ? -1 : pa > pb;
+}
+
+static void
+__ni_var_index_sort(const ni_var_array_t *nva)
+{
+	ni_var_index_t *index = nva->index;
+	unsigned int i;
+
+	if (index->sorted_valid)
+		return;
+
+	free(index->sorted);
+	index->sorted = xcalloc(nva->count + 1, sizeof(index->sorted[0]));
+	for (i = 0; i < nva->count; ++i)
+		index->sorted[i] = i;
+	qsort_r(index->sorted, nva->count, sizeof(index->sorted[0]),
+			__ni_var_index_sort_cmp, nva->data);
+	index->sorted_valid = TRUE;
+}
+
 /*
  * Array of variables
  */
@@ -493,15 +650,97 @@ ni_var_array_destroy(ni_var_array_t *nva)
 		free(nva->data[i].value);
 	}
 	free(nva->data);
+	__ni_var_index_free(nva->index);
 	memset(nva, 0, sizeof(*nva));
 }
 
+/*
+ * Enable a name hash index on the array, speeding up lookups
+ * of large arrays, e.g. sysconfig files with many variables.
+ */
+void
+ni_var_array_index_enable(ni_var_array_t *nva)
+{
+	if (!nva || nva->index)
+		return;
+
+	nva->index = xcalloc(1, sizeof(*nva->index));
+	__ni_var_index_rehash(nva->index, nva);
+}
+
+void
+ni_var_array_index_disable(ni_var_array_t *nva)
+{
+	if (nva) {
+		__ni_var_index_free(nva->index);
+		nva->index = NULL;
+	}
+}
+
+/*
+ * Find all variables with names starting with prefix and append
+ * their array positions in array order to the result.
+ */
+unsigned int
+ni_var_array_find_prefix(const ni_var_array_t *nva, const char *prefix, ni_uint_array_t *res)
+{
+	unsigned int lo, hi, mid, pfxlen, count = 0;
+	const char *name;
+	ni_var_t *var;
+
+	if (!nva || !res)
+		return 0;
+
+	if (!prefix)
+		prefix = "";
+	pfxlen = strlen(prefix);
+
+	if (!nva->index) {
+		for (lo = 0, var = nva->data; lo < nva->count; ++lo, ++var) {
+			if (var->name && !strncmp(var->name, prefix, pfxlen)) {
+				ni_uint_array_append(res, lo);
+				count++;
+			}
+		}
+		return count;
+	}
+
+	__ni_var_index_sort(nva);
+
+	/* lower bound: first name not less than prefix */
+	for (lo = 0, hi = nva->count; lo < hi; ) {
+		mid = lo + (hi - lo) / 2;
+		name = nva->data[nva->index->sorted[mid]].name;
+		if (strcmp(name ? name : "", prefix) < 0)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	for (hi = res->count; lo < nva->count; ++lo) {
+		name = nva->data[nva->index->sorted[lo]].name;
+		if (!name || strncmp(name, prefix, pfxlen))
+			break;
+		ni_uint_array_append(res, nva->index->sorted[lo]);
+		count++;
+	}
+
+	if (count > 1) {
+		qsort(res->data + hi, count, sizeof(res->data[0]),
+				__ni_var_index_pos_cmp);
+	}
+	return count;
+}
+
 ni_var_t *
 ni_var_array_get(const ni_var_array_t *nva, const char *name)
 {
 	unsigned int i;
 	ni_var_t *var;
 
+	if (nva->index)
+		return __ni_var_index_lookup(nva, name);
+
 	for (i = 0, var = nva->data; i < nva->count; ++i, ++var) {
 		if (ni_string_eq(var->name, name))
 			return var;
@@ -542,6 +781,9 @@ ni_var_array_remove_at(ni_var_array_t *array, unsigned int index)
 	array->data[array->count].name = NULL;
 	array->data[array->count].value = NULL;
 
+	if (array->index)
+		__ni_var_index_rehash(array->index, array);
+
 	return TRUE;
 }
 
@@ -551,6 +793,12 @@ ni_var_array_remove(ni_var_array_t *array, const char *name)
 	unsigned int i;
 	ni_var_t *var;
 
+	if (array && array->index) {
+		if (!(var = __ni_var_index_lookup(array, name)))
+			return FALSE;
+		return ni_var_array_remove_at(array, var - array->data);
+	}
+
 	if (array) {
 		for (i = 0, var = array->data; i < array->count; ++i, ++var) {
 			if (ni_string_eq(var->name, name))
@@ -571,6 +819,7 @@ __ni_var_array_append(ni_var_array_t *nva, const char *name, const char *value)
 	var = &nva->data[nva->count++];
 	var->name = xstrdup(name);
 	var->value = xstrdup(value);
+	__ni_var_index_append(nva, nva->count - 1);
 }
 
 void
@@ -585,6 +834,7 @@ ni_var_array_set(ni_var_array_t *nva, const char *name, const char *value)
 		var = &nva->data[nva->count++];
 		var->name = xstrdup(name);
 		var->value = NULL;
+		__ni_var_index_append(nva, nva->count - 1);
 	}
 
 	ni_string_dup(&var->value, value);
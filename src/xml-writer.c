@@ -25,13 +25,27 @@
 #include "config.h"
 #endif
 
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+
 #include <wicked/xml.h>
 #include <wicked/logging.h>
 #include "netinfo_priv.h"
 #include "buffer.h"
 
+/*
+ * The writer serializes into one contiguous, geometrically growing
+ * buffer and hands it to the file (with a single write), the hash
+ * context (in chunks) or the caller (sprint) at the end.
+ */
+#define XML_WRITER_CHUNK	4096
+#define XML_WRITER_HASH_CHUNK	65536
+#define XML_WRITER_HASH_TOKEN	255
+
 typedef struct xml_writer {
 	FILE *		file;
+	int		fd;
 	ni_hashctx_t *	hash;
 	unsigned int	noclose : 1;
 	ni_stringbuf_t	buffer;
@@ -40,15 +54,20 @@ typedef struct xml_writer {
 static int		xml_writer_open(xml_writer_t *, const char *);
 static int		xml_writer_init_file(xml_writer_t *, FILE *);
 static int		xml_writer_init_hash(xml_writer_t *, ni_hashctx_algo_t);
+static void		xml_writer_init_buffer(xml_writer_t *);
+static int		xml_writer_flush(xml_writer_t *);
 static int		xml_writer_close(xml_writer_t *);
 static int		xml_writer_destroy(xml_writer_t *);
 static int		xml_writer_destroy_get_hash(xml_writer_t *, void *, size_t);
-static void		xml_writer_printf(xml_writer_t *, const char *, ...);
+static char *		xml_writer_steal_string(xml_writer_t *);
+static void		xml_writer_put(xml_writer_t *, const char *, size_t);
+static void		xml_writer_puts(xml_writer_t *, const char *);
+static void		xml_writer_indent(xml_writer_t *, unsigned int);
+static void		xml_writer_put_escaped(xml_writer_t *, const char *);
+static void		xml_writer_hash_token(xml_writer_t *, size_t);
 
 static void		xml_document_output(const xml_document_t *, xml_writer_t *);
 static void		xml_node_output(const xml_node_t *node, xml_writer_t *, unsigned int indent);
-static const char *	xml_escape_quote(const char *);
-static const char *	xml_escape_entities(const char *, char **);
 
 int
 xml_document_write(const xml_document_t *doc, const char *filename)
@@ -77,25 +96,11 @@ xml_document_print(const xml_document_t *doc, FILE *fp)
 char *
 xml_document_sprint(const xml_document_t *doc)
 {
-	char *string = NULL;
-	size_t size = 0;
-	FILE *fp;
-	int rv;
-
-	if ((fp = open_memstream(&string, &size)) == NULL) {
-		ni_error("%s: unable to open memstream", __func__);
-		return NULL;
-	}
-
-	rv = xml_document_print(doc, fp);
-	fclose(fp);
-
-	if (rv < 0) {
-		free(string);
-		return NULL;
-	}
+	xml_writer_t writer;
 
-	return string;
+	xml_writer_init_buffer(&writer);
+	xml_document_output(doc, &writer);
+	return xml_writer_steal_string(&writer);
 }
 
 int
@@ -139,7 +144,7 @@ xml_document_uuid(const xml_document_t *doc, unsigned int version,
 void
 xml_document_output(const xml_document_t *doc, xml_writer_t *writer)
 {
-	xml_writer_printf(writer, "<?xml version=\"1.0\" encoding=\"utf8\"?>\n");
+	xml_writer_puts(writer, "<?xml version=\"1.0\" encoding=\"utf8\"?>\n");
 	xml_node_output(doc->root, writer, 0);
 }
 
@@ -160,25 +165,11 @@ xml_node_print(const xml_node_t *node, FILE *fp)
 char *
 xml_node_sprint(const xml_node_t *node)
 {
-	char *string = NULL;
-	size_t size = 0;
-	FILE *fp;
-	int rv;
-
-	if ((fp = open_memstream(&string, &size)) == NULL) {
-		ni_error("%s: unable to open memstream", __func__);
-		return NULL;
-	}
-
-	rv = xml_node_print(node, fp);
-	fclose(fp);
-
-	if (rv < 0) {
-		free(string);
-		return NULL;
-	}
+	xml_writer_t writer;
 
-	return string;
+	xml_writer_init_buffer(&writer);
+	xml_node_output(node, &writer, 0);
+	return xml_writer_steal_string(&writer);
 }
 
 int
@@ -243,27 +234,19 @@ xml_node_content_uuid(const xml_node_t *node, unsigned int version,
 int
 xml_node_print_fn(const xml_node_t *node, void (*writefn)(const char *, void *), void *user_data)
 {
-	char *membuf = NULL;
-	size_t memsz = 0;
-	FILE *memf;
-	int rv;
-
-	memf = open_memstream(&membuf, &memsz);
-	rv = xml_node_print(node, memf);
-	fclose(memf);
+	char *membuf, *s, *t;
 
-	if (rv >= 0) {
-		char *s, *t;
+	if (!(membuf = xml_node_sprint(node)))
+		return -1;
 
-		for (s = membuf; s; s = t) {
-			if ((t = strchr(s, '\n')) != NULL)
-				*t++ = '\0';
-			writefn(s, user_data);
-		}
+	for (s = membuf; s; s = t) {
+		if ((t = strchr(s, '\n')) != NULL)
+			*t++ = '\0';
+		writefn(s, user_data);
 	}
 
 	free(membuf);
-	return rv;
+	return 0;
 }
 
 /*
@@ -288,25 +271,34 @@ xml_node_output(const xml_node_t *node, xml_writer_t *writer, unsigned int inden
 {
 	unsigned int child_indent = indent;
 	int newline = 0;
+	size_t token;
 
 	if (node->name != NULL) {
 		ni_var_t *attr;
 		unsigned int i;
 
-		xml_writer_printf(writer, "%*.*s<%s", indent, indent, "", node->name);
+		token = writer->buffer.len;
+		xml_writer_indent(writer, indent);
+		xml_writer_put(writer, "<", 1);
+		xml_writer_puts(writer, node->name);
+		xml_writer_hash_token(writer, token);
 		for (i = 0, attr = node->attrs.data; i < node->attrs.count; ++i, ++attr) {
-			if (attr->value)
-				xml_writer_printf(writer, " %s=\"%s\"",
-						attr->name, xml_escape_quote(attr->value));
-			else
-				xml_writer_printf(writer, " %s", attr->name);
+			token = writer->buffer.len;
+			xml_writer_put(writer, " ", 1);
+			xml_writer_puts(writer, attr->name);
+			if (attr->value) {
+				xml_writer_put(writer, "=\"", 2);
+				xml_writer_puts(writer, attr->value);
+				xml_writer_put(writer, "\"", 1);
+			}
+			xml_writer_hash_token(writer, token);
 		}
 
 		if (node->cdata == NULL && node->children == NULL) {
-			xml_writer_printf(writer, "/>\n");
+			xml_writer_put(writer, "/>\n", 3);
 			return;
 		}
-		xml_writer_printf(writer, ">");
+		xml_writer_put(writer, ">", 1);
 		child_indent += 2;
 	} else {
 		newline = 1;
@@ -314,85 +306,73 @@ xml_node_output(const xml_node_t *node, xml_writer_t *writer, unsigned int inden
 
 	if (node->cdata) {
 		unsigned int len;
-		char *temp = NULL;
 
 		if (strchr(node->cdata, '\n')) {
-			xml_writer_printf(writer, "\n");
+			xml_writer_put(writer, "\n", 1);
 			newline = 1;
 		}
-		xml_writer_printf(writer, "%s", xml_escape_entities(node->cdata, &temp));
-		ni_string_free(&temp);
+		token = writer->buffer.len;
+		xml_writer_put_escaped(writer, node->cdata);
+		xml_writer_hash_token(writer, token);
 
 		if (newline) {
 			len = strlen(node->cdata);
 			if (len && node->cdata[len-1] != '\n')
-				xml_writer_printf(writer, "\n");
+				xml_writer_put(writer, "\n", 1);
 		}
 	}
 	if (node->children) {
 		xml_node_t *child;
 
 		if (!newline)
-			xml_writer_printf(writer, "\n");
+			xml_writer_put(writer, "\n", 1);
 		for (child = node->children; child; child = child->next)
 			xml_node_output(child, writer, child_indent);
 		newline = 1;
 	}
 
 	if (node->name != NULL) {
-		if (newline)
-			xml_writer_printf(writer, "%*.*s", indent, indent, "");
-		xml_writer_printf(writer, "</%s>\n", node->name);
+		if (newline) {
+			token = writer->buffer.len;
+			xml_writer_indent(writer, indent);
+			xml_writer_hash_token(writer, token);
+		}
+		token = writer->buffer.len;
+		xml_writer_put(writer, "</", 2);
+		xml_writer_puts(writer, node->name);
+		xml_writer_put(writer, ">\n", 2);
+		xml_writer_hash_token(writer, token);
 	}
 }
 
-const char *
-xml_escape_entities(const char *cdata, char **temp)
-{
-	static const char *escmap[256] = {
-		['<'] = "&lt;",
-		['>'] = "&gt;",
-		['&'] = "&amp;",
-	};
-	const unsigned char *pos;
-	unsigned int expand = 0, idx;
-	char *copy = NULL;
-
-	if (!cdata)
-		return NULL;
-
-	for (pos = (const unsigned char *)cdata; *pos; ++pos) {
-		const char *replace;
-
-		idx = *pos;
-		if ((replace = escmap[idx]) != NULL)
-			expand += strlen(replace);
-	}
-
-	if (expand == 0)
-		return cdata;
-
-	copy = *temp = xmalloc(expand + strlen(cdata) + 1);
-	for (pos = (const unsigned char *)cdata; *pos; ++pos) {
-		const char *replace;
+/*
+ * Copy runs of characters not needing an entity with a single memcpy;
+ * strcspn is vectorized by the C library on the common architectures.
+ */
+static const char *	xml_entity_map[256] = {
+	['<'] = "&lt;",
+	['>'] = "&gt;",
+	['&'] = "&amp;",
+};
 
-		idx = *pos;
-		if ((replace = escmap[idx]) != NULL) {
-			strcpy(copy, replace);
-			copy += strlen(copy);
-		} else {
-			*copy++ = *pos;
+void
+xml_writer_put_escaped(xml_writer_t *writer, const char *cdata)
+{
+	const char *replace;
+	size_t run;
+
+	while (*cdata) {
+		run = strcspn(cdata, "<>&");
+		if (run) {
+			xml_writer_put(writer, cdata, run);
+			cdata += run;
 		}
-	}
-	*copy = '\0';
-
-	return *temp;
-}
+		if (!*cdata)
+			break;
 
-const char *
-xml_escape_quote(const char *string)
-{
-	return string;
+		replace = xml_entity_map[(unsigned char)*cdata++];
+		xml_writer_puts(writer, replace);
+	}
 }
 
 /*
@@ -401,9 +381,9 @@ xml_escape_quote(const char *string)
 int
 xml_writer_open(xml_writer_t *writer, const char *filename)
 {
-	memset(writer, 0, sizeof(*writer));
-	writer->file = fopen(filename, "w");
-	if (!writer->file) {
+	xml_writer_init_buffer(writer);
+	writer->fd = open(filename, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0666);
+	if (writer->fd < 0) {
 		ni_error("xml_writer: cannot open %s for writing: %m", filename);
 		return -1;
 	}
@@ -414,7 +394,7 @@ xml_writer_open(xml_writer_t *writer, const char *filename)
 int
 xml_writer_init_file(xml_writer_t *writer, FILE *file)
 {
-	memset(writer, 0, sizeof(*writer));
+	xml_writer_init_buffer(writer);
 	writer->file = file;
 	writer->noclose = 1;
 	return 0;
@@ -423,24 +403,83 @@ xml_writer_init_file(xml_writer_t *writer, FILE *file)
 int
 xml_writer_init_hash(xml_writer_t *writer, ni_hashctx_algo_t algo)
 {
-	memset(writer, 0, sizeof(*writer));
+	xml_writer_init_buffer(writer);
 	writer->hash = ni_hashctx_new(algo);
 	if (writer->hash)
 		return 0;
 	return -1;
 }
 
+void
+xml_writer_init_buffer(xml_writer_t *writer)
+{
+	memset(writer, 0, sizeof(*writer));
+	ni_stringbuf_init(&writer->buffer);
+	writer->fd = -1;
+}
+
+/*
+ * Pass the buffered output on to the hash context or the file
+ */
+int
+xml_writer_flush(xml_writer_t *writer)
+{
+	ni_stringbuf_t *sb = &writer->buffer;
+	size_t done = 0;
+	ssize_t ret;
+	int rv = 0;
+
+	if (!sb->len)
+		return 0;
+
+	if (writer->hash) {
+		ni_hashctx_put(writer->hash, sb->string, sb->len);
+	} else
+	if (writer->file) {
+		if (fwrite(sb->string, 1, sb->len, writer->file) != sb->len)
+			rv = -1;
+	} else
+	if (writer->fd >= 0) {
+		while (done < sb->len) {
+			ret = write(writer->fd, sb->string + done, sb->len - done);
+			if (ret < 0 && errno == EINTR)
+				continue;
+			if (ret <= 0) {
+				ni_error("xml_writer: write failed: %m");
+				rv = -1;
+				break;
+			}
+			done += ret;
+		}
+	} else {
+		/* memory buffer: keep the output */
+		return 0;
+	}
+
+	sb->len = 0;
+	sb->string[0] = '\0';
+	return rv;
+}
+
 int
 xml_writer_close(xml_writer_t *writer)
 {
 	int rv = 0;
 
+	if (xml_writer_flush(writer) < 0)
+		rv = -1;
+
 	if (writer->file && ferror(writer->file))
 		rv = -1;
 	if (writer->file && !writer->noclose) {
 		fclose(writer->file);
 		writer->file = NULL;
 	}
+	if (writer->fd >= 0) {
+		if (close(writer->fd) < 0)
+			rv = -1;
+		writer->fd = -1;
+	}
 	if (writer->hash) {
 		ni_hashctx_free(writer->hash);
 		writer->hash = NULL;
@@ -451,8 +490,11 @@ xml_writer_close(xml_writer_t *writer)
 int
 xml_writer_destroy(xml_writer_t *writer)
 {
+	int rv;
+
+	rv = xml_writer_close(writer);
 	ni_stringbuf_destroy(&writer->buffer);
-	return xml_writer_close(writer);
+	return rv;
 }
 
 int
@@ -460,6 +502,7 @@ xml_writer_destroy_get_hash(xml_writer_t *writer, void *md_buffer, size_t md_siz
 {
 	int rv;
 
+	xml_writer_flush(writer);
 	ni_hashctx_finish(writer->hash);
 
 	rv = ni_hashctx_get_digest(writer->hash, md_buffer, md_size);
@@ -469,21 +512,72 @@ xml_writer_destroy_get_hash(xml_writer_t *writer, void *md_buffer, size_t md_siz
 	return rv;
 }
 
+char *
+xml_writer_steal_string(xml_writer_t *writer)
+{
+	char *string;
+
+	string = writer->buffer.string;
+	writer->buffer.string = NULL;
+	ni_stringbuf_destroy(&writer->buffer);
+
+	return string ? string : xstrdup("");
+}
+
 void
-xml_writer_printf(xml_writer_t *writer, const char *fmt, ...)
+xml_writer_put(xml_writer_t *writer, const char *data, size_t len)
 {
-	char temp[256];
-	va_list ap;
+	ni_stringbuf_t *sb = &writer->buffer;
+	size_t grow;
 
-	va_start(ap, fmt);
-	if (writer->file) {
-		vfprintf(writer->file, fmt, ap);
-	} else {
-		vsnprintf(temp, sizeof(temp), fmt, ap);
-		if (writer->hash)
-			ni_hashctx_puts(writer->hash, temp);
-		else
-			ni_stringbuf_puts(&writer->buffer, temp);
+	if (sb->len + len + 1 > sb->size) {
+		/* grow geometrically, ni_stringbuf_put grows by 64 bytes */
+		grow = max_t(size_t, sb->size, XML_WRITER_CHUNK);
+		ni_stringbuf_grow(sb, max_t(size_t, grow, len));
+	}
+
+	memcpy(sb->string + sb->len, data, len);
+	sb->len += len;
+	sb->string[sb->len] = '\0';
+}
+
+/*
+ * The digests (and config UUIDs) have always been computed over
+ * output tokens truncated to 255 bytes; keep them stable.
+ */
+void
+xml_writer_hash_token(xml_writer_t *writer, size_t start)
+{
+	ni_stringbuf_t *sb = &writer->buffer;
+
+	if (!writer->hash)
+		return;
+
+	if (sb->len - start > XML_WRITER_HASH_TOKEN) {
+		sb->len = start + XML_WRITER_HASH_TOKEN;
+		sb->string[sb->len] = '\0';
+	}
+	if (sb->len >= XML_WRITER_HASH_CHUNK)
+		xml_writer_flush(writer);
+}
+
+void
+xml_writer_puts(xml_writer_t *writer, const char *string)
+{
+	if (string)
+		xml_writer_put(writer, string, strlen(string));
+}
+
+void
+xml_writer_indent(xml_writer_t *writer, unsigned int indent)
+{
+	static const char spaces[] = "                                "
+				     "                                ";
+	unsigned int n;
+
+	while (indent) {
+		n = min_t(unsigned int, indent, sizeof(spaces) - 1);
+		xml_writer_put(writer, spaces, n);
+		indent -= n;
 	}
-	va_end(ap);
 }
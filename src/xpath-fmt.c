@@ -58,7 +58,7 @@
 typedef struct xpath_fnode {
 	ni_stringbuf_t		before;
 	ni_stringbuf_t		expression;
-	xpath_enode_t *		enode;
+	xpath_program_t *	program;
 	xpath_result_t *	result;
 
 	unsigned int		optional : 1;
@@ -119,8 +119,8 @@ xpath_format_parse(const char *format)
 					cur->optional = 1;
 					expression++;
 				}
-				cur->enode = xpath_expression_parse(expression);
-				if (!cur->enode)
+				cur->program = xpath_program_new(expression);
+				if (!cur->program)
 					goto failed;
 
 				cur = NULL;
@@ -163,10 +163,10 @@ xpath_format_eval(xpath_format_t *pieces, xml_node_t *xn, ni_string_array_t *res
 			fnode->result = NULL;
 		}
 
-		if (fnode->enode) {
+		if (fnode->program) {
 			xpath_result_t *result;
 
-			fnode->result = result = xpath_expression_eval(fnode->enode, xn);
+			fnode->result = result = xpath_program_eval(fnode->program, xn);
 			if (!result) {
 				ni_error("xpathfmt: error evaluation expression \"%s\"",
 						fnode->expression.string);
@@ -231,8 +231,8 @@ xpath_format_free(xpath_format_t *na)
 	for (n = 0, fnp = na->node; n < na->count; ++n, ++fnp) {
 		ni_stringbuf_destroy(&fnp->before);
 		ni_stringbuf_destroy(&fnp->expression);
-		if (fnp->enode)
-			xpath_expression_free(fnp->enode);
+		if (fnp->program)
+			xpath_program_free(fnp->program);
 		if (fnp->result)
 			xpath_result_free(fnp->result);
 	}
@@ -127,7 +127,7 @@ xpath_expression_parse(const char *expr)
 failed:
 	ni_error("unable to parse XPATH expression \"%s\"", orig_expr);
 	if (tree)
-		xpath_enode_free(tree);
+		xpath_expression_free(tree);
 	return NULL;
 }
 
@@ -154,31 +154,22 @@ xpath_expression_free(xpath_enode_t *enode)
 {
 	if (!enode)
 		return;
-	if (enode->left)
-		xpath_enode_free(enode->left);
-	if (enode->right)
-		xpath_enode_free(enode->right);
+	xpath_expression_free(enode->left);
+	xpath_expression_free(enode->right);
 	xpath_enode_free(enode);
 }
 
 /*
- * Convenience function: parse XPATH expression, evaluate it once,
+ * Convenience function: evaluate a (cached) XPATH expression
  * and return the resulting string.
  */
 char *
 xml_xpath_eval_string(xml_document_t *doc, xml_node_t *xn, const char *expr)
 {
 	xpath_result_t *xresult;
-	xpath_enode_t *expr_tree;
 	char *result = NULL;
 
-	expr_tree = xpath_expression_parse(expr);
-	if (!expr_tree)
-		return NULL;
-
-	xresult = xpath_expression_eval(expr_tree, xn);
-	xpath_expression_free(expr_tree);
-
+	xresult = xpath_expression_eval_cached(expr, xn);
 	if (!xresult)
 		return NULL;
 	if (xresult->type == XPATH_STRING && xresult->count)
@@ -442,7 +433,7 @@ handle_function:
 failed:
 	/* ni_error("xpath: syntax error in expression \"%s\" at position %s", expr, pos); */
 	if (current)
-		xpath_enode_free(current);
+		xpath_expression_free(current);
 	return NULL;
 }
 
@@ -1054,8 +1045,9 @@ __xpath_enode_predicate_evaluate(const xpath_enode_t *enode, xpath_result_t *lef
 			case XPATH_BOOLEAN:
 				/* Just return all elements */
 				if (rn->value.boolean) {
+					xpath_result_free(right);
 					xpath_result_free(result);
-					return left;
+					return xpath_result_dup(left);
 				}
 				break;
 
@@ -1750,3 +1742,465 @@ xpath_node_type_name(xpath_node_type_t type)
 
 	return "unknown";
 }
+
+/*
+ * Compiled expressions.
+ *
+ * Location paths, optionally with simple predicates, are lowered into
+ * a flat array of steps applied to a node-set register. The register
+ * buffers are owned by the program and reused by every evaluation.
+ * Anything else is evaluated using the expression tree.
+ */
+typedef enum xpath_insn_op {
+	XPATH_INSN_CHILD,
+	XPATH_INSN_DESCENDANT,
+	XPATH_INSN_SELF,
+	XPATH_INSN_GETATTR,
+	XPATH_INSN_PRED_INDEX,		/* [N]			*/
+	XPATH_INSN_PRED_CHILD,		/* [name]		*/
+	XPATH_INSN_PRED_CHILD_EQ,	/* [name = 'value']	*/
+	XPATH_INSN_PRED_ATTR_EQ,	/* [@name = 'value']	*/
+	XPATH_INSN_PREDICATE,		/* [any other]		*/
+} xpath_insn_op_t;
+
+typedef struct xpath_insn {
+	xpath_insn_op_t		op;
+	const char *		name;
+	const char *		value;
+	xpath_integer_t		index;
+	const xpath_enode_t *	enode;
+} xpath_insn_t;
+
+typedef struct xpath_nodeset {
+	unsigned int		count;
+	unsigned int		size;
+	xml_node_t **		data;
+} xpath_nodeset_t;
+
+struct xpath_program {
+	xpath_enode_t *		tree;
+
+	unsigned int		compiled : 1;
+	xpath_node_type_t	outtype;
+	unsigned int		count;
+	xpath_insn_t *		insn;
+
+	xpath_nodeset_t		reg[2];
+};
+
+static inline ni_bool_t
+__xpath_enode_is_context(const xpath_enode_t *enode)
+{
+	return enode->ops == &__xpath_operator_node && !enode->left;
+}
+
+static inline ni_bool_t
+__xpath_enode_is_step(const xpath_enode_t *enode, const xpath_operator_t *ops)
+{
+	return enode->ops == ops && enode->left && __xpath_enode_is_context(enode->left);
+}
+
+static xpath_insn_t *
+__xpath_program_emit(xpath_program_t *prog, xpath_insn_op_t op, const xpath_enode_t *enode)
+{
+	xpath_insn_t *insn;
+
+	if ((prog->count & 7) == 0)
+		prog->insn = xrealloc(prog->insn, (prog->count + 8) * sizeof(prog->insn[0]));
+
+	insn = &prog->insn[prog->count++];
+	memset(insn, 0, sizeof(*insn));
+	insn->op = op;
+	insn->name = enode->identifier;
+	insn->enode = enode;
+	return insn;
+}
+
+static ni_bool_t
+__xpath_program_compile_predicate(xpath_program_t *prog, const xpath_enode_t *enode)
+{
+	const xpath_enode_t *expr = enode->right;
+	const xpath_enode_t *path, *value;
+	xpath_insn_t *insn;
+
+	if (expr->ops == &__xpath_operator_intconst) {
+		insn = __xpath_program_emit(prog, XPATH_INSN_PRED_INDEX, enode);
+		insn->index = expr->integer;
+		return TRUE;
+	}
+
+	if (__xpath_enode_is_step(expr, &__xpath_operator_child)) {
+		__xpath_program_emit(prog, XPATH_INSN_PRED_CHILD, expr);
+		return TRUE;
+	}
+
+	if (expr->ops == &__xpath_operator_eq) {
+		if (expr->right->ops == &__xpath_operator_stringconst) {
+			path = expr->left;
+			value = expr->right;
+		} else {
+			path = expr->right;
+			value = expr->left;
+		}
+
+		if (value->ops == &__xpath_operator_stringconst) {
+			if (__xpath_enode_is_step(path, &__xpath_operator_getattr)) {
+				insn = __xpath_program_emit(prog, XPATH_INSN_PRED_ATTR_EQ, path);
+				insn->value = value->identifier;
+				return TRUE;
+			}
+			if (__xpath_enode_is_step(path, &__xpath_operator_child)) {
+				insn = __xpath_program_emit(prog, XPATH_INSN_PRED_CHILD_EQ, path);
+				insn->value = value->identifier;
+				return TRUE;
+			}
+		}
+	}
+
+	__xpath_program_emit(prog, XPATH_INSN_PREDICATE, enode);
+	return TRUE;
+}
+
+static ni_bool_t
+__xpath_program_compile(xpath_program_t *prog, const xpath_enode_t *enode)
+{
+	const xpath_operator_t *ops = enode->ops;
+	xpath_insn_op_t op;
+
+	if (ops == &__xpath_operator_node) {
+		/* node() is the identity, with or without input path */
+		return !enode->left || __xpath_program_compile(prog, enode->left);
+	}
+
+	if (!enode->left || !__xpath_program_compile(prog, enode->left))
+		return FALSE;
+
+	/* nothing may follow an attribute step */
+	if (prog->count && prog->insn[prog->count - 1].op == XPATH_INSN_GETATTR)
+		return FALSE;
+
+	if (ops == &__xpath_operator_predicate)
+		return __xpath_program_compile_predicate(prog, enode);
+
+	if (ops == &__xpath_operator_child)
+		op = XPATH_INSN_CHILD;
+	else if (ops == &__xpath_operator_descendant)
+		op = XPATH_INSN_DESCENDANT;
+	else if (ops == &__xpath_operator_self)
+		op = XPATH_INSN_SELF;
+	else if (ops == &__xpath_operator_getattr)
+		op = XPATH_INSN_GETATTR;
+	else
+		return FALSE;
+
+	__xpath_program_emit(prog, op, enode);
+	return TRUE;
+}
+
+/*
+ * Parse an expression and compile it into a program
+ */
+xpath_program_t *
+xpath_program_new(const char *expr)
+{
+	xpath_program_t *prog;
+	xpath_enode_t *tree;
+
+	if (!(tree = xpath_expression_parse(expr)))
+		return NULL;
+
+	prog = xcalloc(1, sizeof(*prog));
+	prog->tree = tree;
+	prog->outtype = tree->ops->outtype;
+
+	if (__xpath_program_compile(prog, tree)) {
+		prog->compiled = 1;
+	} else {
+		xtrace("xpath: evaluating \"%s\" using the expression tree", expr);
+		free(prog->insn);
+		prog->insn = NULL;
+		prog->count = 0;
+	}
+	return prog;
+}
+
+void
+xpath_program_free(xpath_program_t *prog)
+{
+	unsigned int i;
+
+	if (!prog)
+		return;
+
+	for (i = 0; i < 2; ++i)
+		free(prog->reg[i].data);
+	free(prog->insn);
+	xpath_expression_free(prog->tree);
+	free(prog);
+}
+
+static inline void
+__xpath_nodeset_append(xpath_nodeset_t *set, xml_node_t *xn)
+{
+	if (set->count == set->size) {
+		set->size = set->size ? set->size * 2 : 16;
+		set->data = xrealloc(set->data, set->size * sizeof(set->data[0]));
+	}
+	set->data[set->count++] = xn;
+}
+
+static void
+__xpath_nodeset_descendants(xpath_nodeset_t *out, xml_node_t *node, const char *name)
+{
+	xml_node_t *child;
+
+	for (child = node->children; child; child = child->next) {
+		if (!name || !strcmp(child->name, name))
+			__xpath_nodeset_append(out, child);
+		if (child->children)
+			__xpath_nodeset_descendants(out, child, name);
+	}
+}
+
+static inline xml_node_t *
+__xpath_node_find_child(xml_node_t *xn, const char *name, xml_node_t *cn)
+{
+	for (cn = cn ? cn->next : xn->children; cn; cn = cn->next) {
+		if (!name || !strcmp(cn->name, name))
+			return cn;
+	}
+	return NULL;
+}
+
+static xpath_result_t *
+__xpath_nodeset_to_result(const xpath_nodeset_t *set, xpath_node_type_t type)
+{
+	xpath_result_t *result;
+	xpath_node_t *xpn;
+	unsigned int n;
+
+	result = xpath_result_new(type);
+	if (set->count) {
+		/* the append functions grow the array in chunks of 16 */
+		result->node = xcalloc((set->count + 15) & ~15U, sizeof(xpath_node_t));
+		for (n = 0, xpn = result->node; n < set->count; ++n, ++xpn) {
+			xpn->type = XPATH_ELEMENT;
+			xpn->value.node = set->data[n];
+		}
+		result->count = set->count;
+	}
+	return result;
+}
+
+static ni_bool_t
+__xpath_program_predicate(const xpath_insn_t *insn, const xpath_nodeset_t *in, xpath_nodeset_t *out)
+{
+	xpath_result_t *left, *result;
+	unsigned int n;
+
+	left = __xpath_nodeset_to_result(in, XPATH_ELEMENT);
+	result = __xpath_enode_predicate_evaluate(insn->enode, left);
+	xpath_result_free(left);
+	if (!result)
+		return FALSE;
+
+	for (n = 0; n < result->count; ++n)
+		__xpath_nodeset_append(out, result->node[n].value.node);
+	xpath_result_free(result);
+	return TRUE;
+}
+
+/*
+ * Evaluate a compiled expression
+ */
+xpath_result_t *
+xpath_program_eval(xpath_program_t *prog, xml_node_t *xn)
+{
+	xpath_nodeset_t *in, *out, *tmp;
+	const xpath_insn_t *insn;
+	xpath_result_t *result;
+	const char *attrval;
+	xml_node_t *cn;
+	unsigned int i, n;
+
+	if (!prog || !xn)
+		return NULL;
+
+	if (!prog->compiled)
+		return xpath_expression_eval(prog->tree, xn);
+
+	in = &prog->reg[0];
+	out = &prog->reg[1];
+	in->count = 0;
+	__xpath_nodeset_append(in, xn);
+
+	for (i = 0, insn = prog->insn; i < prog->count && in->count; ++i, ++insn) {
+		out->count = 0;
+
+		switch (insn->op) {
+		case XPATH_INSN_CHILD:
+			for (n = 0; n < in->count; ++n) {
+				for (cn = in->data[n]->children; cn; cn = cn->next) {
+					if (!insn->name || !strcmp(cn->name, insn->name))
+						__xpath_nodeset_append(out, cn);
+				}
+			}
+			break;
+
+		case XPATH_INSN_DESCENDANT:
+			for (n = 0; n < in->count; ++n)
+				__xpath_nodeset_descendants(out, in->data[n], insn->name);
+			break;
+
+		case XPATH_INSN_SELF:
+			for (n = 0; n < in->count; ++n) {
+				if (!insn->name || !strcmp(in->data[n]->name, insn->name))
+					__xpath_nodeset_append(out, in->data[n]);
+			}
+			break;
+
+		case XPATH_INSN_GETATTR:
+			result = xpath_result_new(XPATH_STRING);
+			for (n = 0; n < in->count; ++n) {
+				if ((attrval = xml_node_get_attr(in->data[n], insn->name)))
+					xpath_result_append_string(result, attrval);
+			}
+			return result;
+
+		case XPATH_INSN_PRED_INDEX:
+			/* Predicate indices are 1 based */
+			if (0 < insn->index && insn->index - 1 < in->count)
+				__xpath_nodeset_append(out, in->data[insn->index - 1]);
+			break;
+
+		case XPATH_INSN_PRED_CHILD:
+			for (n = 0; n < in->count; ++n) {
+				if (__xpath_node_find_child(in->data[n], insn->name, NULL))
+					__xpath_nodeset_append(out, in->data[n]);
+			}
+			break;
+
+		case XPATH_INSN_PRED_CHILD_EQ:
+			for (n = 0; n < in->count; ++n) {
+				for (cn = NULL; (cn = __xpath_node_find_child(in->data[n], insn->name, cn)); ) {
+					if (!xstrcmp(cn->cdata, insn->value)) {
+						__xpath_nodeset_append(out, in->data[n]);
+						break;
+					}
+				}
+			}
+			break;
+
+		case XPATH_INSN_PRED_ATTR_EQ:
+			for (n = 0; n < in->count; ++n) {
+				attrval = xml_node_get_attr(in->data[n], insn->name);
+				if (attrval && !strcmp(attrval, insn->value))
+					__xpath_nodeset_append(out, in->data[n]);
+			}
+			break;
+
+		case XPATH_INSN_PREDICATE:
+			if (!__xpath_program_predicate(insn, in, out))
+				return NULL;
+			break;
+		}
+
+		tmp = in;
+		in = out;
+		out = tmp;
+	}
+
+	if (!in->count)
+		return xpath_result_new(prog->outtype);
+	return __xpath_nodeset_to_result(in, XPATH_ELEMENT);
+}
+
+/*
+ * Cache of compiled expressions, keyed by the expression string.
+ */
+#define XPATH_CACHE_BUCKETS	64
+#define XPATH_CACHE_MAX		256
+
+typedef struct xpath_cache_entry	xpath_cache_entry_t;
+struct xpath_cache_entry {
+	xpath_cache_entry_t *	next;
+	unsigned int		hash;
+	char *			expr;
+	xpath_program_t *	program;
+};
+
+static struct {
+	unsigned int		count;
+	xpath_cache_entry_t *	bucket[XPATH_CACHE_BUCKETS];
+} xpath_cache;
+
+static unsigned int
+__xpath_cache_hash(const char *expr)
+{
+	unsigned int hash = 2166136261U;
+
+	while (*expr)
+		hash = (hash ^ (unsigned char) *expr++) * 16777619U;
+	return hash;
+}
+
+void
+xpath_expression_cache_flush(void)
+{
+	xpath_cache_entry_t *entry;
+	unsigned int i;
+
+	for (i = 0; i < XPATH_CACHE_BUCKETS; ++i) {
+		while ((entry = xpath_cache.bucket[i])) {
+			xpath_cache.bucket[i] = entry->next;
+			xpath_program_free(entry->program);
+			free(entry->expr);
+			free(entry);
+		}
+	}
+	xpath_cache.count = 0;
+}
+
+static xpath_program_t *
+xpath_expression_cache_lookup(const char *expr)
+{
+	xpath_cache_entry_t *entry, **pos;
+	unsigned int hash;
+
+	hash = __xpath_cache_hash(expr);
+	pos = &xpath_cache.bucket[hash % XPATH_CACHE_BUCKETS];
+	for (entry = *pos; entry; entry = entry->next) {
+		if (entry->hash == hash && !strcmp(entry->expr, expr))
+			return entry->program;
+	}
+
+	if (xpath_cache.count >= XPATH_CACHE_MAX)
+		xpath_expression_cache_flush();
+
+	entry = xcalloc(1, sizeof(*entry));
+	if (!(entry->program = xpath_program_new(expr))) {
+		free(entry);
+		return NULL;
+	}
+	entry->hash = hash;
+	entry->expr = xstrdup(expr);
+	entry->next = *pos;
+	*pos = entry;
+	xpath_cache.count++;
+
+	return entry->program;
+}
+
+/*
+ * Evaluate an expression using the compiled expression cache
+ */
+xpath_result_t *
+xpath_expression_eval_cached(const char *expr, xml_node_t *xn)
+{
+	xpath_program_t *program;
+
+	if (!expr || !(program = xpath_expression_cache_lookup(expr)))
+		return NULL;
+
+	return xpath_program_eval(program, xn);
+}
@@ -3,14 +3,29 @@
 #endif
 #include <signal.h>
 #include <stdio.h>
+#include <limits.h>
 
 #include <wicked/fsm.h>
+#include <wicked/netinfo.h>
 
 #include "appconfig.h"
 #include "client/client_state.h"
 
 extern ni_global_t ni_global;
 
+static void
+store_append(const char *data, size_t len, const char *mode)
+{
+	char path[PATH_MAX];
+	FILE *fp;
+
+	snprintf(path, sizeof(path), "%s/client-state.db", ni_config_statedir());
+	if ((fp = fopen(path, mode))) {
+		fwrite(data, 1, len, fp);
+		fclose(fp);
+	}
+}
+
 int main(int argc, char **argv)
 {
 	ni_client_state_t *cs;
@@ -36,7 +51,26 @@ int main(int argc, char **argv)
 	ni_client_state_load(cs, ifindex2);
 	ni_client_state_debug("Test3", cs, "print");
 
+	/* a save behind a torn tail record has to be visible */
+	store_append("NRCD\x02\x00", 6, "a");
+	ni_client_state_save(cs, ifindex1);
+	if (!ni_client_state_load(cs, ifindex1)) {
+		fprintf(stderr, "state lost behind a torn record\n");
+		return 1;
+	}
+	ni_client_state_debug("Test4", cs, "print");
+
+	/* a store with a bad header is recreated */
+	store_append("garbage!garbage!", 16, "w");
+	ni_client_state_save(cs, ifindex1);
+	if (!ni_client_state_load(cs, ifindex1)) {
+		fprintf(stderr, "state lost in a store with a bad header\n");
+		return 1;
+	}
+	ni_client_state_debug("Test5", cs, "print");
+
 	ni_client_state_free(cs);
+	ni_client_state_drop(ifindex1);
 	ni_client_state_drop(ifindex2);
 
 	ni_config_free(ni_global.config);
@@ -0,0 +1,260 @@
+/*
+ * Test the lease journal in a temporary directory: renewal stamps,
+ * torn record truncation, compaction and moving an invalid journal
+ * aside. A second view on the journal, as another process would
+ * use, is opened via an alias of the directory path.
+ *
+ * Copyright (C) 2026 SUSE LLC
+ */
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <netinet/in.h>
+
+#include <wicked/util.h>
+#include <wicked/logging.h>
+#include <wicked/netinfo.h>
+#include <wicked/addrconf.h>
+
+#include "leasejournal.h"
+
+#define LEASE_DATA	"<lease><acquired>1</acquired><address>192.0.2.1</address></lease>"
+
+static char	testdir[] = "/tmp/leasejournal-test.XXXXXX";
+
+static ni_lease_journal_t *
+test_journal(const char *alias, ni_bool_t create)
+{
+	char dir[PATH_MAX];
+
+	snprintf(dir, sizeof(dir), "%s%s", testdir, alias);
+	return ni_lease_journal_open(dir, NI_ADDRCONF_DHCP, AF_INET, create);
+}
+
+static off_t
+test_journal_size(ni_lease_journal_t *journal)
+{
+	struct stat st;
+
+	return stat(ni_lease_journal_path(journal), &st) == 0 ? st.st_size : -1;
+}
+
+static int
+test_put(ni_lease_journal_t *journal, const char *ifname, const char *data, const char *stamp)
+{
+	return ni_lease_journal_put(journal, ifname, data, strlen(data),
+				ni_lease_journal_hash(data, strlen(data)), stamp);
+}
+
+static ni_bool_t
+test_get(ni_lease_journal_t *journal, const char *ifname, const char *data, const char *stamp)
+{
+	char *value, *vstamp = NULL;
+	ni_bool_t ok;
+
+	value = ni_lease_journal_get(journal, ifname, NULL, &vstamp);
+	ok = ni_string_eq(value, data) && ni_string_eq(vstamp, stamp);
+	if (!ok) {
+		fprintf(stderr, "%s: got '%s' stamp '%s', expected '%s' stamp '%s'\n",
+				ifname, value, vstamp, data, stamp);
+	}
+	free(value);
+	free(vstamp);
+	return ok;
+}
+
+/*
+ * Unchanged content stores the new times in a stamp record only
+ */
+static int
+test_stamp(void)
+{
+	ni_lease_journal_t *writer, *reader;
+	off_t size;
+
+	if (!(writer = test_journal("", TRUE)) || test_put(writer, "eth0", LEASE_DATA, "1\n") != 0)
+		return -1;
+
+	size = test_journal_size(writer);
+	if (test_put(writer, "eth0", LEASE_DATA, "1\n") != 1 || test_journal_size(writer) != size) {
+		fprintf(stderr, "stamp: unchanged lease not coalesced\n");
+		return -1;
+	}
+	if (test_put(writer, "eth0", LEASE_DATA, "2\n") != 1 ||
+	    test_journal_size(writer) <= size ||
+	    test_journal_size(writer) >= size + (off_t)strlen(LEASE_DATA)) {
+		fprintf(stderr, "stamp: renewal not stored in a stamp record\n");
+		return -1;
+	}
+
+	if (!(reader = test_journal("/.", FALSE)) || !test_get(reader, "eth0", LEASE_DATA, "2\n"))
+		return -1;
+
+	/* a changed lease supersedes the stamp */
+	if (test_put(writer, "eth0", LEASE_DATA "\n", "3\n") != 0 ||
+	    !test_get(reader, "eth0", LEASE_DATA "\n", NULL))
+		return -1;
+
+	printf("stamp: ok\n");
+	return 0;
+}
+
+/*
+ * A torn append is ignored by readers and truncated by the next writer
+ */
+static int
+test_torn(void)
+{
+	ni_lease_journal_t *writer, *reader;
+	char torn[32], head[32];
+	off_t size;
+	int fd;
+
+	if (!(writer = test_journal("", TRUE)) || test_put(writer, "eth1", LEASE_DATA, "1\n") != 0)
+		return -1;
+	size = test_journal_size(writer);
+
+	/* the head of a record of eth1 with another lease */
+	memset(torn, 0xa5, sizeof(torn));
+	if ((fd = open(ni_lease_journal_path(writer), O_WRONLY | O_APPEND)) < 0)
+		return -1;
+	if (write(fd, torn, sizeof(torn)) != sizeof(torn)) {
+		close(fd);
+		return -1;
+	}
+	close(fd);
+
+	if (!(reader = test_journal("/./", FALSE)) || !test_get(reader, "eth1", LEASE_DATA, NULL))
+		return -1;
+
+	/* the record of eth2 has to replace the torn one */
+	if (test_put(writer, "eth2", LEASE_DATA, "1\n") != 0)
+		return -1;
+	if ((fd = open(ni_lease_journal_path(writer), O_RDONLY)) < 0)
+		return -1;
+	if (pread(fd, head, sizeof(head), size) != sizeof(head) ||
+	    !memcmp(head, torn, sizeof(torn))) {
+		fprintf(stderr, "torn: incomplete record not truncated\n");
+		close(fd);
+		return -1;
+	}
+	close(fd);
+	if (!test_get(reader, "eth2", LEASE_DATA, NULL) || !test_get(reader, "eth1", LEASE_DATA, NULL))
+		return -1;
+
+	printf("torn: ok\n");
+	return 0;
+}
+
+/*
+ * Superseded records are compacted away, keeping the live ones
+ */
+static int
+test_compact(void)
+{
+	ni_lease_journal_t *writer, *reader;
+	char data[1024], stamp[32];
+	unsigned int i;
+
+	if (!(writer = test_journal("", TRUE)))
+		return -1;
+
+	for (i = 0; i < 4 * NI_LEASE_JOURNAL_COMPACT_MIN / sizeof(data); ++i) {
+		memset(data, 'a' + i % 26, sizeof(data) - 1);
+		data[sizeof(data) - 1] = '\0';
+		if (test_put(writer, "eth3", data, "1\n") != 0)
+			return -1;
+	}
+	snprintf(stamp, sizeof(stamp), "%u\n", i);
+	if (test_put(writer, "eth3", data, stamp) != 1)
+		return -1;
+
+	if (test_journal_size(writer) >= NI_LEASE_JOURNAL_COMPACT_MIN) {
+		fprintf(stderr, "compact: journal not compacted\n");
+		return -1;
+	}
+
+	if (!(reader = test_journal("/.//", FALSE)) || !test_get(reader, "eth3", data, stamp) ||
+	    !test_get(reader, "eth0", LEASE_DATA "\n", NULL) ||
+	    !test_get(reader, "eth2", LEASE_DATA, NULL))
+		return -1;
+
+	printf("compact: ok\n");
+	return 0;
+}
+
+/*
+ * A journal with an invalid header is moved aside by a writer
+ */
+static int
+test_invalid(void)
+{
+	ni_lease_journal_t *writer;
+	char path[PATH_MAX], broken[PATH_MAX + 8];
+	FILE *fp;
+
+	snprintf(path, sizeof(path), "%s/leases-dhcp-ipv6.journal", testdir);
+	snprintf(broken, sizeof(broken), "%s.broken", path);
+	if (!(fp = fopen(path, "w")))
+		return -1;
+	fputs("not a lease journal\n", fp);
+	fclose(fp);
+
+	if (!(writer = ni_lease_journal_open(testdir, NI_ADDRCONF_DHCP, AF_INET6, TRUE)) ||
+	    !ni_file_exists(broken) || test_put(writer, "eth0", LEASE_DATA, NULL) != 0 ||
+	    !test_get(writer, "eth0", LEASE_DATA, NULL)) {
+		fprintf(stderr, "invalid: journal not moved aside\n");
+		return -1;
+	}
+
+	printf("invalid: ok\n");
+	return 0;
+}
+
+static void
+test_cleanup(void)
+{
+	static const char *files[] = {
+		"leases-dhcp-ipv4.journal",
+		"leases-dhcp-ipv6.journal",
+		"leases-dhcp-ipv6.journal.broken",
+		NULL
+	};
+	char path[PATH_MAX];
+	unsigned int i;
+
+	for (i = 0; files[i]; ++i) {
+		snprintf(path, sizeof(path), "%s/%s", testdir, files[i]);
+		unlink(path);
+	}
+	if (rmdir(testdir) < 0)
+		fprintf(stderr, "unable to remove %s: %m\n", testdir);
+}
+
+int
+main(int argc, char **argv)
+{
+	int rv = 1;
+
+	if (argc > 1)
+		ni_enable_debug(argv[1]);
+
+	if (!mkdtemp(testdir)) {
+		fprintf(stderr, "unable to create %s: %m\n", testdir);
+		return 1;
+	}
+
+	if (test_stamp() == 0 && test_torn() == 0 && test_compact() == 0 && test_invalid() == 0)
+		rv = 0;
+
+	test_cleanup();
+	return rv;
+}
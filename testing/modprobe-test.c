@@ -0,0 +1,62 @@
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdio.h>
+#include <wicked/util.h>
+#include <wicked/logging.h>
+
+#include "modprobe.h"
+
+/*
+ * Check module presence against the fake module tree in ./modprobe:
+ *	modprobe-test [root [release]] [module...]
+ * Without a module list, the results of the fake tree are verified.
+ */
+static const struct {
+	const char *	name;
+	ni_bool_t	present;
+} expected[] = {
+	{ "bonding",		TRUE	},
+	{ "rtnl-link-bond",	TRUE	},
+	{ "bridge",		TRUE	},	/* builtin */
+	{ "8021q",		TRUE	},	/* builtin */
+	{ "dummy",		FALSE	},
+	{ "rtnl-link-dummy",	FALSE	},
+	{ "tun",		FALSE	},
+	{ "net-pf-99",		TRUE	},	/* evil is blacklisted */
+	{ "custom-bond",	TRUE	},	/* modprobe.d alias */
+	{ NULL,			FALSE	}
+};
+
+int main(int argc, char **argv)
+{
+	const char *root = "./modprobe";
+	const char *release = "0.0.0-test";
+	ni_bool_t present;
+	int i, ret = 0;
+
+	if (argc > 1)
+		root = argv[1];
+	if (argc > 2)
+		release = argv[2];
+
+	ni_modprobe_init(root, release);
+	if (argc > 3) {
+		for (i = 3; i < argc; ++i) {
+			printf("%-16s: %s\n", argv[i],
+				ni_modprobe_loaded(argv[i]) ? "present" : "missing");
+		}
+	} else {
+		for (i = 0; expected[i].name; ++i) {
+			present = ni_modprobe_loaded(expected[i].name);
+			printf("%-16s: %s%s\n", expected[i].name,
+				present ? "present" : "missing",
+				present != expected[i].present ? " -- FAILED" : "");
+			if (present != expected[i].present)
+				ret = 1;
+		}
+	}
+	ni_modprobe_init(NULL, NULL);
+	return ret;
+}
@@ -0,0 +1,286 @@
+/*
+ * Fuzzing and throughput test app for the packet parsers
+ * processing untrusted data received from the network.
+ *
+ * Usage:
+ *	parser-test [--debug facility] [--bench count] <dhcp4|dhcp6|lldp|arp> file...
+ *
+ * Each file contains a single packet payload as it is passed to the
+ * parser: a BOOTP/DHCP4 message, a DHCP6 client message, a LLDPDU
+ * without ethernet header or an ARP packet. Sample packets are in
+ * the parsers/ directory.
+ *
+ * AFL:
+ *	afl-fuzz -i <dhcp6 samples dir> -o findings -- ./parser-test dhcp6 @@
+ *
+ * libFuzzer (the first input byte selects the parser):
+ *	clang -fsanitize=fuzzer,address -DNI_PARSER_TEST_FUZZER ...
+ *
+ * Copyright (C) 2026 SUSE LLC
+ */
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <getopt.h>
+#include <time.h>
+#include <net/if_arp.h>
+
+#include <wicked/netinfo.h>
+#include <wicked/util.h>
+#include <wicked/logging.h>
+#include <wicked/address.h>
+#include <wicked/addrconf.h>
+#include <wicked/lldp.h>
+
+#include "netinfo_priv.h"
+#include "buffer.h"
+#include "lldp-priv.h"
+#include "dhcp4/dhcp4.h"
+#include "dhcp4/protocol.h"
+#include "dhcp6/dhcp6.h"
+#include "dhcp6/protocol.h"
+
+typedef int		ni_parser_test_fn_t(unsigned char *, size_t);
+
+static int
+ni_parser_test_dhcp4(unsigned char *data, size_t len)
+{
+	static ni_dhcp4_config_t config;
+	ni_addrconf_lease_t *lease = NULL;
+	ni_dhcp4_message_t *message;
+	ni_buffer_t buf;
+	int ret;
+
+	ni_buffer_init_reader(&buf, data, len);
+	if (!(message = ni_buffer_pull_head(&buf, sizeof(*message))))
+		return -1;
+
+	ret = ni_dhcp4_parse_response(&config, message, &buf, &lease);
+	if (lease)
+		ni_addrconf_lease_free(lease);
+	return ret;
+}
+
+static int
+ni_parser_test_dhcp6(unsigned char *data, size_t len)
+{
+	static ni_dhcp6_device_t dev = { .ifname = "test" };
+	ni_addrconf_lease_t *lease;
+	unsigned int type, xid;
+	ni_buffer_t buf;
+	int ret;
+
+	ni_buffer_init_reader(&buf, data, len);
+	if (ni_dhcp6_parse_client_header(&buf, &type, &xid) < 0)
+		return -1;
+
+	lease = ni_addrconf_lease_new(NI_ADDRCONF_DHCP, AF_INET6);
+	ret = ni_dhcp6_parse_client_options(&dev, &buf, lease);
+	ni_addrconf_lease_free(lease);
+	return ret;
+}
+
+static int
+ni_parser_test_lldp(unsigned char *data, size_t len)
+{
+	ni_lldp_t *lldp;
+	ni_buffer_t buf;
+	int ret;
+
+	ni_buffer_init_reader(&buf, data, len);
+	lldp = ni_lldp_new();
+	ret = ni_lldp_pdu_parse(lldp, &buf);
+	ni_lldp_free(lldp);
+	return ret;
+}
+
+static int
+ni_parser_test_arp(unsigned char *data, size_t len)
+{
+	static ni_arp_socket_t sock = { .dev_info.hwaddr.type = ARPHRD_ETHER };
+	ni_arp_packet_t packet;
+	ni_buffer_t buf;
+
+	ni_buffer_init_reader(&buf, data, len);
+	return ni_arp_parse(&sock, &buf, &packet);
+}
+
+static const struct ni_parser_test {
+	const char *		name;
+	ni_parser_test_fn_t *	parse;
+} ni_parser_tests[] = {
+	{ "dhcp4",	ni_parser_test_dhcp4	},
+	{ "dhcp6",	ni_parser_test_dhcp6	},
+	{ "lldp",	ni_parser_test_lldp	},
+	{ "arp",	ni_parser_test_arp	},
+	{ NULL,		NULL			}
+};
+
+/*
+ * Parse a copy of the input, so memory checkers see the exact size.
+ */
+static int
+ni_parser_test_run(const struct ni_parser_test *test, const unsigned char *data, size_t len)
+{
+	unsigned char *copy;
+	int ret;
+
+	copy = xmalloc(len ? len : 1);
+	memcpy(copy, data, len);
+	ret = test->parse(copy, len);
+	free(copy);
+	return ret;
+}
+
+#if defined(NI_PARSER_TEST_FUZZER)
+int
+LLVMFuzzerTestOneInput(const unsigned char *data, size_t len)
+{
+	const unsigned int count = sizeof(ni_parser_tests)/sizeof(ni_parser_tests[0]) - 1;
+	static ni_bool_t initialized = FALSE;
+
+	if (len < 1)
+		return 0;
+
+	if (!initialized) {
+		if (ni_init("parser-test") < 0)
+			abort();
+		initialized = TRUE;
+	}
+
+	ni_parser_test_run(&ni_parser_tests[data[0] % count], data + 1, len - 1);
+	return 0;
+}
+#else
+
+enum {
+	OPT_DEBUG,
+	OPT_BENCH,
+};
+
+static struct option	options[] = {
+	{ "debug",		required_argument,	NULL,	OPT_DEBUG },
+	{ "bench",		required_argument,	NULL,	OPT_BENCH },
+
+	{ NULL }
+};
+
+static int
+ni_parser_test_load(const char *filename, ni_buffer_t *bp)
+{
+	unsigned char chunk[4096];
+	size_t len;
+	FILE *fp;
+
+	if (!(fp = fopen(filename, "r"))) {
+		fprintf(stderr, "Cannot open %s: %m\n", filename);
+		return -1;
+	}
+
+	ni_buffer_init_dynamic(bp, sizeof(chunk));
+	while ((len = fread(chunk, 1, sizeof(chunk), fp)) > 0)
+		ni_buffer_put(bp, chunk, len);
+
+	fclose(fp);
+	return 0;
+}
+
+int
+main(int argc, char **argv)
+{
+	const struct ni_parser_test *test;
+	unsigned int bench = 0, n, i, count, failed = 0;
+	struct timespec start, end;
+	ni_buffer_t *packets;
+	double secs;
+	int c;
+
+	if (ni_init("parser-test") < 0)
+		return 1;
+
+	while ((c = getopt_long(argc, argv, "", options, NULL)) != EOF) {
+		switch (c) {
+		case OPT_DEBUG:
+			if (!strcmp(optarg, "help")) {
+				printf("Supported debug facilities:\n");
+				ni_debug_help();
+				return 0;
+			}
+			if (ni_enable_debug(optarg) < 0) {
+				fprintf(stderr, "Bad debug facility \"%s\"\n", optarg);
+				return 1;
+			}
+			break;
+
+		case OPT_BENCH:
+			if (ni_parse_uint(optarg, &bench, 10) < 0 || !bench) {
+				fprintf(stderr, "Bad bench count \"%s\"\n", optarg);
+				return 1;
+			}
+			break;
+
+		default:
+		usage:
+			fprintf(stderr,
+				"Usage: parser-test [--debug facility] [--bench count] "
+				"<dhcp4|dhcp6|lldp|arp> file...\n");
+			return 1;
+		}
+	}
+
+	if (optind + 2 > argc)
+		goto usage;
+
+	for (test = ni_parser_tests; test->name; ++test) {
+		if (!strcmp(test->name, argv[optind]))
+			break;
+	}
+	if (!test->name)
+		goto usage;
+	optind++;
+
+	count = argc - optind;
+	packets = xcalloc(count, sizeof(ni_buffer_t));
+	for (n = 0; n < count; ++n) {
+		if (ni_parser_test_load(argv[optind + n], &packets[n]) < 0)
+			return 1;
+	}
+
+	if (!bench) {
+		for (n = 0; n < count; ++n) {
+			int ret = ni_parser_test_run(test, ni_buffer_head(&packets[n]),
+							ni_buffer_count(&packets[n]));
+
+			printf("%s: %s %s\n", argv[optind + n], test->name,
+					ret < 0 ? "FAILED" : "OK");
+			if (ret < 0)
+				failed++;
+		}
+	} else {
+		clock_gettime(CLOCK_MONOTONIC, &start);
+		for (i = 0; i < bench; ++i) {
+			for (n = 0; n < count; ++n) {
+				test->parse(ni_buffer_head(&packets[n]),
+						ni_buffer_count(&packets[n]));
+			}
+		}
+		clock_gettime(CLOCK_MONOTONIC, &end);
+
+		secs = (end.tv_sec - start.tv_sec) +
+			(end.tv_nsec - start.tv_nsec) / 1e9;
+		printf("%s: %u packets in %.3f sec, %.0f packets/sec\n",
+				test->name, bench * count, secs,
+				secs > 0 ? (bench * count) / secs : 0.0);
+	}
+
+	for (n = 0; n < count; ++n)
+		ni_buffer_destroy(&packets[n]);
+	free(packets);
+
+	return failed ? 1 : 0;
+}
+#endif
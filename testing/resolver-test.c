@@ -0,0 +1,75 @@
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <netdb.h>
+#include <wicked/util.h>
+#include <wicked/netinfo.h>
+#include <wicked/logging.h>
+#include <wicked/socket.h>
+#include <wicked/address.h>
+#include <wicked/resolver.h>
+
+/*
+ * Resolve names and reverse resolve addresses using the async
+ * resolver workers from the socket loop, twice to hit the cache:
+ *	resolver-test [timeout msec] name|address...
+ */
+static unsigned int	pending;
+
+static void
+resolved(int error, const char *name, const ni_sockaddr_t *addr, void *user_data)
+{
+	const char *query = user_data;
+	ni_sockaddr_t qaddr;
+
+	if (error)
+		printf("%-24s: %s\n", query, gai_strerror(error));
+	else if (ni_sockaddr_parse(&qaddr, query, AF_UNSPEC) == 0)
+		printf("%-24s: %s\n", query, name);
+	else
+		printf("%-24s: %s\n", query, ni_sockaddr_print(addr));
+	pending--;
+}
+
+int main(int argc, char **argv)
+{
+	static const char *defaults[] = { "localhost", "127.0.0.1", "::1", NULL };
+	const char **queries = defaults;
+	unsigned int timeout = 2000;
+	ni_sockaddr_t addr;
+	int round, i;
+
+	if (ni_init("resolver-test") < 0)
+		return 1;
+
+	if (argc > 1 && ni_parse_uint(argv[1], &timeout, 10) < 0)
+		return 1;
+	if (argc > 2)
+		queries = (const char **)argv + 2;
+
+	for (round = 0; round < 2; ++round) {
+		for (i = 0; queries[i]; ++i) {
+			unsigned int id;
+
+			if (ni_sockaddr_parse(&addr, queries[i], AF_UNSPEC) == 0)
+				id = ni_resolve_reverse_async(&addr, timeout,
+						resolved, (void *)queries[i]);
+			else
+				id = ni_resolve_hostname_async(queries[i], AF_UNSPEC,
+						timeout, resolved, (void *)queries[i]);
+			if (id)
+				pending++;
+		}
+		while (pending) {
+			long wait = ni_timer_next_timeout();
+
+			if (ni_socket_wait(wait) < 0)
+				return 1;
+		}
+	}
+	return 0;
+}
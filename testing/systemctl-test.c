@@ -0,0 +1,265 @@
+/*
+ * Control units with a mock org.freedesktop.systemd1 manager;
+ * run it on a private session bus, e.g.:
+ *
+ *	dbus-run-session -- ./systemctl-test
+ */
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#include <wicked/util.h>
+#include <wicked/logging.h>
+#include <wicked/dbus.h>
+
+#include "appconfig.h"
+#include "dbus-connection.h"
+#include "systemctl.h"
+
+#define MOCK_BUS_NAME		"org.freedesktop.systemd1"
+#define MOCK_OBJECT_PATH	"/org/freedesktop/systemd1"
+#define MOCK_MANAGER_INTERFACE	MOCK_BUS_NAME ".Manager"
+
+extern ni_global_t ni_global;
+
+typedef struct mock_result {
+	unsigned int	called;
+	int		result;
+} mock_result_t;
+
+static void
+mock_job_signal(DBusConnection *conn, dbus_uint32_t id, const char *job,
+		const char *unit, const char *result)
+{
+	DBusMessage *sig;
+
+	sig = dbus_message_new_signal(MOCK_OBJECT_PATH, MOCK_MANAGER_INTERFACE, "JobRemoved");
+	dbus_message_append_args(sig, DBUS_TYPE_UINT32, &id,
+			DBUS_TYPE_OBJECT_PATH, &job,
+			DBUS_TYPE_STRING, &unit,
+			DBUS_TYPE_STRING, &result,
+			DBUS_TYPE_INVALID);
+	dbus_connection_send(conn, sig, NULL);
+	dbus_connection_flush(conn);
+	dbus_message_unref(sig);
+}
+
+/*
+ * The unit name tells the mock what to do: "busy" and "missing" units
+ * fail the call, "fail" units fail the job, "slow" units finish it
+ * after a while and "early" units before the reply; other jobs are
+ * removed right with the reply.
+ * Properties are "active" unless the client subscribed more than once,
+ * i.e. treated a failure reply as a lost bus.
+ */
+static DBusHandlerResult
+mock_systemd_filter(DBusConnection *conn, DBusMessage *msg, void *user_data)
+{
+	static dbus_uint32_t jobs;
+	static unsigned int subscribes;
+	const char *member = dbus_message_get_member(msg);
+	const char *unit = NULL, *mode = NULL, *result;
+	const char *path = MOCK_OBJECT_PATH "/unit/mock";
+	DBusMessageIter iter, variant;
+	DBusMessage *reply;
+	char job[128];
+
+	if (dbus_message_get_type(msg) != DBUS_MESSAGE_TYPE_METHOD_CALL)
+		return DBUS_HANDLER_RESULT_NOT_YET_HANDLED;
+
+	if (ni_string_eq(member, "Subscribe")) {
+		subscribes++;
+		reply = dbus_message_new_method_return(msg);
+	} else
+	if (ni_string_eq(member, "StartUnit") || ni_string_eq(member, "StopUnit")) {
+		dbus_message_get_args(msg, NULL, DBUS_TYPE_STRING, &unit,
+				DBUS_TYPE_STRING, &mode, DBUS_TYPE_INVALID);
+		if (ni_string_startswith(unit, "busy")) {
+			reply = dbus_message_new_error(msg, DBUS_ERROR_FAILED, "mock busy");
+		} else
+		if (ni_string_startswith(unit, "missing")) {
+			reply = dbus_message_new_error(msg, MOCK_BUS_NAME ".NoSuchUnit",
+					"mock missing");
+		} else {
+			snprintf(job, sizeof(job), MOCK_OBJECT_PATH "/job/%u", ++jobs);
+			path = job;
+			if (ni_string_startswith(unit, "early"))
+				mock_job_signal(conn, jobs, job, unit, "done");
+			reply = dbus_message_new_method_return(msg);
+			dbus_message_append_args(reply, DBUS_TYPE_OBJECT_PATH, &path,
+					DBUS_TYPE_INVALID);
+		}
+	} else
+	if (ni_string_eq(member, "LoadUnit")) {
+		reply = dbus_message_new_method_return(msg);
+		dbus_message_append_args(reply, DBUS_TYPE_OBJECT_PATH, &path,
+				DBUS_TYPE_INVALID);
+	} else
+	if (ni_string_eq(member, "Get")) {
+		result = subscribes == 1 ? "active" : "resubscribed";
+		reply = dbus_message_new_method_return(msg);
+		dbus_message_iter_init_append(reply, &iter);
+		dbus_message_iter_open_container(&iter, DBUS_TYPE_VARIANT,
+				DBUS_TYPE_STRING_AS_STRING, &variant);
+		dbus_message_iter_append_basic(&variant, DBUS_TYPE_STRING, &result);
+		dbus_message_iter_close_container(&iter, &variant);
+	} else {
+		return DBUS_HANDLER_RESULT_NOT_YET_HANDLED;
+	}
+
+	dbus_connection_send(conn, reply, NULL);
+	dbus_connection_flush(conn);
+	dbus_message_unref(reply);
+
+	if (path == job && !ni_string_startswith(unit, "early")) {
+		result = ni_string_startswith(unit, "fail") ? "failed" : "done";
+		if (ni_string_startswith(unit, "slow"))
+			usleep(200000);
+		mock_job_signal(conn, jobs, job, unit, result);
+	}
+	return DBUS_HANDLER_RESULT_HANDLED;
+}
+
+static void
+mock_systemd_run(int ready)
+{
+	DBusConnection *conn;
+
+	if (!(conn = dbus_bus_get_private(DBUS_BUS_SESSION, NULL)))
+		_exit(1);
+	if (dbus_bus_request_name(conn, MOCK_BUS_NAME, DBUS_NAME_FLAG_DO_NOT_QUEUE, NULL) !=
+	    DBUS_REQUEST_NAME_REPLY_PRIMARY_OWNER)
+		_exit(1);
+	dbus_connection_add_filter(conn, mock_systemd_filter, NULL, NULL);
+
+	if (write(ready, "1", 1) != 1)
+		_exit(1);
+	close(ready);
+
+	while (dbus_connection_read_write_dispatch(conn, -1))
+		;
+	_exit(0);
+}
+
+static void
+mock_job_done(const char *service, int result, void *user_data)
+{
+	mock_result_t *res = user_data;
+
+	res->called++;
+	res->result = result;
+}
+
+static int
+wait_job_done(ni_dbus_connection_t *conn, const mock_result_t *res)
+{
+	unsigned int i;
+
+	for (i = 0; i < 50 && !res->called; ++i) {
+		if (!ni_dbus_connection_wait(conn, 100))
+			return -1;
+	}
+	return res->called == 1 ? 0 : -1;
+}
+
+int main(int argc, char **argv)
+{
+	ni_dbus_connection_t *conn;
+	mock_result_t res;
+	char *value = NULL;
+	int fds[2], status, rv = 1;
+	char c;
+	pid_t pid;
+
+	if (!getenv("DBUS_SESSION_BUS_ADDRESS")) {
+		fprintf(stderr, "Usage: dbus-run-session -- %s\n", argv[0]);
+		return 1;
+	}
+
+	if (pipe(fds) < 0 || (pid = fork()) < 0)
+		return 1;
+	if (pid == 0) {
+		close(fds[0]);
+		mock_systemd_run(fds[1]);
+	}
+	close(fds[1]);
+	if (read(fds[0], &c, 1) != 1) {
+		fprintf(stderr, "mock systemd manager failed to start\n");
+		goto done;
+	}
+
+	ni_global.config = ni_config_new();
+	if (argc > 1)
+		ni_enable_debug(argv[1]);
+
+	if (!(conn = ni_dbus_connection_open("session", NULL)))
+		goto done;
+	ni_systemctl_bus_attach(conn);
+
+	/* job removed along with the reply, both dispatched later */
+	memset(&res, 0, sizeof(res));
+	if (ni_systemctl_service_start("ok.service", mock_job_done, &res) != 0 ||
+	    res.called || wait_job_done(conn, &res) < 0 || res.result != 0) {
+		fprintf(stderr, "start of ok.service not completed\n");
+		goto done;
+	}
+
+	/* job removed before the reply */
+	memset(&res, 0, sizeof(res));
+	if (ni_systemctl_service_start("early.service", mock_job_done, &res) != 0 ||
+	    wait_job_done(conn, &res) < 0 || res.result != 0) {
+		fprintf(stderr, "start of early.service not completed\n");
+		goto done;
+	}
+
+	/* job removed later, completed by the dispatched signal */
+	memset(&res, 0, sizeof(res));
+	if (ni_systemctl_service_stop("slow.service", mock_job_done, &res) != 0 ||
+	    res.called || wait_job_done(conn, &res) < 0 || res.result != 0) {
+		fprintf(stderr, "stop of slow.service not completed\n");
+		goto done;
+	}
+
+	memset(&res, 0, sizeof(res));
+	if (ni_systemctl_service_start("fail.service", mock_job_done, &res) != 0 ||
+	    wait_job_done(conn, &res) < 0 || res.result != -1) {
+		fprintf(stderr, "failed job of fail.service not reported\n");
+		goto done;
+	}
+
+	/* failure replies are no transport errors, the bus stays in use */
+	memset(&res, 0, sizeof(res));
+	if (ni_systemctl_service_start("busy.service", mock_job_done, &res) != 0 ||
+	    wait_job_done(conn, &res) < 0 || res.result != -1) {
+		fprintf(stderr, "failure reply of busy.service not reported\n");
+		goto done;
+	}
+
+	memset(&res, 0, sizeof(res));
+	if (ni_systemctl_service_stop("missing.service", mock_job_done, &res) != 0 ||
+	    wait_job_done(conn, &res) < 0 || res.result != -1) {
+		fprintf(stderr, "failure reply of missing.service not reported\n");
+		goto done;
+	}
+
+	if (!ni_systemctl_service_show_property("ok.service", "ActiveState", &value) ||
+	    !ni_string_eq(value, "active")) {
+		fprintf(stderr, "unit property not retrieved: %s\n", value);
+		goto done;
+	}
+
+	printf("systemd unit control ok\n");
+	rv = 0;
+
+done:
+	ni_string_free(&value);
+	kill(pid, SIGTERM);
+	waitpid(pid, &status, 0);
+	return rv;
+}
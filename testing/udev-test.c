@@ -0,0 +1,47 @@
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <wicked/util.h>
+#include <wicked/logging.h>
+#include <wicked/netinfo.h>
+
+#include "udev-utils.h"
+
+/*
+ * Check device readiness against the fake udev database in ./udev:
+ *	udev-test [rundir] [ifindex[:ifname]...]
+ */
+int main(int argc, char **argv)
+{
+	static const char *defaults[] = { "1", "2", "3", "4", "5:eth5",
+					  "6:eth0", "6:eth6", NULL };
+	const char *rundir = "./udev";
+	const char **ifindexes = defaults;
+	unsigned int ifindex;
+	char arg[64], *ifname;
+	int i, ret;
+
+	if (argc > 1)
+		rundir = argv[1];
+	if (argc > 2)
+		ifindexes = (const char **)argv + 2;
+
+	ni_udev_db_init(rundir);
+	for (i = 0; ifindexes[i]; ++i) {
+		snprintf(arg, sizeof(arg), "%s", ifindexes[i]);
+		if ((ifname = strchr(arg, ':')))
+			*ifname++ = '\0';
+		if (ni_parse_uint(arg, &ifindex, 10) < 0)
+			continue;
+
+		ret = ni_udev_db_netdev_ready(ifindex, ifname);
+		printf("n%-8u %-8s: %s\n", ifindex, ifname ? ifname : "",
+				ret < 0 ? "no udev db" : ret ? "ready" : "not ready");
+	}
+	ni_udev_db_init(NULL);
+	return 0;
+}
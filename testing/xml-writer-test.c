@@ -0,0 +1,151 @@
+/*
+ * Regression test for the XML writer: the output has to stay
+ * byte-identical and the UUIDs computed over it unchanged, as
+ * they are stored e.g. as config UUIDs. Run it with the fixtures:
+ *
+ *	./xml-writer-test xml-writer
+ *
+ * Copyright (C) 2026 SUSE LLC
+ */
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <wicked/xml.h>
+#include <wicked/util.h>
+
+#define XML_WRITER_TEST_NSID	"c89756cc-b7fb-569b-b7f0-49a400fa41fe"
+
+typedef struct xml_writer_test {
+	const char *		name;
+	xml_node_t *		(*build)(void);
+	const char *		uuid;	/* UUIDv5 of the node */
+} xml_writer_test_t;
+
+static void
+xml_writer_test_fill(char *buf, size_t len, const char *pattern)
+{
+	size_t plen = strlen(pattern), i;
+
+	for (i = 0; i < len; ++i)
+		buf[i] = pattern[i % plen];
+	buf[len] = '\0';
+}
+
+/*
+ * Closing tag indents of 256 and more bytes at the innermost levels
+ */
+static xml_node_t *
+xml_writer_test_deep(void)
+{
+	xml_node_t *root, *node;
+	unsigned int i;
+
+	root = node = xml_node_new("level", NULL);
+	for (i = 1; i < 130; ++i) {
+		node = xml_node_new("level", node);
+		xml_node_add_attr_uint(node, "depth", i);
+	}
+	xml_node_set_cdata(node, "innermost");
+	xml_node_new("empty", node->parent);
+	return root;
+}
+
+/*
+ * Attributes, cdata and entities in tokens longer than 255 bytes
+ */
+static xml_node_t *
+xml_writer_test_long(void)
+{
+	char buf[1024];
+	xml_node_t *root, *node;
+
+	root = xml_node_new("interface", NULL);
+	xml_node_new_element("name", root, "eth0");
+
+	xml_writer_test_fill(buf, 300, "0123456789");
+	node = xml_node_new("description", root);
+	xml_node_add_attr(node, "value", buf);
+	xml_node_add_attr(node, "flag", NULL);
+
+	xml_writer_test_fill(buf, 600, "a<b>&'\"c");
+	xml_node_new_element("escaped", root, buf);
+
+	xml_writer_test_fill(buf, 400, "line\n");
+	xml_node_new_element("multiline", root, buf);
+
+	xml_writer_test_fill(buf, 270, "x");
+	xml_node_new(buf, root);
+	return root;
+}
+
+static const xml_writer_test_t	xml_writer_tests[] = {
+	{ "deep", xml_writer_test_deep, "6240d954-daf4-5cc8-8a11-c444147e6631" },
+	{ "long", xml_writer_test_long, "b4ab6a1f-8c12-56ac-819f-d7c92156a35e" },
+	{ NULL }
+};
+
+static int
+xml_writer_test_run(const char *dir, const xml_writer_test_t *test, const ni_uuid_t *nsid)
+{
+	char path[PATH_MAX];
+	char *expect = NULL, *output = NULL;
+	xml_node_t *node;
+	ni_uuid_t uuid;
+	size_t len;
+	FILE *fp;
+	int rv = 1;
+
+	snprintf(path, sizeof(path), "%s/%s.xml", dir, test->name);
+	if (!(fp = fopen(path, "r"))) {
+		fprintf(stderr, "%s: unable to open %s: %m\n", test->name, path);
+		return 1;
+	}
+	expect = ni_file_read(fp, &len, 1024 * 1024);
+	fclose(fp);
+
+	node = test->build();
+	output = xml_node_sprint(node);
+
+	if (!expect || !output || strlen(output) != len || memcmp(output, expect, len)) {
+		fprintf(stderr, "%s: output differs from %s\n", test->name, path);
+	} else
+	if (xml_node_uuid(node, 5, nsid, &uuid) < 0) {
+		fprintf(stderr, "%s: unable to compute uuid\n", test->name);
+	} else
+	if (!ni_string_eq(ni_uuid_print(&uuid), test->uuid)) {
+		fprintf(stderr, "%s: uuid %s differs from %s\n", test->name,
+				ni_uuid_print(&uuid), test->uuid);
+	} else {
+		printf("%s: ok\n", test->name);
+		rv = 0;
+	}
+
+	xml_node_free(node);
+	free(output);
+	free(expect);
+	return rv;
+}
+
+int
+main(int argc, char **argv)
+{
+	const xml_writer_test_t *test;
+	ni_uuid_t nsid;
+	int rv = 0;
+
+	if (argc != 2) {
+		fprintf(stderr, "Usage: xml-writer-test fixture-dir\n");
+		return 1;
+	}
+
+	ni_uuid_parse(&nsid, XML_WRITER_TEST_NSID);
+	for (test = xml_writer_tests; test->name; ++test)
+		rv |= xml_writer_test_run(argv[1], test, &nsid);
+
+	return rv;
+}
@@ -9,22 +9,116 @@
 
 #include <stdlib.h>
 #include <getopt.h>
+#include <time.h>
 #include <wicked/netinfo.h>
 #include <wicked/xpath.h>
 #include <wicked/logging.h>
+#include <wicked/util.h>
 
 enum {
 	OPT_DEBUG,
 	OPT_REFERENCE,
+	OPT_BENCH,
 };
 
 static struct option	options[] = {
 	{ "debug",		required_argument,	NULL,	OPT_DEBUG },
 	{ "reference",		required_argument,	NULL,	OPT_REFERENCE },
+	{ "bench",		required_argument,	NULL,	OPT_BENCH },
 
 	{ NULL }
 };
 
+/*
+ * The compiled program has to produce the same result as the tree
+ */
+static int
+xpath_result_equal(const xpath_result_t *a, const xpath_result_t *b)
+{
+	unsigned int n;
+
+	if (a->type != b->type || a->count != b->count)
+		return 0;
+
+	for (n = 0; n < a->count; ++n) {
+		const xpath_node_t *an = &a->node[n], *bn = &b->node[n];
+
+		if (an->type != bn->type)
+			return 0;
+		switch (an->type) {
+		case XPATH_ELEMENT:
+			if (an->value.node != bn->value.node)
+				return 0;
+			break;
+		case XPATH_STRING:
+			if (!ni_string_eq(an->value.string, bn->value.string))
+				return 0;
+			break;
+		case XPATH_INTEGER:
+			if (an->value.integer != bn->value.integer)
+				return 0;
+			break;
+		case XPATH_BOOLEAN:
+			if (an->value.boolean != bn->value.boolean)
+				return 0;
+			break;
+		default:
+			break;
+		}
+	}
+	return 1;
+}
+
+static double
+xpath_bench_elapsed(const struct timespec *start)
+{
+	struct timespec end;
+
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	return (end.tv_sec - start->tv_sec) + (end.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+static void
+xpath_bench(const char *expression, xml_node_t *refnode, unsigned int count)
+{
+	xpath_program_t *program;
+	xpath_enode_t *enode;
+	struct timespec start;
+	unsigned int i;
+	double secs;
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (i = 0; i < count; ++i) {
+		enode = xpath_expression_parse(expression);
+		xpath_result_free(xpath_expression_eval(enode, refnode));
+		xpath_expression_free(enode);
+	}
+	secs = xpath_bench_elapsed(&start);
+	printf("::: parse+eval:   %u in %.3f sec\n", count, secs);
+
+	enode = xpath_expression_parse(expression);
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (i = 0; i < count; ++i)
+		xpath_result_free(xpath_expression_eval(enode, refnode));
+	secs = xpath_bench_elapsed(&start);
+	xpath_expression_free(enode);
+	printf("::: tree eval:    %u in %.3f sec\n", count, secs);
+
+	program = xpath_program_new(expression);
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (i = 0; i < count; ++i)
+		xpath_result_free(xpath_program_eval(program, refnode));
+	secs = xpath_bench_elapsed(&start);
+	xpath_program_free(program);
+	printf("::: program eval: %u in %.3f sec\n", count, secs);
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (i = 0; i < count; ++i)
+		xpath_result_free(xpath_expression_eval_cached(expression, refnode));
+	secs = xpath_bench_elapsed(&start);
+	printf("::: cached eval:  %u in %.3f sec\n", count, secs);
+}
+
 
 int
 main(int argc, char **argv)
@@ -34,7 +128,9 @@ main(int argc, char **argv)
 	xml_document_t *doc;
 	xml_node_t *refnode;
 	xpath_enode_t *enode;
-	xpath_result_t *result;
+	xpath_program_t *program;
+	xpath_result_t *result, *compiled;
+	unsigned int bench = 0;
 	int c;
 
 	while ((c = getopt_long(argc, argv, "", options, NULL)) != EOF) {
@@ -42,7 +138,7 @@ main(int argc, char **argv)
 		default:
 		usage:
 			fprintf(stderr,
-				"./xpath-test [--reference <expression>] <expression> [filename]\n"
+				"./xpath-test [--reference <expression>] [--bench <count>] <expression> [filename]\n"
 			       );
 			return 1;
 
@@ -57,6 +153,11 @@ main(int argc, char **argv)
 			opt_reference = optarg;
 			break;
 
+		case OPT_BENCH:
+			if (ni_parse_uint(optarg, &bench, 10) < 0 || !bench)
+				goto usage;
+			break;
+
 		}
 	}
 
@@ -116,8 +217,20 @@ main(int argc, char **argv)
 		return 1;
 	}
 
+	program = xpath_program_new(expression);
+	compiled = program ? xpath_program_eval(program, refnode) : NULL;
+	if (!compiled || !xpath_result_equal(result, compiled)) {
+		fprintf(stderr, "Compiled XPATH expression returned a different result\n");
+		return 1;
+	}
+
 	xpath_result_print(result, stdout);
 
+	if (bench)
+		xpath_bench(expression, refnode, bench);
+
+	xpath_result_free(compiled);
+	xpath_program_free(program);
 	xpath_result_free(result);
 	xpath_expression_free(enode);
 